@@ -45,9 +45,10 @@
 #include "libavformat/avformat.h"
 #include "libswscale/swscale.h"
 #include "libavutil/opt.h"
-#include "libavutil/tx.h"
 #include "libswresample/swresample.h"
 #include "skymediaplayer_interface.h"
+#include "sky_frame_scaler.h"
+#include "sky_audio_kernels.h"
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -110,7 +111,6 @@ static enum ShowMode show_mode = SHOW_MODE_NONE;
 static const char *audio_codec_name;
 static const char *subtitle_codec_name;
 static const char *video_codec_name;
-double rdftspeed = 0.02;
 static int64_t cursor_last_shown;
 static int cursor_hidden = 0;
 static const char **vfilters_list = NULL;
@@ -119,6 +119,8 @@ static char *afilters = NULL;
 static int autorotate = 1;
 static int find_stream_info = 1;
 static int filter_nbthreads = 0;
+// 音频以 float 输出：解码器多为 planar float，只需交错，音量也在 float 上计算
+static int audio_output_float = 1;
 
 /* current context */
 static int is_full_screen;
@@ -155,7 +157,6 @@ static const struct TextureFormatEntry {
     { AV_PIX_FMT_NONE,           SDL_PIXELFORMAT_UNKNOWN },
 };
 
-static const enum AVSampleFormat sample_fmts[] = { AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_NONE };
 
 /* 函数声明 */
 static void stop_refresh_thread(VideoState *is);
@@ -730,15 +731,112 @@ static void set_sdl_yuv_conversion_mode(AVFrame *frame)
     (void)frame; // Suppress unused parameter warning
 }
 
+#define SUBTITLE_SHOWN_BITMAP 1
+#define SUBTITLE_SHOWN_TEXT   2
+
+/* 文本/ASS 字幕转为纯文本：ASS 去掉 Dialogue 前面的字段和 {} 样式标签，\N 转为换行 */
+static char *subtitle_plain_text(const AVSubtitle *sub)
+{
+    AVBPrint buf;
+    char *str = NULL;
+    unsigned i;
+
+    av_bprint_init(&buf, 0, AV_BPRINT_SIZE_UNLIMITED);
+    for (i = 0; i < sub->num_rects; i++) {
+        const AVSubtitleRect *rect = sub->rects[i];
+        const char *text = NULL;
+        int is_ass = rect->type == SUBTITLE_ASS;
+        int fields;
+
+        if (rect->type == SUBTITLE_TEXT)
+            text = rect->text;
+        else if (is_ass && rect->ass) {
+            // ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text
+            text = rect->ass;
+            for (fields = 0; fields < 8 && text; fields++) {
+                text = strchr(text, ',');
+                if (text)
+                    text++;
+            }
+        }
+        if (!text)
+            continue;
+
+        if (buf.len)
+            av_bprint_chars(&buf, '\n', 1);
+        for (; *text; text++) {
+            if (is_ass && *text == '{' && strchr(text, '}')) {
+                text = strchr(text, '}');
+            } else if (is_ass && *text == '\\' && (text[1] == 'N' || text[1] == 'n')) {
+                av_bprint_chars(&buf, '\n', 1);
+                text++;
+            } else if (is_ass && *text == '\\' && text[1] == 'h') {
+                av_bprint_chars(&buf, ' ', 1);
+                text++;
+            } else if (*text != '\r') {
+                av_bprint_chars(&buf, *text, 1);
+            }
+        }
+    }
+    if (buf.len)
+        av_bprint_finalize(&buf, &str);
+    else
+        av_bprint_finalize(&buf, NULL);
+    return str;
+}
+
+/**
+ * 字幕只在切换时交给 renderer（位图）或 Java（文本），字幕不变的帧没有额外的转换和上传。
+ * 返回 1 表示显示内容有变化，需要重绘当前帧
+ */
+static int sky_update_subtitle(VideoState *is, Frame *vp)
+{
+    Frame *sp = NULL;
+    int shown = 0, changed;
+    unsigned i;
+
+    if (is->subtitle_st && frame_queue_nb_remaining(&is->subpq) > 0) {
+        sp = frame_queue_peek(&is->subpq);
+        if (vp->pts < sp->pts + ((float) sp->sub.start_display_time / 1000))
+            sp = NULL;
+    }
+    if (sp && sp->uploaded)
+        return 0;
+    if (!sp && !is->subtitle_shown)
+        return 0;
+
+    if (sp) {
+        for (i = 0; i < sp->sub.num_rects; i++)
+            shown |= sp->sub.rects[i]->type == SUBTITLE_BITMAP ? SUBTITLE_SHOWN_BITMAP : SUBTITLE_SHOWN_TEXT;
+        sp->uploaded = 1;
+    }
+
+    if (shown & SUBTITLE_SHOWN_BITMAP) {
+        sky_set_subtitle(is->skyPlayer, &sp->sub,
+                         sp->width ? sp->width : vp->width, sp->height ? sp->height : vp->height);
+    } else if (is->subtitle_shown & SUBTITLE_SHOWN_BITMAP) {
+        sky_set_subtitle(is->skyPlayer, NULL, 0, 0);
+    }
+    if (shown & SUBTITLE_SHOWN_TEXT) {
+        sky_post_message(is->skyPlayer, SKY_MSG_TIMED_TEXT, 0, 0, subtitle_plain_text(&sp->sub));
+    } else if (is->subtitle_shown & SUBTITLE_SHOWN_TEXT) {
+        sky_post_message(is->skyPlayer, SKY_MSG_TIMED_TEXT, 0, 0, NULL);
+    }
+    // 只有位图字幕需要重绘视频帧
+    changed = ((shown | is->subtitle_shown) & SUBTITLE_SHOWN_BITMAP) ? 1 : 0;
+    is->subtitle_shown = shown;
+    return changed;
+}
+
 static void sky_video_image_display(VideoState *is)
 {
     Frame *vp;
-
-    // todo 字幕
+    int subtitle_changed;
 
     vp = frame_queue_peek_last(&is->pictq);
-    if (!vp->uploaded) {
-        if (!sky_display_image(is->skyPlayer, vp->frame)) {
+    subtitle_changed = sky_update_subtitle(is, vp);
+    if (!vp->uploaded || subtitle_changed) {
+        if (!sky_display_image(is->skyPlayer, vp->frame, vp->rotation, vp->flip)) {
             return;
         }
         vp->uploaded = 1;
@@ -833,162 +931,6 @@ static void video_image_display(VideoState *is)
     }
 }
 
-static inline int compute_mod(int a, int b)
-{
-    return a < 0 ? a%b + b : a%b;
-}
-
-static void video_audio_display(VideoState *s)
-{
-    int i, i_start, x, y1, y, ys, delay, n, nb_display_channels;
-    int ch, channels, h, h2;
-    int64_t time_diff;
-    int rdft_bits, nb_freq;
-
-    for (rdft_bits = 1; (1 << rdft_bits) < 2 * s->height; rdft_bits++)
-        ;
-    nb_freq = 1 << (rdft_bits - 1);
-
-    /* compute display index : center on currently output samples */
-    channels = s->audio_tgt.ch_layout.nb_channels;
-    nb_display_channels = channels;
-    if (!s->paused) {
-        int data_used= s->show_mode == SHOW_MODE_WAVES ? s->width : (2*nb_freq);
-        n = 2 * channels;
-        delay = s->audio_write_buf_size;
-        delay /= n;
-
-        /* to be more precise, we take into account the time spent since
-           the last buffer_ computation */
-        if (audio_callback_time) {
-            time_diff = av_gettime_relative() - audio_callback_time;
-            delay -= (time_diff * s->audio_tgt.freq) / 1000000;
-        }
-
-        delay += 2 * data_used;
-        if (delay < data_used)
-            delay = data_used;
-
-        i_start= x = compute_mod(s->sample_array_index - delay * channels, SAMPLE_ARRAY_SIZE);
-        if (s->show_mode == SHOW_MODE_WAVES) {
-            h = INT_MIN;
-            for (i = 0; i < 1000; i += channels) {
-                int idx = (SAMPLE_ARRAY_SIZE + x - i) % SAMPLE_ARRAY_SIZE;
-                int a = s->sample_array[idx];
-                int b = s->sample_array[(idx + 4 * channels) % SAMPLE_ARRAY_SIZE];
-                int c = s->sample_array[(idx + 5 * channels) % SAMPLE_ARRAY_SIZE];
-                int d = s->sample_array[(idx + 9 * channels) % SAMPLE_ARRAY_SIZE];
-                int score = a - d;
-                if (h < score && (b ^ c) < 0) {
-                    h = score;
-                    i_start = idx;
-                }
-            }
-        }
-
-        s->last_i_start = i_start;
-    } else {
-        i_start = s->last_i_start;
-    }
-
-    if (s->show_mode == SHOW_MODE_WAVES) {
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-
-        /* total height for one channel */
-        h = s->height / nb_display_channels;
-        /* graph height / 2 */
-        h2 = (h * 9) / 20;
-        for (ch = 0; ch < nb_display_channels; ch++) {
-            i = i_start + ch;
-            y1 = s->ytop + ch * h + (h / 2); /* position of center line */
-            for (x = 0; x < s->width; x++) {
-                y = (s->sample_array[i] * h2) >> 15;
-                if (y < 0) {
-                    y = -y;
-                    ys = y1 - y;
-                } else {
-                    ys = y1;
-                }
-                fill_rectangle(s->xleft + x, ys, 1, y);
-                i += channels;
-                if (i >= SAMPLE_ARRAY_SIZE)
-                    i -= SAMPLE_ARRAY_SIZE;
-            }
-        }
-
-        SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255);
-
-        for (ch = 1; ch < nb_display_channels; ch++) {
-            y = s->ytop + ch * h;
-            fill_rectangle(s->xleft, y, s->width, 1);
-        }
-    } else {
-        int err = 0;
-        if (realloc_texture(&s->vis_texture, SDL_PIXELFORMAT_ARGB8888, s->width, s->height, SDL_BLENDMODE_NONE, 1) < 0)
-            return;
-
-        if (s->xpos >= s->width)
-            s->xpos = 0;
-        nb_display_channels= FFMIN(nb_display_channels, 2);
-        if (rdft_bits != s->rdft_bits) {
-            const float rdft_scale = 1.0;
-            av_tx_uninit(&s->rdft);
-            av_freep(&s->real_data);
-            av_freep(&s->rdft_data);
-            s->rdft_bits = rdft_bits;
-            s->real_data = av_malloc_array(nb_freq, 4 *sizeof(*s->real_data));
-            s->rdft_data = av_malloc_array(nb_freq + 1, 2 *sizeof(*s->rdft_data));
-            err = av_tx_init(&s->rdft, &s->rdft_fn, AV_TX_FLOAT_RDFT,
-                             0, 1 << rdft_bits, &rdft_scale, 0);
-        }
-        if (err < 0 || !s->rdft_data) {
-            av_log(NULL, AV_LOG_ERROR, "Failed to allocate buffers for RDFT, switching to waves display\n");
-            s->show_mode = SHOW_MODE_WAVES;
-        } else {
-            float *data_in[2];
-            AVComplexFloat *data[2];
-            SDL_Rect rect = {.x = s->xpos, .y = 0, .w = 1, .h = s->height};
-            uint32_t *pixels;
-            int pitch;
-            for (ch = 0; ch < nb_display_channels; ch++) {
-                data_in[ch] = s->real_data + 2 * nb_freq * ch;
-                data[ch] = s->rdft_data + nb_freq * ch;
-                i = i_start + ch;
-                for (x = 0; x < 2 * nb_freq; x++) {
-                    double w = (x-nb_freq) * (1.0 / nb_freq);
-                    data_in[ch][x] = s->sample_array[i] * (1.0 - w * w);
-                    i += channels;
-                    if (i >= SAMPLE_ARRAY_SIZE)
-                        i -= SAMPLE_ARRAY_SIZE;
-                }
-                s->rdft_fn(s->rdft, data[ch], data_in[ch], sizeof(float));
-                data[ch][0].im = data[ch][nb_freq].re;
-                data[ch][nb_freq].re = 0;
-            }
-            /* Least efficient way to do this, we should of course
-             * directly access it but it is more than fast enough. */
-            if (!SDL_LockTexture(s->vis_texture, &rect, (void **)&pixels, &pitch)) {
-                pitch >>= 2;
-                pixels += pitch * s->height;
-                for (y = 0; y < s->height; y++) {
-                    double w = 1 / sqrt(nb_freq);
-                    int a = sqrt(w * sqrt(data[0][y].re * data[0][y].re + data[0][y].im * data[0][y].im));
-                    int b = (nb_display_channels == 2 ) ? sqrt(w * hypot(data[1][y].re, data[1][y].im))
-                                                        : a;
-                    a = FFMIN(a, 255);
-                    b = FFMIN(b, 255);
-                    pixels -= pitch;
-                    *pixels = (a << 16) + (b << 8) + ((a+b) >> 1);
-                }
-                SDL_UnlockTexture(s->vis_texture);
-            }
-            SDL_RenderTexture(renderer, s->vis_texture, NULL, NULL);
-        }
-        if (!s->paused)
-            s->xpos++;
-    }
-}
-
 static void stream_component_close(VideoState *is, int stream_index)
 {
     AVFormatContext *ic = is->ic;
@@ -1006,15 +948,10 @@ static void stream_component_close(VideoState *is, int stream_index)
         swr_free(&is->swr_ctx);
         av_freep(&is->audio_buf1);
         is->audio_buf1_size = 0;
+        av_freep(&is->audio_buf2);
+        is->audio_buf2_size = 0;
+        is->audio_downmix_channels = 0;
         is->audio_buf = NULL;
-
-        if (is->rdft) {
-            av_tx_uninit(&is->rdft);
-            av_freep(&is->real_data);
-            av_freep(&is->rdft_data);
-            is->rdft = NULL;
-            is->rdft_bits = 0;
-        }
         break;
     case AVMEDIA_TYPE_VIDEO:
         decoder_abort(&is->viddec, &is->pictq);
@@ -1066,6 +1003,7 @@ void stream_close(VideoState *is)
         stream_component_close(is, is->subtitle_stream);
 
     avformat_close_input(&is->ic);
+    sky_io_close(&is->custom_io);
 
     packet_queue_destroy(&is->videoq);
     packet_queue_destroy(&is->audioq);
@@ -1076,10 +1014,12 @@ void stream_close(VideoState *is)
     frame_queue_destroy(&is->sampq);
     frame_queue_destroy(&is->subpq);
     SDL_DestroyCondition(is->continue_read_thread);
+    SDL_DestroyMutex(is->vfilters_mutex);
+    SDL_DestroyCondition(is->video_resume_cond);
+    SDL_DestroyMutex(is->video_resume_mutex);
+    av_free(is->vfilters);
     sws_freeContext(is->sub_convert_ctx);
     av_free(is->filename);
-    if (is->vis_texture)
-        SDL_DestroyTexture(is->vis_texture);
     if (is->vid_texture)
         SDL_DestroyTexture(is->vid_texture);
     if (is->sub_texture)
@@ -1154,9 +1094,7 @@ static void video_display(VideoState *is)
 
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer);
-    if (is->audio_st && is->show_mode != SHOW_MODE_VIDEO) {
-        video_audio_display(is);
-    } else if (is->video_st) {
+    if (is->video_st) {
 //        video_image_display(is);
         sky_video_image_display(is);
     }
@@ -1274,10 +1212,9 @@ void stream_seek(VideoState *is, int64_t pos, int64_t rel, int by_bytes)
     }
 }
 
-/* pause or resume the video */
-static void stream_toggle_pause(VideoState *is)
+/* 暂停/恢复各时钟，不通知音频设备 */
+static void stream_toggle_clocks(VideoState *is)
 {
-    av_log(NULL, AV_LOG_DEBUG, "[STREAM_TOGGLE_PAUSE] Paused: %d\n", is->paused);
     if (is->paused) {
         is->frame_timer += av_gettime_relative() / 1000000.0 - is->vidclk.last_updated;
         if (is->read_pause_return != AVERROR(ENOSYS)) {
@@ -1287,10 +1224,31 @@ static void stream_toggle_pause(VideoState *is)
     }
     set_clock(&is->extclk, get_clock(&is->extclk), is->extclk.serial);
     is->paused = is->audclk.paused = is->vidclk.paused = is->extclk.paused = !is->paused;
+}
 
+/* pause or resume the video */
+static void stream_toggle_pause(VideoState *is)
+{
+    av_log(NULL, AV_LOG_DEBUG, "[STREAM_TOGGLE_PAUSE] Paused: %d\n", is->paused);
+    stream_toggle_clocks(is);
     sky_pause_audio(is->skyPlayer, is->paused);
 }
 
+void stream_activate(VideoState *is, void *player)
+{
+    is->skyPlayer = player;
+    if (is->paused)
+        stream_toggle_clocks(is);
+    is->step = 0;
+}
+
+void stream_deactivate(VideoState *is)
+{
+    if (!is->paused)
+        stream_toggle_clocks(is);
+    is->skyPlayer = NULL;
+}
+
 void toggle_pause(VideoState *is)
 {
     stream_toggle_pause(is);
@@ -1325,6 +1283,58 @@ int64_t get_media_duration(VideoState *is)
     return duration;
 }
 
+int set_video_filters(VideoState *is, const char *vfilters)
+{
+    char *dup = NULL;
+
+    if (!is)
+        return AVERROR(EINVAL);
+    if (vfilters && !(dup = av_strdup(vfilters)))
+        return AVERROR(ENOMEM);
+
+    SDL_LockMutex(is->vfilters_mutex);
+    av_free(is->vfilters);
+    is->vfilters = dup;
+    is->vfilters_serial++;
+    SDL_UnlockMutex(is->vfilters_mutex);
+    return 0;
+}
+
+void set_video_suspended(VideoState *is, int suspended)
+{
+    if (!is)
+        return;
+    is->video_suspend_req = !!suspended;
+    SDL_SignalCondition(is->continue_read_thread);
+}
+
+int video_frame_available(VideoState *is)
+{
+    if (!is || !is->video_st || is->show_mode == SHOW_MODE_NONE)
+        return AVERROR_STREAM_NOT_FOUND;
+    if (is->video_suspend_req || is->video_suspended)
+        return AVERROR(EAGAIN);
+    return 0;
+}
+
+int stream_video_ended(VideoState *is)
+{
+    if (!is->video_st || is->video_suspended || is->show_mode == SHOW_MODE_NONE || is->abort_request)
+        return 1;
+    return is->viddec.finished == is->videoq.serial && frame_queue_nb_remaining(&is->pictq) == 0;
+}
+
+void request_video_refresh(VideoState *is)
+{
+    if (!is)
+        return;
+    // 暂停时刷新线程只在 force_refresh 时调用 video_refresh
+    is->force_refresh = 1;
+    SDL_LockMutex(is->video_resume_mutex);
+    SDL_SignalCondition(is->video_resume_cond);
+    SDL_UnlockMutex(is->video_resume_mutex);
+}
+
 static void toggle_mute(VideoState *is)
 {
     is->muted = !is->muted;
@@ -1402,15 +1412,6 @@ static void video_refresh(void *opaque, double *remaining_time)
     if (!is->paused && get_master_sync_type(is) == AV_SYNC_EXTERNAL_CLOCK && is->realtime)
         check_external_clock_speed(is);
 
-    if (!display_disable && is->show_mode != SHOW_MODE_VIDEO && is->audio_st) {
-        time = av_gettime_relative() / 1000000.0;
-        if (is->force_refresh || is->last_vis_time + rdftspeed < time) {
-            video_display(is);
-            is->last_vis_time = time;
-        }
-        *remaining_time = FFMIN(*remaining_time, is->last_vis_time + rdftspeed - time);
-    }
-
     if (is->video_st) {
 retry:
         if (frame_queue_nb_remaining(&is->pictq) == 0) {
@@ -1476,7 +1477,7 @@ retry:
                             || (is->vidclk.pts > (sp->pts + ((float) sp->sub.end_display_time / 1000)))
                             || (sp2 && is->vidclk.pts > (sp2->pts + ((float) sp2->sub.start_display_time / 1000))))
                     {
-                        if (sp->uploaded) {
+                        if (sp->uploaded && is->sub_texture) {
                             int i;
                             for (i = 0; i < sp->sub.num_rects; i++) {
                                 AVSubtitleRect *sub_rect = sp->sub.rects[i];
@@ -1507,6 +1508,12 @@ display:
         /* display picture */
         if (!display_disable && is->force_refresh && is->show_mode == SHOW_MODE_VIDEO && is->pictq.rindex_shown)
             video_display(is);
+
+        /* 截图：对正在显示的帧加引用交给截图线程，这里不做拷贝和转换 */
+        if (is->pictq.rindex_shown && sky_capture_pending(is->skyPlayer)) {
+            Frame *vp = frame_queue_peek_last(&is->pictq);
+            sky_capture_frame(is->skyPlayer, vp->frame, vp->pts, vp->rotation, vp->flip);
+        }
     }
     is->force_refresh = 0;
     if (show_status) {
@@ -1577,6 +1584,8 @@ static int queue_picture(VideoState *is, AVFrame *src_frame, double pts, double
     vp->width = src_frame->width;
     vp->height = src_frame->height;
     vp->format = src_frame->format;
+    vp->rotation = is->video_rotation;
+    vp->flip = is->video_flip;
 
     vp->pts = pts;
     vp->duration = duration;
@@ -1585,6 +1594,10 @@ static int queue_picture(VideoState *is, AVFrame *src_frame, double pts, double
 
     set_default_window_size(vp->width, vp->height, vp->sar);
 
+    // 应用内分析的旁路，只加引用
+    if (sky_frame_tap_active(is->skyPlayer))
+        sky_frame_tap_submit(is->skyPlayer, src_frame, pts);
+
     av_frame_move_ref(vp->frame, src_frame);
     frame_queue_push(&is->pictq);
 
@@ -1673,15 +1686,33 @@ fail:
     return ret;
 }
 
+/* 输出立体声时 5.1/7.1 由 audio_decode_frame 中的 downmix 处理 */
+static int audio_downmix_supported(VideoState *is, const AVChannelLayout *layout)
+{
+    static const AVChannelLayout downmix_layouts[] = {
+        AV_CHANNEL_LAYOUT_5POINT1, AV_CHANNEL_LAYOUT_5POINT1_BACK, AV_CHANNEL_LAYOUT_7POINT1,
+    };
+    int i;
+
+    if (is->audio_tgt.ch_layout.nb_channels != 2 || layout->nb_channels > SKY_AUDIO_DOWNMIX_MAX_CHANNELS)
+        return 0;
+    for (i = 0; i < FF_ARRAY_ELEMS(downmix_layouts); i++) {
+        if (!av_channel_layout_compare(layout, &downmix_layouts[i]))
+            return 1;
+    }
+    return 0;
+}
+
 static int configure_audio_filters(VideoState *is, const char *afilters, int force_output_format)
 {
     int sample_rates[2] = { 0, -1 };
+    enum AVSampleFormat sample_fmts[2] = { audio_output_float ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_NONE };
     AVFilterContext *filt_asrc = NULL, *filt_asink = NULL;
     char aresample_swr_opts[512] = "";
     const AVDictionaryEntry *e = NULL;
     AVBPrint bp;
     char asrc_args[256];
-    int ret;
+    int keep_layout, ret;
 
     avfilter_graph_free(&is->agraph);
     if (!(is->agraph = avfilter_graph_alloc()))
@@ -1715,6 +1746,11 @@ static int configure_audio_filters(VideoState *is, const char *afilters, int for
     if (ret < 0)
         goto end;
 
+    /* 5.1/7.1 源在 sink 保留原声道布局并输出 planar float，交给 downmix 处理，不在 swr 里先混成立体声 */
+    keep_layout = force_output_format && audio_downmix_supported(is, &is->audio_filter_src.ch_layout);
+    /* 设备可能回退到了 s16，须在设置 sample_fmts 之前改 */
+    if (force_output_format)
+        sample_fmts[0] = keep_layout ? AV_SAMPLE_FMT_FLTP : is->audio_tgt.fmt;
     if ((ret = av_opt_set_int_list(filt_asink, "sample_fmts", sample_fmts,  AV_SAMPLE_FMT_NONE, AV_OPT_SEARCH_CHILDREN)) < 0)
         goto end;
     if ((ret = av_opt_set_int(filt_asink, "all_channel_counts", 1, AV_OPT_SEARCH_CHILDREN)) < 0)
@@ -1722,10 +1758,12 @@ static int configure_audio_filters(VideoState *is, const char *afilters, int for
 
     if (force_output_format) {
         sample_rates   [0] = is->audio_tgt.freq;
-        if ((ret = av_opt_set_int(filt_asink, "all_channel_counts", 0, AV_OPT_SEARCH_CHILDREN)) < 0)
-            goto end;
         if ((ret = av_opt_set_int_list(filt_asink, "sample_rates"   ,  sample_rates   ,  -1, AV_OPT_SEARCH_CHILDREN)) < 0)
             goto end;
+    }
+    if (force_output_format && !keep_layout) {
+        if ((ret = av_opt_set_int(filt_asink, "all_channel_counts", 0, AV_OPT_SEARCH_CHILDREN)) < 0)
+            goto end;
         if ((ret = av_opt_set_chlayout(filt_asink, "ch_layouts", &is->audio_tgt.ch_layout, AV_OPT_SEARCH_CHILDREN)) < 0)
             goto end;
     }
@@ -1745,7 +1783,318 @@ end:
 }
 
 
-static int configure_video_filters(AVFilterGraph *graph, VideoState *is, const char *vfilters, AVFrame *frame)
+/* 解析 crop/eq 的参数，只接受纯数字，带表达式的交给 libavfilter 处理 */
+static int parse_gpu_filter_args(char *args, const char *const *names, double *values, int nb_names)
+{
+    char *saveptr = NULL, *tok, *end;
+    int pos = 0, idx, i;
+
+    for (tok = av_strtok(args, ":", &saveptr); tok; tok = av_strtok(NULL, ":", &saveptr)) {
+        char *val = strchr(tok, '=');
+        const char *key = tok;
+
+        idx = -1;
+        if (val) {
+            *val++ = '\0';
+            if (!strcmp(key, "out_w"))
+                key = "w";
+            else if (!strcmp(key, "out_h"))
+                key = "h";
+            for (i = 0; i < nb_names; i++) {
+                if (!strcmp(key, names[i]))
+                    idx = i;
+            }
+        } else {
+            val = tok;
+            idx = pos++;
+        }
+        if (idx < 0 || idx >= nb_names)
+            return AVERROR(EINVAL);
+
+        values[idx] = av_strtod(val, &end);
+        if (end == val || *end)
+            return AVERROR(EINVAL);
+    }
+    return 0;
+}
+
+static int parse_gpu_video_filter(char *filter, SkyVideoCrop *crop, SkyVideoEq *eq, int *has_eq)
+{
+    static const char *const crop_names[] = { "w", "h", "x", "y" };
+    static const char *const eq_names[]   = { "contrast", "brightness", "saturation", "gamma" };
+    char *args;
+
+    filter += strspn(filter, " \t\n");
+    args = strchr(filter, '=');
+    if (args)
+        *args++ = '\0';
+
+    if (!strcmp(filter, "crop") && !crop->enabled) {
+        double values[4] = { -1, -1, -1, -1 };
+        if (args && parse_gpu_filter_args(args, crop_names, values, 4) < 0)
+            return AVERROR(EINVAL);
+        crop->enabled = 1;
+        crop->w = (int)values[0];
+        crop->h = (int)values[1];
+        crop->x = (int)values[2];
+        crop->y = (int)values[3];
+        return 0;
+    }
+
+    if (!strcmp(filter, "eq") && !*has_eq) {
+        double values[4] = { 1.0, 0.0, 1.0, 1.0 };
+        if (args && parse_gpu_filter_args(args, eq_names, values, 4) < 0)
+            return AVERROR(EINVAL);
+        eq->contrast   = av_clipd(values[0], -1000.0, 1000.0);
+        eq->brightness = av_clipd(values[1], -1.0, 1.0);
+        eq->saturation = av_clipd(values[2], 0.0, 3.0);
+        eq->gamma      = av_clipd(values[3], 0.1, 10.0);
+        *has_eq = 1;
+        return 0;
+    }
+
+    return AVERROR(ENOSYS);
+}
+
+/**
+ * 从滤镜链尾部剥离 renderer 可以在 GPU 上完成的 crop/eq，剩余部分写入 cpu_vfilters。
+ * 只剥离尾部保证执行顺序不变；带 label 的复杂 graph 整体交给 libavfilter。
+ */
+static int split_gpu_video_filters(const char *vfilters, char **cpu_vfilters,
+                                   SkyVideoCrop *crop, SkyVideoEq *eq)
+{
+    char *buf;
+    int has_eq = 0;
+
+    *cpu_vfilters = NULL;
+    memset(crop, 0, sizeof(*crop));
+    *eq = (SkyVideoEq){ .brightness = 0.0f, .contrast = 1.0f, .saturation = 1.0f, .gamma = 1.0f };
+    if (!vfilters)
+        return 0;
+
+    buf = av_strdup(vfilters);
+    if (!buf)
+        return AVERROR(ENOMEM);
+
+    if (!strpbrk(buf, "[];'\\")) {
+        for (;;) {
+            char *last = strrchr(buf, ',');
+            char *filter = av_strdup(last ? last + 1 : buf);
+            int ret;
+
+            if (!filter) {
+                av_free(buf);
+                return AVERROR(ENOMEM);
+            }
+            ret = parse_gpu_video_filter(filter, crop, eq, &has_eq);
+            av_free(filter);
+            if (ret < 0)
+                break;
+            if (!last) {
+                buf[0] = '\0';
+                break;
+            }
+            *last = '\0';
+        }
+    }
+
+    if (buf[0]) {
+        *cpu_vfilters = buf;
+        av_log(NULL, AV_LOG_INFO, "video filters on cpu: %s, gpu crop=%d eq=%d\n", buf, crop->enabled, has_eq);
+    } else {
+        av_free(buf);
+    }
+    return 0;
+}
+
+/* GPU crop 通过 AVFrame.crop_* 交给 renderer，在纹理坐标上完成 */
+static void apply_gpu_crop(const SkyVideoCrop *crop, AVFrame *frame)
+{
+    int w = crop->w > 0 ? FFMIN(crop->w, frame->width) : frame->width;
+    int h = crop->h > 0 ? FFMIN(crop->h, frame->height) : frame->height;
+    int x = crop->x >= 0 ? crop->x : (frame->width - w) / 2;
+    int y = crop->y >= 0 ? crop->y : (frame->height - h) / 2;
+
+    x = av_clip(x, 0, frame->width - w);
+    y = av_clip(y, 0, frame->height - h);
+    frame->crop_left   = x;
+    frame->crop_right  = frame->width - w - x;
+    frame->crop_top    = y;
+    frame->crop_bottom = frame->height - h - y;
+}
+
+/* 最多缩小到 1/4 */
+#define VIDEO_DOWNSCALE_MAX_SHIFT 2
+
+/**
+ * 在不小于显示区域的前提下，视频可以缩小的 2 的幂次。
+ * 长边对长边、短边对短边比较，与旋转无关；显示区域未知时返回 0
+ */
+static int video_downscale_shift(int width, int height, int target_w, int target_h)
+{
+    int long_side = FFMAX(width, height), short_side = FFMIN(width, height);
+    int target_long = FFMAX(target_w, target_h), target_short = FFMIN(target_w, target_h);
+    int shift = 0;
+
+    if (target_long <= 0 || target_short <= 0)
+        return 0;
+    while (shift < VIDEO_DOWNSCALE_MAX_SHIFT
+           && (long_side >> (shift + 1)) >= target_long
+           && (short_side >> (shift + 1)) >= target_short)
+        shift++;
+    return shift;
+}
+
+/* 视频是否已不小于显示区域 */
+static int video_covers_target(int width, int height, int target_w, int target_h)
+{
+    return FFMAX(width, height) >= FFMAX(target_w, target_h)
+           && FFMIN(width, height) >= FFMIN(target_w, target_h);
+}
+
+/**
+ * 在多码率（HLS/DASH 每个 variant 一个 program）中选择不小于显示区域的最小视频流，
+ * 都不够大时选最大的；单 program 或显示区域未知时保持 current
+ */
+static int select_video_variant(VideoState *is, int current)
+{
+    AVFormatContext *ic = is->ic;
+    int target_w, target_h;
+    int best = -1, best_area = 0, largest = -1, largest_area = 0;
+
+    if (current < 0 || ic->nb_programs <= 1)
+        return current;
+    sky_get_video_target_size(is->skyPlayer, &target_w, &target_h);
+    if (target_w <= 0 || target_h <= 0)
+        return current;
+
+    for (int i = 0; i < ic->nb_streams; i++) {
+        AVCodecParameters *par = ic->streams[i]->codecpar;
+        int area = par->width * par->height;
+        if (par->codec_type != AVMEDIA_TYPE_VIDEO || area <= 0
+            || (ic->streams[i]->disposition & AV_DISPOSITION_ATTACHED_PIC)
+            || !avcodec_find_decoder(par->codec_id))
+            continue;
+        if (area > largest_area) {
+            largest = i;
+            largest_area = area;
+        }
+        if (video_covers_target(par->width, par->height, target_w, target_h)
+            && (best < 0 || area < best_area)) {
+            best = i;
+            best_area = area;
+        }
+    }
+    if (best < 0)
+        best = largest;
+    return best >= 0 ? best : current;
+}
+
+/* 显示区域远小于视频时做 2:1/4:1 box 缩小，减少上传和采样的数据量，缩小后的帧写入 scaled */
+static AVFrame *downscale_video_frame(VideoState *is, AVFrame *frame, AVFrame *scaled)
+{
+    int target_w, target_h, shift;
+
+    if (!scaled || !sky_frame_can_downscale(frame))
+        return frame;
+    sky_get_video_target_size(is->skyPlayer, &target_w, &target_h);
+    shift = video_downscale_shift(frame->width  - frame->crop_left - frame->crop_right,
+                                  frame->height - frame->crop_top  - frame->crop_bottom,
+                                  target_w, target_h);
+    if (!shift || sky_frame_downscale_2x(scaled, frame) < 0)
+        return frame;
+    if (shift > 1) {
+        AVFrame *tmp = av_frame_alloc();
+        if (tmp && sky_frame_downscale_2x(tmp, scaled) >= 0)
+            av_frame_move_ref(scaled, tmp);
+        av_frame_free(&tmp);
+    }
+    return scaled;
+}
+
+/**
+ * 根据 display matrix 更新交给 renderer 的旋转/镜像，
+ * 返回需要 rotate 滤镜处理的任意角度，不需要时返回 0
+ */
+static double update_video_orientation(VideoState *is, AVFrame *frame)
+{
+    double theta = 0.0, rotate_theta = 0.0;
+    int32_t *displaymatrix = NULL;
+    int rotation = 0, flip = 0;
+    AVFrameSideData *sd;
+
+    if (!autorotate)
+        return 0.0;
+
+    sd = av_frame_get_side_data(frame, AV_FRAME_DATA_DISPLAYMATRIX);
+    if (sd)
+        displaymatrix = (int32_t *)sd->data;
+    if (!displaymatrix) {
+        const AVPacketSideData *psd = av_packet_side_data_get(is->video_st->codecpar->coded_side_data,
+                                                              is->video_st->codecpar->nb_coded_side_data,
+                                                              AV_PKT_DATA_DISPLAYMATRIX);
+        if (psd)
+            displaymatrix = (int32_t *)psd->data;
+    }
+    theta = get_rotation(displaymatrix);
+
+    if (fabs(theta - 90) < 1.0) {
+        rotation = 90;
+        flip = displaymatrix[3] > 0 ? SKY_VIDEO_FLIP_H : 0;
+    } else if (fabs(theta - 180) < 1.0) {
+        if (displaymatrix[0] < 0)
+            flip |= SKY_VIDEO_FLIP_H;
+        if (displaymatrix[4] < 0)
+            flip |= SKY_VIDEO_FLIP_V;
+    } else if (fabs(theta - 270) < 1.0) {
+        rotation = 270;
+        flip = displaymatrix[3] < 0 ? SKY_VIDEO_FLIP_H : 0;
+    } else if (fabs(theta) > 1.0) {
+        rotate_theta = theta;
+    } else {
+        if (displaymatrix && displaymatrix[4] < 0)
+            flip |= SKY_VIDEO_FLIP_V;
+    }
+
+    is->video_flip = flip;
+    if (is->video_rotation != rotation) {
+        is->video_rotation = rotation;
+        sky_post_message_ii(is->skyPlayer, SKY_MSG_VIDEO_ROTATION_CHANGED, rotation, 0);
+    }
+    return rotate_theta;
+}
+
+/* 解码输出可以直接交给 renderer 的格式，与 buffersink 的输出格式一致 */
+static int is_display_pixel_format(int format)
+{
+    int i;
+
+    for (i = 0; sdl_texture_format_map[i].format != AV_PIX_FMT_NONE; i++) {
+        if (sdl_texture_format_map[i].format == format)
+            return 1;
+    }
+    return 0;
+}
+
+/* 按帧序或时间戳累积状态的滤镜，seek 后旧状态会让开头几帧的时间或内容出错 */
+static int video_graph_is_stateful(const AVFilterGraph *graph)
+{
+    static const char *const stateful[] = {
+        "fps", "framerate", "minterpolate", "yadif", "bwdif", "w3fdif", "tmix", "tblend",
+        "setpts", "deflicker", "mpdecimate", "decimate", "framestep", NULL
+    };
+    unsigned i;
+    int j;
+
+    for (i = 0; i < graph->nb_filters; i++)
+        for (j = 0; stateful[j]; j++)
+            if (!strcmp(graph->filters[i]->filter->name, stateful[j]))
+                return 1;
+    return 0;
+}
+
+static int configure_video_filters(AVFilterGraph *graph, VideoState *is, const char *vfilters,
+                                   double rotate_theta, AVFrame *frame)
 {
     enum AVPixelFormat pix_fmts[FF_ARRAY_ELEMS(sdl_texture_format_map)];
     char sws_flags_str[512] = "";
@@ -1838,38 +2187,11 @@ static int configure_video_filters(AVFilterGraph *graph, VideoState *is, const c
     last_filter = filt_ctx;                                                  \
 } while (0)
 
-    if (autorotate) {
-        double theta = 0.0;
-        int32_t *displaymatrix = NULL;
-        AVFrameSideData *sd = av_frame_get_side_data(frame, AV_FRAME_DATA_DISPLAYMATRIX);
-        if (sd)
-            displaymatrix = (int32_t *)sd->data;
-        if (!displaymatrix) {
-            const AVPacketSideData *psd = av_packet_side_data_get(is->video_st->codecpar->coded_side_data,
-                                                                  is->video_st->codecpar->nb_coded_side_data,
-                                                                  AV_PKT_DATA_DISPLAYMATRIX);
-            if (psd)
-                displaymatrix = (int32_t *)psd->data;
-        }
-        theta = get_rotation(displaymatrix);
-
-        if (fabs(theta - 90) < 1.0) {
-            INSERT_FILT("transpose", displaymatrix[3] > 0 ? "cclock_flip" : "clock");
-        } else if (fabs(theta - 180) < 1.0) {
-            if (displaymatrix[0] < 0)
-                INSERT_FILT("hflip", NULL);
-            if (displaymatrix[4] < 0)
-                INSERT_FILT("vflip", NULL);
-        } else if (fabs(theta - 270) < 1.0) {
-            INSERT_FILT("transpose", displaymatrix[3] < 0 ? "clock_flip" : "cclock");
-        } else if (fabs(theta) > 1.0) {
-            char rotate_buf[64];
-            snprintf(rotate_buf, sizeof(rotate_buf), "%f*PI/180", theta);
-            INSERT_FILT("rotate", rotate_buf);
-        } else {
-            if (displaymatrix && displaymatrix[4] < 0)
-                INSERT_FILT("vflip", NULL);
-        }
+    // 90 度整数倍的旋转/镜像交给 renderer 在纹理坐标上完成，任意角度 GPU 无等价处理，仍走 rotate 滤镜
+    if (fabs(rotate_theta) > 1.0) {
+        char rotate_buf[64];
+        snprintf(rotate_buf, sizeof(rotate_buf), "%f*PI/180", rotate_theta);
+        INSERT_FILT("rotate", rotate_buf);
     }
 
     if ((ret = configure_filtergraph(graph, vfilters, filt_src, last_filter)) < 0)
@@ -1986,6 +2308,9 @@ static int audio_thread(void *arg)
                 }
             }
         }
+        /* 解码到 EOF 后不会再有帧入队，唤醒在 audio_wait_frame 中等待的接续 */
+        if (is->auddec.finished == is->auddec.pkt_serial)
+            frame_queue_signal(&is->sampq);
     } while (ret >= 0 || ret == AVERROR(EAGAIN) || ret == AVERROR_EOF);
  the_end:
     if (is->agraph)
@@ -2005,12 +2330,28 @@ static int decoder_start(Decoder *d, int (*fn)(void *), const char *thread_name,
     return 0;
 }
 
+/* 计算 pts/duration 并送入 pictq，frame 的时间基为 tb，scaled 为缩小用的临时帧 */
+static int queue_video_frame(VideoState *is, AVFrame *frame, AVFrame *scaled, AVRational tb, AVRational frame_rate)
+{
+    FrameData *fd = frame->opaque_ref ? (FrameData*)frame->opaque_ref->data : NULL;
+    double duration = (frame_rate.num && frame_rate.den ? av_q2d((AVRational){frame_rate.den, frame_rate.num}) : 0);
+    double pts = (frame->pts == AV_NOPTS_VALUE) ? NAN : frame->pts * av_q2d(tb);
+    int64_t pos = fd ? fd->pkt_pos : -1;
+    int ret;
+
+    if (is->gpu_crop.enabled)
+        apply_gpu_crop(&is->gpu_crop, frame);
+    ret = queue_picture(is, downscale_video_frame(is, frame, scaled), pts, duration, pos, is->viddec.pkt_serial);
+    av_frame_unref(scaled);
+    return ret;
+}
+
 static int video_thread(void *arg)
 {
     VideoState *is = arg;
     AVFrame *frame = av_frame_alloc();
-    double pts;
-    double duration;
+    AVFrame *frame_stale = av_frame_alloc();
+    AVFrame *frame_scaled = av_frame_alloc();
     int ret;
     AVRational tb = is->video_st->time_base;
     AVRational frame_rate = av_guess_frame_rate(is->ic, is->video_st, NULL);
@@ -2022,9 +2363,19 @@ static int video_thread(void *arg)
     enum AVPixelFormat last_format = -2;
     int last_serial = -1;
     int last_vfilter_idx = 0;
-
-    if (!frame)
+    int last_vfilters_serial = -1;
+    int last_target_w = -1;
+    int last_target_h = -1;
+    /* 当前 graph 的配置，seek 后重置有状态的滤镜时原样重建 */
+    char *graph_vfilters = NULL;
+    double graph_rotate = 0;
+
+    if (!frame || !frame_stale || !frame_scaled) {
+        av_frame_free(&frame);
+        av_frame_free(&frame_stale);
+        av_frame_free(&frame_scaled);
         return AVERROR(ENOMEM);
+    }
 
     for (;;) {
         ret = get_video_frame(is, frame);
@@ -2035,11 +2386,28 @@ static int video_thread(void *arg)
             continue;
         }
 
+        // 显示区域变大到超过当前解码尺寸时，请求 read_thread 重新选流或降低 lowres
+        {
+            int target_w, target_h;
+            sky_get_video_target_size(is->skyPlayer, &target_w, &target_h);
+            if (target_w != last_target_w || target_h != last_target_h) {
+                if (last_target_w >= 0 && target_w > 0 && target_h > 0
+                    && !video_covers_target(frame->width, frame->height, target_w, target_h))
+                    is->video_reselect_req = 1;
+                last_target_w = target_w;
+                last_target_h = target_h;
+            }
+        }
+
+        // 只有格式、尺寸或滤镜变化才重建 graph，seek 在下面单独处理
         if (   last_w != frame->width
             || last_h != frame->height
             || last_format != frame->format
-            || last_serial != is->viddec.pkt_serial
-            || last_vfilter_idx != is->vfilter_idx) {
+            || last_vfilter_idx != is->vfilter_idx
+            || last_vfilters_serial != is->vfilters_serial) {
+            char *cpu_vfilters = NULL;
+            double rotate_theta;
+
             av_log(NULL, AV_LOG_DEBUG,
                    "Video frame changed from size:%dx%d format:%s serial:%d to size:%dx%d format:%s serial:%d\n",
                    last_w, last_h,
@@ -2047,27 +2415,91 @@ static int video_thread(void *arg)
                    frame->width, frame->height,
                    (const char *)av_x_if_null(av_get_pix_fmt_name(frame->format), "none"), is->viddec.pkt_serial);
             avfilter_graph_free(&graph);
-            graph = avfilter_graph_alloc();
-            if (!graph) {
-                ret = AVERROR(ENOMEM);
-                goto the_end;
-            }
-            graph->nb_threads = filter_nbthreads;
-            if ((ret = configure_video_filters(graph, is, vfilters_list ? vfilters_list[is->vfilter_idx] : NULL, frame)) < 0) {
-                SDL_Event event;
-                event.type = SDL_EVENT_USER + 2;
-                event.user.data1 = is;
-                SDL_PushEvent(&event);
+            av_freep(&graph_vfilters);
+            filt_in = filt_out = NULL;
+            is->in_video_filter = is->out_video_filter = NULL;
+
+            SDL_LockMutex(is->vfilters_mutex);
+            last_vfilters_serial = is->vfilters_serial;
+            ret = split_gpu_video_filters(is->vfilters ? is->vfilters : (vfilters_list ? vfilters_list[is->vfilter_idx] : NULL),
+                                          &cpu_vfilters, &is->gpu_crop, &is->gpu_eq);
+            SDL_UnlockMutex(is->vfilters_mutex);
+            if (ret < 0)
                 goto the_end;
+            if (is->skyPlayer)
+                sky_set_video_eq(is->skyPlayer, &is->gpu_eq);
+            rotate_theta = update_video_orientation(is, frame);
+
+            // graph 为空操作时解码帧直接送显
+            if (cpu_vfilters || fabs(rotate_theta) > 1.0 || frame->hw_frames_ctx
+                || !is_display_pixel_format(frame->format)) {
+                graph = avfilter_graph_alloc();
+                if (!graph) {
+                    av_free(cpu_vfilters);
+                    ret = AVERROR(ENOMEM);
+                    goto the_end;
+                }
+                graph->nb_threads = filter_nbthreads;
+
+                ret = configure_video_filters(graph, is, cpu_vfilters, rotate_theta, frame);
+                graph_vfilters = cpu_vfilters;
+                graph_rotate = rotate_theta;
+                if (ret < 0) {
+                    SDL_Event event;
+                    event.type = SDL_EVENT_USER + 2;
+                    event.user.data1 = is;
+                    SDL_PushEvent(&event);
+                    goto the_end;
+                }
+                filt_in  = is->in_video_filter;
+                filt_out = is->out_video_filter;
+                frame_rate = av_buffersink_get_frame_rate(filt_out);
+                tb = av_buffersink_get_time_base(filt_out);
+            } else {
+                av_log(NULL, AV_LOG_INFO, "video filtergraph bypassed, format:%s\n",
+                       (const char *)av_x_if_null(av_get_pix_fmt_name(frame->format), "none"));
+                frame_rate = av_guess_frame_rate(is->ic, is->video_st, NULL);
+                tb = is->video_st->time_base;
             }
-            filt_in  = is->in_video_filter;
-            filt_out = is->out_video_filter;
             last_w = frame->width;
             last_h = frame->height;
             last_format = frame->format;
             last_serial = is->viddec.pkt_serial;
             last_vfilter_idx = is->vfilter_idx;
-            frame_rate = av_buffersink_get_frame_rate(filt_out);
+        } else if (last_serial != is->viddec.pkt_serial) {
+            last_serial = is->viddec.pkt_serial;
+            if (graph && video_graph_is_stateful(graph)) {
+                // libavfilter 没有单个滤镜的 reset，按同样的配置换一个新 graph，不重新解析滤镜和旋转
+                AVFilterGraph *fresh = avfilter_graph_alloc();
+                if (!fresh) {
+                    ret = AVERROR(ENOMEM);
+                    goto the_end;
+                }
+                fresh->nb_threads = filter_nbthreads;
+                ret = configure_video_filters(fresh, is, graph_vfilters, graph_rotate, frame);
+                if (ret < 0) {
+                    avfilter_graph_free(&fresh);
+                    goto the_end;
+                }
+                avfilter_graph_free(&graph);
+                graph = fresh;
+                filt_in  = is->in_video_filter;
+                filt_out = is->out_video_filter;
+            } else if (graph) {
+                // 无状态的 graph 保留，只丢弃上一个 serial 残留的帧
+                while (av_buffersink_get_frame_flags(filt_out, frame_stale, 0) >= 0)
+                    av_frame_unref(frame_stale);
+            }
+        }
+
+        if (!graph) {
+            is->frame_last_returned_time = av_gettime_relative() / 1000000.0;
+            is->frame_last_filter_delay = 0;
+            ret = queue_video_frame(is, frame, frame_scaled, tb, frame_rate);
+            av_frame_unref(frame);
+            if (ret < 0)
+                goto the_end;
+            continue;
         }
 
         ret = av_buffersrc_add_frame(filt_in, frame);
@@ -2075,8 +2507,6 @@ static int video_thread(void *arg)
             goto the_end;
 
         while (ret >= 0) {
-            FrameData *fd;
-
             is->frame_last_returned_time = av_gettime_relative() / 1000000.0;
 
             ret = av_buffersink_get_frame_flags(filt_out, frame, 0);
@@ -2088,15 +2518,10 @@ static int video_thread(void *arg)
                 break;
             }
 
-            fd = frame->opaque_ref ? (FrameData*)frame->opaque_ref->data : NULL;
-
             is->frame_last_filter_delay = av_gettime_relative() / 1000000.0 - is->frame_last_returned_time;
             if (fabs(is->frame_last_filter_delay) > AV_NOSYNC_THRESHOLD / 10.0)
                 is->frame_last_filter_delay = 0;
-            tb = av_buffersink_get_time_base(filt_out);
-            duration = (frame_rate.num && frame_rate.den ? av_q2d((AVRational){frame_rate.den, frame_rate.num}) : 0);
-            pts = (frame->pts == AV_NOPTS_VALUE) ? NAN : frame->pts * av_q2d(tb);
-            ret = queue_picture(is, frame, pts, duration, fd ? fd->pkt_pos : -1, is->viddec.pkt_serial);
+            ret = queue_video_frame(is, frame, frame_scaled, tb, frame_rate);
             av_frame_unref(frame);
             if (is->videoq.serial != is->viddec.pkt_serial)
                 break;
@@ -2107,6 +2532,9 @@ static int video_thread(void *arg)
     }
 the_end:
     avfilter_graph_free(&graph);
+    av_freep(&graph_vfilters);
+    av_frame_free(&frame_scaled);
+    av_frame_free(&frame_stale);
     av_frame_free(&frame);
     return 0;
 }
@@ -2127,7 +2555,8 @@ static int subtitle_thread(void *arg)
 
         pts = 0;
 
-        if (got_subtitle && sp->sub.format == 0) {
+        // 位图（format 0）和文本（format 1）字幕都进入 subpq，由 sky_update_subtitle 分别处理
+        if (got_subtitle) {
             if (sp->sub.pts != AV_NOPTS_VALUE)
                 pts = sp->sub.pts / (double)AV_TIME_BASE;
             sp->pts = pts;
@@ -2138,32 +2567,11 @@ static int subtitle_thread(void *arg)
 
             /* now we can update the picture count */
             frame_queue_push(&is->subpq);
-        } else if (got_subtitle) {
-            avsubtitle_free(&sp->sub);
         }
     }
     return 0;
 }
 
-/* copy samples for viewing in editor window */
-static void update_sample_display(VideoState *is, short *samples, int samples_size)
-{
-    int size, len;
-
-    size = samples_size / sizeof(short);
-    while (size > 0) {
-        len = SAMPLE_ARRAY_SIZE - is->sample_array_index;
-        if (len > size)
-            len = size;
-        memcpy(is->sample_array + is->sample_array_index, samples, len * sizeof(short));
-        samples += len;
-        is->sample_array_index += len;
-        if (is->sample_array_index >= SAMPLE_ARRAY_SIZE)
-            is->sample_array_index = 0;
-        size -= len;
-    }
-}
-
 /* return the wanted number of samples to get better sync if sync_type is video
  * or external master clock */
 static int synchronize_audio(VideoState *is, int nb_samples)
@@ -2207,6 +2615,62 @@ static int synchronize_audio(VideoState *is, int nb_samples)
     return wanted_nb_samples;
 }
 
+/**
+ * 5.1/7.1 按 ITU-R BS.775 系数 downmix 到立体声，LFE 丢弃。
+ * s16 输出时按系数和归一化避免削波，float 输出保留余量，与 swr 默认的 rematrix 行为一致。
+ * 返回输入声道数，不需要或不支持时返回 0，交给 swr 处理
+ */
+static int audio_downmix_init(VideoState *is, const AVChannelLayout *layout)
+{
+    float sum = 0.0f;
+    int i;
+
+    if (!audio_downmix_supported(is, layout))
+        return 0;
+
+    for (i = 0; i < layout->nb_channels; i++) {
+        float left = 0.0f, right = 0.0f;
+        switch (av_channel_layout_channel_from_index(layout, i)) {
+        case AV_CHAN_FRONT_LEFT:   left = 1.0f; break;
+        case AV_CHAN_FRONT_RIGHT:  right = 1.0f; break;
+        case AV_CHAN_FRONT_CENTER: left = right = M_SQRT1_2; break;
+        case AV_CHAN_SIDE_LEFT:
+        case AV_CHAN_BACK_LEFT:    left = M_SQRT1_2; break;
+        case AV_CHAN_SIDE_RIGHT:
+        case AV_CHAN_BACK_RIGHT:   right = M_SQRT1_2; break;
+        default: break;
+        }
+        is->audio_downmix_left[i] = left;
+        is->audio_downmix_right[i] = right;
+        sum += left;
+    }
+    if (is->audio_tgt.fmt == AV_SAMPLE_FMT_S16) {
+        for (i = 0; i < layout->nb_channels; i++) {
+            is->audio_downmix_left[i] /= sum;
+            is->audio_downmix_right[i] /= sum;
+        }
+    }
+    return layout->nb_channels;
+}
+
+/* planar float 多声道 -> audio_buf2 中的交错立体声（audio_tgt 格式），返回字节数 */
+static int audio_downmix(VideoState *is, const float *const *planes, int nb_samples)
+{
+    int size = nb_samples * is->audio_tgt.frame_size;
+
+    av_fast_malloc(&is->audio_buf2, &is->audio_buf2_size, size);
+    if (!is->audio_buf2)
+        return AVERROR(ENOMEM);
+    if (is->audio_tgt.fmt == AV_SAMPLE_FMT_FLT)
+        sky_audio_downmix_stereo_f32((float *)is->audio_buf2, planes, nb_samples, is->audio_downmix_channels,
+                                     is->audio_downmix_left, is->audio_downmix_right);
+    else
+        sky_audio_downmix_stereo_s16((int16_t *)is->audio_buf2, planes, nb_samples, is->audio_downmix_channels,
+                                     is->audio_downmix_left, is->audio_downmix_right);
+    is->audio_buf = is->audio_buf2;
+    return size;
+}
+
 /**
  * Decode one audio frame and return its uncompressed size.
  *
@@ -2247,13 +2711,22 @@ static int audio_decode_frame(VideoState *is)
         av_channel_layout_compare(&af->frame->ch_layout, &is->audio_src.ch_layout) ||
         af->frame->sample_rate   != is->audio_src.freq           ||
         (wanted_nb_samples       != af->frame->nb_samples && !is->swr_ctx)) {
-        int ret;
+        int ret = 0;
         swr_free(&is->swr_ctx);
-        ret = swr_alloc_set_opts2(&is->swr_ctx,
-                            &is->audio_tgt.ch_layout, is->audio_tgt.fmt, is->audio_tgt.freq,
-                            &af->frame->ch_layout, af->frame->format, af->frame->sample_rate,
-                            0, NULL);
-        if (ret < 0 || swr_init(is->swr_ctx) < 0) {
+        is->audio_downmix_channels = audio_downmix_init(is, &af->frame->ch_layout);
+        /* downmix 时 swr 只做重采样/格式转换，输出 planar float 多声道；解码器直出 fltp 且无需重采样时不用 swr */
+        if (!is->audio_downmix_channels)
+            ret = swr_alloc_set_opts2(&is->swr_ctx,
+                                &is->audio_tgt.ch_layout, is->audio_tgt.fmt, is->audio_tgt.freq,
+                                &af->frame->ch_layout, af->frame->format, af->frame->sample_rate,
+                                0, NULL);
+        else if (af->frame->format != AV_SAMPLE_FMT_FLTP || af->frame->sample_rate != is->audio_tgt.freq ||
+                 wanted_nb_samples != af->frame->nb_samples)
+            ret = swr_alloc_set_opts2(&is->swr_ctx,
+                                &af->frame->ch_layout, AV_SAMPLE_FMT_FLTP, is->audio_tgt.freq,
+                                &af->frame->ch_layout, af->frame->format, af->frame->sample_rate,
+                                0, NULL);
+        if (ret < 0 || (is->swr_ctx && swr_init(is->swr_ctx) < 0)) {
             av_log(NULL, AV_LOG_ERROR,
                    "Cannot create sample rate converter for conversion of %d Hz %s %d channels to %d Hz %s %d channels!\n",
                     af->frame->sample_rate, av_get_sample_fmt_name(af->frame->format), af->frame->ch_layout.nb_channels,
@@ -2269,9 +2742,11 @@ static int audio_decode_frame(VideoState *is)
 
     if (is->swr_ctx) {
         const uint8_t **in = (const uint8_t **)af->frame->extended_data;
-        uint8_t **out = &is->audio_buf1;
+        uint8_t *out[SKY_AUDIO_DOWNMIX_MAX_CHANNELS];
+        int out_channels = is->audio_downmix_channels ? is->audio_downmix_channels : is->audio_tgt.ch_layout.nb_channels;
+        enum AVSampleFormat out_fmt = is->audio_downmix_channels ? AV_SAMPLE_FMT_FLTP : is->audio_tgt.fmt;
         int out_count = (int64_t)wanted_nb_samples * is->audio_tgt.freq / af->frame->sample_rate + 256;
-        int out_size  = av_samples_get_buffer_size(NULL, is->audio_tgt.ch_layout.nb_channels, out_count, is->audio_tgt.fmt, 0);
+        int out_size  = av_samples_get_buffer_size(NULL, out_channels, out_count, out_fmt, 0);
         int len2;
         if (out_size < 0) {
             av_log(NULL, AV_LOG_ERROR, "av_samples_get_buffer_size() failed\n");
@@ -2287,6 +2762,8 @@ static int audio_decode_frame(VideoState *is)
         av_fast_malloc(&is->audio_buf1, &is->audio_buf1_size, out_size);
         if (!is->audio_buf1)
             return AVERROR(ENOMEM);
+        if (av_samples_fill_arrays(out, NULL, is->audio_buf1, out_channels, out_count, out_fmt, 0) < 0)
+            return -1;
         len2 = swr_convert(is->swr_ctx, out, out_count, in, af->frame->nb_samples);
         if (len2 < 0) {
             av_log(NULL, AV_LOG_ERROR, "swr_convert() failed\n");
@@ -2297,12 +2774,23 @@ static int audio_decode_frame(VideoState *is)
             if (swr_init(is->swr_ctx) < 0)
                 swr_free(&is->swr_ctx);
         }
-        is->audio_buf = is->audio_buf1;
-        resampled_data_size = len2 * is->audio_tgt.ch_layout.nb_channels * av_get_bytes_per_sample(is->audio_tgt.fmt);
+        if (is->audio_downmix_channels) {
+            resampled_data_size = audio_downmix(is, (const float *const *)out, len2);
+        } else {
+            is->audio_buf = is->audio_buf1;
+            resampled_data_size = len2 * is->audio_tgt.ch_layout.nb_channels * av_get_bytes_per_sample(is->audio_tgt.fmt);
+        }
+    } else if (is->audio_downmix_channels) {
+        resampled_data_size = audio_downmix(is, (const float *const *)af->frame->extended_data, af->frame->nb_samples);
     } else {
         is->audio_buf = af->frame->data[0];
         resampled_data_size = data_size;
     }
+    if (resampled_data_size < 0)
+        return resampled_data_size;
+    if (is->audio_tap_enabled)
+        sky_pcm_tap_write(is->skyPlayer, is->audio_buf, resampled_data_size, is->audio_tgt.fmt,
+                          is->audio_tgt.ch_layout.nb_channels, is->audio_tgt.freq);
 
     audio_clock0 = is->audio_clock;
     /* update the audio clock with the pts */
@@ -2323,24 +2811,105 @@ static int audio_decode_frame(VideoState *is)
     return resampled_data_size;
 }
 
+/* 音量/静音变化时在 AUDIO_GAIN_RAMP_MS 内渐变到目标增益，避免爆音 */
+static void audio_copy_with_gain(VideoState *is, uint8_t *dst, const uint8_t *src, int len)
+{
+    const int frame_size = is->audio_tgt.frame_size;
+    const int channels = is->audio_tgt.ch_layout.nb_channels;
+    const int is_flt = is->audio_tgt.fmt == AV_SAMPLE_FMT_FLT;
+    const int sample_size = is_flt ? sizeof(float) : sizeof(int16_t);
+    float target = is->muted ? 0.0f : (float)is->audio_volume / SDL_MIX_MAXVOLUME;
+    int frames = len / frame_size;
+
+    if (!src) {
+        memset(dst, 0, len);
+        is->audio_gain = 0.0f;
+        return;
+    }
+
+    if (is->audio_gain != target) {
+        /* 满幅变化用 AUDIO_GAIN_RAMP_MS，本次回调放不下的部分留到下次继续 */
+        int ramp_total = FFMAX(is->audio_tgt.freq * AUDIO_GAIN_RAMP_MS / 1000, 1);
+        int ramp_frames = (int)ceilf(fabsf(target - is->audio_gain) * ramp_total);
+        float gain1 = target;
+        if (ramp_frames > frames) {
+            ramp_frames = frames;
+            gain1 = is->audio_gain + (target > is->audio_gain ? 1.0f : -1.0f) * frames / ramp_total;
+        }
+
+        if (is_flt)
+            sky_audio_ramp_f32((float *)dst, (const float *)src, ramp_frames, channels, is->audio_gain, gain1);
+        else
+            sky_audio_ramp_s16((int16_t *)dst, (const int16_t *)src, ramp_frames, channels, is->audio_gain, gain1);
+        is->audio_gain = gain1;
+        dst += ramp_frames * frame_size;
+        src += ramp_frames * frame_size;
+        len -= ramp_frames * frame_size;
+    }
+
+    if (is_flt)
+        sky_audio_gain_f32((float *)dst, (const float *)src, len / sample_size, is->audio_gain);
+    else
+        sky_audio_gain_s16((int16_t *)dst, (const int16_t *)src, len / sample_size, is->audio_gain);
+}
+
+/* 播放列表接续时等待下一帧音频：1 有帧可读，0 本项音频已全部交出，-1 超时（输出静音） */
+static int audio_wait_frame(VideoState *is)
+{
+    FrameQueue *f = &is->sampq;
+    int64_t deadline = av_gettime_relative() + AUDIO_DRAIN_WAIT_US;
+    int64_t remaining;
+    int ready = -1;
+
+    /* 新帧入队和解码到 EOF 时 audio_thread 都会唤醒 sampq */
+    SDL_LockMutex(f->mutex);
+    while (!f->pktq->abort_request) {
+        if (f->size - f->rindex_shown > 0) {
+            ready = 1;
+            break;
+        }
+        if (is->auddec.finished == is->audioq.serial) {
+            ready = 0;
+            break;
+        }
+        remaining = deadline - av_gettime_relative();
+        if (remaining <= 0)
+            break;
+        SDL_WaitConditionTimeout(f->cond, f->mutex, (Sint32)((remaining + 999) / 1000));
+    }
+    SDL_UnlockMutex(f->mutex);
+    return ready;
+}
+
 /* prepare a new audio buffer_ */
-static void sdl_audio_callback(void *opaque, Uint8 *stream, int len)
+int stream_audio_fill(VideoState *is, Uint8 *stream, int len, int offset, int stop_at_end)
 {
-    VideoState *is = opaque;
-    int audio_size, len1;
+    int audio_size, len1, ready;
+    const int callback_len = len;
 
     audio_callback_time = av_gettime_relative();
+    stream += offset;
+    len -= offset;
+
+    if (!is->audio_st) {
+        /* 没有音频流（播放列表中的纯视频项）时输出静音，视频播完即交出 */
+        if (stop_at_end && is->playback_ended)
+            return offset;
+        memset(stream, 0, len);
+        return callback_len;
+    }
 
     while (len > 0) {
         if (is->audio_buf_index >= is->audio_buf_size) {
-           audio_size = audio_decode_frame(is);
+           ready = stop_at_end && !is->paused ? audio_wait_frame(is) : 1;
+           if (ready == 0)
+               break;
+           audio_size = ready > 0 ? audio_decode_frame(is) : -1;
            if (audio_size < 0) {
                 /* if error, just output silence */
                is->audio_buf = NULL;
                is->audio_buf_size = SDL_AUDIO_MIN_BUFFER_SIZE / is->audio_tgt.frame_size * is->audio_tgt.frame_size;
            } else {
-               if (is->show_mode != SHOW_MODE_VIDEO)
-                   update_sample_display(is, (int16_t *)is->audio_buf, audio_size);
                is->audio_buf_size = audio_size;
            }
            is->audio_buf_index = 0;
@@ -2358,44 +2927,39 @@ static void sdl_audio_callback(void *opaque, Uint8 *stream, int len)
             __android_log_print(ANDROID_LOG_INFO, "SkyPlayer", "sdl_audio_callback: Decoder serial synchronized to %d, continuing audio processing",
                    is->auddec.pkt_serial);
 #endif
-            return;
+            return callback_len;
         }
 
         len1 = is->audio_buf_size - is->audio_buf_index;
         if (len1 > len)
             len1 = len;
-        if (!is->muted && is->audio_buf && is->audio_volume == SDL_MIX_MAXVOLUME)
-            memcpy(stream, (uint8_t *)is->audio_buf + is->audio_buf_index, len1);
-        else {
-            memset(stream, 0, len1);
-            if (!is->muted && is->audio_buf)
-                SDL_MixAudio(stream, (uint8_t *)is->audio_buf + is->audio_buf_index, SDL_AUDIO_S16, len1, is->audio_volume);
-        }
+        audio_copy_with_gain(is, stream, is->audio_buf ? (uint8_t *)is->audio_buf + is->audio_buf_index : NULL, len1);
         len -= len1;
         stream += len1;
         is->audio_buf_index += len1;
     }
     is->audio_write_buf_size = is->audio_buf_size - is->audio_buf_index;
 
-    /* Compensate for audio buffer latency - OpenSL ES has significant buffering */
+    /* 设备队列中还没播放的 + 本次写入的 + audio_buf 中剩余的，设备部分由播放位置得到 */
     if (!isnan(is->audio_clock)) {
-        // 对于OpenSL ES，需要考虑更大的缓冲延迟
-        // 估算总的音频延迟：硬件缓冲 + 写入缓冲 + OpenSL ES额外延迟
-        double opensles_extra_latency = 0.050; // 50ms额外延迟估算
-        double total_audio_latency = (double)(2 * is->audio_hw_buf_size + is->audio_write_buf_size) / is->audio_tgt.bytes_per_sec + opensles_extra_latency;
+        double total_audio_latency = sky_get_audio_latency(is->skyPlayer)
+                                     + (double)(callback_len + is->audio_write_buf_size) / is->audio_tgt.bytes_per_sec;
 
         set_clock_at(&is->audclk, is->audio_clock - total_audio_latency, is->audio_clock_serial, audio_callback_time / 1000000.0);
         sync_clock_to_slave(&is->extclk, &is->audclk);
     }
+    return callback_len - len;
+}
+
+static void sdl_audio_callback(void *opaque, Uint8 *stream, int len)
+{
+    stream_audio_fill(opaque, stream, len, 0, 0);
 }
 
 static int audio_open(void *opaque, AVChannelLayout *wanted_channel_layout, int wanted_sample_rate, struct AudioParams *audio_hw_params)
 {
     SkyAudioSpec wanted_spec, spec;
     const char *env;
-    static const int next_nb_channels[] = {0, 0, 1, 6, 2, 6, 4, 6};
-    static const int next_sample_rates[] = {0, 44100, 48000, 96000, 192000};
-    int next_sample_rate_idx = FF_ARRAY_ELEMS(next_sample_rates) - 1;
     int wanted_nb_channels = wanted_channel_layout->nb_channels;
 
     env = SDL_getenv("SDL_AUDIO_CHANNELS");
@@ -2415,71 +2979,53 @@ static int audio_open(void *opaque, AVChannelLayout *wanted_channel_layout, int
         av_log(NULL, AV_LOG_ERROR, "Invalid sample rate or channel count!\n");
         return -1;
     }
-    while (next_sample_rate_idx && next_sample_rates[next_sample_rate_idx] >= wanted_spec.sdl_audioSpec.freq)
-        next_sample_rate_idx--;
-    wanted_spec.sdl_audioSpec.format = SDL_AUDIO_S16;
+    wanted_spec.sdl_audioSpec.format = audio_output_float ? SDL_AUDIO_F32 : SDL_AUDIO_S16;
     wanted_spec.silence = 0;
     wanted_spec.samples = FFMAX(SDL_AUDIO_MIN_BUFFER_SIZE, 2 << av_log2(wanted_spec.sdl_audioSpec.freq / SDL_AUDIO_MAX_CALLBACKS_PER_SEC));
     wanted_spec.callback = sdl_audio_callback;
     wanted_spec.userdata = opaque;
 
-    // sky_open_audio - 直接使用自定义音频输出，支持多次重试
     VideoState *is = (VideoState *)opaque;
-    if (!is || !is->skyPlayer) {
-        av_log(NULL, AV_LOG_ERROR, "SkyPlayer not available\n");
-        return -1;
-    }
-
-    av_log(NULL, AV_LOG_INFO, "Opening audio with SkyPlayer (OpenSL ES)\n");
-
-    // 尝试不同的音频参数组合
-    int retry_sample_rate_idx = next_sample_rate_idx;
-    int original_wanted_nb_channels = wanted_nb_channels;
-
-    while (1) {
-        av_log(NULL, AV_LOG_INFO, "SkyPlayer trying: %d channels, %d Hz\n",
-               wanted_spec.sdl_audioSpec.channels, wanted_spec.sdl_audioSpec.freq);
-
-        if (sky_open_audio(is->skyPlayer, &wanted_spec, &spec)) {
-            av_log(NULL, AV_LOG_INFO, "SkyPlayer audio opened successfully with %d channels, %d Hz\n",
-                   spec.sdl_audioSpec.channels, spec.sdl_audioSpec.freq);
-
-            // 使用获得的音频参数更新 audio_hw_params
-            audio_hw_params->fmt = AV_SAMPLE_FMT_S16;
-            audio_hw_params->freq = spec.sdl_audioSpec.freq;
-            if (av_channel_layout_copy(&audio_hw_params->ch_layout, wanted_channel_layout) < 0)
-                return -1;
-            audio_hw_params->frame_size = av_samples_get_buffer_size(NULL, audio_hw_params->ch_layout.nb_channels, 1, audio_hw_params->fmt, 1);
-            audio_hw_params->bytes_per_sec = av_samples_get_buffer_size(NULL, audio_hw_params->ch_layout.nb_channels, audio_hw_params->freq, audio_hw_params->fmt, 1);
-
-            if (audio_hw_params->bytes_per_sec <= 0 || audio_hw_params->frame_size <= 0) {
-                av_log(NULL, AV_LOG_ERROR, "av_samples_get_buffer_size failed\n");
-                return -1;
-            }
-
-            return spec.size;
+    if (is && is->audio_preset.sdl_audioSpec.freq > 0) {
+        /* 预加载的播放列表项不打开设备，直接按正在播放的设备参数重采样，接续时写入同一个设备 */
+        spec = is->audio_preset;
+        av_log(NULL, AV_LOG_INFO, "Preloaded audio uses the opened device: %d channels, %d Hz\n",
+               spec.sdl_audioSpec.channels, spec.sdl_audioSpec.freq);
+    } else {
+        if (!is || !is->skyPlayer) {
+            av_log(NULL, AV_LOG_ERROR, "SkyPlayer not available\n");
+            return -1;
         }
 
-        av_log(NULL, AV_LOG_WARNING, "SkyPlayer audio open failed (%d channels, %d Hz)\n",
+        /* 只打开一次设备：输出端把不支持的声道数协商为立体声写回 spec，多声道由 audio_decode_frame 做 downmix */
+        av_log(NULL, AV_LOG_INFO, "Opening audio with SkyPlayer: %d channels, %d Hz\n",
                wanted_spec.sdl_audioSpec.channels, wanted_spec.sdl_audioSpec.freq);
-
-        // 尝试下一个声道数配置
-        wanted_spec.sdl_audioSpec.channels = next_nb_channels[FFMIN(7, wanted_spec.sdl_audioSpec.channels)];
-        if (!wanted_spec.sdl_audioSpec.channels) {
-            // 声道数用完了，尝试下一个采样率
-            wanted_spec.sdl_audioSpec.freq = next_sample_rates[retry_sample_rate_idx--];
-            wanted_spec.sdl_audioSpec.channels = original_wanted_nb_channels;
-            if (!wanted_spec.sdl_audioSpec.freq) {
-                av_log(NULL, AV_LOG_ERROR,
-                       "SkyPlayer: No more combinations to try, audio open failed\n");
-                return -1;
-            }
+        if (!sky_open_audio(is->skyPlayer, &wanted_spec, &spec)) {
+            av_log(NULL, AV_LOG_ERROR, "SkyPlayer audio open failed (%d channels, %d Hz)\n",
+                   wanted_spec.sdl_audioSpec.channels, wanted_spec.sdl_audioSpec.freq);
+            return -1;
         }
+        av_log(NULL, AV_LOG_INFO, "SkyPlayer audio opened with %d channels, %d Hz, %s, gain kernels: %s\n",
+               spec.sdl_audioSpec.channels, spec.sdl_audioSpec.freq,
+               spec.sdl_audioSpec.format == SDL_AUDIO_F32 ? "f32" : "s16", sky_audio_kernels_impl());
+    }
 
-        // 更新声道布局
-        av_channel_layout_uninit(wanted_channel_layout);
-        av_channel_layout_default(wanted_channel_layout, wanted_spec.sdl_audioSpec.channels);
+    audio_hw_params->fmt = spec.sdl_audioSpec.format == SDL_AUDIO_F32 ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S16;
+    audio_hw_params->freq = spec.sdl_audioSpec.freq;
+    if (spec.sdl_audioSpec.channels == wanted_nb_channels) {
+        if (av_channel_layout_copy(&audio_hw_params->ch_layout, wanted_channel_layout) < 0)
+            return -1;
+    } else {
+        av_channel_layout_uninit(&audio_hw_params->ch_layout);
+        av_channel_layout_default(&audio_hw_params->ch_layout, spec.sdl_audioSpec.channels);
+    }
+    audio_hw_params->frame_size = av_samples_get_buffer_size(NULL, audio_hw_params->ch_layout.nb_channels, 1, audio_hw_params->fmt, 1);
+    audio_hw_params->bytes_per_sec = av_samples_get_buffer_size(NULL, audio_hw_params->ch_layout.nb_channels, audio_hw_params->freq, audio_hw_params->fmt, 1);
+    if (audio_hw_params->bytes_per_sec <= 0 || audio_hw_params->frame_size <= 0) {
+        av_log(NULL, AV_LOG_ERROR, "av_samples_get_buffer_size failed\n");
+        return -1;
     }
+    return spec.size;
 }
 
 /* open a given stream. Return 0 if OK */
@@ -2527,6 +3073,13 @@ static int stream_component_open(VideoState *is, int stream_index)
     }
 
     avctx->codec_id = codec->id;
+    // 未指定 lowres 时按显示区域自动选择，IDCT 阶段直接输出小图
+    if (!lowres && avctx->codec_type == AVMEDIA_TYPE_VIDEO && codec->max_lowres > 0) {
+        int target_w, target_h;
+        sky_get_video_target_size(is->skyPlayer, &target_w, &target_h);
+        stream_lowres = FFMIN(video_downscale_shift(avctx->width, avctx->height, target_w, target_h),
+                              codec->max_lowres);
+    }
     if (stream_lowres > codec->max_lowres) {
         av_log(avctx, AV_LOG_WARNING, "The maximum value for lowres supported by the decoder is %d\n",
                 codec->max_lowres);
@@ -2643,7 +3196,8 @@ static int stream_component_open(VideoState *is, int stream_index)
         }
         if ((ret = decoder_start(&is->auddec, audio_thread, "audio_decoder", is)) < 0)
             goto out;
-        sky_pause_audio(is->skyPlayer, 0);
+        if (is->skyPlayer)
+            sky_pause_audio(is->skyPlayer, 0);
 
         // 发送音频解码开始消息
         sky_post_simple_message(is->skyPlayer, SKY_MSG_AUDIO_DECODED_START);
@@ -2651,6 +3205,8 @@ static int stream_component_open(VideoState *is, int stream_index)
     case AVMEDIA_TYPE_VIDEO:
         is->video_stream = stream_index;
         is->video_st = ic->streams[stream_index];
+        is->video_lowres = stream_lowres;
+        is->video_reselect_req = 0;
 
         if ((ret = decoder_init(&is->viddec, avctx, &is->videoq, is->continue_read_thread)) < 0)
             goto fail;
@@ -2658,9 +3214,10 @@ static int stream_component_open(VideoState *is, int stream_index)
             goto out;
         is->queue_attachments_req = 1;
 
-        // 发送视频尺寸变化消息
-        if (avctx->width > 0 && avctx->height > 0) {
-            sky_post_message_ii(is->skyPlayer, SKY_MSG_VIDEO_SIZE_CHANGED, avctx->width, avctx->height);
+        // 发送视频尺寸变化消息，lowres 下 avctx 的尺寸已缩小，上报原始尺寸
+        if (is->video_st->codecpar->width > 0 && is->video_st->codecpar->height > 0) {
+            sky_post_message_ii(is->skyPlayer, SKY_MSG_VIDEO_SIZE_CHANGED,
+                                is->video_st->codecpar->width, is->video_st->codecpar->height);
         }
         break;
     case AVMEDIA_TYPE_SUBTITLE:
@@ -2719,6 +3276,87 @@ static int is_realtime(AVFormatContext *s)
 }
 
 /* this thread gets the stream from the disk or the network */
+/* 显示区域变大后重新选择视频流和 lowres，有变化时重开视频解码器并 seek 回当前位置 */
+static void reselect_video_stream(VideoState *is)
+{
+    int index = select_video_variant(is, is->video_stream);
+    int wanted_lowres = is->video_lowres;
+    int target_w, target_h;
+    double pos;
+
+    if (index < 0)
+        return;
+    if (!lowres && is->viddec.avctx && is->viddec.avctx->codec->max_lowres > 0) {
+        AVCodecParameters *par = is->ic->streams[index]->codecpar;
+        sky_get_video_target_size(is->skyPlayer, &target_w, &target_h);
+        wanted_lowres = FFMIN(video_downscale_shift(par->width, par->height, target_w, target_h),
+                              is->viddec.avctx->codec->max_lowres);
+    }
+    if (index == is->video_stream && wanted_lowres == is->video_lowres)
+        return;
+
+    pos = get_master_clock(is);
+    av_log(NULL, AV_LOG_INFO, "Reopen video stream #%d lowres %d -> #%d lowres %d\n",
+           is->video_stream, is->video_lowres, index, wanted_lowres);
+    stream_component_close(is, is->video_stream);
+    stream_component_open(is, index);
+    if (!isnan(pos))
+        stream_seek(is, (int64_t)(pos * AV_TIME_BASE), 0, 0);
+}
+
+static void set_video_suspended_state(VideoState *is, int suspended)
+{
+    SDL_LockMutex(is->video_resume_mutex);
+    is->video_suspended = suspended;
+    SDL_SignalCondition(is->video_resume_cond);
+    SDL_UnlockMutex(is->video_resume_mutex);
+}
+
+/* 应用视频挂起/恢复请求，只在 read_thread 中调用 */
+static void update_video_suspend(VideoState *is)
+{
+    double pos;
+    int64_t target;
+
+    if (!is->video_st) {
+        set_video_suspended_state(is, is->video_suspend_req);
+        return;
+    }
+
+    if (is->video_suspend_req) {
+        // demuxer 不再输出视频包，解码线程在空队列上等待，刷新线程停在 video_resume_cond 上
+        is->video_st->discard = AVDISCARD_ALL;
+        packet_queue_flush(&is->videoq);
+        set_video_suspended_state(is, 1);
+        av_log(NULL, AV_LOG_INFO, "Video stream #%d suspended\n", is->video_stream);
+        return;
+    }
+
+    is->video_st->discard = AVDISCARD_DEFAULT;
+    packet_queue_flush(&is->videoq);
+    set_video_suspended_state(is, 0);
+
+    if (is->video_st->disposition & AV_DISPOSITION_ATTACHED_PIC) {
+        is->queue_attachments_req = 1;
+        return;
+    }
+
+    // 只回退到音频时钟之前最近的关键帧，音频队列保留，早于该关键帧的视频帧由 video_refresh 丢弃
+    pos = is->audio_st ? get_clock(&is->audclk) : get_master_clock(is);
+    if (isnan(pos))
+        return;
+    target = (int64_t)(pos * AV_TIME_BASE);
+    if (avformat_seek_file(is->ic, -1, INT64_MIN, target, target, 0) < 0) {
+        av_log(NULL, AV_LOG_WARNING, "%s: seek to keyframe failed, video resumes at next keyframe\n",
+               is->ic->url);
+        return;
+    }
+    is->audio_skip_ts = is->audio_last_ts;
+    is->subtitle_skip_ts = is->subtitle_last_ts;
+    is->eof = 0;
+    av_log(NULL, AV_LOG_INFO, "Video stream #%d resumed at %.3f\n", is->video_stream, pos);
+}
+
 static int read_thread(void *arg)
 {
     VideoState *is = arg;
@@ -2761,9 +3399,19 @@ static int read_thread(void *arg)
         scan_all_pmts_set = 1;
     }
 
+    // 发送打开输入消息
+    sky_post_simple_message(is->skyPlayer, SKY_MSG_OPEN_INPUT);
+
+    is->custom_io = sky_io_open(is->filename, &ic->interrupt_callback);
+    if (is->custom_io) {
+        ic->pb = is->custom_io;
+        ic->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
     // ========== 网络播放参数配置 (方案A) ==========
-    // 只对网络协议（http/https/rtmp/rtsp等）设置网络选项
-    if (strstr(is->filename, "://") != NULL &&
+    // 只对网络协议（http/https/rtmp/rtsp等）设置网络选项；自定义 IO（预加载）自己回源，
+    // 协议选项不会被 avformat_open_input 消费，设置了会被当作未知选项报错
+    if (!is->custom_io && strstr(is->filename, "://") != NULL &&
         (strncmp(is->filename, "http://", 7) == 0 ||
          strncmp(is->filename, "https://", 8) == 0 ||
          strncmp(is->filename, "rtmp://", 7) == 0 ||
@@ -2785,9 +3433,6 @@ static int read_thread(void *arg)
     }
     // ========== 网络播放参数配置结束 ==========
 
-    // 发送打开输入消息
-    sky_post_simple_message(is->skyPlayer, SKY_MSG_OPEN_INPUT);
-
     err = avformat_open_input(&ic, is->filename, is->iformat, &format_opts);
     if (err < 0) {
         print_error(is->filename, err);
@@ -2890,10 +3535,13 @@ static int read_thread(void *arg)
         }
     }
 
-    if (!video_disable)
+    if (!video_disable) {
         st_index[AVMEDIA_TYPE_VIDEO] =
             av_find_best_stream(ic, AVMEDIA_TYPE_VIDEO,
                                 st_index[AVMEDIA_TYPE_VIDEO], -1, NULL, 0);
+        if (!wanted_stream_spec[AVMEDIA_TYPE_VIDEO])
+            st_index[AVMEDIA_TYPE_VIDEO] = select_video_variant(is, st_index[AVMEDIA_TYPE_VIDEO]);
+    }
     if (!audio_disable)
         st_index[AVMEDIA_TYPE_AUDIO] =
             av_find_best_stream(ic, AVMEDIA_TYPE_AUDIO,
@@ -2929,7 +3577,7 @@ static int read_thread(void *arg)
         ret = stream_component_open(is, st_index[AVMEDIA_TYPE_VIDEO]);
     }
     if (is->show_mode == SHOW_MODE_NONE)
-        is->show_mode = ret >= 0 ? SHOW_MODE_VIDEO : SHOW_MODE_RDFT;
+        is->show_mode = ret >= 0 ? SHOW_MODE_VIDEO : SHOW_MODE_NONE;
 
     if (st_index[AVMEDIA_TYPE_SUBTITLE] >= 0) {
         stream_component_open(is, st_index[AVMEDIA_TYPE_SUBTITLE]);
@@ -2946,6 +3594,7 @@ static int read_thread(void *arg)
         infinite_buffer = 1;
 
     // 数据准备好
+    is->read_status = 1;
     sky_post_simple_message(is->skyPlayer, SKY_MSG_PREPARED);
 
     for (;;) {
@@ -2968,6 +3617,13 @@ static int read_thread(void *arg)
             continue;
         }
 #endif
+        if (is->video_suspend_req != is->video_suspended)
+            update_video_suspend(is);
+        if (is->video_reselect_req) {
+            is->video_reselect_req = 0;
+            if (!wanted_stream_spec[AVMEDIA_TYPE_VIDEO] && !is->video_suspended)
+                reselect_video_stream(is);
+        }
         if (is->seek_req) {
             int64_t seek_target = is->seek_pos;
             int64_t seek_min    = is->seek_rel > 0 ? seek_target - is->seek_rel + 2: INT64_MIN;
@@ -2986,6 +3642,8 @@ static int read_thread(void *arg)
                     packet_queue_flush(&is->subtitleq);
                 if (is->video_stream >= 0)
                     packet_queue_flush(&is->videoq);
+                is->audio_last_ts = is->audio_skip_ts = AV_NOPTS_VALUE;
+                is->subtitle_last_ts = is->subtitle_skip_ts = AV_NOPTS_VALUE;
                 if (is->seek_flags & AVSEEK_FLAG_BYTE) {
                    set_clock(&is->extclk, NAN, 0);
                 } else {
@@ -2998,6 +3656,7 @@ static int read_thread(void *arg)
             is->seek_req = 0;
             is->queue_attachments_req = 1;
             is->eof = 0;
+            is->playback_ended = 0;
             if (is->paused)
                 step_to_next_frame(is);
         }
@@ -3015,7 +3674,7 @@ static int read_thread(void *arg)
         if (infinite_buffer<1 &&
               (is->audioq.size + is->videoq.size + is->subtitleq.size > MAX_QUEUE_SIZE
             || (stream_has_enough_packets(is->audio_st, is->audio_stream, &is->audioq) &&
-                stream_has_enough_packets(is->video_st, is->video_stream, &is->videoq) &&
+                stream_has_enough_packets(is->video_st, is->video_suspended ? -1 : is->video_stream, &is->videoq) &&
                 stream_has_enough_packets(is->subtitle_st, is->subtitle_stream, &is->subtitleq)))) {
 
             // ========== 缓冲进度上报 (方案A) ==========
@@ -3043,7 +3702,12 @@ static int read_thread(void *arg)
         }
         if (!is->paused &&
             (!is->audio_st || (is->auddec.finished == is->audioq.serial && frame_queue_nb_remaining(&is->sampq) == 0)) &&
-            (!is->video_st || (is->viddec.finished == is->videoq.serial && frame_queue_nb_remaining(&is->pictq) == 0))) {
+            (!is->video_st || is->video_suspended || (is->viddec.finished == is->videoq.serial && frame_queue_nb_remaining(&is->pictq) == 0))) {
+            // SKY_MSG_COMPLETED 在读到文件尾时发出，这里才是真正播完
+            if (!is->playback_ended) {
+                is->playback_ended = 1;
+                sky_post_simple_message(is->skyPlayer, SKY_MSG_PLAYBACK_END);
+            }
             if (loop != 1 && (!loop || --loop)) {
                 stream_seek(is, start_time != AV_NOPTS_VALUE ? start_time : 0, 0, 0);
             } else if (autoexit) {
@@ -3087,11 +3751,28 @@ static int read_thread(void *arg)
                 (double)(start_time != AV_NOPTS_VALUE ? start_time : 0) / 1000000
                 <= ((double)duration / 1000000);
         if (pkt->stream_index == is->audio_stream && pkt_in_play_range) {
+            if (is->audio_skip_ts != AV_NOPTS_VALUE) {
+                if (pkt_ts != AV_NOPTS_VALUE && pkt_ts <= is->audio_skip_ts) {
+                    av_packet_unref(pkt);
+                    continue;
+                }
+                is->audio_skip_ts = AV_NOPTS_VALUE;
+            }
+            is->audio_last_ts = pkt_ts;
             packet_queue_put(&is->audioq, pkt);
         } else if (pkt->stream_index == is->video_stream && pkt_in_play_range
                    && !(is->video_st->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
             packet_queue_put(&is->videoq, pkt);
         } else if (pkt->stream_index == is->subtitle_stream && pkt_in_play_range) {
+            // 字幕已经显示过的包同样丢弃，否则恢复后会重复显示
+            if (is->subtitle_skip_ts != AV_NOPTS_VALUE) {
+                if (pkt_ts != AV_NOPTS_VALUE && pkt_ts <= is->subtitle_skip_ts) {
+                    av_packet_unref(pkt);
+                    continue;
+                }
+                is->subtitle_skip_ts = AV_NOPTS_VALUE;
+            }
+            is->subtitle_last_ts = pkt_ts;
             packet_queue_put(&is->subtitleq, pkt);
         } else {
             av_packet_unref(pkt);
@@ -3104,6 +3785,8 @@ static int read_thread(void *arg)
         avformat_close_input(&ic);
 
     av_packet_free(&pkt);
+    if (!is->read_status)
+        is->read_status = ret < 0 ? ret : AVERROR_EXIT;
     if (ret != 0) {
         SDL_Event event;
 
@@ -3124,12 +3807,22 @@ static int refresh_thread(void *arg)
     av_log(NULL, AV_LOG_INFO, "Refresh thread started\n");
 
     while (!is->refresh_thread_abort && is && !is->abort_request) {
+        // 视频挂起或纯音频时不刷新，等待恢复；在锁内检查条件，恢复信号不会丢失，超时兜底退出标志和 show_mode 的检查
+        SDL_LockMutex(is->video_resume_mutex);
+        if (is->video_suspended || is->show_mode == SHOW_MODE_NONE) {
+            if (!is->refresh_thread_abort)
+                SDL_WaitConditionTimeout(is->video_resume_cond, is->video_resume_mutex, 100);
+            SDL_UnlockMutex(is->video_resume_mutex);
+            remaining_time = 0.0;
+            continue;
+        }
+        SDL_UnlockMutex(is->video_resume_mutex);
         if (remaining_time > 0.0)
             av_usleep((int64_t)(remaining_time * 1000000.0));
 
         remaining_time = REFRESH_RATE;
-        // 只处理视频刷新，不处理SDL事件
-        if (is->show_mode != SHOW_MODE_NONE && (!is->paused || is->force_refresh)) {
+        // 只处理视频刷新，不处理SDL事件；播放列表接续后等切换时不取帧
+        if (is->show_mode != SHOW_MODE_NONE && !is->video_hold && (!is->paused || is->force_refresh)) {
             video_refresh(is, &remaining_time);
         }
     }
@@ -3160,7 +3853,10 @@ static void stop_refresh_thread(VideoState *is)
 {
     if (is->refresh_tid) {
         av_log(NULL, AV_LOG_INFO, "Stopping refresh thread\n");
+        SDL_LockMutex(is->video_resume_mutex);
         is->refresh_thread_abort = 1;
+        SDL_SignalCondition(is->video_resume_cond);
+        SDL_UnlockMutex(is->video_resume_mutex);
         SDL_WaitThread(is->refresh_tid, NULL);
         is->refresh_tid = NULL;
         av_log(NULL, AV_LOG_INFO, "Refresh thread stopped\n");
@@ -3177,19 +3873,21 @@ static void simple_wait_event(SDL_Event *event) {
     }
 }
 
-// 去掉 static，jxPlayer通过 ffplay.h 调用这个方法
-VideoState *stream_open(const char *filename,
-                               const AVInputFormat *iformat)
+static VideoState *stream_open_internal(const char *filename, const AVInputFormat *iformat,
+                                       const SkyAudioSpec *audio_preset)
 {
     VideoState *is;
 
     is = av_mallocz(sizeof(VideoState));
     if (!is)
         return NULL;
+    if (audio_preset)
+        is->audio_preset = *audio_preset;
     is->last_video_stream = is->video_stream = -1;
     is->last_audio_stream = is->audio_stream = -1;
     is->last_subtitle_stream = is->subtitle_stream = -1;
-    is->filename = av_strdup(filename);
+    // skycache: 前缀下的 HLS/DASH 不经过缓存，去掉前缀直接交给 FFmpeg
+    is->filename = av_strdup(sky_io_filename(filename));
     if (!is->filename)
         goto fail;
     is->iformat = iformat;
@@ -3214,6 +3912,22 @@ VideoState *stream_open(const char *filename,
         goto fail;
     }
 
+    if (!(is->vfilters_mutex = SDL_CreateMutex())) {
+        av_log(NULL, AV_LOG_FATAL, "SDL_CreateMutex(): %s\n", SDL_GetError());
+        goto fail;
+    }
+
+    if (!(is->video_resume_mutex = SDL_CreateMutex())) {
+        av_log(NULL, AV_LOG_FATAL, "SDL_CreateMutex(): %s\n", SDL_GetError());
+        goto fail;
+    }
+    if (!(is->video_resume_cond = SDL_CreateCondition())) {
+        av_log(NULL, AV_LOG_FATAL, "SDL_CreateCondition(): %s\n", SDL_GetError());
+        goto fail;
+    }
+    is->audio_last_ts = is->audio_skip_ts = AV_NOPTS_VALUE;
+    is->subtitle_last_ts = is->subtitle_skip_ts = AV_NOPTS_VALUE;
+
     init_clock(&is->vidclk, &is->videoq.serial);
     init_clock(&is->audclk, &is->audioq.serial);
     init_clock(&is->extclk, &is->extclk.serial);
@@ -3255,6 +3969,18 @@ fail:
     return is;
 }
 
+// 去掉 static，jxPlayer通过 ffplay.h 调用这个方法
+VideoState *stream_open(const char *filename,
+                               const AVInputFormat *iformat)
+{
+    return stream_open_internal(filename, iformat, NULL);
+}
+
+VideoState *stream_open_preload(const char *filename, const AVInputFormat *iformat, const SkyAudioSpec *audio_preset)
+{
+    return stream_open_internal(filename, iformat, audio_preset);
+}
+
 static void stream_cycle_channel(VideoState *is, int codec_type)
 {
     AVFormatContext *ic = is->ic;
@@ -3535,7 +4261,6 @@ static const OptionDef options[] = {
     { "top", OPT_TYPE_INT, OPT_EXPERT, { &screen_top }, "set the y position for the top of the window", "y pos" },
     { "vf", OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT, { .func_arg = opt_add_vfilter }, "set video filters", "filter_graph" },
     { "af", OPT_TYPE_STRING, 0, { &afilters }, "set audio filters", "filter_graph" },
-    { "rdftspeed", OPT_TYPE_INT, OPT_AUDIO | OPT_EXPERT, { &rdftspeed }, "rdft speed", "msecs" },
     { "showmode", OPT_TYPE_FUNC, OPT_FUNC_ARG, { .func_arg = opt_show_mode}, "select show mode (0 = video, 1 = waves, 2 = RDFT)", "mode" },
     { "i", OPT_TYPE_BOOL, 0, { &dummy}, "read specified file", "input_file"},
     { "codec", OPT_TYPE_FUNC, OPT_FUNC_ARG, { .func_arg = opt_codec}, "force decoder", "decoder_name" },
@@ -10,7 +10,6 @@
 #include "libavcodec/avcodec.h"
 #include "libavutil/fifo.h"
 #include "libavformat/avformat.h"
-#include "libavutil/tx.h"
 #include "libavfilter/avfilter.h"
 
 // Include sky message definitions
@@ -30,8 +29,12 @@ extern "C" {
 
 /* Minimum SDL audio buffer_ size, in samples. */
 #define SDL_AUDIO_MIN_BUFFER_SIZE 512
+/* 音量/静音切换时的渐变时长 */
+#define AUDIO_GAIN_RAMP_MS 10
 /* Calculate actual buffer_ size keeping in mind not cause too frequent audio callbacks */
 #define SDL_AUDIO_MAX_CALLBACKS_PER_SEC 30
+/* 播放列表接续时每次回调等待解码的上限，超过则先输出静音 */
+#define AUDIO_DRAIN_WAIT_US 20000
 
 /* Step size for volume control in dB */
 #define SDL_VOLUME_STEP (0.75)
@@ -59,10 +62,6 @@ extern "C" {
 /* polls for possible required screen refresh at least this often, should be less than 1/fps */
 #define REFRESH_RATE 0.01
 
-/* NOTE: the size must be big enough to compensate the hardware audio buffersize size */
-/* TODO: We assume that a decoded and resampled frame fits into this buffer_ */
-#define SAMPLE_ARRAY_SIZE (8 * 65536)
-
 #define CURSOR_HIDE_DELAY 1000000
 
 #define USE_ONEPASS_SUBTITLE_RENDER 1
@@ -88,6 +87,10 @@ typedef struct PacketQueue {
 #define SAMPLE_QUEUE_SIZE 9
 #define FRAME_QUEUE_SIZE FFMAX(SAMPLE_QUEUE_SIZE, FFMAX(VIDEO_PICTURE_QUEUE_SIZE, SUBPICTURE_QUEUE_SIZE))
 
+/* Frame.flip 取值，renderer 在旋转之后做镜像 */
+#define SKY_VIDEO_FLIP_H 1
+#define SKY_VIDEO_FLIP_V 2
+
 typedef void (*Sky_AudioCallback) (void *userdata, Uint8 * stream, int len);
 
 typedef struct SkyAudioSpec {
@@ -99,6 +102,21 @@ typedef struct SkyAudioSpec {
         void *userdata;
 } SkyAudioSpec;
 
+/* 可由 renderer 在 GPU 上完成的 eq 参数，语义与 libavfilter eq 一致 */
+typedef struct SkyVideoEq {
+    float brightness;     /* -1.0 ~ 1.0，默认 0 */
+    float contrast;       /* 默认 1 */
+    float saturation;     /* 0 ~ 3，默认 1 */
+    float gamma;          /* 0.1 ~ 10，默认 1 */
+} SkyVideoEq;
+
+/* 可由 renderer 在 GPU 上完成的 crop 参数，写入 AVFrame.crop_* 交给 renderer */
+typedef struct SkyVideoCrop {
+    int enabled;
+    int w, h;
+    int x, y;             /* 小于 0 表示居中 */
+} SkyVideoCrop;
+
 typedef struct AudioParams {
     int freq;
     AVChannelLayout ch_layout;
@@ -135,6 +153,8 @@ typedef struct Frame {
     AVRational sar;
     int uploaded;
     int flip_v;
+    int rotation;         /* 顺时针旋转角度 0/90/180/270，由 renderer 完成 */
+    int flip;             /* SKY_VIDEO_FLIP_*，在旋转之后应用 */
 } Frame;
 
 typedef struct FrameQueue {
@@ -186,6 +206,8 @@ typedef struct VideoState {
     int64_t seek_rel;
     int read_pause_return;
     AVFormatContext *ic;
+    // sky_io_open 返回的自定义数据源（预加载缓存等），没有时为 NULL，由 FFmpeg 按协议打开
+    AVIOContext *custom_io;
     int realtime;
 
     Clock audclk;
@@ -221,32 +243,30 @@ typedef struct VideoState {
     int audio_write_buf_size;
     int audio_volume;
     int muted;
+    float audio_gain; /* 当前实际增益，向 audio_volume/muted 对应的目标渐变 */
     struct AudioParams audio_src;
     struct AudioParams audio_filter_src;
     struct AudioParams audio_tgt;
     struct SwrContext *swr_ctx;
+    /* 5.1/7.1 -> 立体声的专用 downmix，channels 为 0 表示由 swr 完成声道转换 */
+    int audio_downmix_channels;
+    float audio_downmix_left[8];
+    float audio_downmix_right[8];
+    uint8_t *audio_buf2;
+    unsigned int audio_buf2_size;
     int frame_drops_early;
     int frame_drops_late;
 
     enum ShowMode {
         SHOW_MODE_NONE = -1, SHOW_MODE_VIDEO = 0, SHOW_MODE_WAVES, SHOW_MODE_RDFT, SHOW_MODE_NB
     } show_mode;
-    int16_t sample_array[SAMPLE_ARRAY_SIZE];
-    int sample_array_index;
-    int last_i_start;
-    AVTXContext *rdft;
-    av_tx_fn rdft_fn;
-    int rdft_bits;
-    float *real_data;
-    AVComplexFloat *rdft_data;
-    int xpos;
-    double last_vis_time;
-    SDL_Texture *vis_texture;
     SDL_Texture *sub_texture;
     SDL_Texture *vid_texture;
 
     int subtitle_stream;
     AVStream *subtitle_st;
+    // 当前交给 renderer/Java 显示的字幕类型，SUBTITLE_SHOWN_* 组合
+    int subtitle_shown;
     PacketQueue subtitleq;
 
     double frame_timer;
@@ -282,6 +302,48 @@ typedef struct VideoState {
      */
     void* skyPlayer;
 
+    // autorotate 计算出的显示方向，交给 renderer 处理
+    int video_rotation;
+    int video_flip;
+
+    // 播放器级别的视频滤镜，优先于 vfilters_list，由 vfilters_mutex 保护
+    char *vfilters;
+    int vfilters_serial;
+    SDL_Mutex *vfilters_mutex;
+    // 从滤镜链尾部剥离出来、交给 GPU 完成的部分
+    SkyVideoCrop gpu_crop;
+    SkyVideoEq gpu_eq;
+
+    // 按显示区域缩小：打开解码器时选定的 lowres，显示区域变大后由 read_thread 重新选流/重开解码器
+    int video_lowres;
+    int video_reselect_req;
+
+    // 没有 Surface 时挂起视频：demuxer 丢弃视频包，解码线程和刷新线程空闲。
+    // video_suspend_req 由播放器设置，read_thread 应用后更新 video_suspended
+    int video_suspend_req;
+    int video_suspended;
+    // 刷新线程在 video_resume_mutex 上按 video_suspended 等待，修改 video_suspended 也要持有它
+    SDL_Mutex *video_resume_mutex;
+    SDL_Condition *video_resume_cond;
+    // 恢复时为了视频从关键帧开始会回退 demuxer，重复读到的音频/字幕包（不晚于 *_skip_ts）直接丢弃
+    int64_t audio_last_ts;
+    int64_t audio_skip_ts;
+    int64_t subtitle_last_ts;
+    int64_t subtitle_skip_ts;
+
+    // 有 PCM 旁路的消费方时由播放器置 1，audio_decode_frame 把重采样后的数据交给 sky_pcm_tap_write
+    int audio_tap_enabled;
+
+    // 播放列表预加载：接续前 skyPlayer 为空并保持暂停，只缓冲不显示不出声；
+    // 音频不打开设备，直接按 audio_preset（当前设备的参数，freq 为 0 表示没有）重采样
+    SkyAudioSpec audio_preset;
+    // read_thread 的状态：0 打开中，1 已就绪（各路流已打开），<0 打开失败
+    int read_status;
+    // 音视频都已播完，SKY_MSG_PLAYBACK_END 只发一次，seek 后重新计算
+    int playback_ended;
+    // 音频已接续、上一项还在显示时由播放器置 1，刷新线程不取帧，视频留在队列中等切换
+    int video_hold;
+
     // 独立刷新线程管理
     SDL_Thread *refresh_tid;        // 刷新线程句柄
     int refresh_thread_abort;       // 刷新线程退出标志
@@ -300,6 +362,55 @@ double get_current_position(VideoState *is);
 
 int64_t get_media_duration(VideoState *is);
 
+/**
+ * 设置视频滤镜链（libavfilter 语法），尾部的 crop/eq 会交给 renderer 在 GPU 上完成，
+ * 其余部分仍走 libavfilter。NULL 表示清除。
+ */
+int set_video_filters(VideoState *is, const char *vfilters);
+
+/**
+ * 挂起/恢复视频，音频不受影响。挂起时在 demuxer 层丢弃视频包，
+ * 恢复时视频从音频时钟之前最近的关键帧开始解码并追上音频。
+ */
+void set_video_suspended(VideoState *is, int suspended);
+
+/**
+ * 当前能否取到显示帧：0 可以，没有视频流时返回 AVERROR_STREAM_NOT_FOUND，视频挂起时返回 AVERROR(EAGAIN)
+ */
+int video_frame_available(VideoState *is);
+
+/**
+ * 视频是否已显示到最后一帧，没有视频、视频挂起或不显示时返回 1
+ */
+int stream_video_ended(VideoState *is);
+
+/**
+ * 让刷新线程尽快执行一次 video_refresh，暂停时也会执行
+ */
+void request_video_refresh(VideoState *is);
+
+/**
+ * 预加载播放列表的下一项：与 stream_open 相同，但保持暂停、不显示，音频按 audio_preset 重采样，
+ * 不再打开音频设备。接续时由 stream_activate 交给播放器
+ */
+VideoState *stream_open_preload(const char *filename, const AVInputFormat *iformat, const SkyAudioSpec *audio_preset);
+
+/**
+ * 音频回调的实现：从 offset 开始向 stream 填充 PCM，音频时钟按整个 len 计算延迟。
+ * stop_at_end 为 0 时与 SDL 回调相同，总是填满；为 1 时本项音频全部交出后停止。返回写到的位置（含 offset）
+ */
+int stream_audio_fill(VideoState *is, uint8_t *stream, int len, int offset, int stop_at_end);
+
+/**
+ * 接续：预加载的项开始播放，时钟从当前时刻继续，不再通知音频设备（设备一直在播放）
+ */
+void stream_activate(VideoState *is, void *player);
+
+/**
+ * 被接续的项停止显示和回调播放器，之后只等待 stream_close
+ */
+void stream_deactivate(VideoState *is);
+
 #ifdef __cplusplus
 };
 #endif
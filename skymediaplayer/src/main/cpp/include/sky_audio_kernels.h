@@ -0,0 +1,69 @@
+//
+// 音量、渐变和混音的 SIMD 内核，供 ffplay.c 的音频回调和混音器使用；另有响度计量用的 K 加权滤波
+//
+
+#ifndef MY_PLAYER_SKY_AUDIO_KERNELS_H
+#define MY_PLAYER_SKY_AUDIO_KERNELS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * dst = src * gain，s16 饱和；gain 为 1 时等价于 memcpy，为 0 时输出静音
+ * @param count 样本数（帧数 * 声道数），dst 与 src 可以相同
+ */
+void sky_audio_gain_s16(int16_t *dst, const int16_t *src, int count, float gain);
+void sky_audio_gain_f32(float *dst, const float *src, int count, float gain);
+
+/**
+ * 增益在 frames 帧内从 gain0 线性变化到 gain1（不含 gain1），同一帧各声道增益相同，用于静音/音量切换去爆音
+ */
+void sky_audio_ramp_s16(int16_t *dst, const int16_t *src, int frames, int channels, float gain0, float gain1);
+void sky_audio_ramp_f32(float *dst, const float *src, int frames, int channels, float gain0, float gain1);
+
+/**
+ * dst = dst + src * gain，s16 饱和；f32 不做截断，保留混音余量，由设备或最后一级处理
+ */
+void sky_audio_mix_s16(int16_t *dst, const int16_t *src, int count, float gain);
+void sky_audio_mix_f32(float *dst, const float *src, int count, float gain);
+
+/**
+ * 交错立体声 dst = dst + src * (gainL, gainR)，用于混音器按声道增益（音量 + 声像）叠加各路输入
+ */
+void sky_audio_mix_stereo_f32(float *dst, const float *src, int frames, float gainL, float gainR);
+
+/**
+ * 多声道 planar float 按系数 downmix 为交错立体声，同时完成 planar -> packed 和 float -> s16 的转换
+ * @param planes 每个声道一个平面，共 channels 个，channels 最多 SKY_AUDIO_DOWNMIX_MAX_CHANNELS
+ * @param left/right 每个输入声道对左/右声道的系数
+ */
+#define SKY_AUDIO_DOWNMIX_MAX_CHANNELS 8
+void sky_audio_downmix_stereo_f32(float *dst, const float *const *planes, int frames, int channels,
+                                  const float *left, const float *right);
+void sky_audio_downmix_stereo_s16(int16_t *dst, const float *const *planes, int frames, int channels,
+                                  const float *left, const float *right);
+
+/**
+ * 交错多声道逐帧通过两级 biquad（Direct Form II 转置），用于响度计量的 K 加权，同时统计滤波后每个声道的平方和
+ * @param coeffs 两级的 b0 b1 b2 a1 a2，共 10 个（a0 已归一化），所有声道相同
+ * @param state 每个声道 4 个状态（第一级 2 个、第二级 2 个），按声道排列，调用之间保持；
+ *              channels 最多 SKY_AUDIO_KWEIGHT_MAX_CHANNELS
+ * @param sumSq 返回本次每个声道滤波输出的平方和
+ */
+#define SKY_AUDIO_KWEIGHT_MAX_CHANNELS 8
+void sky_audio_kweight_f32(const float *src, int frames, int channels, const float *coeffs, float *state, float *sumSq);
+
+// 当前使用的实现，便于日志和 benchmark
+const char *sky_audio_kernels_impl(void);
+
+// 测试和 benchmark 用：非 0 时所有内核改走标量实现，用来与 SIMD 结果对比
+void sky_audio_kernels_force_scalar(int enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MY_PLAYER_SKY_AUDIO_KERNELS_H
@@ -0,0 +1,31 @@
+//
+// 上传前的快速帧缩小，供 ffplay.c 在 Surface 远小于视频时使用
+//
+
+#ifndef MY_PLAYER_SKY_FRAME_SCALER_H
+#define MY_PLAYER_SKY_FRAME_SCALER_H
+
+#include "libavutil/frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 是否支持 sky_frame_downscale_2x，目前为 8 bit 的 YUV420P/NV12/NV21
+ */
+int sky_frame_can_downscale(const AVFrame *frame);
+
+/**
+ * 2:1 box 缩小（每 2x2 像素取平均），宽高向下取偶数，crop_* 同比缩小
+ * 4:1 由调用方连续调用两次完成
+ * @param dst 输出帧，会先被 unref，再按 src 的格式分配
+ * @return 0 成功，失败返回 AVERROR
+ */
+int sky_frame_downscale_2x(AVFrame *dst, const AVFrame *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MY_PLAYER_SKY_FRAME_SCALER_H
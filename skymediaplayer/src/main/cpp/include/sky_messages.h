@@ -20,6 +20,7 @@ extern "C" {
 #define SKY_MSG_ERROR                       100     /* arg1 = error , ffplay error code*/
 #define SKY_MSG_PREPARED                    200
 #define SKY_MSG_COMPLETED                   300
+#define SKY_MSG_PLAYBACK_END                301     /* 音视频都已播完，COMPLETED 在读到文件尾时就会发出 */
 
 // Video related messages
 #define SKY_MSG_VIDEO_SIZE_CHANGED          400     /* arg1 = width, arg2 = height */
@@ -49,6 +50,8 @@ extern "C" {
 #define SKY_MSG_TIMED_TEXT                  800
 #define SKY_MSG_ACCURATE_SEEK_COMPLETE      900     /* arg1 = current position*/
 #define SKY_MSG_GET_IMG_STATE               1000    /* arg1 = timestamp, arg2 = result code, obj = file name*/
+#define SKY_MSG_PLAYLIST_ADVANCE            1100    /* 音频回调已接续下一项，或预加载的项打开失败 */
+#define SKY_MSG_PLAYLIST_PRELOAD            1101
 
 // Decoder messages
 #define SKY_MSG_VIDEO_DECODER_OPEN          10001
@@ -15,14 +15,88 @@ extern "C" {
 /**
  * 方法定义，c -> cpp 调用方向
  */
-bool sky_display_image(void *player, AVFrame *frame);
 
+/**
+ * 显示一帧图像
+ * @param rotation 顺时针旋转角度 (0/90/180/270)，由 renderer 在纹理坐标上完成
+ * @param flip SKY_VIDEO_FLIP_* 组合，在旋转之后应用
+ */
+bool sky_display_image(void *player, AVFrame *frame, int rotation, int flip);
+
+/**
+ * 设置 GPU eq 参数，由 renderer 的后处理阶段完成
+ */
+void sky_set_video_eq(void *player, const SkyVideoEq *eq);
+
+/**
+ * 设置当前显示的位图字幕，只在字幕切换时调用，sub 为 NULL 表示清除
+ * @param width/height 字幕 rect 坐标所在画布的尺寸
+ */
+void sky_set_subtitle(void *player, const AVSubtitle *sub, int width, int height);
+
+/**
+ * 获取视频显示区域尺寸，解码时据此缩小远大于 Surface 的帧，未知时为 0
+ */
+void sky_get_video_target_size(void *player, int *width, int *height);
+
+/**
+ * 是否有等待取帧的截图请求，video_refresh 每次查询，只是一次原子读
+ */
+bool sky_capture_pending(void *player);
+
+/**
+ * 对当前显示帧加引用交给截图线程，不拷贝像素，不阻塞调用线程
+ * @param pts 帧的显示时间（秒），NAN 表示未知
+ */
+void sky_capture_frame(void *player, const AVFrame *frame, double pts, int rotation, int flip);
+
+/**
+ * 是否有解码帧旁路的订阅，queue_picture 每帧查询，只是一次原子读
+ */
+bool sky_frame_tap_active(void *player);
+
+/**
+ * 解码帧交给旁路线程，只加引用，不拷贝像素，不阻塞解码线程
+ * @param pts 帧的显示时间（秒），NAN 表示未知
+ */
+void sky_frame_tap_submit(void *player, const AVFrame *frame, double pts);
+
+/**
+ * 重采样后、音量处理前的 PCM 交给旁路的消费方，只拷贝进 ring，不加锁、不分配内存
+ * @param format AVSampleFormat，交错格式
+ */
+void sky_pcm_tap_write(void *player, const uint8_t *data, int bytes, int format, int channels, int sample_rate);
+
+/**
+ * 打开音频输出，只调用一次；输出端不支持的声道数会被协商为立体声，实际参数通过 obtained 返回
+ */
 bool sky_open_audio(void *player, SkyAudioSpec *desired, SkyAudioSpec *obtained);
 
 void sky_pause_audio(void *player, bool pause);
 
 void sky_flush_audio(void *player);
 
+/**
+ * 已写给音频设备但还没有播放的时长（秒），由设备播放位置计算，只在音频回调中调用
+ */
+double sky_get_audio_latency(void *player);
+
+/**
+ * 播放器实际打开的地址：带 skycache: 前缀的 HLS/DASH 清单无法按单个 URL 缓存，返回去掉前缀的地址，其余原样返回
+ */
+const char *sky_io_filename(const char *url);
+
+/**
+ * read_thread 打开输入前调用：本地文件、带 skycache: / skyparallel: 前缀或有预加载数据时返回对应的 AVIOContext，否则返回 NULL
+ * @param interrupt 回源时使用的中断回调，函数内会复制
+ */
+AVIOContext *sky_io_open(const char *url, const AVIOInterruptCB *interrupt);
+
+/**
+ * 释放 sky_io_open 返回的 AVIOContext 并置空，须在 avformat_close_input 之后调用
+ */
+void sky_io_close(AVIOContext **pb);
+
 /**
  * 消息发送接口 - 从 ffplay.c 发送消息到 SkyPlayer
  * @param player SkyPlayer 实例指针
@@ -0,0 +1,186 @@
+extern "C" {
+#include "libavutil/frame.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+}
+
+#include <utility>
+#include "sky_anativewindow_renderer.h"
+
+static const char* TAG = "SkyANativeWindowRenderer";
+
+SkyANativeWindowRenderer::SkyANativeWindowRenderer(SkyYuvConverter::OutputFormat format) : format_(format) {
+    ALOG_I(TAG, "create, yuv converter=%s", SkyYuvConverter::implementationName());
+}
+
+SkyANativeWindowRenderer::~SkyANativeWindowRenderer() {
+    terminate();
+}
+
+bool SkyANativeWindowRenderer::displayImage(EGLNativeWindowType window, AVFrame *frame) {
+    if (nullptr == window || nullptr == frame) {
+        ALOG_E(TAG, "%s null ptr", __func__);
+        return false;
+    }
+
+    if (window != window_) {
+        window_ = window;
+        bufferWidth_ = 0;
+        bufferHeight_ = 0;
+        appliedTransform_ = -1;
+    }
+
+    int visibleWidth = static_cast<int>(frame->width - frame->crop_left - frame->crop_right);
+    int visibleHeight = static_cast<int>(frame->height - frame->crop_top - frame->crop_bottom);
+    if (!setBuffersGeometry(visibleWidth, visibleHeight)) {
+        return false;
+    }
+    applyTransform();
+
+    ANativeWindow_Buffer buffer;
+    if (ANativeWindow_lock(window_, &buffer, nullptr) != 0) {
+        ALOG_E(TAG, "ANativeWindow_lock fail");
+        return false;
+    }
+
+    bool ret = false;
+    if (buffer.width >= visibleWidth && buffer.height >= visibleHeight) {
+        // stride 以像素为单位
+        int dstStride = buffer.stride * SkyYuvConverter::bytesPerPixel(format_);
+        ret = convertFrame(frame, static_cast<uint8_t*>(buffer.bits), dstStride, format_, &swsContext_);
+    } else {
+        ALOG_E(TAG, "buffer %dx%d smaller than frame %dx%d", buffer.width, buffer.height, visibleWidth, visibleHeight);
+    }
+    ANativeWindow_unlockAndPost(window_);
+
+    return ret;
+}
+
+void SkyANativeWindowRenderer::setOrientation(int rotation, int flip) {
+    rotation_ = rotation;
+    flip_ = flip;
+}
+
+bool SkyANativeWindowRenderer::isValid() {
+    return window_ != nullptr;
+}
+
+void SkyANativeWindowRenderer::releaseSurface() {
+    window_ = nullptr;
+    bufferWidth_ = 0;
+    bufferHeight_ = 0;
+    appliedTransform_ = -1;
+}
+
+void SkyANativeWindowRenderer::terminate() {
+    releaseSurface();
+    if (swsContext_) {
+        sws_freeContext(swsContext_);
+        swsContext_ = nullptr;
+    }
+}
+
+EGLBoolean SkyANativeWindowRenderer::setBuffersGeometry(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        ALOG_E(TAG, "invalid frame size %dx%d", width, height);
+        return EGL_FALSE;
+    }
+    if (bufferWidth_ == width && bufferHeight_ == height) {
+        return EGL_TRUE;
+    }
+
+    int windowFormat = format_ == SkyYuvConverter::OutputFormat::RGB565 ? WINDOW_FORMAT_RGB_565 : WINDOW_FORMAT_RGBA_8888;
+    ALOG_I(TAG, "ANativeWindow_setBuffersGeometry(w=%d,h=%d,f=%d)", width, height, windowFormat);
+    int ret = ANativeWindow_setBuffersGeometry(window_, width, height, windowFormat);
+    if (ret) {
+        ALOG_E(TAG, "ANativeWindow_setBuffersGeometry() returned error %d", ret);
+        return EGL_FALSE;
+    }
+    bufferWidth_ = width;
+    bufferHeight_ = height;
+    return EGL_TRUE;
+}
+
+void SkyANativeWindowRenderer::applyTransform() {
+    // SkyRenderer 的语义是先旋转再镜像，ANativeWindow 的 transform 是先镜像再顺时针旋转 90，
+    // 所以 90/270 时镜像方向互换
+    int flipH = flip_ & SKY_VIDEO_FLIP_H;
+    int flipV = flip_ & SKY_VIDEO_FLIP_V;
+    if (rotation_ == 90 || rotation_ == 270) {
+        std::swap(flipH, flipV);
+    }
+
+    int transform = (flipH ? ANATIVEWINDOW_TRANSFORM_MIRROR_HORIZONTAL : 0)
+                    | (flipV ? ANATIVEWINDOW_TRANSFORM_MIRROR_VERTICAL : 0);
+    if (rotation_ == 180 || rotation_ == 270) {
+        transform ^= ANATIVEWINDOW_TRANSFORM_ROTATE_180;
+    }
+    if (rotation_ == 90 || rotation_ == 270) {
+        transform |= ANATIVEWINDOW_TRANSFORM_ROTATE_90;
+    }
+
+    if (transform == appliedTransform_) {
+        return;
+    }
+    int ret = ANativeWindow_setBuffersTransform(window_, transform);
+    ALOG_I(TAG, "ANativeWindow_setBuffersTransform(%d) ret=%d", transform, ret);
+    appliedTransform_ = transform;
+}
+
+bool SkyANativeWindowRenderer::convertFrame(const AVFrame *frame, uint8_t *dst, int dstStride,
+                                            SkyYuvConverter::OutputFormat format, SwsContext **swsCache) {
+    if (nullptr == frame || nullptr == dst) {
+        return false;
+    }
+
+    const int left = static_cast<int>(frame->crop_left);
+    const int top = static_cast<int>(frame->crop_top);
+    const int width = static_cast<int>(frame->width - frame->crop_left - frame->crop_right);
+    const int height = static_cast<int>(frame->height - frame->crop_top - frame->crop_bottom);
+
+    const uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+    const int strides[3] = {frame->linesize[0], frame->linesize[1], frame->linesize[2]};
+    planes[0] = frame->data[0] + static_cast<ptrdiff_t>(top) * frame->linesize[0] + left;
+    switch (frame->format) {
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P:
+            planes[1] = frame->data[1] + static_cast<ptrdiff_t>(top / 2) * frame->linesize[1] + left / 2;
+            planes[2] = frame->data[2] + static_cast<ptrdiff_t>(top / 2) * frame->linesize[2] + left / 2;
+            return SkyYuvConverter::convert(SkyYuvConverter::Layout::I420, planes, strides,
+                                            width, height, dst, dstStride, format);
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV21:
+            planes[1] = frame->data[1] + static_cast<ptrdiff_t>(top / 2) * frame->linesize[1] + (left / 2) * 2;
+            return SkyYuvConverter::convert(frame->format == AV_PIX_FMT_NV12 ? SkyYuvConverter::Layout::NV12
+                                                                             : SkyYuvConverter::Layout::NV21,
+                                            planes, strides, width, height, dst, dstStride, format);
+        default:
+            break;
+    }
+
+    // 其余格式交给 swscale，crop 通过 av_frame_apply_cropping 处理
+    AVFrame* cropped = av_frame_clone(frame);
+    if (nullptr == cropped) {
+        return false;
+    }
+    bool ret = false;
+    if (av_frame_apply_cropping(cropped, AV_FRAME_CROP_UNALIGNED) >= 0) {
+        AVPixelFormat dstFormat = format == SkyYuvConverter::OutputFormat::RGB565 ? AV_PIX_FMT_RGB565LE : AV_PIX_FMT_RGBA;
+        SwsContext* localContext = nullptr;
+        SwsContext** context = swsCache ? swsCache : &localContext;
+        *context = sws_getCachedContext(*context, cropped->width, cropped->height,
+                                        static_cast<AVPixelFormat>(cropped->format),
+                                        cropped->width, cropped->height, dstFormat,
+                                        SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        if (*context) {
+            uint8_t* dstData[4] = {dst, nullptr, nullptr, nullptr};
+            int dstLinesize[4] = {dstStride, 0, 0, 0};
+            ret = sws_scale(*context, cropped->data, cropped->linesize, 0, cropped->height, dstData, dstLinesize) > 0;
+        } else {
+            ALOG_E(TAG, "sws_getCachedContext fail for %s", av_get_pix_fmt_name(static_cast<AVPixelFormat>(frame->format)));
+        }
+        sws_freeContext(localContext);
+    }
+    av_frame_free(&cropped);
+    return ret;
+}
@@ -0,0 +1,51 @@
+#ifndef SKY_ANATIVEWINDOW_RENDERER_H
+#define SKY_ANATIVEWINDOW_RENDERER_H
+
+#include "skyrenderer.h"
+#include "sky_yuv_converter.h"
+
+struct SwsContext;
+
+/**
+ * EGL 不可用时的 CPU 兜底渲染：YUV 在 CPU 上转成 RGBA/RGB565，直接写入 lock 到的 ANativeWindow buffer，
+ * 旋转/镜像交给 ANativeWindow_setBuffersTransform 由合成器完成。
+ * 限制：setEq/setWatermark/setSubtitle/setOutput 沿用基类空实现，这条路径上画面调节、水印、
+ * 字幕叠加和额外输出都不生效，只保证主画面能显示。
+ */
+class SkyANativeWindowRenderer : public SkyRenderer {
+public:
+    explicit SkyANativeWindowRenderer(SkyYuvConverter::OutputFormat format = SkyYuvConverter::OutputFormat::RGBA8888);
+    ~SkyANativeWindowRenderer() override;
+
+    bool displayImage(EGLNativeWindowType window, AVFrame *frame) override;
+    void setOrientation(int rotation, int flip) override;
+    bool isValid() override;
+    void releaseSurface() override;
+    void terminate() override;
+
+    /**
+     * 将 frame 的可见区域（考虑 crop_*）转换到 dst，截图也使用该接口。
+     * YUV420P/NV12/NV21 走 SIMD 转换，其余格式走 swscale。
+     * @param swsCache 可选的 swscale 上下文缓存，为空时每次临时创建
+     */
+    static bool convertFrame(const AVFrame *frame, uint8_t *dst, int dstStride,
+                             SkyYuvConverter::OutputFormat format, SwsContext **swsCache = nullptr);
+
+private:
+    EGLBoolean setBuffersGeometry(int width, int height);
+    void applyTransform();
+
+private:
+    SkyYuvConverter::OutputFormat format_;
+    EGLNativeWindowType window_ = nullptr;
+    SwsContext* swsContext_ = nullptr;
+
+    int bufferWidth_ = 0;
+    int bufferHeight_ = 0;
+
+    int rotation_ = 0;
+    int flip_ = 0;
+    int appliedTransform_ = -1;
+};
+
+#endif // SKY_ANATIVEWINDOW_RENDERER_H
@@ -0,0 +1,165 @@
+extern "C" {
+#include "libavutil/tx.h"
+}
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sys/resource.h>
+
+#include "logger.h"
+#include "sky_audio_analyzer.h"
+
+static const char* TAG = "SkyAudioAnalyzer";
+
+// 分析线程的 nice 值，与 Android 的 THREAD_PRIORITY_BACKGROUND 相同
+#define AUDIO_ANALYZER_NICE 10
+// 频带下限，再往下 FFT 的分辨率不够
+#define AUDIO_ANALYZER_MIN_FREQ 40.0
+
+SkyAudioAnalyzer::SkyAudioAnalyzer(PcmSource source, int bands)
+    : source_(std::move(source))
+    , bandCount_(std::clamp(bands, 1, AUDIO_ANALYZER_MAX_BANDS)) {
+    thread_ = std::thread([this]() {
+        this->run();
+    });
+}
+
+SkyAudioAnalyzer::~SkyAudioAnalyzer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        abort_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    av_tx_uninit(&tx_);
+}
+
+bool SkyAudioAnalyzer::getLevels(SkyAudioLevels *levels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (levels_.serial == 0) {
+        return false;
+    }
+    *levels = levels_;
+    return true;
+}
+
+bool SkyAudioAnalyzer::initTx() {
+    const float scale = 1.0f;
+    if (av_tx_init(&tx_, &txFn_, AV_TX_FLOAT_RDFT, 0, AUDIO_ANALYZER_FFT_SIZE, &scale, 0) < 0) {
+        ALOG_E(TAG, "av_tx_init failed");
+        return false;
+    }
+
+    // Hann 窗
+    window_.resize(AUDIO_ANALYZER_FFT_SIZE);
+    for (int i = 0; i < AUDIO_ANALYZER_FFT_SIZE; i++) {
+        window_[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / AUDIO_ANALYZER_FFT_SIZE);
+    }
+    mono_.resize(AUDIO_ANALYZER_FFT_SIZE);
+    spectrum_.resize(2 * (AUDIO_ANALYZER_FFT_SIZE / 2 + 1));
+    return true;
+}
+
+void SkyAudioAnalyzer::run() {
+    // 可视化不影响播放：低优先级，只用空闲 CPU
+    setpriority(PRIO_PROCESS, 0, AUDIO_ANALYZER_NICE);
+    ALOG_I(TAG, "analyzer thread started, %d bands", bandCount_);
+
+    if (!initTx()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!abort_) {
+        cond_.wait_for(lock, std::chrono::milliseconds(AUDIO_ANALYZER_INTERVAL_MS), [this]() { return abort_; });
+        if (abort_) {
+            break;
+        }
+        lock.unlock();
+
+        // 按上一次的格式取 FFT_SIZE 帧，格式变化（重新打开音频）后下一轮再取
+        SkyPcmFormat format;
+        uint64_t endIndex = 0;
+        size_t got = source_(pcm_.data(), pcm_.size(), &format, &endIndex);
+        if (format.sampleRate != format_.sampleRate || format.channels != format_.channels
+            || format.format != format_.format) {
+            format_ = format;
+            size_t bytesPerFrame = static_cast<size_t>(std::max(format.channels, 0)) * SDL_AUDIO_BYTESIZE(format.format);
+            pcm_.resize(AUDIO_ANALYZER_FFT_SIZE * bytesPerFrame);
+        } else if (got > 0 && got == pcm_.size() && endIndex != lastEndIndex_) {
+            // 暂停时读位置不动，不重复计算
+            analyze(format);
+        }
+        lastEndIndex_ = endIndex;
+
+        lock.lock();
+    }
+    ALOG_I(TAG, "analyzer thread exited");
+}
+
+void SkyAudioAnalyzer::analyze(const SkyPcmFormat &format) {
+    const int channels = format.channels;
+    const int used = std::min(channels, 2);
+    const bool isFloat = SDL_AUDIO_ISFLOAT(format.format);
+    const bool isS16 = format.format == SDL_AUDIO_S16;
+    if (!isFloat && !isS16) {
+        return;
+    }
+
+    float sumSq[2] = {0, 0};
+    float peak[2] = {0, 0};
+    for (int i = 0; i < AUDIO_ANALYZER_FFT_SIZE; i++) {
+        float mix = 0.0f;
+        for (int ch = 0; ch < used; ch++) {
+            size_t index = static_cast<size_t>(i) * channels + ch;
+            float v = isFloat ? reinterpret_cast<const float *>(pcm_.data())[index]
+                              : reinterpret_cast<const int16_t *>(pcm_.data())[index] / 32768.0f;
+            sumSq[ch] += v * v;
+            peak[ch] = std::max(peak[ch], std::fabs(v));
+            mix += v;
+        }
+        mono_[i] = mix / used * window_[i];
+    }
+
+    txFn_(tx_, spectrum_.data(), mono_.data(), sizeof(float));
+
+    // 满幅正弦加 Hann 窗后峰值 bin 的幅度为 N/4，以此作为 0 dBFS
+    const double ref = static_cast<double>(AUDIO_ANALYZER_FFT_SIZE) / 4;
+    const double binHz = static_cast<double>(format.sampleRate) / AUDIO_ANALYZER_FFT_SIZE;
+    const double maxFreq = std::min(20000.0, format.sampleRate / 2.0);
+    const double ratio = std::pow(maxFreq / AUDIO_ANALYZER_MIN_FREQ, 1.0 / bandCount_);
+    const int nbBins = AUDIO_ANALYZER_FFT_SIZE / 2;
+
+    SkyAudioLevels levels;
+    levels.channels = used;
+    for (int ch = 0; ch < used; ch++) {
+        levels.rms[ch] = std::sqrt(sumSq[ch] / AUDIO_ANALYZER_FFT_SIZE);
+        levels.peak[ch] = peak[ch];
+    }
+    levels.bands.resize(bandCount_);
+    // 低频的频带可能不足一个 bin，每个频带至少占一个 bin，依次往后排
+    double low = AUDIO_ANALYZER_MIN_FREQ;
+    int next = 1;
+    for (int b = 0; b < bandCount_; b++) {
+        double high = low * ratio;
+        int first = std::min(std::max(next, static_cast<int>(low / binHz)), nbBins);
+        int last = std::clamp(static_cast<int>(high / binHz), first, nbBins);
+        next = last + 1;
+        double power = 0;
+        for (int k = first; k <= last; k++) {
+            double re = spectrum_[2 * k];
+            double im = spectrum_[2 * k + 1];
+            power += re * re + im * im;
+        }
+        float db = power > 0 ? static_cast<float>(10.0 * std::log10(power / (ref * ref))) : AUDIO_ANALYZER_FLOOR_DB;
+        levels.bands[b] = std::max(db, AUDIO_ANALYZER_FLOOR_DB);
+        low = high;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    levels.serial = levels_.serial + 1;
+    levels_ = std::move(levels);
+}
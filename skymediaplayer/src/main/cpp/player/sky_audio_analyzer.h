@@ -0,0 +1,75 @@
+#ifndef SKY_AUDIO_ANALYZER_H
+#define SKY_AUDIO_ANALYZER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "skyaudio.h"
+
+struct AVTXContext;
+
+#define AUDIO_ANALYZER_FFT_SIZE     2048
+#define AUDIO_ANALYZER_MAX_BANDS    64
+#define AUDIO_ANALYZER_INTERVAL_MS  33
+/* 频带能量的下限 */
+#define AUDIO_ANALYZER_FLOOR_DB     -120.0f
+
+struct SkyAudioLevels {
+    // 统计的声道数，多声道只统计前两个
+    int channels = 0;
+    // 线性值，满幅为 1
+    float rms[2] = {0, 0};
+    float peak[2] = {0, 0};
+    // 从低到高按对数划分的频带能量，dBFS，满幅正弦约为 0
+    std::vector<float> bands;
+    // 已有结果之后又计算过的次数，拉取方据此判断是否有更新
+    uint64_t serial = 0;
+};
+
+/**
+ * 音频分析：在低优先级线程上周期性地从输出 ring 取最近播放的 PCM，计算 RMS、峰值和 FFT 频带，
+ * 调用方按需拉取结果。输出线程不做任何额外拷贝，不需要可视化的播放器不创建该对象。
+ */
+class SkyAudioAnalyzer {
+public:
+    // 拷贝设备正在播放的 bytes 字节 PCM，取不到返回 0，见 SkyAudioOut::peekRecentPcm
+    using PcmSource = std::function<size_t(uint8_t *dst, size_t bytes, SkyPcmFormat *format, uint64_t *endIndex)>;
+
+    SkyAudioAnalyzer(PcmSource source, int bands);
+    ~SkyAudioAnalyzer();
+
+    // 任意线程调用，返回最近一次的结果，还没有结果时返回 false
+    bool getLevels(SkyAudioLevels *levels);
+
+private:
+    void run();
+    void analyze(const SkyPcmFormat &format);
+    bool initTx();
+
+private:
+    PcmSource source_;
+    int bandCount_;
+
+    // 只在分析线程访问
+    std::vector<uint8_t> pcm_;
+    std::vector<float> mono_;
+    std::vector<float> window_;
+    std::vector<float> spectrum_;
+    AVTXContext *tx_ = nullptr;
+    void (*txFn_)(AVTXContext *, void *, void *, ptrdiff_t) = nullptr;
+    SkyPcmFormat format_;
+    uint64_t lastEndIndex_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool abort_ = false;
+    SkyAudioLevels levels_;
+    std::thread thread_;
+};
+
+#endif // SKY_AUDIO_ANALYZER_H
@@ -0,0 +1,692 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#include "sky_audio_kernels.h"
+
+#if defined(__aarch64__)
+#define SKY_AUDIO_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define SKY_AUDIO_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SKY_AUDIO_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+/*
+ * 每个 SIMD 函数处理尽可能多的样本并返回处理的个数，剩余部分由标量实现完成。
+ * 所有实现都按 float 计算、就近取整、饱和，乘加分成两步，避免 FMA 导致各实现结果不一致。
+ */
+namespace {
+    inline int16_t saturateS16(float value) {
+        long rounded = lrintf(value);
+        if (rounded > INT16_MAX) return INT16_MAX;
+        if (rounded < INT16_MIN) return INT16_MIN;
+        return static_cast<int16_t>(rounded);
+    }
+
+    void gainS16Scalar(int16_t* dst, const int16_t* src, int start, int count, float gain) {
+        for (int i = start; i < count; ++i) {
+            dst[i] = saturateS16(static_cast<float>(src[i]) * gain);
+        }
+    }
+
+    void gainF32Scalar(float* dst, const float* src, int start, int count, float gain) {
+        for (int i = start; i < count; ++i) {
+            dst[i] = src[i] * gain;
+        }
+    }
+
+    void mixS16Scalar(int16_t* dst, const int16_t* src, int start, int count, float gain) {
+        for (int i = start; i < count; ++i) {
+            float scaled = static_cast<float>(src[i]) * gain;
+            dst[i] = saturateS16(static_cast<float>(dst[i]) + scaled);
+        }
+    }
+
+    void mixF32Scalar(float* dst, const float* src, int start, int count, float gain) {
+        for (int i = start; i < count; ++i) {
+            float scaled = src[i] * gain;
+            dst[i] = dst[i] + scaled;
+        }
+    }
+
+    void mixStereoF32Scalar(float* dst, const float* src, int start, int count, float gainL, float gainR) {
+        for (int i = start; i < count; i += 2) {
+            float scaledL = src[i] * gainL;
+            float scaledR = src[i + 1] * gainR;
+            dst[i] = dst[i] + scaledL;
+            dst[i + 1] = dst[i + 1] + scaledR;
+        }
+    }
+
+    inline float rampGain(int frame, float gain0, float step) {
+        float offset = step * static_cast<float>(frame);
+        return gain0 + offset;
+    }
+
+    void rampS16Scalar(int16_t* dst, const int16_t* src, int start, int count, int channels, float gain0, float step) {
+        for (int i = start; i < count; ++i) {
+            dst[i] = saturateS16(static_cast<float>(src[i]) * rampGain(i / channels, gain0, step));
+        }
+    }
+
+    void rampF32Scalar(float* dst, const float* src, int start, int count, int channels, float gain0, float step) {
+        for (int i = start; i < count; ++i) {
+            dst[i] = src[i] * rampGain(i / channels, gain0, step);
+        }
+    }
+
+    inline void downmixFrame(const float* const* planes, int i, int channels,
+                             const float* left, const float* right, float* l, float* r) {
+        float accL = 0.0f;
+        float accR = 0.0f;
+        for (int ch = 0; ch < channels; ++ch) {
+            float sampleL = planes[ch][i] * left[ch];
+            float sampleR = planes[ch][i] * right[ch];
+            accL = accL + sampleL;
+            accR = accR + sampleR;
+        }
+        *l = accL;
+        *r = accR;
+    }
+
+    void downmixF32Scalar(float* dst, const float* const* planes, int start, int frames, int channels,
+                          const float* left, const float* right) {
+        for (int i = start; i < frames; ++i) {
+            downmixFrame(planes, i, channels, left, right, dst + i * 2, dst + i * 2 + 1);
+        }
+    }
+
+    void downmixS16Scalar(int16_t* dst, const float* const* planes, int start, int frames, int channels,
+                          const float* left, const float* right) {
+        for (int i = start; i < frames; ++i) {
+            float l, r;
+            downmixFrame(planes, i, channels, left, right, &l, &r);
+            // planar float 的满幅为 1.0
+            dst[i * 2] = saturateS16(l * 32768.0f);
+            dst[i * 2 + 1] = saturateS16(r * 32768.0f);
+        }
+    }
+
+    // Direct Form II 转置的一级 biquad，c 为 b0 b1 b2 a1 a2，z 为两个状态
+    inline float biquad(float x, const float* c, float* z) {
+        float y = c[0] * x;
+        y = y + z[0];
+        float t = c[1] * x;
+        t = t + z[1];
+        float u = c[3] * y;
+        z[0] = t - u;
+        t = c[2] * x;
+        u = c[4] * y;
+        z[1] = t - u;
+        return y;
+    }
+
+    void kweightF32Scalar(const float* src, int start, int frames, int channels, const float* coeffs,
+                          float* state, float* sumSq) {
+        for (int ch = 0; ch < channels; ++ch) {
+            float* z = state + ch * 4;
+            float acc = sumSq[ch];
+            for (int i = start; i < frames; ++i) {
+                float y = biquad(biquad(src[i * channels + ch], coeffs, z), coeffs + 5, z + 2);
+                float sq = y * y;
+                acc = acc + sq;
+            }
+            sumSq[ch] = acc;
+        }
+    }
+
+#if SKY_AUDIO_NEON
+    inline void downmixNeon(const float* const* planes, int i, int channels,
+                            const float* left, const float* right, float32x4_t* l, float32x4_t* r) {
+        float32x4_t accL = vdupq_n_f32(0.0f);
+        float32x4_t accR = vdupq_n_f32(0.0f);
+        for (int ch = 0; ch < channels; ++ch) {
+            float32x4_t v = vld1q_f32(planes[ch] + i);
+            accL = vaddq_f32(accL, vmulq_n_f32(v, left[ch]));
+            accR = vaddq_f32(accR, vmulq_n_f32(v, right[ch]));
+        }
+        *l = accL;
+        *r = accR;
+    }
+
+    int downmixF32Neon(float* dst, const float* const* planes, int frames, int channels,
+                       const float* left, const float* right) {
+        int i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            float32x4x2_t lr;
+            downmixNeon(planes, i, channels, left, right, &lr.val[0], &lr.val[1]);
+            vst2q_f32(dst + i * 2, lr);
+        }
+        return i;
+    }
+
+    int downmixS16Neon(int16_t* dst, const float* const* planes, int frames, int channels,
+                       const float* left, const float* right) {
+        const float32x4_t scale = vdupq_n_f32(32768.0f);
+        int i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            float32x4_t l, r;
+            downmixNeon(planes, i, channels, left, right, &l, &r);
+            int16x4x2_t lr;
+            lr.val[0] = vqmovn_s32(vcvtnq_s32_f32(vmulq_f32(l, scale)));
+            lr.val[1] = vqmovn_s32(vcvtnq_s32_f32(vmulq_f32(r, scale)));
+            vst2_s16(dst + i * 2, lr);
+        }
+        return i;
+    }
+
+    inline int16x8_t scaleS16Neon(int16x8_t v, float32x4_t gainLo, float32x4_t gainHi) {
+        float32x4_t lo = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), gainLo);
+        float32x4_t hi = vmulq_f32(vcvtq_f32_s32(vmovl_high_s16(v)), gainHi);
+        return vqmovn_high_s32(vqmovn_s32(vcvtnq_s32_f32(lo)), vcvtnq_s32_f32(hi));
+    }
+
+    int gainS16Neon(int16_t* dst, const int16_t* src, int count, float gain) {
+        const float32x4_t g = vdupq_n_f32(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            vst1q_s16(dst + i, scaleS16Neon(vld1q_s16(src + i), g, g));
+        }
+        return i;
+    }
+
+    int gainF32Neon(float* dst, const float* src, int count, float gain) {
+        const float32x4_t g = vdupq_n_f32(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            vst1q_f32(dst + i, vmulq_f32(vld1q_f32(src + i), g));
+            vst1q_f32(dst + i + 4, vmulq_f32(vld1q_f32(src + i + 4), g));
+        }
+        return i;
+    }
+
+    int mixS16Neon(int16_t* dst, const int16_t* src, int count, float gain) {
+        const float32x4_t g = vdupq_n_f32(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            int16x8_t s = vld1q_s16(src + i);
+            int16x8_t d = vld1q_s16(dst + i);
+            float32x4_t lo = vaddq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(d))),
+                                       vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), g));
+            float32x4_t hi = vaddq_f32(vcvtq_f32_s32(vmovl_high_s16(d)),
+                                       vmulq_f32(vcvtq_f32_s32(vmovl_high_s16(s)), g));
+            vst1q_s16(dst + i, vqmovn_high_s32(vqmovn_s32(vcvtnq_s32_f32(lo)), vcvtnq_s32_f32(hi)));
+        }
+        return i;
+    }
+
+    int mixF32Neon(float* dst, const float* src, int count, float gain) {
+        const float32x4_t g = vdupq_n_f32(gain);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vmulq_f32(vld1q_f32(src + i), g)));
+        }
+        return i;
+    }
+
+    int mixStereoF32Neon(float* dst, const float* src, int count, float gainL, float gainR) {
+        const float gains[4] = {gainL, gainR, gainL, gainR};
+        const float32x4_t g = vld1q_f32(gains);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vmulq_f32(vld1q_f32(src + i), g)));
+        }
+        return i;
+    }
+
+    // 单声道每个样本一帧，立体声每两个样本一帧，其余声道数走标量
+    inline float32x4_t rampGainNeon(int sample, int channels, float32x4_t gain0, float32x4_t step) {
+        static const float mono[4] = {0, 1, 2, 3};
+        static const float stereo[4] = {0, 0, 1, 1};
+        float32x4_t frames = vaddq_f32(vdupq_n_f32(static_cast<float>(sample / channels)),
+                                       vld1q_f32(channels == 1 ? mono : stereo));
+        return vaddq_f32(gain0, vmulq_f32(step, frames));
+    }
+
+    int rampS16Neon(int16_t* dst, const int16_t* src, int count, int channels, float gain0, float step) {
+        if (channels > 2) {
+            return 0;
+        }
+        const float32x4_t g0 = vdupq_n_f32(gain0);
+        const float32x4_t st = vdupq_n_f32(step);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            vst1q_s16(dst + i, scaleS16Neon(vld1q_s16(src + i),
+                                            rampGainNeon(i, channels, g0, st), rampGainNeon(i + 4, channels, g0, st)));
+        }
+        return i;
+    }
+
+    int rampF32Neon(float* dst, const float* src, int count, int channels, float gain0, float step) {
+        if (channels > 2) {
+            return 0;
+        }
+        const float32x4_t g0 = vdupq_n_f32(gain0);
+        const float32x4_t st = vdupq_n_f32(step);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            vst1q_f32(dst + i, vmulq_f32(vld1q_f32(src + i), rampGainNeon(i, channels, g0, st)));
+        }
+        return i;
+    }
+
+    // 立体声两个声道放在两个 lane 上同时递推，运算顺序与标量版本一致
+    inline float32x2_t biquadNeon(float32x2_t x, const float32x2_t* c, float32x2_t* z) {
+        float32x2_t y = vadd_f32(vmul_f32(c[0], x), z[0]);
+        z[0] = vsub_f32(vadd_f32(vmul_f32(c[1], x), z[1]), vmul_f32(c[3], y));
+        z[1] = vsub_f32(vmul_f32(c[2], x), vmul_f32(c[4], y));
+        return y;
+    }
+
+    int kweightStereoF32Neon(const float* src, int frames, const float* coeffs, float* state, float* sumSq) {
+        float32x2_t c[10];
+        for (int k = 0; k < 10; ++k) {
+            c[k] = vdup_n_f32(coeffs[k]);
+        }
+        float32x2_t z[4];
+        for (int k = 0; k < 4; ++k) {
+            const float lr[2] = {state[k], state[4 + k]};
+            z[k] = vld1_f32(lr);
+        }
+        float32x2_t acc = vld1_f32(sumSq);
+        for (int i = 0; i < frames; ++i) {
+            float32x2_t y = biquadNeon(biquadNeon(vld1_f32(src + i * 2), c, z), c + 5, z + 2);
+            acc = vadd_f32(acc, vmul_f32(y, y));
+        }
+        for (int k = 0; k < 4; ++k) {
+            state[k] = vget_lane_f32(z[k], 0);
+            state[4 + k] = vget_lane_f32(z[k], 1);
+        }
+        vst1_f32(sumSq, acc);
+        return frames;
+    }
+#endif
+
+#if SKY_AUDIO_SSE2
+    inline __m128i scaleS16Sse2(__m128i v, __m128 gainLo, __m128 gainHi) {
+        __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), gainLo);
+        __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), gainHi);
+        return _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+    }
+
+    int gainS16Sse2(int16_t* dst, const int16_t* src, int count, float gain) {
+        const __m128 g = _mm_set1_ps(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), scaleS16Sse2(v, g, g));
+        }
+        return i;
+    }
+
+    int gainF32Sse2(float* dst, const float* src, int count, float gain) {
+        const __m128 g = _mm_set1_ps(gain);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+        }
+        return i;
+    }
+
+    int mixS16Sse2(int16_t* dst, const int16_t* src, int count, float gain) {
+        const __m128 g = _mm_set1_ps(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            __m128 lo = _mm_add_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16)),
+                                   _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)), g));
+            __m128 hi = _mm_add_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16)),
+                                   _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)), g));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                             _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+        }
+        return i;
+    }
+
+    int mixF32Sse2(float* dst, const float* src, int count, float gain) {
+        const __m128 g = _mm_set1_ps(gain);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+        }
+        return i;
+    }
+
+    int mixStereoF32Sse2(float* dst, const float* src, int count, float gainL, float gainR) {
+        const __m128 g = _mm_setr_ps(gainL, gainR, gainL, gainR);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+        }
+        return i;
+    }
+
+    inline __m128 rampGainSse2(int sample, int channels, __m128 gain0, __m128 step) {
+        __m128 offsets = channels == 1 ? _mm_setr_ps(0, 1, 2, 3) : _mm_setr_ps(0, 0, 1, 1);
+        __m128 frames = _mm_add_ps(_mm_set1_ps(static_cast<float>(sample / channels)), offsets);
+        return _mm_add_ps(gain0, _mm_mul_ps(step, frames));
+    }
+
+    int rampS16Sse2(int16_t* dst, const int16_t* src, int count, int channels, float gain0, float step) {
+        if (channels > 2) {
+            return 0;
+        }
+        const __m128 g0 = _mm_set1_ps(gain0);
+        const __m128 st = _mm_set1_ps(step);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                             scaleS16Sse2(v, rampGainSse2(i, channels, g0, st), rampGainSse2(i + 4, channels, g0, st)));
+        }
+        return i;
+    }
+
+    int rampF32Sse2(float* dst, const float* src, int count, int channels, float gain0, float step) {
+        if (channels > 2) {
+            return 0;
+        }
+        const __m128 g0 = _mm_set1_ps(gain0);
+        const __m128 st = _mm_set1_ps(step);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), rampGainSse2(i, channels, g0, st)));
+        }
+        return i;
+    }
+
+    inline void downmixSse2(const float* const* planes, int i, int channels,
+                            const float* left, const float* right, __m128* l, __m128* r) {
+        __m128 accL = _mm_setzero_ps();
+        __m128 accR = _mm_setzero_ps();
+        for (int ch = 0; ch < channels; ++ch) {
+            __m128 v = _mm_loadu_ps(planes[ch] + i);
+            accL = _mm_add_ps(accL, _mm_mul_ps(v, _mm_set1_ps(left[ch])));
+            accR = _mm_add_ps(accR, _mm_mul_ps(v, _mm_set1_ps(right[ch])));
+        }
+        *l = accL;
+        *r = accR;
+    }
+
+    int downmixF32Sse2(float* dst, const float* const* planes, int frames, int channels,
+                       const float* left, const float* right) {
+        int i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            __m128 l, r;
+            downmixSse2(planes, i, channels, left, right, &l, &r);
+            _mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(l, r));
+        }
+        return i;
+    }
+
+    int downmixS16Sse2(int16_t* dst, const float* const* planes, int frames, int channels,
+                       const float* left, const float* right) {
+        const __m128 scale = _mm_set1_ps(32768.0f);
+        int i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            __m128 l, r;
+            downmixSse2(planes, i, channels, left, right, &l, &r);
+            __m128i li = _mm_cvtps_epi32(_mm_mul_ps(l, scale));
+            __m128i ri = _mm_cvtps_epi32(_mm_mul_ps(r, scale));
+            __m128i packed = _mm_packs_epi32(_mm_unpacklo_epi32(li, ri), _mm_unpackhi_epi32(li, ri));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), packed);
+        }
+        return i;
+    }
+
+    // 立体声只用低两个 lane：两个声道共用一条递推链，标量版本要逐声道各跑一遍
+    inline __m128 biquadSse2(__m128 x, const __m128* c, __m128* z) {
+        __m128 y = _mm_add_ps(_mm_mul_ps(c[0], x), z[0]);
+        z[0] = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(c[1], x), z[1]), _mm_mul_ps(c[3], y));
+        z[1] = _mm_sub_ps(_mm_mul_ps(c[2], x), _mm_mul_ps(c[4], y));
+        return y;
+    }
+
+    int kweightStereoF32Sse2(const float* src, int frames, const float* coeffs, float* state, float* sumSq) {
+        __m128 c[10];
+        for (int k = 0; k < 10; ++k) {
+            c[k] = _mm_set1_ps(coeffs[k]);
+        }
+        __m128 z[4];
+        for (int k = 0; k < 4; ++k) {
+            z[k] = _mm_setr_ps(state[k], state[4 + k], 0.0f, 0.0f);
+        }
+        __m128 acc = _mm_setr_ps(sumSq[0], sumSq[1], 0.0f, 0.0f);
+        for (int i = 0; i < frames; ++i) {
+            __m128 x = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(src + i * 2)));
+            __m128 y = biquadSse2(biquadSse2(x, c, z), c + 5, z + 2);
+            acc = _mm_add_ps(acc, _mm_mul_ps(y, y));
+        }
+        for (int k = 0; k < 4; ++k) {
+            float lanes[4];
+            _mm_storeu_ps(lanes, z[k]);
+            state[k] = lanes[0];
+            state[4 + k] = lanes[1];
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc);
+        sumSq[0] = lanes[0];
+        sumSq[1] = lanes[1];
+        return frames;
+    }
+#endif
+
+#if SKY_AUDIO_AVX2
+    __attribute__((target("avx2")))
+    int gainS16Avx2(int16_t* dst, const int16_t* src, int count, float gain) {
+        const __m256 g = _mm256_set1_ps(gain);
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256 lo = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v))), g);
+            __m256 hi = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1))), g);
+            // packs 按 128 bit lane 交错，需要再按 64 bit 重排回原顺序
+            __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(lo), _mm256_cvtps_epi32(hi));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(packed, 0xD8));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    int gainF32Avx2(float* dst, const float* src, int count, float gain) {
+        const __m256 g = _mm256_set1_ps(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    int mixS16Avx2(int16_t* dst, const int16_t* src, int count, float gain) {
+        const __m256 g = _mm256_set1_ps(gain);
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            __m256 lo = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(d))),
+                                      _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(s))), g));
+            __m256 hi = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(d, 1))),
+                                      _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(s, 1))), g));
+            __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(lo), _mm256_cvtps_epi32(hi));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(packed, 0xD8));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    int mixF32Avx2(float* dst, const float* src, int count, float gain) {
+        const __m256 g = _mm256_set1_ps(gain);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    int mixStereoF32Avx2(float* dst, const float* src, int count, float gainL, float gainR) {
+        const __m256 g = _mm256_setr_ps(gainL, gainR, gainL, gainR, gainL, gainR, gainL, gainR);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+        }
+        return i;
+    }
+#endif
+
+    struct Kernels {
+        const char* name;
+        int (*gainS16)(int16_t*, const int16_t*, int, float);
+        int (*gainF32)(float*, const float*, int, float);
+        int (*mixS16)(int16_t*, const int16_t*, int, float);
+        int (*mixF32)(float*, const float*, int, float);
+        int (*mixStereoF32)(float*, const float*, int, float, float);
+        int (*rampS16)(int16_t*, const int16_t*, int, int, float, float);
+        int (*rampF32)(float*, const float*, int, int, float, float);
+        int (*downmixF32)(float*, const float* const*, int, int, const float*, const float*);
+        int (*downmixS16)(int16_t*, const float* const*, int, int, const float*, const float*);
+        int (*kweightStereoF32)(const float*, int, const float*, float*, float*);
+    };
+
+    const Kernels kScalarKernels = {"scalar", nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                                    nullptr, nullptr};
+    std::atomic<bool> forceScalar{false};
+
+    Kernels selectKernels() {
+#if SKY_AUDIO_NEON
+        return {"neon", gainS16Neon, gainF32Neon, mixS16Neon, mixF32Neon, mixStereoF32Neon, rampS16Neon, rampF32Neon,
+                downmixF32Neon, downmixS16Neon, kweightStereoF32Neon};
+#elif SKY_AUDIO_SSE2
+#if SKY_AUDIO_AVX2
+        // 渐变只在音量切换后的几毫秒内使用，downmix 受限于逐声道的加载，K 加权是逐帧递推，都沿用 SSE2 版本
+        if (__builtin_cpu_supports("avx2")) {
+            return {"avx2", gainS16Avx2, gainF32Avx2, mixS16Avx2, mixF32Avx2, mixStereoF32Avx2, rampS16Sse2, rampF32Sse2,
+                    downmixF32Sse2, downmixS16Sse2, kweightStereoF32Sse2};
+        }
+#endif
+        return {"sse2", gainS16Sse2, gainF32Sse2, mixS16Sse2, mixF32Sse2, mixStereoF32Sse2, rampS16Sse2, rampF32Sse2,
+                downmixF32Sse2, downmixS16Sse2, kweightStereoF32Sse2};
+#else
+        return kScalarKernels;
+#endif
+    }
+
+    const Kernels& kernels() {
+        static const Kernels k = selectKernels();
+        return forceScalar.load(std::memory_order_relaxed) ? kScalarKernels : k;
+    }
+}
+
+void sky_audio_gain_s16(int16_t *dst, const int16_t *src, int count, float gain) {
+    if (gain == 1.0f) {
+        if (dst != src) memmove(dst, src, sizeof(int16_t) * count);
+        return;
+    }
+    if (gain == 0.0f) {
+        memset(dst, 0, sizeof(int16_t) * count);
+        return;
+    }
+    int done = kernels().gainS16 ? kernels().gainS16(dst, src, count, gain) : 0;
+    gainS16Scalar(dst, src, done, count, gain);
+}
+
+void sky_audio_gain_f32(float *dst, const float *src, int count, float gain) {
+    if (gain == 1.0f) {
+        if (dst != src) memmove(dst, src, sizeof(float) * count);
+        return;
+    }
+    if (gain == 0.0f) {
+        memset(dst, 0, sizeof(float) * count);
+        return;
+    }
+    int done = kernels().gainF32 ? kernels().gainF32(dst, src, count, gain) : 0;
+    gainF32Scalar(dst, src, done, count, gain);
+}
+
+void sky_audio_ramp_s16(int16_t *dst, const int16_t *src, int frames, int channels, float gain0, float gain1) {
+    if (frames <= 0 || channels <= 0) {
+        return;
+    }
+    const int count = frames * channels;
+    const float step = (gain1 - gain0) / static_cast<float>(frames);
+    int done = kernels().rampS16 ? kernels().rampS16(dst, src, count, channels, gain0, step) : 0;
+    rampS16Scalar(dst, src, done, count, channels, gain0, step);
+}
+
+void sky_audio_ramp_f32(float *dst, const float *src, int frames, int channels, float gain0, float gain1) {
+    if (frames <= 0 || channels <= 0) {
+        return;
+    }
+    const int count = frames * channels;
+    const float step = (gain1 - gain0) / static_cast<float>(frames);
+    int done = kernels().rampF32 ? kernels().rampF32(dst, src, count, channels, gain0, step) : 0;
+    rampF32Scalar(dst, src, done, count, channels, gain0, step);
+}
+
+void sky_audio_mix_s16(int16_t *dst, const int16_t *src, int count, float gain) {
+    if (gain == 0.0f) {
+        return;
+    }
+    int done = kernels().mixS16 ? kernels().mixS16(dst, src, count, gain) : 0;
+    mixS16Scalar(dst, src, done, count, gain);
+}
+
+void sky_audio_mix_f32(float *dst, const float *src, int count, float gain) {
+    if (gain == 0.0f) {
+        return;
+    }
+    int done = kernels().mixF32 ? kernels().mixF32(dst, src, count, gain) : 0;
+    mixF32Scalar(dst, src, done, count, gain);
+}
+
+void sky_audio_mix_stereo_f32(float *dst, const float *src, int frames, float gainL, float gainR) {
+    if (gainL == gainR) {
+        sky_audio_mix_f32(dst, src, frames * 2, gainL);
+        return;
+    }
+    int done = kernels().mixStereoF32 ? kernels().mixStereoF32(dst, src, frames * 2, gainL, gainR) : 0;
+    mixStereoF32Scalar(dst, src, done, frames * 2, gainL, gainR);
+}
+
+void sky_audio_downmix_stereo_f32(float *dst, const float *const *planes, int frames, int channels,
+                                  const float *left, const float *right) {
+    int done = kernels().downmixF32 ? kernels().downmixF32(dst, planes, frames, channels, left, right) : 0;
+    downmixF32Scalar(dst, planes, done, frames, channels, left, right);
+}
+
+void sky_audio_downmix_stereo_s16(int16_t *dst, const float *const *planes, int frames, int channels,
+                                  const float *left, const float *right) {
+    int done = kernels().downmixS16 ? kernels().downmixS16(dst, planes, frames, channels, left, right) : 0;
+    downmixS16Scalar(dst, planes, done, frames, channels, left, right);
+}
+
+void sky_audio_kweight_f32(const float *src, int frames, int channels, const float *coeffs, float *state, float *sumSq) {
+    if (channels <= 0 || channels > SKY_AUDIO_KWEIGHT_MAX_CHANNELS) {
+        return;
+    }
+    std::fill(sumSq, sumSq + channels, 0.0f);
+    if (frames <= 0) {
+        return;
+    }
+    // 多声道只在没有 downmix 的输出上出现，走标量
+    int done = channels == 2 && kernels().kweightStereoF32
+               ? kernels().kweightStereoF32(src, frames, coeffs, state, sumSq) : 0;
+    kweightF32Scalar(src, done, frames, channels, coeffs, state, sumSq);
+}
+
+const char *sky_audio_kernels_impl(void) {
+    return kernels().name;
+}
+
+void sky_audio_kernels_force_scalar(int enabled) {
+    forceScalar.store(enabled != 0, std::memory_order_relaxed);
+}
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "sky_audio_mixer.h"
+#include "sky_audio_kernels.h"
+
+static const char *TAG = "SkyAudioMixer";
+
+namespace {
+    // 混音器的设备输出：复用 OpenSL ES 输出线程，buffer 由混音器直接填充，没有生产线程
+    class SkyMixerDeviceOut : public SkySLESAudioOut {
+    public:
+        explicit SkyMixerDeviceOut(SkyAudioMixer *mixer) : mixer_(mixer) {}
+
+    protected:
+        void fillBuffer(uint8_t *dst, int bytes) override {
+            const int frames = bytes / static_cast<int>(AUDIO_MIXER_CHANNELS * sizeof(float));
+            // 只在输出线程调用，设备时钟不会被并发更新
+            auto queued = static_cast<int64_t>(std::llround(getLatencySeconds() * AUDIO_MIXER_SAMPLE_RATE));
+            mixer_->mix(reinterpret_cast<float *>(dst), frames, queued + frames);
+        }
+
+        bool useDeepBuffer() override {
+            return mixer_->allInputsDeepBuffer();
+        }
+
+    private:
+        SkyAudioMixer *mixer_;
+    };
+}
+
+SkyAudioMixer& SkyAudioMixer::instance() {
+    static SkyAudioMixer mixer;
+    return mixer;
+}
+
+template <typename Fn>
+void SkyAudioMixer::updateInputsLocked(Fn &&update) {
+    auto waitReaderLeaves = [this](int index) {
+        // 实时线程每个 buffer 只持有列表很短的时间
+        while (reading_.load() == index) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    const int current = current_.load();
+    const int next = 1 - current;
+    waitReaderLeaves(next);
+    inputs_[next] = inputs_[current];
+    update(inputs_[next]);
+    current_.store(next);
+    waitReaderLeaves(current);
+}
+
+const std::vector<SkyMixerAudioOut*>& SkyAudioMixer::acquireInputs() const {
+    int index;
+    do {
+        // 先登记再确认列表没有被切换，写线程据此判断旧列表是否还在使用
+        index = current_.load();
+        reading_.store(index);
+    } while (current_.load() != index);
+    return inputs_[index];
+}
+
+void SkyAudioMixer::releaseInputs() const {
+    reading_.store(-1, std::memory_order_release);
+}
+
+bool SkyAudioMixer::addInput(SkyMixerAudioOut *input) {
+    std::lock_guard<std::mutex> deviceLock(deviceMutex_);
+    if (!device_) {
+        SkyAudioSpec desired{};
+        desired.sdl_audioSpec.freq = AUDIO_MIXER_SAMPLE_RATE;
+        desired.sdl_audioSpec.channels = AUDIO_MIXER_CHANNELS;
+        desired.sdl_audioSpec.format = SDL_AUDIO_F32;
+        desired.silence = 0;
+
+        scratch_.assign(static_cast<size_t>(AUDIO_MIXER_SAMPLE_RATE) * OPENSLES_DEEP_BUFLEN / 1000 * AUDIO_MIXER_CHANNELS, 0.0f);
+        deviceQueuedFrames_.store(0, std::memory_order_relaxed);
+
+        auto device = std::make_unique<SkyMixerDeviceOut>(this);
+        if (!device->openAudio(&desired, nullptr)) {
+            ALOG_E(TAG, "open mixer device failed");
+            device->closeAudio();
+            return false;
+        }
+        device_ = std::move(device);
+        ALOG_I(TAG, "mixer device opened: %d Hz, %d channels, kernels: %s",
+               AUDIO_MIXER_SAMPLE_RATE, AUDIO_MIXER_CHANNELS, sky_audio_kernels_impl());
+    }
+
+    updateInputsLocked([input](std::vector<SkyMixerAudioOut*> &inputs) {
+        inputs.push_back(input);
+    });
+    ALOG_I(TAG, "input %p added, %zu inputs", input, inputs_[current_.load()].size());
+    return true;
+}
+
+void SkyAudioMixer::removeInput(SkyMixerAudioOut *input) {
+    std::lock_guard<std::mutex> deviceLock(deviceMutex_);
+    // 返回后实时线程不会再访问该输入
+    updateInputsLocked([input](std::vector<SkyMixerAudioOut*> &inputs) {
+        inputs.erase(std::remove(inputs.begin(), inputs.end(), input), inputs.end());
+    });
+    const bool empty = inputs_[current_.load()].empty();
+    ALOG_I(TAG, "input %p removed", input);
+
+    if (empty && device_) {
+        // 输出线程不拿 deviceMutex_，持有它 join 不会死锁
+        device_->closeAudio();
+        device_.reset();
+        ALOG_I(TAG, "mixer device closed");
+    } else if (device_) {
+        device_->pauseAudio(hasActiveInputLocked() ? 0 : 1);
+    }
+}
+
+void SkyAudioMixer::onInputStateChanged() {
+    std::lock_guard<std::mutex> deviceLock(deviceMutex_);
+    if (device_) {
+        device_->pauseAudio(hasActiveInputLocked() ? 0 : 1);
+    }
+}
+
+bool SkyAudioMixer::hasActiveInputLocked() const {
+    const auto &inputs = inputs_[current_.load()];
+    return std::any_of(inputs.begin(), inputs.end(), [](const SkyMixerAudioOut *input) {
+        return !input->isPaused();
+    });
+}
+
+bool SkyAudioMixer::allInputsDeepBuffer() const {
+    bool active = false;
+    bool deep = true;
+    for (const SkyMixerAudioOut *input : acquireInputs()) {
+        if (input->isPaused()) {
+            continue;
+        }
+        active = true;
+        if (!input->deepBufferActive()) {
+            deep = false;
+            break;
+        }
+    }
+    releaseInputs();
+    return active && deep;
+}
+
+void SkyAudioMixer::mix(float *dst, int frames, int64_t deviceQueued) {
+    std::fill(dst, dst + static_cast<size_t>(frames) * AUDIO_MIXER_CHANNELS, 0.0f);
+    if (static_cast<size_t>(frames) * AUDIO_MIXER_CHANNELS <= scratch_.size()) {
+        for (SkyMixerAudioOut *input : acquireInputs()) {
+            if (!input->isPaused()) {
+                input->mixInto(dst, scratch_.data(), frames);
+            }
+        }
+        releaseInputs();
+    }
+    deviceQueuedFrames_.store(deviceQueued, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// SkyMixerAudioOut
+// ============================================================================
+
+SkyMixerAudioOut::~SkyMixerAudioOut() {
+    closeAudio();
+}
+
+bool SkyMixerAudioOut::openAudio(const SkyAudioSpec *desired, SkyAudioSpec *obtained) {
+    if (opened_.load(std::memory_order_relaxed)) {
+        ALOG_E(TAG, "mixer input already opened");
+        return false;
+    }
+
+    SkyAudioSpec spec = *desired;
+    spec.sdl_audioSpec.freq = AUDIO_MIXER_SAMPLE_RATE;
+    spec.sdl_audioSpec.channels = AUDIO_MIXER_CHANNELS;
+    spec.sdl_audioSpec.format = SDL_AUDIO_F32;
+    spec.silence = 0;
+
+    const int bytesPerFrame = AUDIO_MIXER_CHANNELS * static_cast<int>(sizeof(float));
+    const int framesPerBuffer = AUDIO_MIXER_SAMPLE_RATE * OPENSLES_BUFLEN / 1000;
+    resetPosition(AUDIO_MIXER_SAMPLE_RATE);
+    minimalLatencySeconds = (double) OPENSLES_BUFFERS * OPENSLES_BUFLEN / 1000;
+    paused_.store(true, std::memory_order_relaxed);
+
+    if (obtained) {
+        *obtained = spec;
+        obtained->size = OPENSLES_BUFFERS * framesPerBuffer * bytesPerFrame;
+    }
+
+    startProducer(spec, bytesPerFrame, framesPerBuffer * bytesPerFrame);
+    if (!SkyAudioMixer::instance().addInput(this)) {
+        stopProducer();
+        return false;
+    }
+    opened_.store(true, std::memory_order_relaxed);
+    ALOG_I(TAG, "mixer input opened, source %d channels %d Hz", desired->sdl_audioSpec.channels,
+           desired->sdl_audioSpec.freq);
+    return true;
+}
+
+void SkyMixerAudioOut::pauseAudio(int pauseOn) {
+    paused_.store(pauseOn != 0, std::memory_order_relaxed);
+    setProducerPaused(pauseOn != 0);
+    if (opened_.load(std::memory_order_relaxed)) {
+        SkyAudioMixer::instance().onInputStateChanged();
+    }
+}
+
+void SkyMixerAudioOut::flushAudio() {
+    // 已经混进设备队列的数据与其他输入混在一起，无法单独丢弃，只作废 ring 中的数据
+    requestRingFlush();
+}
+
+void SkyMixerAudioOut::setVolume(float left, float right) {
+    leftVolume_.store(left, std::memory_order_relaxed);
+    rightVolume_.store(right, std::memory_order_relaxed);
+}
+
+void SkyMixerAudioOut::setPan(float pan) {
+    pan_.store(std::clamp(pan, -1.0f, 1.0f), std::memory_order_relaxed);
+}
+
+void SkyMixerAudioOut::closeAudio() {
+    if (!opened_.exchange(false, std::memory_order_relaxed)) {
+        return;
+    }
+    SkyAudioMixer::instance().removeInput(this);
+    stopProducer();
+}
+
+void SkyMixerAudioOut::mixInto(float *dst, float *scratch, int frames) {
+    readPcm(reinterpret_cast<uint8_t *>(scratch), frames * AUDIO_MIXER_CHANNELS * static_cast<int>(sizeof(float)), 0);
+    onFramesWritten(frames);
+
+    // 声像按平衡方式处理：偏向一侧时只衰减另一侧
+    float pan = pan_.load(std::memory_order_relaxed);
+    float gainL = leftVolume_.load(std::memory_order_relaxed) * (pan > 0.0f ? 1.0f - pan : 1.0f);
+    float gainR = rightVolume_.load(std::memory_order_relaxed) * (pan < 0.0f ? 1.0f + pan : 1.0f);
+    sky_audio_mix_stereo_f32(dst, scratch, frames, gainL, gainR);
+}
+
+int64_t SkyMixerAudioOut::getDevicePlayedFrames() {
+    int64_t played = framesWritten_.load(std::memory_order_relaxed) - SkyAudioMixer::instance().deviceQueuedFrames();
+    return std::max<int64_t>(played, 0);
+}
@@ -0,0 +1,100 @@
+#ifndef MY_PLAYER_SKY_AUDIO_MIXER_H
+#define MY_PLAYER_SKY_AUDIO_MIXER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "skyaudio.h"
+
+#define AUDIO_MIXER_SAMPLE_RATE 48000
+#define AUDIO_MIXER_CHANNELS    2
+
+class SkyMixerAudioOut;
+
+/**
+ * 进程内共享的混音器：只有一个 OpenSL ES 引擎、一路设备输出和一个实时线程。
+ * 每个播放器是其中一路输入，实时线程直接从各输入的 ring 读取，按各自的增益/声像叠加。
+ * 第一路输入加入时打开设备，最后一路移除后关闭；所有输入都暂停时设备也暂停。
+ */
+class SkyAudioMixer {
+public:
+    static SkyAudioMixer& instance();
+
+    bool addInput(SkyMixerAudioOut *input);
+    void removeInput(SkyMixerAudioOut *input);
+    // 输入暂停/恢复后调用
+    void onInputStateChanged();
+
+    // 已混合写给设备但还没播放的帧数，实时线程每个 buffer 更新一次
+    int64_t deviceQueuedFrames() const {
+        return deviceQueuedFrames_.load(std::memory_order_relaxed);
+    }
+
+    // 实时线程：把所有未暂停的输入混合到 dst，deviceQueued 为设备中已有的帧数
+    void mix(float *dst, int frames, int64_t deviceQueued);
+    // 所有未暂停的输入都处于深缓冲时，设备才按深缓冲入队
+    bool allInputsDeepBuffer() const;
+
+private:
+    SkyAudioMixer() = default;
+    bool hasActiveInputLocked() const;
+    // 持有 deviceMutex_：按 update 修改输入列表并发布，返回时实时线程已不再使用旧列表
+    template <typename Fn>
+    void updateInputsLocked(Fn &&update);
+
+    // 实时线程：取当前发布的输入列表，用完后 release，期间该列表不会被修改
+    const std::vector<SkyMixerAudioOut*>& acquireInputs() const;
+    void releaseInputs() const;
+
+private:
+    // 设备的打开/关闭/暂停和输入列表的修改都串行执行，实时线程不会拿这把锁
+    std::mutex deviceMutex_;
+    std::unique_ptr<SkySLESAudioOut> device_;
+
+    // 输入列表双缓冲：修改写到未发布的一份再切换 current_，实时线程不加锁，避免 SCHED_FIFO 线程被普通线程阻塞。
+    // reading_ 为实时线程正在使用的下标，-1 表示没有使用
+    std::vector<SkyMixerAudioOut*> inputs_[2];
+    std::atomic<int> current_{0};
+    mutable std::atomic<int> reading_{-1};
+    // 只在实时线程使用，设备打开前分配
+    std::vector<float> scratch_;
+
+    std::atomic<int64_t> deviceQueuedFrames_{0};
+};
+
+/**
+ * 混音器的一路输入。输出格式固定为混音器格式（48k 立体声 float），
+ * 重采样和声道转换由上层 swr 在生产线程完成，实时线程只做拷贝和乘加。
+ */
+class SkyMixerAudioOut : public SkyAudioOut {
+public:
+    ~SkyMixerAudioOut() override;
+
+    bool openAudio(const SkyAudioSpec *desired, SkyAudioSpec *obtained) override;
+    void pauseAudio(int pauseOn) override;
+    void flushAudio() override;
+    void setVolume(float left, float right) override;
+    void setPan(float pan) override;
+    void closeAudio() override;
+
+    bool isPaused() const {
+        return paused_.load(std::memory_order_relaxed);
+    }
+
+    // 混音器实时线程：读取 frames 帧并按增益叠加到 dst，scratch 至少 frames 帧
+    void mixInto(float *dst, float *scratch, int frames);
+
+protected:
+    int64_t getDevicePlayedFrames() override;
+
+private:
+    std::atomic<bool> opened_{false};
+    std::atomic<bool> paused_{true};
+    std::atomic<float> leftVolume_{1.0f};
+    std::atomic<float> rightVolume_{1.0f};
+    std::atomic<float> pan_{0.0f};
+};
+
+#endif //MY_PLAYER_SKY_AUDIO_MIXER_H
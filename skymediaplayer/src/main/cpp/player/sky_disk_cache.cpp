@@ -0,0 +1,529 @@
+extern "C" {
+#include "libavutil/error.h"
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+#include "logger.h"
+#include "sky_disk_cache.h"
+
+static const char* TAG = "SkyDiskCache";
+
+#define DISK_CACHE_INDEX_MAGIC "skycache 2"
+#define DISK_CACHE_INDEX_EXT ".index"
+#define DISK_CACHE_DATA_EXT ".data"
+
+// ============================================================================
+// SkyDiskCacheEntry
+// ============================================================================
+
+int64_t SkyDiskCacheEntry::rangeEnd(int64_t pos) const {
+    auto it = ranges_.upper_bound(pos);
+    if (it == ranges_.begin()) {
+        return -1;
+    }
+    --it;
+    return it->second > pos ? it->second : -1;
+}
+
+int64_t SkyDiskCacheEntry::nextRangeStart(int64_t pos) const {
+    auto it = ranges_.upper_bound(pos);
+    return it == ranges_.end() ? -1 : it->first;
+}
+
+int64_t SkyDiskCacheEntry::addRange(int64_t start, int64_t end) {
+    if (end <= start) {
+        return 0;
+    }
+
+    // 从包含或紧接 start 的区间开始，把 end 之前的区间都合并进来
+    auto it = ranges_.upper_bound(start);
+    if (it != ranges_.begin() && std::prev(it)->second >= start) {
+        --it;
+        start = it->first;
+    }
+    int64_t merged = 0;
+    while (it != ranges_.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        merged += it->second - it->first;
+        it = ranges_.erase(it);
+    }
+    ranges_[start] = end;
+
+    const int64_t added = end - start - merged;
+    bytes_ += added;
+    return added;
+}
+
+void SkyDiskCacheEntry::clearRanges() {
+    ranges_.clear();
+    bytes_ = 0;
+}
+
+// ============================================================================
+// 播放器读取：命中从磁盘读，空洞回源并写回磁盘
+// ============================================================================
+
+class SkyDiskCache::Source : public SkyIoSource {
+public:
+    Source(SkyDiskCache &cache, std::shared_ptr<SkyDiskCacheEntry> entry, const AVIOInterruptCB *interrupt)
+        : cache_(cache)
+        , entry_(std::move(entry))
+        , interrupt_(interrupt ? *interrupt : AVIOInterruptCB{}) {
+    }
+
+    ~Source() override {
+        ALOG_I(TAG, "close %s: %lld bytes from disk, %lld bytes from network",
+               entry_->url.c_str(), (long long) hitBytes_, (long long) missBytes_);
+        avio_closep(&upstream_);
+        cache_.release(entry_.get());
+    }
+
+    int read(uint8_t *buf, int size) override {
+        int64_t rangeEnd = -1;
+        int64_t nextStart = -1;
+        const int64_t total = cache_.lookup(entry_.get(), pos_, &rangeEnd, &nextStart);
+        if (rangeEnd > pos_) {
+            auto n = static_cast<size_t>(std::min<int64_t>(size, rangeEnd - pos_));
+            ssize_t ret = pread(entry_->fd, buf, n, pos_);
+            if (ret > 0) {
+                pos_ += ret;
+                hitBytes_ += ret;
+                return static_cast<int>(ret);
+            }
+            // 读盘失败时回源
+            ALOG_W(TAG, "pread at %lld failed: %s", (long long) pos_, strerror(errno));
+        }
+        if (total >= 0 && pos_ >= total) {
+            return AVERROR_EOF;
+        }
+
+        int ret = ensureUpstream();
+        if (ret < 0) {
+            return ret;
+        }
+        if (upstreamPos_ != pos_) {
+            int64_t pos = avio_seek(upstream_, pos_, SEEK_SET);
+            if (pos < 0) {
+                return static_cast<int>(pos);
+            }
+            upstreamPos_ = pos_;
+        }
+        // 只下载到下一个已缓存的区间为止
+        if (nextStart > pos_) {
+            size = static_cast<int>(std::min<int64_t>(size, nextStart - pos_));
+        }
+        ret = avio_read_partial(upstream_, buf, size);
+        if (ret <= 0) {
+            return ret == 0 ? AVERROR_EOF : ret;
+        }
+        cache_.store(entry_.get(), pos_, buf, ret);
+        pos_ += ret;
+        upstreamPos_ += ret;
+        missBytes_ += ret;
+        return ret;
+    }
+
+    int64_t seek(int64_t offset, int whence) override {
+        whence &= ~AVSEEK_FORCE;
+        int64_t total = -1;
+        if (whence == AVSEEK_SIZE || whence == SEEK_END) {
+            int64_t rangeEnd;
+            int64_t nextStart;
+            total = cache_.lookup(entry_.get(), pos_, &rangeEnd, &nextStart);
+            // 大小已记录在索引里时不必联网
+            if (total < 0 && ensureUpstream() >= 0) {
+                total = avio_size(upstream_);
+            }
+            if (whence == AVSEEK_SIZE) {
+                return total >= 0 ? total : AVERROR(ENOSYS);
+            }
+            if (total < 0) {
+                return AVERROR(ENOSYS);
+            }
+        }
+
+        int64_t pos;
+        switch (whence) {
+            case SEEK_SET:
+                pos = offset;
+                break;
+            case SEEK_CUR:
+                pos = pos_ + offset;
+                break;
+            case SEEK_END:
+                pos = total + offset;
+                break;
+            default:
+                return AVERROR(EINVAL);
+        }
+        if (pos < 0) {
+            return AVERROR(EINVAL);
+        }
+        pos_ = pos;
+        return pos_;
+    }
+
+private:
+    int ensureUpstream() {
+        if (upstream_) {
+            return 0;
+        }
+        int ret = SkyIo::openUpstream(entry_->url, &interrupt_, &upstream_);
+        if (ret < 0) {
+            return ret;
+        }
+        upstreamPos_ = 0;
+        SkyHttpInfo info;
+        info.size = avio_size(upstream_);
+        cache_.validate(entry_.get(), info);
+        return 0;
+    }
+
+private:
+    SkyDiskCache &cache_;
+    std::shared_ptr<SkyDiskCacheEntry> entry_;
+    AVIOInterruptCB interrupt_;
+    AVIOContext *upstream_ = nullptr;
+    int64_t pos_ = 0;
+    int64_t upstreamPos_ = 0;
+    int64_t hitBytes_ = 0;
+    int64_t missBytes_ = 0;
+};
+
+// ============================================================================
+// SkyDiskCache
+// ============================================================================
+
+SkyDiskCache& SkyDiskCache::instance() {
+    static SkyDiskCache cache;
+    return cache;
+}
+
+void SkyDiskCache::setDir(const std::string &dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dir_.empty() || dir.empty()) {
+        return;
+    }
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        ALOG_E(TAG, "mkdir %s failed: %s", dir.c_str(), strerror(errno));
+        return;
+    }
+    dir_ = dir;
+
+    // 加载上次进程留下的索引；没有有效索引的数据文件是写了一半的，连同临时文件一起删除
+    DIR *d = opendir(dir_.c_str());
+    if (nullptr == d) {
+        return;
+    }
+    std::vector<std::string> names;
+    while (struct dirent *ent = readdir(d)) {
+        if (ent->d_name[0] != '.') {
+            names.emplace_back(ent->d_name);
+        }
+    }
+    closedir(d);
+
+    const std::string indexExt(DISK_CACHE_INDEX_EXT);
+    std::unordered_set<std::string> keys;
+    for (const auto &name : names) {
+        if (name.size() > indexExt.size() && name.compare(name.size() - indexExt.size(), indexExt.size(), indexExt) == 0
+            && loadIndexLocked(dir_ + "/" + name)) {
+            keys.insert(name.substr(0, name.size() - indexExt.size()));
+        }
+    }
+    for (const auto &name : names) {
+        const size_t dot = name.find('.');
+        const std::string ext = dot == std::string::npos ? "" : name.substr(dot);
+        const bool known = ext == DISK_CACHE_DATA_EXT || ext == DISK_CACHE_INDEX_EXT;
+        if (!known || keys.count(name.substr(0, dot)) == 0) {
+            unlink((dir_ + "/" + name).c_str());
+        }
+    }
+    evictLocked(nullptr, 0);
+    ALOG_I(TAG, "setDir %s: %zu entries, %lld bytes", dir_.c_str(), entries_.size(), (long long) used_);
+}
+
+void SkyDiskCache::setBudget(int64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = std::max<int64_t>(bytes, 0);
+    evictLocked(nullptr, 0);
+    ALOG_I(TAG, "budget %lld bytes, used %lld", (long long) budget_, (long long) used_);
+}
+
+bool SkyDiskCache::isCacheUrl(const char *url) {
+    return url && strncmp(url, DISK_CACHE_SCHEME, strlen(DISK_CACHE_SCHEME)) == 0;
+}
+
+bool SkyDiskCache::isSegmentedUrl(const char *url) {
+    if (nullptr == url) {
+        return false;
+    }
+    const char *end = url + strcspn(url, "?#");
+    for (const char *ext : {".m3u8", ".m3u", ".mpd"}) {
+        const size_t len = strlen(ext);
+        if (static_cast<size_t>(end - url) >= len && strncasecmp(end - len, ext, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *SkyDiskCache::unwrapUrl(const char *url) {
+    if (isCacheUrl(url) && isSegmentedUrl(url + strlen(DISK_CACHE_SCHEME))) {
+        ALOG_I(TAG, "segmented stream is not cached: %s", url);
+        return url + strlen(DISK_CACHE_SCHEME);
+    }
+    return url;
+}
+
+int64_t SkyDiskCache::cachedBytes(const std::string &url) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(url);
+    return it == entries_.end() ? 0 : it->second->bytes();
+}
+
+AVIOContext *SkyDiskCache::openIo(const char *url, const AVIOInterruptCB *interrupt) {
+    if (!isCacheUrl(url)) {
+        return nullptr;
+    }
+    const char *upstreamUrl = url + strlen(DISK_CACHE_SCHEME);
+    if (isSegmentedUrl(upstreamUrl)) {
+        ALOG_W(TAG, "segmented stream can not be cached: %s", upstreamUrl);
+        return nullptr;
+    }
+    auto entry = acquire(upstreamUrl);
+    // 复用已缓存的区间之前先向源站确认内容没变；连不上时保留缓存，离线也能重播
+    if (!entry->key.empty() && SkyIo::isHttp(upstreamUrl)) {
+        SkyHttpInfo info;
+        if (SkyIo::probeHttp(upstreamUrl, interrupt, &info) >= 0) {
+            validate(entry.get(), info);
+        }
+    }
+    return SkyIo::wrap(std::make_unique<Source>(*this, std::move(entry), interrupt));
+}
+
+std::shared_ptr<SkyDiskCacheEntry> SkyDiskCache::acquire(const std::string &url) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dir_.empty()) {
+        // 没有缓存目录：不进表、不开文件，所有读取都回源
+        ALOG_W(TAG, "no cache dir, %s is not cached", url.c_str());
+        auto entry = std::make_shared<SkyDiskCacheEntry>();
+        entry->url = url;
+        entry->pins = 1;
+        return entry;
+    }
+
+    auto &entry = entries_[url];
+    if (!entry) {
+        entry = std::make_shared<SkyDiskCacheEntry>();
+        entry->url = url;
+        char key[32];
+        snprintf(key, sizeof(key), "%016zx", std::hash<std::string>()(url));
+        entry->key = key;
+    }
+    entry->pins++;
+    entry->lastUsed = ++clock_;
+    if (entry->fd < 0) {
+        entry->fd = open(pathLocked(*entry, DISK_CACHE_DATA_EXT).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (entry->fd < 0) {
+            ALOG_E(TAG, "open data file failed: %s", strerror(errno));
+            used_ -= entry->bytes();
+            entry->clearRanges();
+        }
+    }
+    ALOG_I(TAG, "open %s: %lld bytes cached", url.c_str(), (long long) entry->bytes());
+    return entry;
+}
+
+void SkyDiskCache::release(SkyDiskCacheEntry *entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--entry->pins > 0 || entry->fd < 0) {
+        return;
+    }
+    writeIndexLocked(entry);
+    close(entry->fd);
+    entry->fd = -1;
+}
+
+int64_t SkyDiskCache::lookup(SkyDiskCacheEntry *entry, int64_t pos, int64_t *rangeEnd, int64_t *nextStart) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    *rangeEnd = entry->rangeEnd(pos);
+    *nextStart = entry->nextRangeStart(pos);
+    return entry->size;
+}
+
+void SkyDiskCache::store(SkyDiskCacheEntry *entry, int64_t pos, const uint8_t *data, int size) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entry->fd < 0 || !evictLocked(entry, size)) {
+            return;
+        }
+    }
+
+    // 先写数据再记区间，索引里的区间在磁盘上一定有数据
+    ssize_t written = pwrite(entry->fd, data, static_cast<size_t>(size), pos);
+    if (written <= 0) {
+        ALOG_W(TAG, "pwrite at %lld failed: %s", (long long) pos, strerror(errno));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int64_t added = entry->addRange(pos, pos + written);
+    used_ += added;
+    entry->unflushed += added;
+    if (entry->unflushed >= DISK_CACHE_INDEX_FLUSH_BYTES) {
+        writeIndexLocked(entry);
+    }
+}
+
+void SkyDiskCache::validate(SkyDiskCacheEntry *entry, const SkyHttpInfo &info) {
+    // 两边都已知时才比较；源站不再返回某个字段时沿用记录
+    auto differs = [](const std::string &cached, const std::string &current) {
+        return !cached.empty() && !current.empty() && cached != current;
+    };
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool sizeChanged = info.size >= 0 && entry->size >= 0 && entry->size != info.size;
+    if (sizeChanged || differs(entry->etag, info.etag) || differs(entry->lastModified, info.lastModified)) {
+        ALOG_W(TAG, "%s changed (size %lld -> %lld, etag %s -> %s, last-modified %s -> %s), drop %lld cached bytes",
+               entry->url.c_str(), (long long) entry->size, (long long) info.size, entry->etag.c_str(),
+               info.etag.c_str(), entry->lastModified.c_str(), info.lastModified.c_str(),
+               (long long) entry->bytes());
+        used_ -= entry->bytes();
+        entry->clearRanges();
+        entry->etag.clear();
+        entry->lastModified.clear();
+        if (entry->fd >= 0) {
+            ftruncate(entry->fd, 0);
+        }
+    }
+
+    bool updated = false;
+    if (info.size >= 0 && entry->size != info.size) {
+        entry->size = info.size;
+        updated = true;
+    }
+    if (!info.etag.empty() && entry->etag != info.etag) {
+        entry->etag = info.etag;
+        updated = true;
+    }
+    if (!info.lastModified.empty() && entry->lastModified != info.lastModified) {
+        entry->lastModified = info.lastModified;
+        updated = true;
+    }
+    if (updated) {
+        entry->unflushed = std::max<int64_t>(entry->unflushed, 1);
+    }
+}
+
+std::string SkyDiskCache::pathLocked(const SkyDiskCacheEntry &entry, const char *ext) const {
+    return dir_ + "/" + entry.key + ext;
+}
+
+bool SkyDiskCache::loadIndexLocked(const std::string &path) {
+    FILE *fp = fopen(path.c_str(), "r");
+    if (nullptr == fp) {
+        return false;
+    }
+
+    // 头部逐行读：魔数、url、大小、ETag、Last-Modified，后两者可能是空行
+    auto entry = std::make_shared<SkyDiskCacheEntry>();
+    char line[4096];
+    auto readLine = [&](std::string *value) {
+        if (!fgets(line, sizeof(line), fp)) {
+            return false;
+        }
+        line[strcspn(line, "\n")] = '\0';
+        *value = line;
+        return true;
+    };
+    std::string magic;
+    std::string size;
+    bool ok = readLine(&magic) && magic == DISK_CACHE_INDEX_MAGIC
+              && readLine(&entry->url) && readLine(&size)
+              && readLine(&entry->etag) && readLine(&entry->lastModified);
+    if (ok) {
+        entry->size = strtoll(size.c_str(), nullptr, 10);
+    }
+    int64_t start;
+    int64_t end;
+    while (ok && fscanf(fp, "%" SCNd64 " %" SCNd64 "\n", &start, &end) == 2) {
+        entry->addRange(start, end);
+    }
+    fclose(fp);
+
+    const std::string name = path.substr(path.find_last_of('/') + 1);
+    entry->key = name.substr(0, name.size() - strlen(DISK_CACHE_INDEX_EXT));
+    struct stat st;
+    if (!ok || entry->url.empty() || stat(pathLocked(*entry, DISK_CACHE_DATA_EXT).c_str(), &st) != 0) {
+        ALOG_W(TAG, "drop broken index %s", path.c_str());
+        return false;
+    }
+
+    // 索引的修改时间即最近使用时间，重启后继续按 LRU 淘汰
+    stat(path.c_str(), &st);
+    entry->lastUsed = static_cast<uint64_t>(st.st_mtime);
+    clock_ = std::max(clock_, entry->lastUsed);
+    used_ += entry->bytes();
+    entries_[entry->url] = entry;
+    return true;
+}
+
+void SkyDiskCache::writeIndexLocked(SkyDiskCacheEntry *entry) {
+    // 先写临时文件再 rename，避免进程被杀时留下半个索引
+    const std::string path = pathLocked(*entry, DISK_CACHE_INDEX_EXT);
+    const std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "w");
+    if (nullptr == fp) {
+        ALOG_W(TAG, "open %s failed: %s", tmpPath.c_str(), strerror(errno));
+        return;
+    }
+    fprintf(fp, "%s\n%s\n%" PRId64 "\n%s\n%s\n", DISK_CACHE_INDEX_MAGIC, entry->url.c_str(), entry->size,
+            entry->etag.c_str(), entry->lastModified.c_str());
+    for (const auto &range : entry->ranges_) {
+        fprintf(fp, "%" PRId64 " %" PRId64 "\n", range.first, range.second);
+    }
+    bool ok = fflush(fp) == 0 && fdatasync(fileno(fp)) == 0;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ALOG_W(TAG, "write index %s failed", path.c_str());
+        unlink(tmpPath.c_str());
+        return;
+    }
+    entry->unflushed = 0;
+}
+
+bool SkyDiskCache::evictLocked(const SkyDiskCacheEntry *keep, int64_t incoming) {
+    while (used_ + incoming > budget_) {
+        // 正在播放的不淘汰
+        auto victim = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            const auto &entry = it->second;
+            if (entry.get() != keep && entry->pins == 0
+                && (victim == entries_.end() || entry->lastUsed < victim->second->lastUsed)) {
+                victim = it;
+            }
+        }
+        if (victim == entries_.end()) {
+            return false;
+        }
+        ALOG_I(TAG, "evict %s, %lld bytes", victim->first.c_str(), (long long) victim->second->bytes());
+        unlink(pathLocked(*victim->second, DISK_CACHE_INDEX_EXT).c_str());
+        unlink(pathLocked(*victim->second, DISK_CACHE_DATA_EXT).c_str());
+        used_ -= victim->second->bytes();
+        entries_.erase(victim);
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+#ifndef SKY_DISK_CACHE_H
+#define SKY_DISK_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "sky_io.h"
+
+// data source 加上这个前缀时经过磁盘缓存，如 skycache:https://...
+#define DISK_CACHE_SCHEME "skycache:"
+// 所有缓存文件共用的磁盘上限
+#define DISK_CACHE_DEFAULT_BUDGET (512LL * 1024 * 1024)
+// 每新增这么多字节写一次索引，进程被杀时最多丢失这部分
+#define DISK_CACHE_INDEX_FLUSH_BYTES (4 * 1024 * 1024)
+
+/**
+ * 一个 URL 的缓存：数据按原始偏移写进稀疏文件，已下载的区间记录在索引文件里。由 SkyDiskCache 的锁保护
+ */
+class SkyDiskCacheEntry {
+public:
+    // pos 所在区间的结束位置，pos 未缓存时返回 -1
+    int64_t rangeEnd(int64_t pos) const;
+    // pos 之后第一个区间的起点，没有时返回 -1
+    int64_t nextRangeStart(int64_t pos) const;
+    // 记录 [start, end) 已缓存，返回新增的字节数
+    int64_t addRange(int64_t start, int64_t end);
+    void clearRanges();
+
+    int64_t bytes() const {
+        return bytes_;
+    }
+
+public:
+    std::string url;
+    // 文件名（不含扩展名），由 url 计算
+    std::string key;
+    // 源文件大小，未知时为 -1
+    int64_t size = -1;
+    // 源站返回的校验信息，未知时为空，与本次打开时的不一致就丢弃已缓存的区间
+    std::string etag;
+    std::string lastModified;
+    uint64_t lastUsed = 0;
+    // 打开它的播放器数，大于 0 时不淘汰，数据文件保持打开
+    int pins = 0;
+    int fd = -1;
+    // 上次写索引之后新增的字节数
+    int64_t unflushed = 0;
+
+private:
+    friend class SkyDiskCache;
+    // 起点 -> 终点，相邻或重叠的区间合并
+    std::map<int64_t, int64_t> ranges_;
+    int64_t bytes_ = 0;
+};
+
+/**
+ * 进程内共享的 HTTP 区间缓存：命中的区间从磁盘读，空洞才回源下载并写回磁盘，
+ * 重播、回退 seek、循环播放不再重复下载。总量受预算限制，超出时按最近使用淘汰，
+ * 索引持久化在缓存目录中，进程重启后继续使用。
+ */
+class SkyDiskCache {
+public:
+    static SkyDiskCache& instance();
+
+    // 第一次调用时扫描目录加载已有索引，之后的调用被忽略
+    void setDir(const std::string &dir);
+    void setBudget(int64_t bytes);
+
+    static bool isCacheUrl(const char *url);
+    // HLS/DASH 清单：分片由 demuxer 按相对地址另行打开，不能经过单个 URL 的区间缓存
+    static bool isSegmentedUrl(const char *url);
+    // read_thread 实际打开的地址：带 DISK_CACHE_SCHEME 前缀的分片流去掉前缀直接播放，其余原样返回
+    static const char *unwrapUrl(const char *url);
+    // 已缓存的字节数，没有时返回 0
+    int64_t cachedBytes(const std::string &url);
+    // read_thread 调用：url 带 DISK_CACHE_SCHEME 前缀，返回经过缓存的 AVIOContext；未设置目录时直接回源，分片流返回 nullptr
+    AVIOContext *openIo(const char *url, const AVIOInterruptCB *interrupt);
+
+private:
+    class Source;
+
+    SkyDiskCache() = default;
+
+    std::shared_ptr<SkyDiskCacheEntry> acquire(const std::string &url);
+    void release(SkyDiskCacheEntry *entry);
+    // 下面几个给 Source 使用，内部加锁
+    // 返回源文件大小（未知时为 -1），rangeEnd 为 pos 所在区间的终点，未命中时为 -1
+    int64_t lookup(SkyDiskCacheEntry *entry, int64_t pos, int64_t *rangeEnd, int64_t *nextStart);
+    void store(SkyDiskCacheEntry *entry, int64_t pos, const uint8_t *data, int size);
+    // 源文件大小、ETag 或 Last-Modified 与缓存记录不一致时视为内容已变，丢弃旧数据
+    void validate(SkyDiskCacheEntry *entry, const SkyHttpInfo &info);
+
+    // 以下在持有 mutex_ 时调用
+    std::string pathLocked(const SkyDiskCacheEntry &entry, const char *ext) const;
+    bool loadIndexLocked(const std::string &path);
+    void writeIndexLocked(SkyDiskCacheEntry *entry);
+    // 淘汰到能再放下 incoming 字节，放不下时返回 false
+    bool evictLocked(const SkyDiskCacheEntry *keep, int64_t incoming);
+
+private:
+    std::mutex mutex_;
+    std::string dir_;
+    int64_t budget_ = DISK_CACHE_DEFAULT_BUDGET;
+    int64_t used_ = 0;
+    uint64_t clock_ = 0;
+    std::unordered_map<std::string, std::shared_ptr<SkyDiskCacheEntry>> entries_;
+};
+
+#endif // SKY_DISK_CACHE_H
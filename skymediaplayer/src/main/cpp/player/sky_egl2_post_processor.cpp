@@ -0,0 +1,324 @@
+#include "sky_egl2_post_processor.h"
+#include "sky_egl2_program_cache.h"
+
+static const char* TAG = "SkyEGL2PostProcessor";
+
+// 后处理使用主画面之外的纹理单元，避免破坏各 Imp 在 use() 中绑定好的 plane 纹理
+constexpr GLenum POST_TEXTURE_UNIT = GL_TEXTURE0 + SKY_GLES2_MAX_PLANE;
+
+static const GLfloat FULLSCREEN_VERTICES[8] = {
+        -1.0f, -1.0f,   // left-bottom
+         1.0f, -1.0f,   // right-bottom
+        -1.0f,  1.0f,   // left-top
+         1.0f,  1.0f,   // right-top
+};
+
+// FBO 纹理原点在左下角
+static const GLfloat FRAMEBUFFER_TEXCOORDS[8] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+};
+
+// 位图纹理第一行在上
+static const GLfloat BITMAP_TEXCOORDS[8] = {
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+};
+
+// ============================================================================
+// SkyEGL2PostPass
+// ============================================================================
+
+GLboolean SkyEGL2PostPass::init() {
+    const char* fragmentSource = getFragmentShaderSource();
+
+    program = SkyEGL2ProgramCache::loadProgram(YUV_VERTEX_SHADER_DEFAULT, fragmentSource);
+    if (!program) {
+        GLuint vertexShader = SkyEGL2RendererImp::compileShader(GL_VERTEX_SHADER, YUV_VERTEX_SHADER_DEFAULT);
+        GLuint fragmentShader = SkyEGL2RendererImp::compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+        GLint linkStatus = 0;
+        if (vertexShader && fragmentShader) {
+            program = glCreateProgram();        skyElg2CheckError("glCreateProgram");
+        }
+        if (program) {
+            glAttachShader(program, vertexShader);      skyElg2CheckError("glAttachShader");
+            glAttachShader(program, fragmentShader);    skyElg2CheckError("glAttachShader");
+            glLinkProgram(program);
+            glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+            if (!linkStatus) {
+                SkyEGL2RendererImp::printProgramInfo(program);
+                glDeleteProgram(program);
+                program = INVALID_PROGRAM;
+            }
+        }
+        // program 链接完成后 shader 可以立即删除
+        if (vertexShader) {
+            glDeleteShader(vertexShader);
+        }
+        if (fragmentShader) {
+            glDeleteShader(fragmentShader);
+        }
+        if (!program) {
+            ALOG_E(TAG, "build post pass program fail");
+            return GL_FALSE;
+        }
+        SkyEGL2ProgramCache::saveProgram(program, YUV_VERTEX_SHADER_DEFAULT, fragmentSource);
+    }
+
+    av4_position = glGetAttribLocation(program, "av4_Position");     skyElg2CheckError("glGetAttribLocation(av4_Position)");
+    av2_texcoord = glGetAttribLocation(program, "av2_Texcoord");     skyElg2CheckError("glGetAttribLocation(av2_Texcoord)");
+    um4_mvp = glGetUniformLocation(program, "um4_ModelViewProjection");     skyElg2CheckError("glGetUniformLocation(um4_ModelViewProjection)");
+    us2_sampler = glGetUniformLocation(program, "us2_Sampler");     skyElg2CheckError("glGetUniformLocation(us2_Sampler)");
+    onInit();
+
+    return GL_TRUE;
+}
+
+void SkyEGL2PostPass::draw(GLuint texture, const GLfloat *vertices, const GLfloat *texcoords) {
+    glUseProgram(program);      skyElg2CheckError("glUseProgram");
+
+    glActiveTexture(POST_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(us2_sampler, SKY_GLES2_MAX_PLANE);
+
+    Matrix4x4Std modelViewProj;
+    SkyEGL2RendererImp::buildOrthoMatrix(modelViewProj, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+    glUniformMatrix4fv(um4_mvp, 1, GL_FALSE, modelViewProj.data());
+    setUniforms();
+
+    glVertexAttribPointer(av4_position, 2, GL_FLOAT, GL_FALSE, 0, vertices);     skyElg2CheckError("glVertexAttribPointer(av4_position)");
+    glEnableVertexAttribArray(av4_position);
+    glVertexAttribPointer(av2_texcoord, 2, GL_FLOAT, GL_FALSE, 0, texcoords);    skyElg2CheckError("glVertexAttribPointer(av2_texcoord)");
+    glEnableVertexAttribArray(av2_texcoord);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);      skyElg2CheckError("glDrawArrays");
+}
+
+void SkyEGL2PostPass::reset() {
+    if (program) {
+        glDeleteProgram(program);
+    }
+    program = INVALID_PROGRAM;
+}
+
+void SkyEGL2EqPass::onInit() {
+    uv4_eq = glGetUniformLocation(program, "uv4_Eq");      skyElg2CheckError("glGetUniformLocation(uv4_Eq)");
+}
+
+void SkyEGL2EqPass::setUniforms() {
+    glUniform4f(uv4_eq, eq.brightness, eq.contrast, eq.saturation, 1.0f / eq.gamma);
+}
+
+void SkyEGL2OverlayPass::onInit() {
+    uf_alpha = glGetUniformLocation(program, "uf_Alpha");      skyElg2CheckError("glGetUniformLocation(uf_Alpha)");
+}
+
+void SkyEGL2OverlayPass::setUniforms() {
+    glUniform1f(uf_alpha, alpha);
+}
+
+// ============================================================================
+// SkyEGL2PostProcessor
+// ============================================================================
+
+void SkyEGL2PostProcessor::setEq(const SkyVideoEq &eq) {
+    eq_ = eq;
+    eqEnabled_ = eq.brightness != 0.0f || eq.contrast != 1.0f
+                 || eq.saturation != 1.0f || eq.gamma != 1.0f;
+    ALOG_I(TAG, "setEq enabled=%d brightness=%.2f contrast=%.2f saturation=%.2f gamma=%.2f",
+           eqEnabled_, eq.brightness, eq.contrast, eq.saturation, eq.gamma);
+}
+
+void SkyEGL2PostProcessor::setWatermark(std::shared_ptr<const SkyWatermark> watermark) {
+    watermark_.image = std::move(watermark);
+    watermark_.dirty = true;
+}
+
+void SkyEGL2PostProcessor::setSubtitle(std::shared_ptr<const SkyWatermark> subtitle) {
+    subtitle_.image = std::move(subtitle);
+    subtitle_.dirty = true;
+}
+
+bool SkyEGL2PostProcessor::isActive() const {
+    return eqEnabled_ || watermark_.image != nullptr || subtitle_.image != nullptr;
+}
+
+std::vector<SkyEGL2PostPass*> SkyEGL2PostProcessor::buildPassChain() {
+    std::vector<SkyEGL2PostPass*> chain;
+    if (eqEnabled_) {
+        if (nullptr == eqPass_) {
+            eqPass_ = std::make_unique<SkyEGL2EqPass>();
+            if (!eqPass_->init()) {
+                eqPass_.reset();
+                eqEnabled_ = false;
+                return chain;
+            }
+        }
+        eqPass_->setEq(eq_);
+        chain.push_back(eqPass_.get());
+    }
+    return chain;
+}
+
+GLboolean SkyEGL2PostProcessor::ensureFramebuffers(GLsizei width, GLsizei height) {
+    if (framebuffers_[0] && framebufferWidth_ == width && framebufferHeight_ == height) {
+        return GL_TRUE;
+    }
+    releaseFramebuffers();
+
+    glGenFramebuffers(2, framebuffers_);
+    glGenTextures(2, framebufferTextures_);
+    glActiveTexture(POST_TEXTURE_UNIT);
+    for (int i = 0; i < 2; ++i) {
+        glBindTexture(GL_TEXTURE_2D, framebufferTextures_[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffers_[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, framebufferTextures_[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            ALOG_E(TAG, "framebuffer %d incomplete", i);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            releaseFramebuffers();
+            return GL_FALSE;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    skyElg2CheckError("ensureFramebuffers");
+
+    framebufferWidth_ = width;
+    framebufferHeight_ = height;
+    ALOG_I(TAG, "framebuffers created %dx%d", width, height);
+    return GL_TRUE;
+}
+
+void SkyEGL2PostProcessor::releaseFramebuffers() {
+    if (framebuffers_[0]) {
+        glDeleteFramebuffers(2, framebuffers_);
+        glDeleteTextures(2, framebufferTextures_);
+    }
+    framebuffers_[0] = framebuffers_[1] = 0;
+    framebufferTextures_[0] = framebufferTextures_[1] = 0;
+    framebufferWidth_ = 0;
+    framebufferHeight_ = 0;
+}
+
+GLboolean SkyEGL2PostProcessor::begin(GLsizei width, GLsizei height) {
+    offscreen_ = !buildPassChain().empty();
+    if (!offscreen_) {
+        return GL_TRUE;
+    }
+
+    if (!ensureFramebuffers(width, height)) {
+        offscreen_ = false;
+        return GL_FALSE;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffers_[0]);     skyElg2CheckError("glBindFramebuffer");
+    return GL_TRUE;
+}
+
+GLboolean SkyEGL2PostProcessor::end(GLsizei width, GLsizei height) {
+    if (offscreen_) {
+        std::vector<SkyEGL2PostPass*> chain = buildPassChain();
+        int input = 0;
+        for (size_t i = 0; i < chain.size(); ++i) {
+            bool last = i + 1 == chain.size();
+            glBindFramebuffer(GL_FRAMEBUFFER, last ? 0 : framebuffers_[1 - input]);
+            glViewport(0, 0, width, height);
+            chain[i]->draw(framebufferTextures_[input], FULLSCREEN_VERTICES, FRAMEBUFFER_TEXCOORDS);
+            input = 1 - input;
+        }
+        offscreen_ = false;
+    }
+
+    drawOverlay(watermark_);
+    // 字幕画在水印之上
+    drawOverlay(subtitle_);
+    return GL_TRUE;
+}
+
+void SkyEGL2PostProcessor::drawOverlay(OverlayLayer &layer) {
+    if (layer.dirty) {
+        layer.dirty = false;
+        if (nullptr == layer.image) {
+            releaseOverlay(layer);
+            return;
+        }
+
+        if (0 == layer.texture) {
+            glGenTextures(1, &layer.texture);
+        }
+        glActiveTexture(POST_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, layer.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, layer.image->width, layer.image->height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, layer.image->pixels.data());
+        skyElg2CheckError("upload overlay");
+    }
+
+    if (nullptr == layer.image || 0 == layer.texture) {
+        return;
+    }
+
+    if (nullptr == overlayPass_) {
+        overlayPass_ = std::make_unique<SkyEGL2OverlayPass>();
+        if (!overlayPass_->init()) {
+            overlayPass_.reset();
+            layer.image.reset();
+            return;
+        }
+    }
+
+    // 归一化的 surface 坐标（左上角为原点）转为 NDC
+    const SkyWatermark& image = *layer.image;
+    const GLfloat left = image.left * 2.0f - 1.0f;
+    const GLfloat right = image.right * 2.0f - 1.0f;
+    const GLfloat top = 1.0f - image.top * 2.0f;
+    const GLfloat bottom = 1.0f - image.bottom * 2.0f;
+    const GLfloat vertices[8] = {
+            left, bottom,
+            right, bottom,
+            left, top,
+            right, top,
+    };
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    overlayPass_->setAlpha(image.alpha);
+    overlayPass_->draw(layer.texture, vertices, BITMAP_TEXCOORDS);
+    glDisable(GL_BLEND);
+}
+
+void SkyEGL2PostProcessor::releaseOverlay(OverlayLayer &layer) {
+    if (layer.texture) {
+        glDeleteTextures(1, &layer.texture);
+        layer.texture = 0;
+    }
+}
+
+void SkyEGL2PostProcessor::reset() {
+    releaseFramebuffers();
+    releaseOverlay(watermark_);
+    releaseOverlay(subtitle_);
+    // context 重建后需要重新上传
+    watermark_.dirty = watermark_.image != nullptr;
+    subtitle_.dirty = subtitle_.image != nullptr;
+    if (eqPass_) {
+        eqPass_->reset();
+        eqPass_.reset();
+    }
+    if (overlayPass_) {
+        overlayPass_->reset();
+        overlayPass_.reset();
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef SKY_EGL2_POST_PROCESSOR_H
+#define SKY_EGL2_POST_PROCESSOR_H
+
+#include <memory>
+#include <vector>
+#include "skyrenderer.h"
+
+/**
+ * 后处理 pass 基类：全屏（或指定区域）画一张输入纹理，子类只提供 fragment shader 和 uniform
+ */
+class SkyEGL2PostPass {
+public:
+    virtual ~SkyEGL2PostPass() = default;
+
+    GLboolean init();
+    GLboolean isValid() const { return program > 0; }
+    void draw(GLuint texture, const GLfloat *vertices, const GLfloat *texcoords);
+    void reset();
+
+protected:
+    virtual const char* getFragmentShaderSource() = 0;
+    virtual void onInit() {}
+    virtual void setUniforms() {}
+
+protected:
+    GLuint program = INVALID_PROGRAM;
+    GLuint av4_position = 0;
+    GLuint av2_texcoord = 0;
+    GLuint um4_mvp = 0;
+    GLuint us2_sampler = 0;
+};
+
+// brightness/contrast/saturation/gamma，对应 libavfilter eq
+class SkyEGL2EqPass : public SkyEGL2PostPass {
+public:
+    constexpr static const char EQ_FRAGMENT_SHADER[] = GLES_STRING(
+            precision mediump float;
+            varying   highp vec2 vv2_Texcoord;
+            uniform   lowp  sampler2D us2_Sampler;
+            uniform         vec4 uv4_Eq;    // brightness, contrast, saturation, 1/gamma
+
+            void main()
+            {
+                vec3 rgb = texture2D(us2_Sampler, vv2_Texcoord).rgb;
+                rgb = (rgb - 0.5) * uv4_Eq.y + 0.5 + uv4_Eq.x;
+                float luma = dot(rgb, vec3(0.299, 0.587, 0.114));
+                rgb = mix(vec3(luma), rgb, uv4_Eq.z);
+                rgb = pow(clamp(rgb, 0.0, 1.0), vec3(uv4_Eq.w));
+                gl_FragColor = vec4(rgb, 1.0);
+            }
+    );
+
+    void setEq(const SkyVideoEq &value) { eq = value; }
+
+protected:
+    const char* getFragmentShaderSource() override { return EQ_FRAGMENT_SHADER; }
+    void onInit() override;
+    void setUniforms() override;
+
+private:
+    SkyVideoEq eq{0.0f, 1.0f, 1.0f, 1.0f};
+    GLint uv4_eq = -1;
+};
+
+// 水印/字幕叠加，输入为 premultiplied RGBA
+class SkyEGL2OverlayPass : public SkyEGL2PostPass {
+public:
+    constexpr static const char OVERLAY_FRAGMENT_SHADER[] = GLES_STRING(
+            precision mediump float;
+            varying   highp vec2 vv2_Texcoord;
+            uniform   lowp  sampler2D us2_Sampler;
+            uniform   lowp  float uf_Alpha;
+
+            void main()
+            {
+                gl_FragColor = texture2D(us2_Sampler, vv2_Texcoord) * uf_Alpha;
+            }
+    );
+
+    void setAlpha(GLfloat value) { alpha = value; }
+
+protected:
+    const char* getFragmentShaderSource() override { return OVERLAY_FRAGMENT_SHADER; }
+    void onInit() override;
+    void setUniforms() override;
+
+private:
+    GLfloat alpha = 1.0f;
+    GLint uf_alpha = -1;
+};
+
+/**
+ * GPU 后处理链：像素级 pass（目前为 eq）按配置组成链，在两个 FBO 之间 ping-pong，
+ * 最后一个 pass 直接画到窗口；水印和字幕在最后叠加，位图只在变化时上传。没有启用任何 pass 时不产生额外开销。
+ * 所有方法都在 EGL context 当前的渲染线程调用。
+ */
+class SkyEGL2PostProcessor {
+public:
+    void setEq(const SkyVideoEq &eq);
+    void setWatermark(std::shared_ptr<const SkyWatermark> watermark);
+    // 所有字幕 rect 合成在一张位图里，一次 draw call 叠加，nullptr 为清除
+    void setSubtitle(std::shared_ptr<const SkyWatermark> subtitle);
+
+    // 是否有任何后处理，有则主 program 的 GL 状态每帧需要重新绑定
+    bool isActive() const;
+
+    // 需要离屏时绑定 FBO，主画面画到 FBO 上
+    GLboolean begin(GLsizei width, GLsizei height);
+    // 执行 pass 链并叠加水印/字幕，结果画到当前窗口
+    GLboolean end(GLsizei width, GLsizei height);
+
+    void reset();
+
+private:
+    // 叠加层：位图变化时置 dirty，下一帧上传一次
+    struct OverlayLayer {
+        std::shared_ptr<const SkyWatermark> image;
+        bool dirty = false;
+        GLuint texture = 0;
+    };
+
+    std::vector<SkyEGL2PostPass*> buildPassChain();
+    GLboolean ensureFramebuffers(GLsizei width, GLsizei height);
+    void releaseFramebuffers();
+    void drawOverlay(OverlayLayer &layer);
+    static void releaseOverlay(OverlayLayer &layer);
+
+private:
+    SkyVideoEq eq_{0.0f, 1.0f, 1.0f, 1.0f};
+    bool eqEnabled_ = false;
+    std::unique_ptr<SkyEGL2EqPass> eqPass_;
+
+    OverlayLayer watermark_;
+    OverlayLayer subtitle_;
+    std::unique_ptr<SkyEGL2OverlayPass> overlayPass_;
+
+    GLuint framebuffers_[2] = {0};
+    GLuint framebufferTextures_[2] = {0};
+    GLsizei framebufferWidth_ = 0;
+    GLsizei framebufferHeight_ = 0;
+    bool offscreen_ = false;
+};
+
+#endif // SKY_EGL2_POST_PROCESSOR_H
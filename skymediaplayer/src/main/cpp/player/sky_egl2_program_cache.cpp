@@ -0,0 +1,256 @@
+#include "sky_egl2_program_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <vector>
+#include <functional>
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+#include "logger.h"
+
+static const char* TAG = "SkyEGL2ProgramCache";
+
+namespace {
+    constexpr uint32_t kCacheMagic = 0x534b5950;    // 'SKYP'
+    constexpr uint32_t kCacheVersion = 1;
+    // 当前驱动目录中超过这个时间没有命中的 binary 视为旧 shader 留下的
+    constexpr time_t kCacheMaxAgeSeconds = 30 * 24 * 3600;
+
+    struct ProgramBinaryHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t binaryFormat;
+        uint32_t length;
+    };
+
+    std::mutex cacheMutex;
+    std::string cacheDir;
+    bool cachePruned = false;
+
+    bool hasPrefix(const char* name, const char* prefix) {
+        return strncmp(name, prefix, strlen(prefix)) == 0;
+    }
+
+    void removeDir(const std::string& dir) {
+        DIR* d = opendir(dir.c_str());
+        if (nullptr == d) {
+            return;
+        }
+        while (dirent* entry = readdir(d)) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                unlink((dir + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(d);
+        rmdir(dir.c_str());
+    }
+
+    PFNGLGETPROGRAMBINARYOESPROC getProgramBinaryOES = nullptr;
+    PFNGLPROGRAMBINARYOESPROC programBinaryOES = nullptr;
+    std::once_flag extensionInitFlag;
+
+    void initExtension() {
+        const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+        if (nullptr == extensions || nullptr == strstr(extensions, "GL_OES_get_program_binary")) {
+            ALOG_I(TAG, "GL_OES_get_program_binary not supported");
+            return;
+        }
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+        if (formats <= 0) {
+            ALOG_I(TAG, "no program binary formats");
+            return;
+        }
+
+        getProgramBinaryOES = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(eglGetProcAddress("glGetProgramBinaryOES"));
+        programBinaryOES = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(eglGetProcAddress("glProgramBinaryOES"));
+        ALOG_I(TAG, "program binary %s, formats=%d",
+               (getProgramBinaryOES && programBinaryOES) ? "enabled" : "disabled", formats);
+    }
+}
+
+void SkyEGL2ProgramCache::setCacheDir(const char *dir) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheDir = dir ? dir : "";
+    cachePruned = false;
+    ALOG_I(TAG, "setCacheDir %s", cacheDir.c_str());
+}
+
+bool SkyEGL2ProgramCache::isSupported() {
+    std::call_once(extensionInitFlag, initExtension);
+    return getProgramBinaryOES && programBinaryOES;
+}
+
+std::string SkyEGL2ProgramCache::cacheFilePath(const char *vertexSource, const char *fragmentSource) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cacheDir.empty()) {
+        return {};
+    }
+
+    // 驱动信息决定目录，系统升级 GPU 驱动后旧的 binary 不会被误用，也不会留在磁盘上
+    const auto* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    const auto* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    std::string driver(renderer ? renderer : "");
+    driver.append(version ? version : "");
+    driver.append(std::to_string(kCacheVersion));
+
+    char name[64];
+    snprintf(name, sizeof(name), "/sky_programs_%016zx", std::hash<std::string>()(driver));
+    std::string dir = cacheDir + name;
+    if (!cachePruned) {
+        cachePruned = true;
+        mkdir(dir.c_str(), 0700);
+        pruneLocked(dir);
+    }
+
+    std::string key(vertexSource);
+    key.append(fragmentSource);
+    snprintf(name, sizeof(name), "/sky_program_%016zx.bin", std::hash<std::string>()(key));
+    return dir + name;
+}
+
+void SkyEGL2ProgramCache::pruneLocked(const std::string &currentDir) {
+    DIR* d = opendir(cacheDir.c_str());
+    if (nullptr == d) {
+        return;
+    }
+    int removed = 0;
+    while (dirent* entry = readdir(d)) {
+        std::string path = cacheDir + "/" + entry->d_name;
+        if (hasPrefix(entry->d_name, "sky_programs_") && path != currentDir) {
+            removeDir(path);
+            removed++;
+        } else if (hasPrefix(entry->d_name, "sky_program_")) {
+            // 旧版本直接放在 cacheDir 下的文件
+            unlink(path.c_str());
+            removed++;
+        }
+    }
+    closedir(d);
+
+    d = opendir(currentDir.c_str());
+    if (nullptr == d) {
+        return;
+    }
+    const time_t now = time(nullptr);
+    struct stat st{};
+    while (dirent* entry = readdir(d)) {
+        std::string path = currentDir + "/" + entry->d_name;
+        if (hasPrefix(entry->d_name, "sky_program_") && stat(path.c_str(), &st) == 0
+            && now - st.st_mtime > kCacheMaxAgeSeconds) {
+            unlink(path.c_str());
+            removed++;
+        }
+    }
+    closedir(d);
+    if (removed > 0) {
+        ALOG_I(TAG, "pruned %d stale program cache entries", removed);
+    }
+}
+
+GLuint SkyEGL2ProgramCache::loadProgram(const char *vertexSource, const char *fragmentSource) {
+    if (!isSupported()) {
+        return 0;
+    }
+
+    std::string path = cacheFilePath(vertexSource, fragmentSource);
+    if (path.empty()) {
+        return 0;
+    }
+
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (nullptr == fp) {
+        return 0;
+    }
+
+    ProgramBinaryHeader header{};
+    std::vector<uint8_t> binary;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1
+              && header.magic == kCacheMagic
+              && header.version == kCacheVersion
+              && header.length > 0;
+    if (ok) {
+        binary.resize(header.length);
+        ok = fread(binary.data(), 1, binary.size(), fp) == binary.size();
+    }
+    fclose(fp);
+
+    if (!ok) {
+        ALOG_W(TAG, "invalid cache file %s", path.c_str());
+        remove(path.c_str());
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (!program) {
+        return 0;
+    }
+    programBinaryOES(program, header.binaryFormat, binary.data(), static_cast<GLint>(binary.size()));
+
+    GLint linkStatus = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (!linkStatus) {
+        // 驱动拒绝旧 binary，删除后走正常 compile/link
+        ALOG_W(TAG, "program binary rejected, recompile");
+        glDeleteProgram(program);
+        remove(path.c_str());
+        glGetError();
+        return 0;
+    }
+
+    // 命中时更新修改时间，清理只删长期没用过的文件
+    utime(path.c_str(), nullptr);
+    ALOG_I(TAG, "program loaded from %s", path.c_str());
+    return program;
+}
+
+void SkyEGL2ProgramCache::saveProgram(GLuint program, const char *vertexSource, const char *fragmentSource) {
+    if (!program || !isSupported()) {
+        return;
+    }
+
+    std::string path = cacheFilePath(vertexSource, fragmentSource);
+    if (path.empty()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<uint8_t> binary(length);
+    GLenum binaryFormat = 0;
+    getProgramBinaryOES(program, length, &length, &binaryFormat, binary.data());
+    if (glGetError() != GL_NO_ERROR || length <= 0) {
+        ALOG_W(TAG, "glGetProgramBinaryOES fail");
+        return;
+    }
+
+    // 先写临时文件再 rename，避免进程被杀时留下半个文件
+    std::string tmpPath = path + ".tmp";
+    FILE* fp = fopen(tmpPath.c_str(), "wb");
+    if (nullptr == fp) {
+        ALOG_W(TAG, "open %s fail", tmpPath.c_str());
+        return;
+    }
+
+    ProgramBinaryHeader header{kCacheMagic, kCacheVersion, binaryFormat, static_cast<uint32_t>(length)};
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+              && fwrite(binary.data(), 1, length, fp) == static_cast<size_t>(length);
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ALOG_W(TAG, "write %s fail", path.c_str());
+        remove(tmpPath.c_str());
+        return;
+    }
+
+    ALOG_I(TAG, "program saved to %s (%d bytes)", path.c_str(), length);
+}
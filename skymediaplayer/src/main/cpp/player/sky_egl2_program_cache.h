@@ -0,0 +1,32 @@
+#ifndef SKY_EGL2_PROGRAM_CACHE_H
+#define SKY_EGL2_PROGRAM_CACHE_H
+
+#include <string>
+#include <GLES2/gl2.h>
+
+/**
+ * 基于 GL_OES_get_program_binary 的 program 磁盘缓存。
+ * 以 (vertex shader, fragment shader, GL_RENDERER, GL_VERSION) 为 key。
+ * 文件放在按驱动信息命名的子目录中，驱动升级后整个旧目录在第一次访问时删除；
+ * shader 源码变化（应用升级）留下的旧文件按最近使用时间清理。
+ * 所有接口都必须在 EGL context 当前的线程调用。
+ */
+class SkyEGL2ProgramCache {
+public:
+    // 设置缓存目录（一般为 Context.getCacheDir()），为空则不做持久化
+    static void setCacheDir(const char* dir);
+
+    // 命中缓存返回已 link 的 program，否则返回 0
+    static GLuint loadProgram(const char* vertexSource, const char* fragmentSource);
+
+    // 将已 link 成功的 program 写入缓存
+    static void saveProgram(GLuint program, const char* vertexSource, const char* fragmentSource);
+
+private:
+    static bool isSupported();
+    static std::string cacheFilePath(const char* vertexSource, const char* fragmentSource);
+    // 删除其他驱动版本的目录、旧版本的平铺文件和长期没用过的文件，每个进程只做一次
+    static void pruneLocked(const std::string& currentDir);
+};
+
+#endif // SKY_EGL2_PROGRAM_CACHE_H
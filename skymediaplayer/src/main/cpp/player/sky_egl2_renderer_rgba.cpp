@@ -61,7 +61,7 @@ GLboolean SkyEGL2RendererRGBAImp::isValid() {
 }
 
 GLsizei SkyEGL2RendererRGBAImp::getBufferWidth(AVFrame *avFrame) {
-    return avFrame->linesize[0];
+    return avFrame->width;  // 与 uploadTexture 保持一致，linesize 是字节数
 }
 
 GLboolean SkyEGL2RendererRGBAImp::uploadTexture(AVFrame *avFrame) {
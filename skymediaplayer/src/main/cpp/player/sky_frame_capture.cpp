@@ -0,0 +1,304 @@
+extern "C" {
+#include "libavutil/frame.h"
+#include "libavutil/error.h"
+#include "libavutil/rational.h"
+#include "libswscale/swscale.h"
+}
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <android/bitmap.h>
+#include <android/data_space.h>
+
+#include "logger.h"
+#include "ffplay.h"
+#include "sky_frame_capture.h"
+#include "sky_frame_scaler.h"
+#include "sky_anativewindow_renderer.h"
+
+static const char* TAG = "SkyFrameCapture";
+
+namespace {
+    struct RgbaImage {
+        std::vector<uint8_t> pixels;
+        int width = 0;
+        int height = 0;
+
+        void resize(int w, int h) {
+            width = w;
+            height = h;
+            pixels.resize(static_cast<size_t>(w) * h * 4);
+        }
+        int stride() const { return width * 4; }
+    };
+
+    // 顺时针旋转后再镜像，与 renderer 的纹理坐标变换一致
+    void transformImage(const RgbaImage &src, RgbaImage &dst, int rotation, int flip) {
+        const bool swap = rotation == 90 || rotation == 270;
+        dst.resize(swap ? src.height : src.width, swap ? src.width : src.height);
+
+        auto* in = reinterpret_cast<const uint32_t*>(src.pixels.data());
+        auto* out = reinterpret_cast<uint32_t*>(dst.pixels.data());
+        for (int y = 0; y < src.height; ++y) {
+            for (int x = 0; x < src.width; ++x) {
+                int dx, dy;
+                switch (rotation) {
+                    case 90:  dx = src.height - 1 - y; dy = x; break;
+                    case 180: dx = src.width - 1 - x;  dy = src.height - 1 - y; break;
+                    case 270: dx = y;                  dy = src.width - 1 - x; break;
+                    default:  dx = x;                  dy = y; break;
+                }
+                if (flip & SKY_VIDEO_FLIP_H) dx = dst.width - 1 - dx;
+                if (flip & SKY_VIDEO_FLIP_V) dy = dst.height - 1 - dy;
+                out[static_cast<size_t>(dy) * dst.width + dx] = in[static_cast<size_t>(y) * src.width + x];
+            }
+        }
+    }
+
+    bool writeToFile(void* userContext, const void* data, size_t size) {
+        return fwrite(data, 1, size, static_cast<FILE*>(userContext)) == size;
+    }
+
+    int encodeImage(const RgbaImage &image, const SkyCaptureRequest &request) {
+        FILE* file = fopen(request.path.c_str(), "wb");
+        if (nullptr == file) {
+            ALOG_E(TAG, "capture: open %s failed", request.path.c_str());
+            return AVERROR(EIO);
+        }
+
+        AndroidBitmapInfo info{};
+        info.width = static_cast<uint32_t>(image.width);
+        info.height = static_cast<uint32_t>(image.height);
+        info.stride = static_cast<uint32_t>(image.stride());
+        info.format = ANDROID_BITMAP_FORMAT_RGBA_8888;
+        info.flags = ANDROID_BITMAP_FLAGS_ALPHA_OPAQUE;
+        int32_t format = request.format == SKY_CAPTURE_FORMAT_PNG
+                ? ANDROID_BITMAP_COMPRESS_FORMAT_PNG : ANDROID_BITMAP_COMPRESS_FORMAT_JPEG;
+        int ret = AndroidBitmap_compress(&info, ADATASPACE_SRGB, image.pixels.data(), format,
+                                         std::clamp(request.quality, 0, 100), file, writeToFile);
+        if (fclose(file) != 0 && ret == ANDROID_BITMAP_RESULT_SUCCESS) {
+            ret = ANDROID_BITMAP_RESULT_JNI_EXCEPTION;
+        }
+        if (ret != ANDROID_BITMAP_RESULT_SUCCESS) {
+            ALOG_E(TAG, "capture: compress %s failed %d", request.path.c_str(), ret);
+            remove(request.path.c_str());
+            return ret == ANDROID_BITMAP_RESULT_ALLOCATION_FAILED ? AVERROR(ENOMEM) : AVERROR(EIO);
+        }
+        return 0;
+    }
+}
+
+SkyFrameCapturer::SkyFrameCapturer(Callback callback)
+    : callback_(std::move(callback)) {
+}
+
+SkyFrameCapturer::~SkyFrameCapturer() {
+    stop();
+}
+
+bool SkyFrameCapturer::request(SkyCaptureRequest request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (abort_ || request.path.empty() || requests_.size() + jobs_.size() >= MAX_PENDING) {
+        return false;
+    }
+    startThreadLocked();
+    requests_.push_back({std::move(request), std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MS)});
+    pending_.store(static_cast<int>(requests_.size()), std::memory_order_release);
+    // 唤醒截图线程按新请求的期限等待
+    cond_.notify_one();
+    return true;
+}
+
+void SkyFrameCapturer::submit(const AVFrame *frame, double pts, int rotation, int flip) {
+    if (nullptr == frame || !isPending()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 同一帧可以满足所有等待中的请求，每个 job 各持有一份引用
+    while (!requests_.empty()) {
+        Job job;
+        job.request = std::move(requests_.front().request);
+        requests_.pop_front();
+        job.frame = av_frame_clone(frame);
+        job.positionMs = std::isnan(pts) ? 0 : static_cast<int>(pts * 1000);
+        job.rotation = rotation;
+        job.flip = flip;
+        jobs_.push_back(std::move(job));
+    }
+    pending_.store(0, std::memory_order_release);
+    cond_.notify_one();
+}
+
+void SkyFrameCapturer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        abort_ = true;
+        requests_.clear();
+        pending_.store(0, std::memory_order_release);
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    for (auto &job : jobs_) {
+        av_frame_free(&job.frame);
+    }
+    jobs_.clear();
+    if (swsContext_) {
+        sws_freeContext(swsContext_);
+        swsContext_ = nullptr;
+    }
+}
+
+void SkyFrameCapturer::startThreadLocked() {
+    if (thread_.joinable()) {
+        return;
+    }
+    thread_ = std::thread([this]() {
+        this->run();
+    });
+}
+
+void SkyFrameCapturer::run() {
+    ALOG_I(TAG, "capture thread started");
+    for (;;) {
+        Job job;
+        bool hasJob = false;
+        std::deque<SkyCaptureRequest> expired;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // 有请求在等帧时按最早的期限醒来检查超时
+            while (!abort_ && jobs_.empty()) {
+                if (requests_.empty()) {
+                    cond_.wait(lock);
+                } else if (cond_.wait_until(lock, requests_.front().deadline) == std::cv_status::timeout) {
+                    break;
+                }
+            }
+            if (abort_) {
+                break;
+            }
+            expireLocked(&expired);
+            if (!jobs_.empty()) {
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+                hasJob = true;
+            }
+        }
+
+        for (const auto &request : expired) {
+            ALOG_W(TAG, "capture timed out: %s", request.path.c_str());
+            if (callback_) {
+                callback_(0, AVERROR(ETIMEDOUT), request.path);
+            }
+        }
+        if (!hasJob) {
+            continue;
+        }
+
+        int ret = process(job);
+        av_frame_free(&job.frame);
+        if (callback_) {
+            callback_(job.positionMs, ret, job.request.path);
+        }
+    }
+    ALOG_I(TAG, "capture thread exit");
+}
+
+void SkyFrameCapturer::expireLocked(std::deque<SkyCaptureRequest> *expired) {
+    const auto now = std::chrono::steady_clock::now();
+    while (!requests_.empty() && requests_.front().deadline <= now) {
+        expired->push_back(std::move(requests_.front().request));
+        requests_.pop_front();
+    }
+    pending_.store(static_cast<int>(requests_.size()), std::memory_order_release);
+}
+
+int SkyFrameCapturer::process(const Job &job) {
+    const AVFrame* frame = job.frame;
+    if (nullptr == frame) {
+        return AVERROR(ENOMEM);
+    }
+    if (frame->hw_frames_ctx) {
+        // MediaCodec 直接输出到 Surface 时拿不到像素
+        ALOG_E(TAG, "capture: hardware frame is not supported");
+        return AVERROR(ENOSYS);
+    }
+
+    int width = static_cast<int>(frame->width - frame->crop_left - frame->crop_right);
+    int height = static_cast<int>(frame->height - frame->crop_top - frame->crop_bottom);
+    if (width <= 0 || height <= 0) {
+        return AVERROR(EINVAL);
+    }
+
+    // 目标尺寸：按 SAR 还原显示宽度，再按比例缩到 max 以内（max 针对旋转后的图像）
+    const bool swap = job.rotation == 90 || job.rotation == 270;
+    double sar = frame->sample_aspect_ratio.num > 0 ? av_q2d(frame->sample_aspect_ratio) : 1.0;
+    double targetWidth = width * sar;
+    double targetHeight = height;
+    int maxWidth = swap ? job.request.maxHeight : job.request.maxWidth;
+    int maxHeight = swap ? job.request.maxWidth : job.request.maxHeight;
+    double fit = 1.0;
+    if (maxWidth > 0) fit = std::min(fit, maxWidth / targetWidth);
+    if (maxHeight > 0) fit = std::min(fit, maxHeight / targetHeight);
+    const int outWidth = std::max(1, static_cast<int>(std::lround(targetWidth * fit)));
+    const int outHeight = std::max(1, static_cast<int>(std::lround(targetHeight * fit)));
+
+    // 先在 YUV 上做 2:1 box 缩小，减少后面转换和 swscale 的像素数
+    AVFrame* scaled[2] = {nullptr, nullptr};
+    int current = -1;
+    while (sky_frame_can_downscale(frame) && width / 2 >= outWidth / sar && height / 2 >= outHeight) {
+        int next = current == 0 ? 1 : 0;
+        if (nullptr == scaled[next]) {
+            scaled[next] = av_frame_alloc();
+        }
+        if (nullptr == scaled[next] || sky_frame_downscale_2x(scaled[next], frame) < 0) {
+            break;
+        }
+        current = next;
+        frame = scaled[current];
+        width = static_cast<int>(frame->width - frame->crop_left - frame->crop_right);
+        height = static_cast<int>(frame->height - frame->crop_top - frame->crop_bottom);
+    }
+
+    RgbaImage image;
+    image.resize(width, height);
+    bool converted = SkyANativeWindowRenderer::convertFrame(frame, image.pixels.data(), image.stride(),
+                                                            SkyYuvConverter::OutputFormat::RGBA8888, &swsContext_);
+    av_frame_free(&scaled[0]);
+    av_frame_free(&scaled[1]);
+    if (!converted) {
+        ALOG_E(TAG, "capture: convert frame failed, format=%d", job.frame->format);
+        return AVERROR(EINVAL);
+    }
+
+    if (outWidth != width || outHeight != height) {
+        RgbaImage resized;
+        resized.resize(outWidth, outHeight);
+        SwsContext* ctx = sws_getContext(width, height, AV_PIX_FMT_RGBA, outWidth, outHeight, AV_PIX_FMT_RGBA,
+                                         SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (nullptr == ctx) {
+            return AVERROR(ENOMEM);
+        }
+        const uint8_t* srcData[1] = {image.pixels.data()};
+        const int srcStride[1] = {image.stride()};
+        uint8_t* dstData[1] = {resized.pixels.data()};
+        const int dstStride[1] = {resized.stride()};
+        sws_scale(ctx, srcData, srcStride, 0, height, dstData, dstStride);
+        sws_freeContext(ctx);
+        image = std::move(resized);
+    }
+
+    if (job.rotation != 0 || job.flip != 0) {
+        RgbaImage transformed;
+        transformImage(image, transformed, job.rotation, job.flip);
+        image = std::move(transformed);
+    }
+
+    ALOG_I(TAG, "capture: %dx%d -> %s", image.width, image.height, job.request.path.c_str());
+    return encodeImage(image, job.request);
+}
@@ -0,0 +1,94 @@
+#ifndef SKY_FRAME_CAPTURE_H
+#define SKY_FRAME_CAPTURE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct AVFrame;
+struct SwsContext;
+
+enum SkyCaptureFormat {
+    SKY_CAPTURE_FORMAT_JPEG = 0,
+    SKY_CAPTURE_FORMAT_PNG  = 1,
+};
+
+struct SkyCaptureRequest {
+    std::string path;
+    int format = SKY_CAPTURE_FORMAT_JPEG;
+    int quality = 90;
+    // 0 表示不限制，按比例缩小到不超过 maxWidth x maxHeight
+    int maxWidth = 0;
+    int maxHeight = 0;
+};
+
+/**
+ * 异步截图：渲染线程只对当前显示帧 av_frame_ref，转换/缩放/编码都在截图线程完成，
+ * 不会阻塞 video_refresh。
+ */
+class SkyFrameCapturer {
+public:
+    // positionMs 为截到帧的 pts，result 为 0 成功，<0 为 AVERROR
+    using Callback = std::function<void(int positionMs, int result, const std::string &path)>;
+
+    explicit SkyFrameCapturer(Callback callback);
+    ~SkyFrameCapturer();
+
+    // 任意线程调用，等待下一次 refresh 取帧；排队过多时返回 false，TIMEOUT_MS 内没取到帧时回调 AVERROR(ETIMEDOUT)
+    bool request(SkyCaptureRequest request);
+
+    // 渲染线程每次 refresh 查询，只是一次原子读
+    bool isPending() const {
+        return pending_.load(std::memory_order_acquire) > 0;
+    }
+
+    // 渲染线程调用，对 frame 加引用后交给截图线程，不拷贝像素
+    void submit(const AVFrame *frame, double pts, int rotation, int flip);
+
+    // 丢弃还没处理的请求和帧，不回调
+    void stop();
+
+private:
+    struct Pending {
+        SkyCaptureRequest request;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    struct Job {
+        SkyCaptureRequest request;
+        AVFrame *frame = nullptr;
+        int positionMs = 0;
+        int rotation = 0;
+        int flip = 0;
+    };
+
+    void run();
+    int process(const Job &job);
+    void startThreadLocked();
+    // 取出已超时的请求
+    void expireLocked(std::deque<SkyCaptureRequest> *expired);
+
+private:
+    static constexpr size_t MAX_PENDING = 4;
+    static constexpr int TIMEOUT_MS = 3000;
+
+    Callback callback_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<Pending> requests_;
+    std::deque<Job> jobs_;
+    std::atomic<int> pending_{0};
+    bool abort_ = false;
+    std::thread thread_;
+
+    // 只在截图线程使用
+    SwsContext *swsContext_ = nullptr;
+};
+
+#endif // SKY_FRAME_CAPTURE_H
@@ -0,0 +1,162 @@
+extern "C" {
+#include "libavutil/frame.h"
+#include "libavutil/error.h"
+}
+
+#include <cstddef>
+#include "sky_frame_scaler.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SKY_SCALER_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define SKY_SCALER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // 平面：out[x] = 相邻两行 2x2 像素的平均
+    void boxRowPlanar(const uint8_t* a, const uint8_t* b, uint8_t* out, int outWidth) {
+        int x = 0;
+#if SKY_SCALER_NEON
+        for (; x + 16 <= outWidth; x += 16) {
+            uint16x8_t lo = vaddq_u16(vpaddlq_u8(vld1q_u8(a + x * 2)), vpaddlq_u8(vld1q_u8(b + x * 2)));
+            uint16x8_t hi = vaddq_u16(vpaddlq_u8(vld1q_u8(a + x * 2 + 16)), vpaddlq_u8(vld1q_u8(b + x * 2 + 16)));
+            vst1q_u8(out + x, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+        }
+#elif SKY_SCALER_SSE2
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+        const __m128i round = _mm_set1_epi16(2);
+        for (; x + 16 <= outWidth; x += 16) {
+            __m128i sum[2];
+            for (int i = 0; i < 2; ++i) {
+                __m128i ra = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x * 2 + i * 16));
+                __m128i rb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x * 2 + i * 16));
+                __m128i s = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(ra, mask), _mm_srli_epi16(ra, 8)),
+                                          _mm_add_epi16(_mm_and_si128(rb, mask), _mm_srli_epi16(rb, 8)));
+                sum[i] = _mm_srli_epi16(_mm_add_epi16(s, round), 2);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(sum[0], sum[1]));
+        }
+#endif
+        for (; x < outWidth; ++x) {
+            out[x] = static_cast<uint8_t>((a[x * 2] + a[x * 2 + 1] + b[x * 2] + b[x * 2 + 1] + 2) >> 2);
+        }
+    }
+
+    // NV12/NV21 的交错色度：按 (U,V) 对做 2x2 平均
+    void boxRowInterleaved(const uint8_t* a, const uint8_t* b, uint8_t* out, int outPairs) {
+        int x = 0;
+#if SKY_SCALER_NEON
+        for (; x + 8 <= outPairs; x += 8) {
+            uint8x16x2_t ra = vld2q_u8(a + x * 4);
+            uint8x16x2_t rb = vld2q_u8(b + x * 4);
+            uint8x8x2_t result;
+            for (int i = 0; i < 2; ++i) {
+                result.val[i] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(ra.val[i]), vpaddlq_u8(rb.val[i])), 2);
+            }
+            vst2_u8(out + x * 2, result);
+        }
+#elif SKY_SCALER_SSE2
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i round = _mm_set1_epi32(2);
+        for (; x + 8 <= outPairs; x += 8) {
+            __m128i first[2], second[2];
+            for (int i = 0; i < 2; ++i) {
+                __m128i ra = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x * 4 + i * 16));
+                __m128i rb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x * 4 + i * 16));
+                // 16 bit lane 中分离出两个分量，madd 把相邻两个像素加到 32 bit
+                __m128i s0 = _mm_add_epi32(_mm_madd_epi16(_mm_and_si128(ra, mask), ones),
+                                           _mm_madd_epi16(_mm_and_si128(rb, mask), ones));
+                __m128i s1 = _mm_add_epi32(_mm_madd_epi16(_mm_srli_epi16(ra, 8), ones),
+                                           _mm_madd_epi16(_mm_srli_epi16(rb, 8), ones));
+                first[i] = _mm_srli_epi32(_mm_add_epi32(s0, round), 2);
+                second[i] = _mm_srli_epi32(_mm_add_epi32(s1, round), 2);
+            }
+            __m128i c0 = _mm_packs_epi32(first[0], first[1]);
+            __m128i c1 = _mm_packs_epi32(second[0], second[1]);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 2), _mm_or_si128(c0, _mm_slli_epi16(c1, 8)));
+        }
+#endif
+        for (; x < outPairs; ++x) {
+            for (int c = 0; c < 2; ++c) {
+                out[x * 2 + c] = static_cast<uint8_t>((a[x * 4 + c] + a[x * 4 + 2 + c]
+                                                       + b[x * 4 + c] + b[x * 4 + 2 + c] + 2) >> 2);
+            }
+        }
+    }
+
+    void downscalePlane(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride,
+                        int outWidth, int outHeight, bool interleaved) {
+        for (int y = 0; y < outHeight; ++y) {
+            const uint8_t* a = src + static_cast<ptrdiff_t>(y * 2) * srcStride;
+            const uint8_t* b = a + srcStride;
+            uint8_t* out = dst + static_cast<ptrdiff_t>(y) * dstStride;
+            if (interleaved) {
+                boxRowInterleaved(a, b, out, outWidth);
+            } else {
+                boxRowPlanar(a, b, out, outWidth);
+            }
+        }
+    }
+}
+
+int sky_frame_can_downscale(const AVFrame *frame) {
+    if (nullptr == frame || frame->hw_frames_ctx) {
+        return 0;
+    }
+    switch (frame->format) {
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P:
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV21:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int sky_frame_downscale_2x(AVFrame *dst, const AVFrame *src) {
+    if (nullptr == dst || !sky_frame_can_downscale(src)) {
+        return AVERROR(EINVAL);
+    }
+
+    // 取偶数保证 4:2:0 色度与亮度仍然对齐，且色度源数据不会越界
+    const int width = (src->width / 2) & ~1;
+    const int height = (src->height / 2) & ~1;
+    if (width <= 0 || height <= 0) {
+        return AVERROR(EINVAL);
+    }
+
+    av_frame_unref(dst);
+    dst->format = src->format;
+    dst->width = width;
+    dst->height = height;
+    int ret = av_frame_get_buffer(dst, 0);
+    if (ret < 0) {
+        return ret;
+    }
+    ret = av_frame_copy_props(dst, src);
+    if (ret < 0) {
+        av_frame_unref(dst);
+        return ret;
+    }
+    dst->crop_left = src->crop_left / 2;
+    dst->crop_right = src->crop_right / 2;
+    dst->crop_top = src->crop_top / 2;
+    dst->crop_bottom = src->crop_bottom / 2;
+    if (dst->crop_left + dst->crop_right >= static_cast<size_t>(width)
+        || dst->crop_top + dst->crop_bottom >= static_cast<size_t>(height)) {
+        dst->crop_left = dst->crop_right = dst->crop_top = dst->crop_bottom = 0;
+    }
+
+    downscalePlane(src->data[0], src->linesize[0], dst->data[0], dst->linesize[0], width, height, false);
+    if (src->format == AV_PIX_FMT_NV12 || src->format == AV_PIX_FMT_NV21) {
+        downscalePlane(src->data[1], src->linesize[1], dst->data[1], dst->linesize[1], width / 2, height / 2, true);
+    } else {
+        downscalePlane(src->data[1], src->linesize[1], dst->data[1], dst->linesize[1], width / 2, height / 2, false);
+        downscalePlane(src->data[2], src->linesize[2], dst->data[2], dst->linesize[2], width / 2, height / 2, false);
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+extern "C" {
+#include "libavutil/buffer.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+}
+
+#include <algorithm>
+#include <cmath>
+
+#include "logger.h"
+#include "sky_frame_tap.h"
+#include "sky_frame_scaler.h"
+#include "sky_anativewindow_renderer.h"
+
+static const char* TAG = "SkyFrameTap";
+
+SkyFrameTap::~SkyFrameTap() {
+    unsubscribe();
+}
+
+void SkyFrameTap::subscribe(const SkyFrameTapConfig &config, Callback callback) {
+    unsubscribe();
+    if (!callback) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    config_.queueSize = std::max(1, config.queueSize);
+    callback_ = std::move(callback);
+    abort_ = false;
+    hasLastPts_ = false;
+    dropped_ = 0;
+    thread_ = std::thread([this]() {
+        this->run();
+    });
+    active_.store(true, std::memory_order_release);
+    ALOG_I(TAG, "subscribe: format %d, max %dx%d, max fps %.1f, queue %d",
+           config_.format, config_.maxWidth, config_.maxHeight, config_.maxFps, config_.queueSize);
+}
+
+void SkyFrameTap::unsubscribe() {
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_.store(false, std::memory_order_release);
+        abort_ = true;
+        clearJobsLocked();
+        thread = std::move(thread_);
+    }
+    cond_.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+        ALOG_I(TAG, "unsubscribe: %llu frames dropped", (unsigned long long) dropped_);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = nullptr;
+    av_frame_free(&scaled_[0]);
+    av_frame_free(&scaled_[1]);
+    av_buffer_pool_uninit(&pool_);
+    poolSize_ = 0;
+    sws_freeContext(swsContext_);
+    swsContext_ = nullptr;
+}
+
+void SkyFrameTap::clearJobsLocked() {
+    for (auto &job : jobs_) {
+        av_frame_free(&job.frame);
+    }
+    jobs_.clear();
+}
+
+void SkyFrameTap::submit(const AVFrame *frame, double pts) {
+    if (nullptr == frame || !isActive()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (abort_) {
+        return;
+    }
+    // 按帧率抽帧，pts 回退（seek）时重新计时
+    if (config_.maxFps > 0 && !std::isnan(pts)) {
+        if (hasLastPts_ && pts >= lastPts_ && pts - lastPts_ < 1.0 / config_.maxFps - 0.001) {
+            return;
+        }
+        lastPts_ = pts;
+        hasLastPts_ = true;
+    }
+
+    Job job;
+    job.frame = av_frame_clone(frame);
+    job.pts = pts;
+    if (nullptr == job.frame) {
+        return;
+    }
+    // 背压：订阅方处理不过来时丢最旧的帧，解码线程从不等待
+    while (jobs_.size() >= static_cast<size_t>(config_.queueSize)) {
+        av_frame_free(&jobs_.front().frame);
+        jobs_.pop_front();
+        dropped_++;
+    }
+    jobs_.push_back(job);
+    cond_.notify_one();
+}
+
+void SkyFrameTap::run() {
+    ALOG_I(TAG, "tap thread started");
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]() { return abort_ || !jobs_.empty(); });
+            if (abort_) {
+                break;
+            }
+            job = jobs_.front();
+            jobs_.pop_front();
+        }
+
+        SkyTapFrame tapped;
+        tapped.source = job.frame;
+        tapped.pts = job.pts;
+        AVBufferRef *buffer = nullptr;
+        if (config_.format == SKY_FRAME_TAP_FORMAT_NONE || convert(job.frame, &tapped, &buffer)) {
+            callback_(tapped);
+        }
+        av_buffer_unref(&buffer);
+        av_frame_free(&job.frame);
+    }
+    ALOG_I(TAG, "tap thread exited");
+}
+
+bool SkyFrameTap::convert(const AVFrame *frame, SkyTapFrame *out, AVBufferRef **buffer) {
+    if (frame->hw_frames_ctx) {
+        // MediaCodec 直接输出到 Surface 时拿不到像素，只交出引用
+        return true;
+    }
+
+    int width = static_cast<int>(frame->width - frame->crop_left - frame->crop_right);
+    int height = static_cast<int>(frame->height - frame->crop_top - frame->crop_bottom);
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    // 目标尺寸：按 SAR 还原显示宽度，再按比例缩到 max 以内，NV12 取偶数
+    const bool nv12 = config_.format == SKY_FRAME_TAP_FORMAT_NV12;
+    double sar = frame->sample_aspect_ratio.num > 0 ? av_q2d(frame->sample_aspect_ratio) : 1.0;
+    double fit = 1.0;
+    if (config_.maxWidth > 0) fit = std::min(fit, config_.maxWidth / (width * sar));
+    if (config_.maxHeight > 0) fit = std::min(fit, static_cast<double>(config_.maxHeight) / height);
+    int outWidth = std::max(1, static_cast<int>(std::lround(width * sar * fit)));
+    int outHeight = std::max(1, static_cast<int>(std::lround(height * fit)));
+    if (nv12) {
+        outWidth = std::max(2, outWidth & ~1);
+        outHeight = std::max(2, outHeight & ~1);
+    }
+
+    // 先在 YUV 上做 2:1 box 缩小，减少后面转换和 swscale 的像素数
+    const AVFrame *current = frame;
+    int index = -1;
+    while (sky_frame_can_downscale(current) && width / 2 >= outWidth / sar && height / 2 >= outHeight) {
+        int next = index == 0 ? 1 : 0;
+        if (nullptr == scaled_[next]) {
+            scaled_[next] = av_frame_alloc();
+        }
+        if (nullptr == scaled_[next] || sky_frame_downscale_2x(scaled_[next], current) < 0) {
+            break;
+        }
+        index = next;
+        current = scaled_[index];
+        width = static_cast<int>(current->width - current->crop_left - current->crop_right);
+        height = static_cast<int>(current->height - current->crop_top - current->crop_bottom);
+    }
+
+    const int stride = nv12 ? outWidth : outWidth * 4;
+    const size_t size = nv12 ? static_cast<size_t>(stride) * outHeight * 3 / 2 : static_cast<size_t>(stride) * outHeight;
+    if (!pool_ || poolSize_ != size) {
+        // 尺寸变化后旧 pool 中借出的 buffer 在释放时回收
+        av_buffer_pool_uninit(&pool_);
+        pool_ = av_buffer_pool_init(size, nullptr);
+        poolSize_ = pool_ ? size : 0;
+    }
+    *buffer = pool_ ? av_buffer_pool_get(pool_) : nullptr;
+    if (nullptr == *buffer) {
+        return false;
+    }
+    uint8_t *dst = (*buffer)->data;
+
+    bool ok;
+    if (nv12) {
+        uint8_t *const dstData[4] = {dst, dst + static_cast<size_t>(stride) * outHeight, nullptr, nullptr};
+        const int dstLinesize[4] = {stride, stride, 0, 0};
+        ok = scale(current, AV_PIX_FMT_NV12, outWidth, outHeight, dstData, dstLinesize);
+    } else if (width == outWidth && height == outHeight) {
+        // 尺寸一致时走 SIMD 的 YUV -> RGBA
+        ok = SkyANativeWindowRenderer::convertFrame(current, dst, stride, SkyYuvConverter::OutputFormat::RGBA8888,
+                                                    &swsContext_);
+    } else {
+        uint8_t *const dstData[4] = {dst, nullptr, nullptr, nullptr};
+        const int dstLinesize[4] = {stride, 0, 0, 0};
+        ok = scale(current, AV_PIX_FMT_RGBA, outWidth, outHeight, dstData, dstLinesize);
+    }
+    if (!ok) {
+        ALOG_E(TAG, "convert %s %dx%d -> %dx%d failed",
+               av_get_pix_fmt_name(static_cast<AVPixelFormat>(current->format)), width, height, outWidth, outHeight);
+        av_buffer_unref(buffer);
+        return false;
+    }
+
+    out->data = dst;
+    out->size = size;
+    out->width = outWidth;
+    out->height = outHeight;
+    out->stride = stride;
+    out->format = config_.format;
+    return true;
+}
+
+bool SkyFrameTap::scale(const AVFrame *frame, int dstFormat, int width, int height,
+                        uint8_t *const dstData[4], const int dstLinesize[4]) {
+    AVFrame *cropped = av_frame_clone(frame);
+    if (nullptr == cropped) {
+        return false;
+    }
+    bool ret = false;
+    if (av_frame_apply_cropping(cropped, AV_FRAME_CROP_UNALIGNED) >= 0) {
+        swsContext_ = sws_getCachedContext(swsContext_, cropped->width, cropped->height,
+                                           static_cast<AVPixelFormat>(cropped->format),
+                                           width, height, static_cast<AVPixelFormat>(dstFormat),
+                                           SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        if (swsContext_) {
+            ret = sws_scale(swsContext_, cropped->data, cropped->linesize, 0, cropped->height, dstData, dstLinesize) > 0;
+        }
+    }
+    av_frame_free(&cropped);
+    return ret;
+}
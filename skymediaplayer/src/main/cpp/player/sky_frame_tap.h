@@ -0,0 +1,106 @@
+#ifndef SKY_FRAME_TAP_H
+#define SKY_FRAME_TAP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+struct AVFrame;
+struct AVBufferPool;
+struct AVBufferRef;
+struct SwsContext;
+
+enum SkyFrameTapFormat {
+    SKY_FRAME_TAP_FORMAT_NONE = 0,  // 不转换，只交出解码帧的引用
+    SKY_FRAME_TAP_FORMAT_RGBA = 1,
+    SKY_FRAME_TAP_FORMAT_NV12 = 2,
+};
+
+struct SkyFrameTapConfig {
+    // 最高帧率，0 表示每一帧都交出
+    double maxFps = 0;
+    // 转换的目标尺寸，按比例缩小到不超过 maxWidth x maxHeight，0 表示不限制
+    int maxWidth = 0;
+    int maxHeight = 0;
+    int format = SKY_FRAME_TAP_FORMAT_NONE;
+    // 等待处理的帧数上限，满了丢弃最旧的一帧
+    int queueSize = 2;
+};
+
+struct SkyTapFrame {
+    // 解码帧的引用，回调返回后释放
+    const AVFrame *source = nullptr;
+    // 显示时间（秒），NAN 表示未知
+    double pts = 0;
+    // 转换后的像素，NONE 或硬件帧时为空；NV12 的 UV 紧跟在 Y 之后，行字节数相同
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    int format = SKY_FRAME_TAP_FORMAT_NONE;
+};
+
+/**
+ * 解码帧旁路，供应用内分析（场景检测、审核等）使用，不需要 GPU 回读也不需要再解码一次。
+ * 解码线程在 queue_picture 中只对帧加引用后入队，不拷贝像素、不等待，队列满时丢弃最旧的帧；
+ * 缩小、RGBA/NV12 转换和回调都在旁路线程完成，输出 buffer 来自 buffer pool。
+ */
+class SkyFrameTap {
+public:
+    using Callback = std::function<void(const SkyTapFrame &frame)>;
+
+    ~SkyFrameTap();
+
+    // 设置订阅并启动旁路线程，已有订阅时替换；不能在回调中调用
+    void subscribe(const SkyFrameTapConfig &config, Callback callback);
+    // 取消订阅，等旁路线程退出后返回，未处理的帧直接丢弃
+    void unsubscribe();
+
+    // 解码线程每帧查询，只是一次原子读
+    bool isActive() const {
+        return active_.load(std::memory_order_acquire);
+    }
+
+    // 解码线程调用，按帧率筛选后对 frame 加引用入队
+    void submit(const AVFrame *frame, double pts);
+
+private:
+    struct Job {
+        AVFrame *frame = nullptr;
+        double pts = 0;
+    };
+
+    void run();
+    // 转换到 config_ 的格式和尺寸，结果写入 out，buffer 由调用方释放
+    bool convert(const AVFrame *frame, SkyTapFrame *out, AVBufferRef **buffer);
+    bool scale(const AVFrame *frame, int dstFormat, int width, int height, uint8_t *const dstData[4], const int dstLinesize[4]);
+    void clearJobsLocked();
+
+private:
+    std::atomic<bool> active_{false};
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<Job> jobs_;
+    SkyFrameTapConfig config_;
+    Callback callback_;
+    bool abort_ = false;
+    double lastPts_ = 0;
+    bool hasLastPts_ = false;
+    uint64_t dropped_ = 0;
+    std::thread thread_;
+
+    // 只在旁路线程访问
+    AVFrame *scaled_[2] = {nullptr, nullptr};
+    AVBufferPool *pool_ = nullptr;
+    size_t poolSize_ = 0;
+    SwsContext *swsContext_ = nullptr;
+};
+
+#endif // SKY_FRAME_TAP_H
@@ -0,0 +1,196 @@
+extern "C" {
+#include "libavformat/avformat.h"
+#include "libavutil/avstring.h"
+#include "libavutil/dict.h"
+#include "libavutil/mem.h"
+}
+
+#include <cstdlib>
+#include <cstring>
+
+#include "logger.h"
+#include "sky_io.h"
+
+static const char* TAG = "SkyIo";
+
+// HEAD 请求最多跟随的重定向次数和响应头的长度上限
+#define SKY_IO_MAX_REDIRECTS 5
+#define SKY_IO_MAX_HEADER_SIZE (16 * 1024)
+
+namespace {
+    int readPacket(void *opaque, uint8_t *buf, int size) {
+        return static_cast<SkyIoSource *>(opaque)->read(buf, size);
+    }
+
+    int64_t seekPacket(void *opaque, int64_t offset, int whence) {
+        return static_cast<SkyIoSource *>(opaque)->seek(offset, whence);
+    }
+
+    // 重定向的 Location 可能是相对地址，按 base 解析
+    std::string resolveLocation(const std::string &base, const std::string &location) {
+        if (SkyIo::isHttp(location.c_str())) {
+            return location;
+        }
+        const size_t scheme = base.find("://");
+        if (location.compare(0, 2, "//") == 0) {
+            return base.substr(0, scheme + 1) + location;
+        }
+        const size_t pathStart = base.find('/', scheme + 3);
+        const std::string origin = base.substr(0, pathStart);
+        if (location[0] == '/' || pathStart == std::string::npos) {
+            return origin + (location[0] == '/' ? "" : "/") + location;
+        }
+        const std::string path = base.substr(pathStart, base.find_first_of("?#", pathStart) - pathStart);
+        return origin + path.substr(0, path.rfind('/') + 1) + location;
+    }
+
+    // 在 tcp/tls 连接上发一次 HEAD，返回状态码，3xx 时 location 为跳转地址
+    int headOnce(const std::string &url, const AVIOInterruptCB *interrupt, SkyHttpInfo *info, std::string *location) {
+        char proto[16];
+        char host[256];
+        char path[4096];
+        int port = -1;
+        av_url_split(proto, sizeof(proto), nullptr, 0, host, sizeof(host), &port, path, sizeof(path), url.c_str());
+        const bool tls = strcmp(proto, "https") == 0;
+        if (port < 0) {
+            port = tls ? 443 : 80;
+        }
+        char address[300];
+        snprintf(address, sizeof(address), "%s://%s:%d", tls ? "tls" : "tcp", host, port);
+
+        AVDictionary *opts = nullptr;
+        av_dict_set(&opts, "timeout", "5000000", 0);
+        av_dict_set(&opts, "rw_timeout", "10000000", 0);
+        AVIOContext *pb = nullptr;
+        int ret = avio_open2(&pb, address, AVIO_FLAG_READ_WRITE, interrupt, &opts);
+        av_dict_free(&opts);
+        if (ret < 0) {
+            return ret;
+        }
+
+        const bool defaultPort = port == (tls ? 443 : 80);
+        std::string request = std::string("HEAD ") + (path[0] ? path : "/") + " HTTP/1.1\r\n"
+                              + "Host: " + host + (defaultPort ? "" : ":" + std::to_string(port)) + "\r\n"
+                              + "User-Agent: SkyPlayer/1.0 (Android)\r\n"
+                              + "Accept: */*\r\nConnection: close\r\n\r\n";
+        avio_write(pb, reinterpret_cast<const unsigned char *>(request.data()), static_cast<int>(request.size()));
+        avio_flush(pb);
+
+        // 逐行读到空行为止，HEAD 没有 body
+        std::string line;
+        int status = AVERROR_INVALIDDATA;
+        int total = 0;
+        for (;;) {
+            int c = avio_r8(pb);
+            if (avio_feof(pb) || ++total > SKY_IO_MAX_HEADER_SIZE) {
+                break;
+            }
+            if (c != '\n') {
+                line += static_cast<char>(c);
+                continue;
+            }
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                break;
+            }
+            const size_t colon = line.find(':');
+            if (status == AVERROR_INVALIDDATA) {
+                const size_t space = line.find(' ');
+                if (av_strncasecmp(line.c_str(), "HTTP/", 5) == 0 && space != std::string::npos) {
+                    status = atoi(line.c_str() + space + 1);
+                }
+            } else if (colon != std::string::npos) {
+                const std::string name = line.substr(0, colon);
+                std::string value = line.substr(colon + 1);
+                value.erase(0, value.find_first_not_of(" \t"));
+                if (av_strcasecmp(name.c_str(), "Content-Length") == 0) {
+                    info->size = strtoll(value.c_str(), nullptr, 10);
+                } else if (av_strcasecmp(name.c_str(), "ETag") == 0) {
+                    info->etag = value;
+                } else if (av_strcasecmp(name.c_str(), "Last-Modified") == 0) {
+                    info->lastModified = value;
+                } else if (av_strcasecmp(name.c_str(), "Location") == 0) {
+                    *location = value;
+                }
+            }
+            line.clear();
+        }
+        avio_closep(&pb);
+        return status;
+    }
+}
+
+AVIOContext *SkyIo::wrap(std::unique_ptr<SkyIoSource> source, int bufferSize) {
+    auto *buffer = static_cast<unsigned char *>(av_malloc(bufferSize));
+    if (nullptr == buffer) {
+        return nullptr;
+    }
+    AVIOContext *pb = avio_alloc_context(buffer, bufferSize, 0, source.get(), readPacket, nullptr, seekPacket);
+    if (nullptr == pb) {
+        av_free(buffer);
+        return nullptr;
+    }
+    source.release();
+    return pb;
+}
+
+void SkyIo::close(AVIOContext **pb) {
+    if (nullptr == pb || nullptr == *pb) {
+        return;
+    }
+    delete static_cast<SkyIoSource *>((*pb)->opaque);
+    // buffer 可能已被 AVIOContext 换过，释放当前的那一个
+    av_freep(&(*pb)->buffer);
+    avio_context_free(pb);
+}
+
+int SkyIo::openUpstream(const std::string &url, const AVIOInterruptCB *interrupt, AVIOContext **pb,
+                        int64_t offset, int64_t endOffset) {
+    AVDictionary *opts = nullptr;
+    if (isHttp(url.c_str())) {
+        av_dict_set(&opts, "timeout", "5000000", 0);
+        av_dict_set(&opts, "rw_timeout", "10000000", 0);
+        av_dict_set(&opts, "user_agent", "SkyPlayer/1.0 (Android)", 0);
+        av_dict_set(&opts, "reconnect", "1", 0);
+        av_dict_set(&opts, "reconnect_streamed", "1", 0);
+        av_dict_set(&opts, "reconnect_delay_max", "5", 0);
+        if (endOffset > 0) {
+            av_dict_set_int(&opts, "offset", offset, 0);
+            av_dict_set_int(&opts, "end_offset", endOffset, 0);
+        }
+    }
+    int ret = avio_open2(pb, url.c_str(), AVIO_FLAG_READ, interrupt, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        ALOG_W(TAG, "open %s failed: %d", url.c_str(), ret);
+    }
+    return ret;
+}
+
+int SkyIo::probeHttp(const std::string &url, const AVIOInterruptCB *interrupt, SkyHttpInfo *info) {
+    std::string current = url;
+    for (int i = 0; i <= SKY_IO_MAX_REDIRECTS; i++) {
+        *info = SkyHttpInfo();
+        std::string location;
+        int status = headOnce(current, interrupt, info, &location);
+        if (status < 0) {
+            ALOG_W(TAG, "probe %s failed: %d", current.c_str(), status);
+            return status;
+        }
+        if (status >= 200 && status < 300) {
+            return 0;
+        }
+        if (status < 300 || status >= 400 || location.empty()) {
+            ALOG_W(TAG, "probe %s: http %d", current.c_str(), status);
+            return status >= 500 ? AVERROR_HTTP_SERVER_ERROR : AVERROR_HTTP_OTHER_4XX;
+        }
+        current = resolveLocation(current, location);
+    }
+    return AVERROR(ELOOP);
+}
+
+bool SkyIo::isHttp(const char *url) {
+    return url && (strncmp(url, "http://", 7) == 0 || strncmp(url, "https://", 8) == 0);
+}
@@ -0,0 +1,52 @@
+#ifndef SKY_IO_H
+#define SKY_IO_H
+
+extern "C" {
+#include "libavformat/avio.h"
+}
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// 自定义 IO 的 AVIOContext buffer 大小
+#define SKY_IO_BUFFER_SIZE (64 * 1024)
+
+/**
+ * read_thread 的自定义数据源（预加载缓存等），由 SkyIo::wrap 包装成 AVIOContext，
+ * 只在 read_thread 中使用，不需要加锁
+ */
+class SkyIoSource {
+public:
+    virtual ~SkyIoSource() = default;
+
+    // 与 AVIOContext 的 read_packet 相同：返回读到的字节数，结束时返回 AVERROR_EOF
+    virtual int read(uint8_t *buf, int size) = 0;
+    // 与 AVIOContext 的 seek 相同，支持 AVSEEK_SIZE
+    virtual int64_t seek(int64_t offset, int whence) = 0;
+};
+
+// HTTP 响应头里与缓存校验有关的字段，未返回的为空或 -1
+struct SkyHttpInfo {
+    int64_t size = -1;
+    std::string etag;
+    std::string lastModified;
+};
+
+class SkyIo {
+public:
+    // 取得 source 的所有权，返回的 AVIOContext 用 close 释放
+    static AVIOContext *wrap(std::unique_ptr<SkyIoSource> source, int bufferSize = SKY_IO_BUFFER_SIZE);
+    static void close(AVIOContext **pb);
+
+    // 用 FFmpeg 自带协议打开源地址，网络参数与 read_thread 一致；endOffset 大于 0 时 http 只请求 [offset, endOffset)
+    static int openUpstream(const std::string &url, const AVIOInterruptCB *interrupt, AVIOContext **pb,
+                            int64_t offset = 0, int64_t endOffset = 0);
+
+    // 发 HEAD 请求取大小、ETag 和 Last-Modified（FFmpeg 的 http 协议不暴露后两者），跟随重定向
+    static int probeHttp(const std::string &url, const AVIOInterruptCB *interrupt, SkyHttpInfo *info);
+
+    static bool isHttp(const char *url);
+};
+
+#endif // SKY_IO_H
@@ -0,0 +1,252 @@
+extern "C" {
+#include "libavutil/samplefmt.h"
+}
+
+#include <algorithm>
+#include <cmath>
+#include <sys/resource.h>
+
+#include "logger.h"
+#include "sky_loudness_meter.h"
+
+static const char* TAG = "SkyLoudnessMeter";
+
+// 计量线程的 nice 值，与 Android 的 THREAD_PRIORITY_BACKGROUND 相同
+#define LOUDNESS_METER_NICE 10
+// 子块 100ms，瞬时响度取 4 个子块，短期响度取 30 个
+#define LOUDNESS_METER_MOMENTARY_BLOCKS 4
+#define LOUDNESS_METER_SHORT_TERM_BLOCKS 30
+// 整体响度的绝对门限和相对门限（BS.1770-4）
+#define LOUDNESS_METER_ABS_GATE -70.0
+#define LOUDNESS_METER_REL_GATE -10.0
+// 直方图覆盖 -70 ~ +5 LUFS，每格 0.1 LU
+#define LOUDNESS_METER_HIST_MAX 5.0
+#define LOUDNESS_METER_HIST_STEP 0.1
+
+namespace {
+    inline double energyToLufs(double energy) {
+        return energy > 0 ? -0.691 + 10.0 * std::log10(energy) : -HUGE_VAL;
+    }
+
+    inline float toReported(double lufs) {
+        return static_cast<float>(std::max(lufs, static_cast<double>(LOUDNESS_METER_FLOOR_LUFS)));
+    }
+
+    // BS.1770 的 K 加权（高架 + 高通），按采样率重新做双线性变换，与 48kHz 下规范给出的系数一致
+    void kweightCoeffs(int sampleRate, float *coeffs) {
+        const double fs = sampleRate;
+
+        double f0 = 1681.974450955533;
+        double gain = 3.999843853973347;
+        double q = 0.7071752369554196;
+        double k = std::tan(M_PI * f0 / fs);
+        double vh = std::pow(10.0, gain / 20.0);
+        double vb = std::pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        coeffs[0] = static_cast<float>((vh + vb * k / q + k * k) / a0);
+        coeffs[1] = static_cast<float>(2.0 * (k * k - vh) / a0);
+        coeffs[2] = static_cast<float>((vh - vb * k / q + k * k) / a0);
+        coeffs[3] = static_cast<float>(2.0 * (k * k - 1.0) / a0);
+        coeffs[4] = static_cast<float>((1.0 - k / q + k * k) / a0);
+
+        f0 = 38.13547087602444;
+        q = 0.5003270373238773;
+        k = std::tan(M_PI * f0 / fs);
+        a0 = 1.0 + k / q + k * k;
+        coeffs[5] = 1.0f;
+        coeffs[6] = -2.0f;
+        coeffs[7] = 1.0f;
+        coeffs[8] = static_cast<float>(2.0 * (k * k - 1.0) / a0);
+        coeffs[9] = static_cast<float>((1.0 - k / q + k * k) / a0);
+    }
+}
+
+SkyLoudnessMeter::SkyLoudnessMeter(SkyPcmTap &tap) : tap_(tap) {
+    ring_.init(LOUDNESS_METER_RING_SIZE);
+    blocks_.assign(LOUDNESS_METER_SHORT_TERM_BLOCKS, 0.0);
+    const auto bins = static_cast<size_t>(std::lround((LOUDNESS_METER_HIST_MAX - LOUDNESS_METER_ABS_GATE) / LOUDNESS_METER_HIST_STEP));
+    histCount_.assign(bins, 0);
+    histEnergy_.assign(bins, 0.0);
+    thread_ = std::thread([this]() {
+        this->run();
+    });
+    tap_.attach(&ring_);
+}
+
+SkyLoudnessMeter::~SkyLoudnessMeter() {
+    tap_.detach(&ring_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        abort_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool SkyLoudnessMeter::getLoudness(SkyLoudness *loudness) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loudness_.serial == 0) {
+        return false;
+    }
+    *loudness = loudness_;
+    return true;
+}
+
+void SkyLoudnessMeter::run() {
+    // 计量不影响播放：低优先级，只用空闲 CPU
+    setpriority(PRIO_PROCESS, 0, LOUDNESS_METER_NICE);
+    ALOG_I(TAG, "meter thread started, kernels: %s", sky_audio_kernels_impl());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!abort_) {
+        cond_.wait_for(lock, std::chrono::milliseconds(LOUDNESS_METER_INTERVAL_MS), [this]() { return abort_; });
+        if (abort_) {
+            break;
+        }
+        lock.unlock();
+
+        SkyPcmTapChunk chunk;
+        while (reader_.next(ring_, &chunk)) {
+            process(chunk);
+        }
+
+        lock.lock();
+    }
+    lock.unlock();
+    ALOG_I(TAG, "meter thread exited, integrated %.1f LUFS, %llu chunks, %llu dropped",
+           integratedLufs(), (unsigned long long) chunks_, (unsigned long long) tap_.dropped());
+}
+
+void SkyLoudnessMeter::configure(int sampleRate, int channels) {
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+    kweightCoeffs(sampleRate, coeffs_);
+    // 5.1/7.1 按 BS.1770 的声道权重：LFE 不计入，环绕声道 +1.5dB
+    for (int ch = 0; ch < channels; ch++) {
+        bool surround = channels >= 6 && ch >= 4;
+        weights_[ch] = (channels >= 6 && ch == 3) ? 0.0f : (surround ? 1.41f : 1.0f);
+    }
+    std::fill(std::begin(state_), std::end(state_), 0.0f);
+    std::fill(std::begin(blockSumSq_), std::end(blockSumSq_), 0.0);
+    blockFrames_ = std::max(sampleRate / 10, 1);
+    blockFilled_ = 0;
+    // 滑动窗口按新格式重新积累，整体响度的直方图保留
+    blockCount_ = 0;
+    blockPos_ = 0;
+    ALOG_I(TAG, "configure: %d Hz, %d channels", sampleRate, channels);
+}
+
+void SkyLoudnessMeter::process(const SkyPcmTapChunk &chunk) {
+    const bool isFloat = chunk.format == AV_SAMPLE_FMT_FLT;
+    const bool isS16 = chunk.format == AV_SAMPLE_FMT_S16;
+    if ((!isFloat && !isS16) || chunk.sampleRate <= 0
+        || chunk.channels <= 0 || chunk.channels > SKY_AUDIO_KWEIGHT_MAX_CHANNELS) {
+        return;
+    }
+    if (chunk.sampleRate != sampleRate_ || chunk.channels != channels_) {
+        configure(chunk.sampleRate, chunk.channels);
+    }
+    chunks_++;
+
+    const int channels = chunk.channels;
+    const size_t count = chunk.bytes / av_get_bytes_per_sample(static_cast<AVSampleFormat>(chunk.format));
+    const int frames = static_cast<int>(count / channels);
+    samples_.resize(count);
+    if (isFloat) {
+        std::copy_n(reinterpret_cast<const float *>(chunk.data), count, samples_.data());
+    } else {
+        const auto *src = reinterpret_cast<const int16_t *>(chunk.data);
+        for (size_t i = 0; i < count; i++) {
+            samples_[i] = src[i] / 32768.0f;
+        }
+    }
+
+    int done = 0;
+    while (done < frames) {
+        int n = std::min(frames - done, blockFrames_ - blockFilled_);
+        float sumSq[SKY_AUDIO_KWEIGHT_MAX_CHANNELS];
+        sky_audio_kweight_f32(samples_.data() + static_cast<size_t>(done) * channels, n, channels, coeffs_, state_, sumSq);
+        for (int ch = 0; ch < channels; ch++) {
+            blockSumSq_[ch] += sumSq[ch];
+        }
+        done += n;
+        blockFilled_ += n;
+        if (blockFilled_ == blockFrames_) {
+            finishBlock();
+        }
+    }
+}
+
+void SkyLoudnessMeter::finishBlock() {
+    double energy = 0;
+    for (int ch = 0; ch < channels_; ch++) {
+        energy += weights_[ch] * blockSumSq_[ch] / blockFrames_;
+        blockSumSq_[ch] = 0;
+    }
+    blockFilled_ = 0;
+    blocks_[blockPos_] = energy;
+    blockPos_ = (blockPos_ + 1) % LOUDNESS_METER_SHORT_TERM_BLOCKS;
+    blockCount_ = std::min(blockCount_ + 1, LOUDNESS_METER_SHORT_TERM_BLOCKS);
+
+    // 从最新的子块往回取 n 个求平均
+    auto windowEnergy = [this](int n) {
+        double sum = 0;
+        for (int i = 1; i <= n; i++) {
+            sum += blocks_[(blockPos_ - i + LOUDNESS_METER_SHORT_TERM_BLOCKS) % LOUDNESS_METER_SHORT_TERM_BLOCKS];
+        }
+        return sum / n;
+    };
+
+    SkyLoudness loudness;
+    if (blockCount_ >= LOUDNESS_METER_MOMENTARY_BLOCKS) {
+        // 400ms 块每 100ms 一个，重叠 75%，同时作为整体响度的门限块
+        double momentary = windowEnergy(LOUDNESS_METER_MOMENTARY_BLOCKS);
+        addGatingBlock(momentary);
+        loudness.momentary = toReported(energyToLufs(momentary));
+    }
+    // 不足 3 秒时按已有的子块计算
+    loudness.shortTerm = toReported(energyToLufs(windowEnergy(blockCount_)));
+    loudness.integrated = integratedLufs();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    loudness.serial = loudness_.serial + 1;
+    loudness_ = loudness;
+}
+
+void SkyLoudnessMeter::addGatingBlock(double energy) {
+    double lufs = energyToLufs(energy);
+    if (lufs < LOUDNESS_METER_ABS_GATE) {
+        return;
+    }
+    auto bin = static_cast<size_t>((lufs - LOUDNESS_METER_ABS_GATE) / LOUDNESS_METER_HIST_STEP);
+    bin = std::min(bin, histCount_.size() - 1);
+    histCount_[bin]++;
+    histEnergy_[bin] += energy;
+}
+
+float SkyLoudnessMeter::integratedLufs() const {
+    uint64_t count = 0;
+    double energy = 0;
+    for (size_t i = 0; i < histCount_.size(); i++) {
+        count += histCount_[i];
+        energy += histEnergy_[i];
+    }
+    if (count == 0) {
+        return LOUDNESS_METER_FLOOR_LUFS;
+    }
+
+    // 相对门限按格子中心比较，误差不超过半格
+    const double gate = energyToLufs(energy / count) + LOUDNESS_METER_REL_GATE;
+    count = 0;
+    energy = 0;
+    for (size_t i = 0; i < histCount_.size(); i++) {
+        double center = LOUDNESS_METER_ABS_GATE + (i + 0.5) * LOUDNESS_METER_HIST_STEP;
+        if (center >= gate) {
+            count += histCount_[i];
+            energy += histEnergy_[i];
+        }
+    }
+    return count > 0 ? toReported(energyToLufs(energy / count)) : LOUDNESS_METER_FLOOR_LUFS;
+}
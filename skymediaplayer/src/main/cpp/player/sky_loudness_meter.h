@@ -0,0 +1,82 @@
+#ifndef SKY_LOUDNESS_METER_H
+#define SKY_LOUDNESS_METER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sky_pcm_ring.h"
+#include "sky_pcm_tap.h"
+#include "sky_audio_kernels.h"
+
+// 消费方 ring 的容量，约 1 秒 48kHz 立体声 float
+#define LOUDNESS_METER_RING_SIZE    (384 * 1024)
+#define LOUDNESS_METER_INTERVAL_MS  100
+/* 没有数据或低于绝对门限时报告的响度 */
+#define LOUDNESS_METER_FLOOR_LUFS   -70.0f
+
+struct SkyLoudness {
+    // EBU R128 / ITU-R BS.1770，单位 LUFS
+    float momentary = LOUDNESS_METER_FLOOR_LUFS;   // 400ms 窗口
+    float shortTerm = LOUDNESS_METER_FLOOR_LUFS;   // 3s 窗口
+    float integrated = LOUDNESS_METER_FLOOR_LUFS;  // 从开启计量起，经过绝对和相对门限
+    // 已有结果之后又更新过的次数，拉取方据此判断是否有更新
+    uint64_t serial = 0;
+};
+
+/**
+ * 响度计量：从 SkyPcmTap 取解码后的 PCM，在低优先级线程上按 100ms 子块增量计算
+ * 瞬时、短期和整体响度。K 加权滤波走 SIMD 内核，整体响度用 0.1 LU 的直方图做门限，内存不随时长增长。
+ */
+class SkyLoudnessMeter {
+public:
+    explicit SkyLoudnessMeter(SkyPcmTap &tap);
+    // 先从 tap 摘除 ring，再等计量线程退出
+    ~SkyLoudnessMeter();
+
+    // 任意线程调用，返回最近一次的结果，还没有结果时返回 false
+    bool getLoudness(SkyLoudness *loudness);
+
+private:
+    void run();
+    void process(const SkyPcmTapChunk &chunk);
+    void configure(int sampleRate, int channels);
+    void finishBlock();
+    void addGatingBlock(double energy);
+    float integratedLufs() const;
+
+private:
+    SkyPcmTap &tap_;
+    SkyPcmRing ring_;
+
+    // 只在计量线程访问
+    SkyPcmTapReader reader_;
+    int sampleRate_ = 0;
+    int channels_ = 0;
+    float coeffs_[10] = {};
+    float weights_[SKY_AUDIO_KWEIGHT_MAX_CHANNELS] = {};
+    float state_[SKY_AUDIO_KWEIGHT_MAX_CHANNELS * 4] = {};
+    std::vector<float> samples_;
+    int blockFrames_ = 0;
+    int blockFilled_ = 0;
+    double blockSumSq_[SKY_AUDIO_KWEIGHT_MAX_CHANNELS] = {};
+    // 最近 30 个子块（3 秒）的加权均方，循环使用
+    std::vector<double> blocks_;
+    int blockCount_ = 0;
+    int blockPos_ = 0;
+    // 整体响度的门限直方图：每个 400ms 块按响度落到 0.1 LU 的格子里，记录块数和能量和
+    std::vector<uint64_t> histCount_;
+    std::vector<double> histEnergy_;
+    uint64_t chunks_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool abort_ = false;
+    SkyLoudness loudness_;
+    std::thread thread_;
+};
+
+#endif // SKY_LOUDNESS_METER_H
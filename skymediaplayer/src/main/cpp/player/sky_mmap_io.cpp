@@ -0,0 +1,203 @@
+extern "C" {
+#include "libavutil/error.h"
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "sky_mmap_io.h"
+
+static const char* TAG = "SkyMmapIo";
+
+namespace {
+    class MmapSource : public SkyIoSource {
+    public:
+        MmapSource(int fd, const uint8_t *data, int64_t size, const struct timespec &mtime)
+            : fd_(fd), data_(data), size_(size), mtime_(mtime) {
+            // 整体按顺序读，内核加大预读并尽早回收已读过的页
+            madvise(const_cast<uint8_t *>(data_), static_cast<size_t>(size_), MADV_SEQUENTIAL);
+            adviseFrom(0);
+        }
+
+        ~MmapSource() override {
+            ALOG_I(TAG, "close: %lld bytes in %lld reads, %lld seeks, %lld madvise",
+                   (long long) bytesRead_, (long long) reads_, (long long) seeks_, (long long) advises_);
+            munmap(const_cast<uint8_t *>(data_), static_cast<size_t>(size_));
+            ::close(fd_);
+        }
+
+        int read(uint8_t *buf, int size) override {
+            // 拷贝区间越过上次确认过的范围或靠近尾部时，先确认文件没有被改动
+            if (!fileChanged_ && (pos_ + size > checkedUntil_ || pos_ + size > size_ - MMAP_IO_TAIL_CHECK)) {
+                checkFile(pos_ + size);
+            }
+            if (fileChanged_) {
+                return readFile(buf, size);
+            }
+            if (pos_ >= size_) {
+                return AVERROR_EOF;
+            }
+            auto n = static_cast<int>(std::min<int64_t>(size, size_ - pos_));
+            memcpy(buf, data_ + pos_, static_cast<size_t>(n));
+            pos_ += n;
+            bytesRead_ += n;
+            reads_++;
+            if (pos_ >= advisedEnd_ - MMAP_IO_READAHEAD / 2) {
+                adviseFrom(pos_);
+            }
+            return n;
+        }
+
+        int64_t seek(int64_t offset, int whence) override {
+            int64_t pos;
+            switch (whence & ~AVSEEK_FORCE) {
+                case AVSEEK_SIZE:
+                    return fileSize();
+                case SEEK_SET:
+                    pos = offset;
+                    break;
+                case SEEK_CUR:
+                    pos = pos_ + offset;
+                    break;
+                case SEEK_END:
+                    pos = fileSize() + offset;
+                    break;
+                default:
+                    return AVERROR(EINVAL);
+            }
+            if (pos < 0) {
+                return AVERROR(EINVAL);
+            }
+            // 跳到预读窗口之外（用户 seek、mov 的 moov 在文件尾）时在新位置重新预读
+            if (!fileChanged_ && (pos < advisedStart_ || pos >= advisedEnd_)) {
+                adviseFrom(pos);
+            }
+            // 下一次读取先确认文件大小
+            checkedUntil_ = std::min(checkedUntil_, pos);
+            pos_ = pos;
+            seeks_++;
+            return pos_;
+        }
+
+    private:
+        // 大小和修改时间都没变时，确认到 end 之后再半个预读窗口；变了就一直改用 pread，
+        // 大小不变但修改时间变了说明文件正被改写，随时可能截短
+        void checkFile(int64_t end) {
+            checkedUntil_ = end + MMAP_IO_READAHEAD / 2;
+            struct stat st{};
+            if (fstat(fd_, &st) == 0 && st.st_size == size_ && st.st_mtim.tv_sec == mtime_.tv_sec
+                && st.st_mtim.tv_nsec == mtime_.tv_nsec) {
+                return;
+            }
+            ALOG_W(TAG, "file changed: size %lld -> %lld, read with pread", (long long) size_,
+                   (long long) st.st_size);
+            fileChanged_ = true;
+        }
+
+        int64_t fileSize() const {
+            if (!fileChanged_) {
+                return size_;
+            }
+            struct stat st;
+            return fstat(fd_, &st) == 0 ? st.st_size : AVERROR(errno);
+        }
+
+        int readFile(uint8_t *buf, int size) {
+            ssize_t n = pread(fd_, buf, static_cast<size_t>(size), pos_);
+            if (n < 0) {
+                return AVERROR(errno);
+            }
+            if (n == 0) {
+                return AVERROR_EOF;
+            }
+            pos_ += n;
+            bytesRead_ += n;
+            reads_++;
+            return static_cast<int>(n);
+        }
+
+        void adviseFrom(int64_t pos) {
+            // madvise 的起点须按页对齐
+            static const int64_t pageSize = sysconf(_SC_PAGESIZE);
+            const int64_t start = std::min(pos, size_) / pageSize * pageSize;
+            const int64_t end = std::min(start + MMAP_IO_READAHEAD, size_);
+            if (end > start) {
+                madvise(const_cast<uint8_t *>(data_ + start), static_cast<size_t>(end - start), MADV_WILLNEED);
+                advises_++;
+            }
+            advisedStart_ = start;
+            advisedEnd_ = end;
+        }
+
+    private:
+        // 保持打开，用来确认文件大小和改用 pread
+        const int fd_;
+        const uint8_t *data_;
+        const int64_t size_;
+        const struct timespec mtime_;
+        int64_t pos_ = 0;
+        int64_t checkedUntil_ = 0;
+        bool fileChanged_ = false;
+        int64_t advisedStart_ = 0;
+        int64_t advisedEnd_ = 0;
+        int64_t bytesRead_ = 0;
+        int64_t reads_ = 0;
+        int64_t seeks_ = 0;
+        int64_t advises_ = 0;
+    };
+}
+
+bool SkyMmapIo::isLocalFile(const char *url) {
+    return url && (url[0] == '/' || strncmp(url, "file:", 5) == 0);
+}
+
+AVIOContext *SkyMmapIo::open(const char *url) {
+    if (!isLocalFile(url)) {
+        return nullptr;
+    }
+    const char *path = url;
+    if (strncmp(path, "file://", 7) == 0) {
+        path += 7;
+    } else if (strncmp(path, "file:", 5) == 0) {
+        path += 5;
+    }
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0
+        || (sizeof(void *) < 8 && st.st_size > MMAP_IO_MAX_SIZE_32BIT)) {
+        ::close(fd);
+        return nullptr;
+    }
+    if (time(nullptr) - st.st_mtime < MMAP_IO_STABLE_SECONDS) {
+        ALOG_I(TAG, "%s modified recently, may be still written, skip mmap", path);
+        ::close(fd);
+        return nullptr;
+    }
+    void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == data) {
+        ALOG_W(TAG, "mmap %s failed: %s", path, strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+
+    AVIOContext *pb = SkyIo::wrap(std::make_unique<MmapSource>(fd, static_cast<const uint8_t *>(data), st.st_size,
+                                                               st.st_mtim), MMAP_IO_BUFFER_SIZE);
+    if (nullptr == pb) {
+        return nullptr;
+    }
+    // 大于 buffer 或 direct 时 avio_read 直接调用 read_packet 写进调用方的内存
+    pb->direct = 1;
+    ALOG_I(TAG, "mmap %s, %lld bytes", path, (long long) st.st_size);
+    return pb;
+}
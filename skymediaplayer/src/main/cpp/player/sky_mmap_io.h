@@ -0,0 +1,33 @@
+#ifndef SKY_MMAP_IO_H
+#define SKY_MMAP_IO_H
+
+#include "sky_io.h"
+
+// mmap 数据源的 AVIOContext buffer，只承接头部解析等小块读取，大块读取直接拷进 packet
+#define MMAP_IO_BUFFER_SIZE (256 * 1024)
+// 播放位置之前预读的窗口，越过半个窗口时再提示一次
+#define MMAP_IO_READAHEAD (8 * 1024 * 1024)
+// 32 位进程地址空间有限，超过这个大小的文件仍走 FFmpeg 的 file 协议
+#define MMAP_IO_MAX_SIZE_32BIT (1024LL * 1024 * 1024)
+// 最近这段时间内修改过的文件可能正在写入（录制、下载），仍走 file 协议
+#define MMAP_IO_STABLE_SECONDS 2
+// 读到映射尾部这个范围内时每次都确认文件大小
+#define MMAP_IO_TAIL_CHECK (1024 * 1024)
+
+/**
+ * 本地文件整体 mmap 后作为 read_thread 的数据源：读取不再走 read() 系统调用，
+ * AVIOContext 设为 direct，av_read_frame 的大块读取从映射页直接拷进 packet，少一次经过 AVIO buffer 的拷贝。
+ * 按播放位置用 madvise 提示内核预读。
+ * 映射只覆盖打开时的大小，文件被截短后访问截掉的页会 SIGBUS：每次拷贝越过上次确认的范围（半个预读窗口）
+ * 或落在尾部附近时先 fstat，大小或修改时间变化后改用 pread 读取（追加的数据也能读到）。
+ * fstat 与拷贝之间被截短仍然可能 SIGBUS。
+ */
+class SkyMmapIo {
+public:
+    // 绝对路径或 file: URL
+    static bool isLocalFile(const char *url);
+    // 映射失败时返回 nullptr，由 FFmpeg 按原路径打开
+    static AVIOContext *open(const char *url);
+};
+
+#endif // SKY_MMAP_IO_H
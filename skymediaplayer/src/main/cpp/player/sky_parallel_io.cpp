@@ -0,0 +1,355 @@
+extern "C" {
+#include "libavutil/error.h"
+#include "libavutil/time.h"
+}
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "sky_parallel_io.h"
+
+static const char* TAG = "SkyParallelIo";
+
+// 读线程等数据时检查中断的间隔
+#define PARALLEL_IO_WAIT_MS 10
+// 下载线程每次读取的大小，读到就交给读线程
+#define PARALLEL_IO_READ_SIZE (64 * 1024)
+
+namespace {
+    struct Chunk {
+        enum State {
+            PENDING,
+            RUNNING,
+            DONE,
+            FAILED,
+        };
+
+        int64_t start = 0;
+        int64_t length = 0;
+        // 下载线程写、读线程读，[0, filled) 已就绪，filled 由 mutex_ 保护
+        std::vector<uint8_t> data;
+        int64_t filled = 0;
+        State state = PENDING;
+        int error = 0;
+        // 连续失败的次数，有进展后清零
+        int retries = 0;
+        // 退避中的块在这个时间（av_gettime_relative）之后才重新下载
+        int64_t retryAt = 0;
+        std::atomic<bool> cancelled{false};
+        // 探测大小时已打开的第一个块的连接，省一次握手
+        AVIOContext *preopened = nullptr;
+    };
+
+    int chunkInterruptCallback(void *opaque) {
+        return static_cast<Chunk *>(opaque)->cancelled.load() ? 1 : 0;
+    }
+
+    /**
+     * 按块并发下载，读线程按顺序取用
+     */
+    class ParallelSource : public SkyIoSource {
+    public:
+        ParallelSource(std::string url, const AVIOInterruptCB *interrupt, AVIOContext *probe, int64_t size)
+            : url_(std::move(url))
+            , interrupt_(interrupt ? *interrupt : AVIOInterruptCB{})
+            , size_(size)
+            , startTime_(av_gettime_relative()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            scheduleLocked(0);
+            chunks_[0]->preopened = probe;
+            for (int i = 0; i < PARALLEL_IO_CONNECTIONS; i++) {
+                workers_.emplace_back([this]() {
+                    this->run();
+                });
+            }
+        }
+
+        ~ParallelSource() override {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                abort_ = true;
+                for (auto &it : chunks_) {
+                    it.second->cancelled.store(true);
+                }
+            }
+            workCond_.notify_all();
+            for (auto &worker : workers_) {
+                if (worker.joinable()) {
+                    worker.join();
+                }
+            }
+            for (auto &it : chunks_) {
+                avio_closep(&it.second->preopened);
+            }
+            const int64_t elapsedMs = std::max<int64_t>((av_gettime_relative() - startTime_) / 1000, 1);
+            ALOG_I(TAG, "close %s: %lld bytes downloaded in %lld ms (%lld kbps), %d chunks, %d cancelled, %d retried",
+                   url_.c_str(), (long long) downloaded_, (long long) elapsedMs,
+                   (long long) (downloaded_ * 8 / elapsedMs), chunkCount_, cancelCount_, retryCount_);
+        }
+
+        int read(uint8_t *buf, int size) override {
+            if (pos_ >= size_) {
+                return AVERROR_EOF;
+            }
+            const int64_t index = pos_ / PARALLEL_IO_CHUNK_SIZE;
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            scheduleLocked(index);
+            std::shared_ptr<Chunk> chunk = chunks_[index];
+            const int64_t offset = pos_ - chunk->start;
+            while (chunk->filled <= offset) {
+                // 重试由下载线程安排，到这里已经用完重试次数
+                if (chunk->state == Chunk::FAILED) {
+                    ALOG_E(TAG, "chunk at %lld failed: %d", (long long) chunk->start, chunk->error);
+                    return chunk->error;
+                }
+                if (interrupt_.callback && interrupt_.callback(interrupt_.opaque)) {
+                    return AVERROR_EXIT;
+                }
+                dataCond_.wait_for(lock, std::chrono::milliseconds(PARALLEL_IO_WAIT_MS));
+            }
+
+            auto n = static_cast<int>(std::min<int64_t>(size, chunk->filled - offset));
+            memcpy(buf, chunk->data.data() + offset, static_cast<size_t>(n));
+            pos_ += n;
+            return n;
+        }
+
+        int64_t seek(int64_t offset, int whence) override {
+            int64_t pos;
+            switch (whence & ~AVSEEK_FORCE) {
+                case AVSEEK_SIZE:
+                    return size_;
+                case SEEK_SET:
+                    pos = offset;
+                    break;
+                case SEEK_CUR:
+                    pos = pos_ + offset;
+                    break;
+                case SEEK_END:
+                    pos = size_ + offset;
+                    break;
+                default:
+                    return AVERROR(EINVAL);
+            }
+            if (pos < 0) {
+                return AVERROR(EINVAL);
+            }
+            // 窗口在下一次 read 时按新位置调整
+            pos_ = pos;
+            return pos_;
+        }
+
+    private:
+        // 窗口移到 index：取消并释放窗口外的块，补上窗口内缺少的块
+        void scheduleLocked(int64_t index) {
+            const int64_t last = std::min<int64_t>(index + PARALLEL_IO_WINDOW,
+                                                   (size_ + PARALLEL_IO_CHUNK_SIZE - 1) / PARALLEL_IO_CHUNK_SIZE);
+            for (auto it = chunks_.begin(); it != chunks_.end();) {
+                // 保留前一个已有数据的块，demuxer 小幅回退时不必重新下载
+                const bool keep = (it->first >= index && it->first < last)
+                                  || (it->first == index - 1 && it->second->filled > 0);
+                if (keep) {
+                    ++it;
+                    continue;
+                }
+                if (it->second->state == Chunk::RUNNING) {
+                    it->second->cancelled.store(true);
+                    cancelCount_++;
+                }
+                avio_closep(&it->second->preopened);
+                it = chunks_.erase(it);
+            }
+
+            bool added = false;
+            for (int64_t i = index; i < last; i++) {
+                auto &chunk = chunks_[i];
+                if (chunk) {
+                    continue;
+                }
+                chunk = std::make_shared<Chunk>();
+                chunk->start = i * PARALLEL_IO_CHUNK_SIZE;
+                chunk->length = std::min<int64_t>(PARALLEL_IO_CHUNK_SIZE, size_ - chunk->start);
+                chunk->data.resize(static_cast<size_t>(chunk->length));
+                chunkCount_++;
+                added = true;
+            }
+            if (added) {
+                workCond_.notify_all();
+            }
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!abort_) {
+                // chunks_ 按偏移排序，离读位置最近的先下载；退避中的块等到时间再取
+                std::shared_ptr<Chunk> chunk;
+                int64_t wakeAt = 0;
+                const int64_t now = av_gettime_relative();
+                for (auto &it : chunks_) {
+                    if (it.second->state != Chunk::PENDING) {
+                        continue;
+                    }
+                    if (it.second->retryAt <= now) {
+                        chunk = it.second;
+                        break;
+                    }
+                    if (wakeAt == 0 || it.second->retryAt < wakeAt) {
+                        wakeAt = it.second->retryAt;
+                    }
+                }
+                if (!chunk) {
+                    if (wakeAt > 0) {
+                        workCond_.wait_for(lock, std::chrono::microseconds(wakeAt - now));
+                    } else {
+                        workCond_.wait(lock);
+                    }
+                    continue;
+                }
+
+                chunk->state = Chunk::RUNNING;
+                AVIOContext *pb = chunk->preopened;
+                chunk->preopened = nullptr;
+                const int64_t filledBefore = chunk->filled;
+                lock.unlock();
+                int ret = fetch(chunk.get(), pb);
+                lock.lock();
+
+                if (chunk->filled == chunk->length) {
+                    chunk->state = Chunk::DONE;
+                } else if (!chunk->cancelled.load() && (chunk->filled > filledBefore
+                                                        || chunk->retries < PARALLEL_IO_RETRIES)) {
+                    // 从断点重试，等待时间按连续失败次数翻倍
+                    chunk->retries = chunk->filled > filledBefore ? 1 : chunk->retries + 1;
+                    const int64_t delayMs = static_cast<int64_t>(PARALLEL_IO_RETRY_DELAY_MS) << (chunk->retries - 1);
+                    chunk->retryAt = av_gettime_relative() + delayMs * 1000;
+                    chunk->state = Chunk::PENDING;
+                    retryCount_++;
+                    ALOG_W(TAG, "chunk at %lld stopped at %lld: %d, retry %d in %lld ms", (long long) chunk->start,
+                           (long long) chunk->filled, ret, chunk->retries, (long long) delayMs);
+                } else {
+                    chunk->state = Chunk::FAILED;
+                    chunk->error = ret < 0 ? ret : AVERROR_EOF;
+                }
+                dataCond_.notify_all();
+            }
+        }
+
+        int fetch(Chunk *chunk, AVIOContext *pb) {
+            // 只有这个线程修改 filled，读取不需要加锁
+            const int64_t from = chunk->start + chunk->filled;
+            const int64_t end = chunk->start + chunk->length;
+            int ret = 0;
+            if (nullptr == pb) {
+                const AVIOInterruptCB interrupt = {chunkInterruptCallback, chunk};
+                ret = SkyIo::openUpstream(url_, &interrupt, &pb, from, end);
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+
+            while (!chunk->cancelled.load() && chunk->filled < chunk->length) {
+                int size = static_cast<int>(std::min<int64_t>(PARALLEL_IO_READ_SIZE, chunk->length - chunk->filled));
+                ret = avio_read_partial(pb, chunk->data.data() + chunk->filled, size);
+                if (ret <= 0) {
+                    ret = ret == 0 ? AVERROR_EOF : ret;
+                    break;
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                chunk->filled += ret;
+                downloaded_ += ret;
+                dataCond_.notify_all();
+            }
+            avio_closep(&pb);
+            return ret < 0 ? ret : 0;
+        }
+
+    private:
+        const std::string url_;
+        const AVIOInterruptCB interrupt_;
+        const int64_t size_;
+        const int64_t startTime_;
+        // 只在读线程中使用
+        int64_t pos_ = 0;
+
+        std::mutex mutex_;
+        std::condition_variable workCond_;
+        std::condition_variable dataCond_;
+        bool abort_ = false;
+        std::map<int64_t, std::shared_ptr<Chunk>> chunks_;
+        std::vector<std::thread> workers_;
+        int64_t downloaded_ = 0;
+        int chunkCount_ = 0;
+        int cancelCount_ = 0;
+        int retryCount_ = 0;
+    };
+
+    /**
+     * 服务器不支持 range 或大小未知：单连接顺序读取
+     */
+    class SerialSource : public SkyIoSource {
+    public:
+        explicit SerialSource(AVIOContext *upstream) : upstream_(upstream) {
+        }
+
+        ~SerialSource() override {
+            avio_closep(&upstream_);
+        }
+
+        int read(uint8_t *buf, int size) override {
+            int ret = avio_read_partial(upstream_, buf, size);
+            return ret == 0 ? AVERROR_EOF : ret;
+        }
+
+        int64_t seek(int64_t offset, int whence) override {
+            if (whence & AVSEEK_SIZE) {
+                return avio_size(upstream_);
+            }
+            return avio_seek(upstream_, offset, whence);
+        }
+
+    private:
+        AVIOContext *upstream_;
+    };
+}
+
+bool SkyParallelIo::isParallelUrl(const char *url) {
+    return url && strncmp(url, PARALLEL_IO_SCHEME, strlen(PARALLEL_IO_SCHEME)) == 0;
+}
+
+AVIOContext *SkyParallelIo::open(const char *url, const AVIOInterruptCB *interrupt) {
+    if (!isParallelUrl(url)) {
+        return nullptr;
+    }
+    const std::string upstreamUrl(url + strlen(PARALLEL_IO_SCHEME));
+
+    // 第一个块的请求同时用来探测大小和 range 支持，连接留给第一个块继续读
+    AVIOContext *probe = nullptr;
+    if (SkyIo::openUpstream(upstreamUrl, interrupt, &probe, 0, PARALLEL_IO_CHUNK_SIZE) < 0) {
+        return nullptr;
+    }
+    const int64_t size = avio_size(probe);
+    if (size <= PARALLEL_IO_CHUNK_SIZE || !(probe->seekable & AVIO_SEEKABLE_NORMAL)) {
+        ALOG_W(TAG, "%s: size %lld, seekable %d, fall back to one connection",
+               upstreamUrl.c_str(), (long long) size, probe->seekable);
+        if (size < 0 || size > PARALLEL_IO_CHUNK_SIZE) {
+            // 探测请求只要了第一个块，重新打开完整的请求
+            avio_closep(&probe);
+            if (SkyIo::openUpstream(upstreamUrl, interrupt, &probe) < 0) {
+                return nullptr;
+            }
+        }
+        return SkyIo::wrap(std::make_unique<SerialSource>(probe));
+    }
+
+    ALOG_I(TAG, "%s: %lld bytes, %d connections x %d bytes", upstreamUrl.c_str(), (long long) size,
+           PARALLEL_IO_CONNECTIONS, PARALLEL_IO_CHUNK_SIZE);
+    return SkyIo::wrap(std::make_unique<ParallelSource>(upstreamUrl, interrupt, probe, size));
+}
@@ -0,0 +1,30 @@
+#ifndef SKY_PARALLEL_IO_H
+#define SKY_PARALLEL_IO_H
+
+#include "sky_io.h"
+
+// data source 加上这个前缀时用多个 http range 请求并行下载，如 skyparallel:https://...
+#define PARALLEL_IO_SCHEME "skyparallel:"
+// 每个 range 请求的大小
+#define PARALLEL_IO_CHUNK_SIZE (1024 * 1024)
+// 同时下载的连接数
+#define PARALLEL_IO_CONNECTIONS 4
+// 读位置之后最多预读的块数，决定单个播放器的内存占用
+#define PARALLEL_IO_WINDOW 8
+// 单个块连续失败后从断点重试的次数
+#define PARALLEL_IO_RETRIES 3
+// 第一次重试前的等待，之后每次翻倍，避免服务器或链路出错时立刻重连
+#define PARALLEL_IO_RETRY_DELAY_MS 250
+
+/**
+ * 渐进式 MP4/MKV 的多连接下载：读位置之后的若干块由多个连接并发请求，
+ * 按偏移顺序拼成连续的流交给 demuxer；seek 跳出窗口时取消窗口外还在下载的块。
+ * 高延迟链路上单连接受限于 TCP 窗口，多连接可以接近链路带宽。服务器不支持 range 时退回单连接顺序读取。
+ */
+class SkyParallelIo {
+public:
+    static bool isParallelUrl(const char *url);
+    static AVIOContext *open(const char *url, const AVIOInterruptCB *interrupt);
+};
+
+#endif // SKY_PARALLEL_IO_H
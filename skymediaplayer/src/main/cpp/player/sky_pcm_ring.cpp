@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstring>
+
+#include "sky_pcm_ring.h"
+
+void SkyPcmRing::init(size_t capacity) {
+    buffer_.assign(capacity, 0);
+    reset();
+}
+
+void SkyPcmRing::reset() {
+    readIndex_.store(0, std::memory_order_relaxed);
+    writeIndex_.store(0, std::memory_order_relaxed);
+    flushIndex_.store(0, std::memory_order_relaxed);
+}
+
+size_t SkyPcmRing::availableToRead() const {
+    uint64_t write = writeIndex_.load(std::memory_order_acquire);
+    uint64_t read = std::max(readIndex_.load(std::memory_order_acquire), flushIndex_.load(std::memory_order_acquire));
+    return write > read ? static_cast<size_t>(write - read) : 0;
+}
+
+size_t SkyPcmRing::availableToWrite() const {
+    uint64_t write = writeIndex_.load(std::memory_order_relaxed);
+    uint64_t read = readIndex_.load(std::memory_order_acquire);
+    return buffer_.size() - static_cast<size_t>(write - read);
+}
+
+uint8_t* SkyPcmRing::beginWrite(size_t *contiguous) {
+    if (buffer_.empty()) {
+        *contiguous = 0;
+        return nullptr;
+    }
+    uint64_t write = writeIndex_.load(std::memory_order_relaxed);
+    size_t offset = static_cast<size_t>(write % buffer_.size());
+    *contiguous = std::min(availableToWrite(), buffer_.size() - offset);
+    return buffer_.data() + offset;
+}
+
+void SkyPcmRing::commitWrite(size_t bytes) {
+    writeIndex_.fetch_add(bytes, std::memory_order_release);
+}
+
+size_t SkyPcmRing::write(const uint8_t *src, size_t bytes) {
+    size_t written = 0;
+    while (written < bytes) {
+        size_t contiguous = 0;
+        uint8_t *dst = beginWrite(&contiguous);
+        size_t count = std::min(contiguous, bytes - written);
+        if (count == 0) {
+            break;
+        }
+        memcpy(dst, src + written, count);
+        commitWrite(count);
+        written += count;
+    }
+    return written;
+}
+
+void SkyPcmRing::markFlush() {
+    flushIndex_.store(writeIndex_.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+size_t SkyPcmRing::read(uint8_t *dst, size_t bytes) {
+    if (buffer_.empty()) {
+        return 0;
+    }
+
+    uint64_t read = readIndex_.load(std::memory_order_relaxed);
+    uint64_t flush = flushIndex_.load(std::memory_order_acquire);
+    if (flush > read) {
+        read = flush;
+    }
+    uint64_t write = writeIndex_.load(std::memory_order_acquire);
+    size_t count = std::min(bytes, write > read ? static_cast<size_t>(write - read) : size_t(0));
+
+    size_t offset = static_cast<size_t>(read % buffer_.size());
+    size_t first = std::min(count, buffer_.size() - offset);
+    memcpy(dst, buffer_.data() + offset, first);
+    if (count > first) {
+        memcpy(dst + first, buffer_.data(), count - first);
+    }
+    readIndex_.store(read + count, std::memory_order_release);
+    return count;
+}
+
+size_t SkyPcmRing::peekRecent(uint8_t *dst, size_t bytes, size_t lagBytes, uint64_t *endIndex) const {
+    uint64_t read = readIndex_.load(std::memory_order_acquire);
+    uint64_t end = read > lagBytes ? read - lagBytes : 0;
+    *endIndex = end;
+    if (buffer_.empty() || bytes == 0 || bytes + lagBytes > buffer_.size() || end < bytes) {
+        return 0;
+    }
+
+    uint64_t start = end - bytes;
+    size_t offset = static_cast<size_t>(start % buffer_.size());
+    size_t first = std::min(bytes, buffer_.size() - offset);
+    memcpy(dst, buffer_.data() + offset, first);
+    if (bytes > first) {
+        memcpy(dst + first, buffer_.data(), bytes - first);
+    }
+
+    // 生产者最多写到 readIndex + capacity，写位置越过 start + capacity 说明拷贝的数据已被覆盖
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (writeIndex_.load(std::memory_order_relaxed) > start + buffer_.size()) {
+        return 0;
+    }
+    return bytes;
+}
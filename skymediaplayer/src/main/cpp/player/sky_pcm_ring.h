@@ -0,0 +1,53 @@
+#ifndef SKY_PCM_RING_H
+#define SKY_PCM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 单生产者单消费者的 PCM 环形缓冲，读写两端都不加锁、不分配内存。
+ * 生产者为解码/重采样线程，消费者为实时输出线程。
+ */
+class SkyPcmRing {
+public:
+    // 只能在两端线程都没有运行时调用
+    void init(size_t capacity);
+    void reset();
+
+    size_t capacity() const { return buffer_.size(); }
+    size_t availableToRead() const;
+    size_t availableToWrite() const;
+
+    /**
+     * 生产者：取得可连续写入的区域，写完后 commitWrite
+     * @param contiguous 返回可连续写入的字节数
+     */
+    uint8_t* beginWrite(size_t *contiguous);
+    void commitWrite(size_t bytes);
+    // 生产者：拷贝写入，空间不足时只写能放下的部分，返回写入的字节数
+    size_t write(const uint8_t *src, size_t bytes);
+
+    // 生产者：把目前已写入的数据标记为作废，消费者下次读取时跳过
+    void markFlush();
+
+    // 消费者：最多读取 bytes 字节，返回实际读取的字节数
+    size_t read(uint8_t *dst, size_t bytes);
+
+    /**
+     * 第三方线程：拷贝消费者读走的数据中，结束于读位置之前 lagBytes 处的 bytes 字节，不移动读写位置。
+     * 拷贝期间这段数据被生产者覆盖时返回 0，否则返回 bytes
+     * @param endIndex 返回这段数据结束处的位置，与上次相同说明没有新数据
+     */
+    size_t peekRecent(uint8_t *dst, size_t bytes, size_t lagBytes, uint64_t *endIndex) const;
+
+private:
+    std::vector<uint8_t> buffer_;
+    // 单调递增的读写位置，取模得到 buffer_ 中的偏移
+    std::atomic<uint64_t> readIndex_{0};
+    std::atomic<uint64_t> writeIndex_{0};
+    std::atomic<uint64_t> flushIndex_{0};
+};
+
+#endif // SKY_PCM_RING_H
@@ -0,0 +1,62 @@
+#include <thread>
+
+#include "sky_pcm_tap.h"
+
+void SkyPcmTap::attach(SkyPcmRing *ring) {
+    ring_.store(ring, std::memory_order_seq_cst);
+}
+
+void SkyPcmTap::detach(SkyPcmRing *ring) {
+    ring_.compare_exchange_strong(ring, nullptr, std::memory_order_seq_cst);
+    // 生产者先置 writing_ 再读 ring_，都是 seq_cst：这里看到 writing_ 为 false 后，它之后不会再读到旧的 ring
+    while (writing_.load(std::memory_order_seq_cst)) {
+        std::this_thread::yield();
+    }
+}
+
+void SkyPcmTap::write(const uint8_t *data, size_t bytes, int format, int channels, int sampleRate) {
+    if (nullptr == data || bytes == 0) {
+        return;
+    }
+    writing_.store(true, std::memory_order_seq_cst);
+    SkyPcmRing *ring = ring_.load(std::memory_order_seq_cst);
+    if (ring) {
+        SkyPcmTapHeader header{};
+        header.sampleRate = sampleRate;
+        header.channels = static_cast<int16_t>(channels);
+        header.format = static_cast<int16_t>(format);
+        header.bytes = static_cast<uint32_t>(bytes);
+        // 整块放得下才写，消费方不会读到半块
+        if (ring->availableToWrite() >= sizeof(header) + bytes) {
+            ring->write(reinterpret_cast<const uint8_t *>(&header), sizeof(header));
+            ring->write(data, bytes);
+        } else {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    writing_.store(false, std::memory_order_release);
+}
+
+bool SkyPcmTapReader::next(SkyPcmRing &ring, SkyPcmTapChunk *chunk) {
+    if (!hasHeader_) {
+        if (ring.availableToRead() < sizeof(header_)) {
+            return false;
+        }
+        ring.read(reinterpret_cast<uint8_t *>(&header_), sizeof(header_));
+        hasHeader_ = true;
+    }
+    // 生产者连续写入块头和数据，块头之后的数据很快就会到齐
+    if (ring.availableToRead() < header_.bytes) {
+        return false;
+    }
+    payload_.resize(header_.bytes);
+    ring.read(payload_.data(), payload_.size());
+    hasHeader_ = false;
+
+    chunk->sampleRate = header_.sampleRate;
+    chunk->channels = header_.channels;
+    chunk->format = header_.format;
+    chunk->data = payload_.data();
+    chunk->bytes = payload_.size();
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef SKY_PCM_TAP_H
+#define SKY_PCM_TAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sky_pcm_ring.h"
+
+// 每块 PCM 之前的块头，格式变化（重新打开音频、切换音轨）随数据一起到达消费方
+struct SkyPcmTapHeader {
+    int32_t sampleRate;
+    int16_t channels;
+    // AVSampleFormat，只会是交错的 S16 或 FLT
+    int16_t format;
+    uint32_t bytes;
+    uint32_t reserved;
+};
+
+struct SkyPcmTapChunk {
+    int sampleRate = 0;
+    int channels = 0;
+    int format = -1;
+    // 交错 PCM，按 format 解释
+    const uint8_t *data = nullptr;
+    size_t bytes = 0;
+};
+
+/**
+ * 重采样后的 PCM 旁路，供响度计量、音频分析等使用。
+ * 音频解码线程把数据原样写入消费方持有的 SPSC ring，不加锁、不分配内存、不等待，
+ * ring 放不下整块时丢弃这一块；没有消费方时 ffplay 只多一次分支判断。
+ */
+class SkyPcmTap {
+public:
+    // 消费方：挂上自己的 ring，替换已有的消费方
+    void attach(SkyPcmRing *ring);
+    // 消费方：摘除自己的 ring（已被替换时不影响新的消费方），返回后生产者不会再访问它
+    void detach(SkyPcmRing *ring);
+
+    // 音频解码线程调用
+    void write(const uint8_t *data, size_t bytes, int format, int channels, int sampleRate);
+
+    // 因 ring 空间不足丢弃的块数
+    uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<SkyPcmRing *> ring_{nullptr};
+    // 生产者正在写 ring，摘除时等它写完
+    std::atomic<bool> writing_{false};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+/**
+ * 消费方按块读取 SkyPcmTap 写入的数据，只在消费线程使用
+ */
+class SkyPcmTapReader {
+public:
+    // 读出下一个完整的块，数据不足一块时返回 false；chunk.data 在下一次调用前有效
+    bool next(SkyPcmRing &ring, SkyPcmTapChunk *chunk);
+
+private:
+    SkyPcmTapHeader header_{};
+    bool hasHeader_ = false;
+    std::vector<uint8_t> payload_;
+};
+
+#endif // SKY_PCM_TAP_H
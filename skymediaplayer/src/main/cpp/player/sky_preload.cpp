@@ -0,0 +1,549 @@
+extern "C" {
+#include "libavformat/avformat.h"
+#include "libavutil/time.h"
+}
+
+#include <algorithm>
+#include <cstring>
+#include <sys/resource.h>
+
+#include "logger.h"
+#include "sky_preload.h"
+
+static const char* TAG = "SkyPreload";
+
+// 下载线程的 nice 值，与 Android 的 THREAD_PRIORITY_BACKGROUND 相同
+#define PRELOAD_NICE 10
+
+// ============================================================================
+// SkyPreloadEntry
+// ============================================================================
+
+size_t SkyPreloadEntry::read(int64_t pos, uint8_t *dst, size_t size) const {
+    auto it = ranges_.upper_bound(pos);
+    if (it == ranges_.begin()) {
+        return 0;
+    }
+    --it;
+    const int64_t offset = pos - it->first;
+    if (offset >= static_cast<int64_t>(it->second.size())) {
+        return 0;
+    }
+    size_t n = std::min(size, it->second.size() - static_cast<size_t>(offset));
+    memcpy(dst, it->second.data() + offset, n);
+    return n;
+}
+
+size_t SkyPreloadEntry::write(int64_t pos, const uint8_t *src, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    // 接到包含 pos 或恰好在 pos 结束的区间后面，否则新建区间
+    auto it = ranges_.upper_bound(pos);
+    if (it != ranges_.begin() && std::prev(it)->first + static_cast<int64_t>(std::prev(it)->second.size()) >= pos) {
+        --it;
+    } else {
+        it = ranges_.emplace(pos, std::vector<uint8_t>()).first;
+    }
+
+    std::vector<uint8_t> &data = it->second;
+    int64_t covered = static_cast<int64_t>(data.size());
+    const int64_t end = pos + static_cast<int64_t>(size);
+    if (end > it->first + static_cast<int64_t>(data.size())) {
+        size_t skip = static_cast<size_t>(it->first + static_cast<int64_t>(data.size()) - pos);
+        data.insert(data.end(), src + skip, src + size);
+    }
+
+    // 合并被覆盖或相邻的后续区间
+    auto next = std::next(it);
+    while (next != ranges_.end() && next->first <= it->first + static_cast<int64_t>(data.size())) {
+        const int64_t dataEnd = it->first + static_cast<int64_t>(data.size());
+        const int64_t nextEnd = next->first + static_cast<int64_t>(next->second.size());
+        if (nextEnd > dataEnd) {
+            data.insert(data.end(), next->second.begin() + (dataEnd - next->first), next->second.end());
+        }
+        covered += static_cast<int64_t>(next->second.size());
+        next = ranges_.erase(next);
+    }
+
+    size_t added = static_cast<size_t>(static_cast<int64_t>(data.size()) - covered);
+    bytes_ += static_cast<int64_t>(added);
+    return added;
+}
+
+int64_t SkyPreloadEntry::nextRangeStart(int64_t pos) const {
+    auto it = ranges_.upper_bound(pos);
+    return it == ranges_.end() ? -1 : it->first;
+}
+
+// ============================================================================
+// 播放器读取：命中从内存读，未命中回源
+// ============================================================================
+
+class SkyPreloadManager::Source : public SkyIoSource {
+public:
+    Source(SkyPreloadManager &manager, std::shared_ptr<SkyPreloadEntry> entry,
+           const AVIOInterruptCB *interrupt, int64_t size)
+        : manager_(manager)
+        , entry_(std::move(entry))
+        , interrupt_(interrupt ? *interrupt : AVIOInterruptCB{})
+        , size_(size) {
+    }
+
+    ~Source() override {
+        ALOG_I(TAG, "close %s: %lld bytes from preload, %lld bytes from network",
+               entry_->url.c_str(), (long long) hitBytes_, (long long) missBytes_);
+        avio_closep(&upstream_);
+        manager_.release(entry_.get());
+    }
+
+    int read(uint8_t *buf, int size) override {
+        int64_t nextStart = -1;
+        size_t n = manager_.readCached(entry_.get(), pos_, buf, static_cast<size_t>(size), &nextStart);
+        if (n > 0) {
+            pos_ += static_cast<int64_t>(n);
+            hitBytes_ += static_cast<int64_t>(n);
+            return static_cast<int>(n);
+        }
+        if (size_ >= 0 && pos_ >= size_) {
+            return AVERROR_EOF;
+        }
+
+        int ret = ensureUpstream();
+        if (ret < 0) {
+            return ret;
+        }
+        if (upstreamPos_ != pos_) {
+            int64_t pos = avio_seek(upstream_, pos_, SEEK_SET);
+            if (pos < 0) {
+                return static_cast<int>(pos);
+            }
+            upstreamPos_ = pos_;
+        }
+        // 只回源到下一个已缓存的区间为止
+        if (nextStart > pos_) {
+            size = static_cast<int>(std::min<int64_t>(size, nextStart - pos_));
+        }
+        ret = avio_read_partial(upstream_, buf, size);
+        if (ret <= 0) {
+            return ret == 0 ? AVERROR_EOF : ret;
+        }
+        pos_ += ret;
+        upstreamPos_ += ret;
+        missBytes_ += ret;
+        return ret;
+    }
+
+    int64_t seek(int64_t offset, int whence) override {
+        whence &= ~AVSEEK_FORCE;
+        if (whence == AVSEEK_SIZE || whence == SEEK_END) {
+            if (size_ < 0) {
+                if (ensureUpstream() < 0) {
+                    return AVERROR(ENOSYS);
+                }
+                size_ = avio_size(upstream_);
+            }
+            if (whence == AVSEEK_SIZE || size_ < 0) {
+                return size_;
+            }
+        }
+
+        int64_t pos;
+        switch (whence) {
+            case SEEK_SET:
+                pos = offset;
+                break;
+            case SEEK_CUR:
+                pos = pos_ + offset;
+                break;
+            case SEEK_END:
+                pos = size_ + offset;
+                break;
+            default:
+                return AVERROR(EINVAL);
+        }
+        if (pos < 0) {
+            return AVERROR(EINVAL);
+        }
+        pos_ = pos;
+        return pos_;
+    }
+
+private:
+    int ensureUpstream() {
+        if (upstream_) {
+            return 0;
+        }
+        int ret = SkyIo::openUpstream(entry_->url, &interrupt_, &upstream_);
+        upstreamPos_ = 0;
+        return ret;
+    }
+
+private:
+    SkyPreloadManager &manager_;
+    std::shared_ptr<SkyPreloadEntry> entry_;
+    AVIOInterruptCB interrupt_;
+    AVIOContext *upstream_ = nullptr;
+    int64_t size_;
+    int64_t pos_ = 0;
+    int64_t upstreamPos_ = 0;
+    int64_t hitBytes_ = 0;
+    int64_t missBytes_ = 0;
+};
+
+// ============================================================================
+// 按时长预加载：解析容器时经过的数据都存下来
+// ============================================================================
+
+class SkyPreloadManager::Tee : public SkyIoSource {
+public:
+    Tee(SkyPreloadManager &manager, Task *task, AVIOContext *upstream)
+        : manager_(manager), task_(task), upstream_(upstream) {
+    }
+
+    int read(uint8_t *buf, int size) override {
+        if (task_->cancelled.load()) {
+            return AVERROR_EXIT;
+        }
+        // 字节数或预算到上限后当作文件结束，解析随之停止
+        if (full_ || fetched_ >= task_->request.maxBytes) {
+            return AVERROR_EOF;
+        }
+        int ret = avio_read_partial(upstream_, buf, size);
+        if (ret <= 0) {
+            return ret == 0 ? AVERROR_EOF : ret;
+        }
+        {
+            std::lock_guard<std::mutex> lock(manager_.mutex_);
+            full_ = !manager_.storeLocked(task_->entry.get(), pos_, buf, static_cast<size_t>(ret));
+        }
+        pos_ += ret;
+        fetched_ += ret;
+        return ret;
+    }
+
+    int64_t seek(int64_t offset, int whence) override {
+        if (whence & AVSEEK_SIZE) {
+            return avio_size(upstream_);
+        }
+        int64_t pos = avio_seek(upstream_, offset, whence);
+        if (pos >= 0) {
+            pos_ = pos;
+        }
+        return pos;
+    }
+
+private:
+    SkyPreloadManager &manager_;
+    Task *task_;
+    AVIOContext *upstream_;
+    int64_t pos_ = 0;
+    int64_t fetched_ = 0;
+    bool full_ = false;
+};
+
+// ============================================================================
+// SkyPreloadManager
+// ============================================================================
+
+SkyPreloadManager& SkyPreloadManager::instance() {
+    static SkyPreloadManager manager;
+    return manager;
+}
+
+SkyPreloadManager::SkyPreloadManager() {
+    for (int i = 0; i < PRELOAD_WORKERS; i++) {
+        workers_.emplace_back([this]() {
+            this->run();
+        });
+    }
+}
+
+SkyPreloadManager::~SkyPreloadManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        abort_ = true;
+        for (auto &task : tasks_) {
+            task->cancelled.store(true);
+        }
+    }
+    cond_.notify_all();
+    for (auto &worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void SkyPreloadManager::setBudget(int64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = std::max<int64_t>(bytes, 0);
+    while (used_ > budget_ && evictOneLocked(nullptr)) {
+    }
+    ALOG_I(TAG, "budget %lld bytes, used %lld", (long long) budget_, (long long) used_);
+}
+
+void SkyPreloadManager::preload(const SkyPreloadRequest &request) {
+    if (!SkyIo::isHttp(request.url.c_str())) {
+        ALOG_W(TAG, "preload ignored, not a http url: %s", request.url.c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto entry = entryLocked(request.url);
+    entry->priority = request.priority;
+    entry->lastUsed = ++clock_;
+    for (auto &task : tasks_) {
+        if (task->request.url == request.url && !task->cancelled.load()) {
+            // 已在队列中：更新优先级，还没开始的同时更新上限
+            task->request.priority = request.priority;
+            if (!task->running) {
+                task->request = request;
+            }
+            return;
+        }
+    }
+    if (entry->bytes() >= request.maxBytes) {
+        return;
+    }
+
+    auto task = std::make_unique<Task>();
+    task->request = request;
+    task->entry = entry;
+    entry->pins++;
+    tasks_.push_back(std::move(task));
+    ALOG_I(TAG, "preload %s, priority %d, %lld bytes, %d ms", request.url.c_str(), request.priority,
+           (long long) request.maxBytes, request.durationMs);
+    cond_.notify_one();
+}
+
+void SkyPreloadManager::cancel(const std::string &url) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = tasks_.begin(); it != tasks_.end();) {
+        Task *task = it->get();
+        ++it;
+        if (url.empty() || task->request.url == url) {
+            cancelLocked(task);
+        }
+    }
+}
+
+int64_t SkyPreloadManager::preloadedBytes(const std::string &url) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(url);
+    return it == entries_.end() ? 0 : it->second->bytes();
+}
+
+AVIOContext *SkyPreloadManager::openIo(const char *url, const AVIOInterruptCB *interrupt) {
+    if (!SkyIo::isHttp(url)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<SkyPreloadEntry> entry;
+    int64_t size;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 播放器接手后预加载不再和它抢带宽
+        for (auto it = tasks_.begin(); it != tasks_.end();) {
+            Task *task = it->get();
+            ++it;
+            if (task->request.url == url) {
+                cancelLocked(task);
+            }
+        }
+        auto it = entries_.find(url);
+        if (it == entries_.end() || it->second->bytes() == 0) {
+            return nullptr;
+        }
+        entry = it->second;
+        entry->pins++;
+        entry->lastUsed = ++clock_;
+        size = entry->size;
+        ALOG_I(TAG, "open %s with %lld preloaded bytes", url, (long long) entry->bytes());
+    }
+    return SkyIo::wrap(std::make_unique<Source>(*this, std::move(entry), interrupt, size));
+}
+
+void SkyPreloadManager::run() {
+    setpriority(PRIO_PROCESS, 0, PRELOAD_NICE);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        Task *task = nullptr;
+        cond_.wait(lock, [this, &task]() {
+            if (abort_) {
+                return true;
+            }
+            for (auto &candidate : tasks_) {
+                if (!candidate->running && !candidate->cancelled.load()
+                    && (nullptr == task || candidate->request.priority > task->request.priority)) {
+                    task = candidate.get();
+                }
+            }
+            return nullptr != task;
+        });
+        if (abort_) {
+            break;
+        }
+
+        task->running = true;
+        lock.unlock();
+        execute(task);
+        lock.lock();
+
+        task->entry->pins--;
+        tasks_.remove_if([task](const std::unique_ptr<Task> &item) {
+            return item.get() == task;
+        });
+    }
+}
+
+int SkyPreloadManager::interruptCallback(void *opaque) {
+    return static_cast<Task *>(opaque)->cancelled.load() ? 1 : 0;
+}
+
+void SkyPreloadManager::execute(Task *task) {
+    const int64_t start = av_gettime_relative();
+    const AVIOInterruptCB interrupt = {interruptCallback, task};
+    AVIOContext *upstream = nullptr;
+    if (SkyIo::openUpstream(task->request.url, &interrupt, &upstream) < 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task->entry->size = avio_size(upstream);
+    }
+
+    if (task->request.durationMs > 0) {
+        fetchDuration(task, upstream);
+    } else {
+        fetchBytes(task, upstream);
+    }
+    avio_closep(&upstream);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ALOG_I(TAG, "preloaded %s: %lld bytes in %lld ms%s", task->request.url.c_str(),
+           (long long) task->entry->bytes(), (long long) ((av_gettime_relative() - start) / 1000),
+           task->cancelled.load() ? ", cancelled" : "");
+}
+
+void SkyPreloadManager::fetchBytes(Task *task, AVIOContext *upstream) {
+    std::vector<uint8_t> buffer(SKY_IO_BUFFER_SIZE);
+    int64_t pos = 0;
+    while (!task->cancelled.load() && pos < task->request.maxBytes) {
+        int size = static_cast<int>(std::min<int64_t>(buffer.size(), task->request.maxBytes - pos));
+        int ret = avio_read_partial(upstream, buffer.data(), size);
+        if (ret <= 0) {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!storeLocked(task->entry.get(), pos, buffer.data(), static_cast<size_t>(ret))) {
+            ALOG_W(TAG, "budget exhausted, stop %s", task->request.url.c_str());
+            break;
+        }
+        pos += ret;
+    }
+}
+
+void SkyPreloadManager::fetchDuration(Task *task, AVIOContext *upstream) {
+    AVIOContext *pb = SkyIo::wrap(std::make_unique<Tee>(*this, task, upstream));
+    AVFormatContext *ic = pb ? avformat_alloc_context() : nullptr;
+    if (nullptr == ic) {
+        SkyIo::close(&pb);
+        return;
+    }
+    ic->pb = pb;
+    ic->flags |= AVFMT_FLAG_CUSTOM_IO;
+    ic->interrupt_callback = {interruptCallback, task};
+
+    // 与 read_thread 读取相同的头部和开头的包；失败时 ic 已被释放
+    if (avformat_open_input(&ic, task->request.url.c_str(), nullptr, nullptr) >= 0) {
+        const int64_t limit = av_rescale(task->request.durationMs, AV_TIME_BASE, 1000);
+        AVPacket *pkt = av_packet_alloc();
+        while (pkt && !task->cancelled.load() && av_read_frame(ic, pkt) >= 0) {
+            const AVStream *st = ic->streams[pkt->stream_index];
+            const int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+            const int64_t startTime = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+            const bool done = ts != AV_NOPTS_VALUE
+                              && av_rescale_q(ts - startTime, st->time_base, AV_TIME_BASE_Q) >= limit;
+            av_packet_unref(pkt);
+            if (done) {
+                break;
+            }
+        }
+        av_packet_free(&pkt);
+        avformat_close_input(&ic);
+    }
+    SkyIo::close(&pb);
+}
+
+std::shared_ptr<SkyPreloadEntry> SkyPreloadManager::entryLocked(const std::string &url) {
+    auto &entry = entries_[url];
+    if (!entry) {
+        entry = std::make_shared<SkyPreloadEntry>();
+        entry->url = url;
+    }
+    return entry;
+}
+
+void SkyPreloadManager::cancelLocked(Task *task) {
+    task->cancelled.store(true);
+    if (task->running) {
+        // 下载线程在中断回调里退出，之后自己移除任务
+        return;
+    }
+    task->entry->pins--;
+    tasks_.remove_if([task](const std::unique_ptr<Task> &item) {
+        return item.get() == task;
+    });
+}
+
+bool SkyPreloadManager::storeLocked(SkyPreloadEntry *entry, int64_t pos, const uint8_t *data, size_t size) {
+    while (used_ + static_cast<int64_t>(size) > budget_) {
+        if (!evictOneLocked(entry)) {
+            return false;
+        }
+    }
+    used_ += static_cast<int64_t>(entry->write(pos, data, size));
+    return true;
+}
+
+bool SkyPreloadManager::evictOneLocked(const SkyPreloadEntry *keep) {
+    // 先淘汰优先级低的，同优先级淘汰最久没用的；正在读写的不淘汰
+    auto victim = entries_.end();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        const auto &entry = it->second;
+        if (entry.get() == keep || entry->pins > 0) {
+            continue;
+        }
+        if (victim == entries_.end()
+            || entry->priority < victim->second->priority
+            || (entry->priority == victim->second->priority && entry->lastUsed < victim->second->lastUsed)) {
+            victim = it;
+        }
+    }
+    if (victim == entries_.end()) {
+        return false;
+    }
+    ALOG_I(TAG, "evict %s, %lld bytes", victim->first.c_str(), (long long) victim->second->bytes());
+    used_ -= victim->second->bytes();
+    entries_.erase(victim);
+    return true;
+}
+
+void SkyPreloadManager::release(SkyPreloadEntry *entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry->pins--;
+}
+
+size_t SkyPreloadManager::readCached(SkyPreloadEntry *entry, int64_t pos, uint8_t *dst, size_t size,
+                                     int64_t *nextStart) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry->lastUsed = ++clock_;
+    size_t n = entry->read(pos, dst, size);
+    if (n == 0) {
+        *nextStart = entry->nextRangeStart(pos);
+    }
+    return n;
+}
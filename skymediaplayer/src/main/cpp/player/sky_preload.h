@@ -0,0 +1,127 @@
+#ifndef SKY_PRELOAD_H
+#define SKY_PRELOAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "sky_io.h"
+
+// 所有预加载数据共用的内存上限
+#define PRELOAD_DEFAULT_BUDGET (64 * 1024 * 1024)
+// 同时下载的 URL 数
+#define PRELOAD_WORKERS 2
+// 单个 URL 默认最多预加载的字节数
+#define PRELOAD_DEFAULT_MAX_BYTES (4 * 1024 * 1024)
+
+struct SkyPreloadRequest {
+    std::string url;
+    // 数值大的先下载，超出预算时先淘汰数值小的
+    int priority = 0;
+    int64_t maxBytes = PRELOAD_DEFAULT_MAX_BYTES;
+    // 大于 0 时按容器解析，取够这么长的开头（含 moov 等头部）即停止；否则只按字节数顺序下载
+    int durationMs = 0;
+};
+
+/**
+ * 一个 URL 已下载的字节区间，相邻或重叠的区间合并保存。由 SkyPreloadManager 的锁保护
+ */
+class SkyPreloadEntry {
+public:
+    // 从 pos 开始命中的字节数，未命中返回 0
+    size_t read(int64_t pos, uint8_t *dst, size_t size) const;
+    // 写入 [pos, pos + size)，返回新增的字节数
+    size_t write(int64_t pos, const uint8_t *src, size_t size);
+    // pos 之后第一个区间的起点，没有时返回 -1
+    int64_t nextRangeStart(int64_t pos) const;
+
+    int64_t bytes() const {
+        return bytes_;
+    }
+
+public:
+    std::string url;
+    int priority = 0;
+    // 源文件大小，未知时为 -1
+    int64_t size = -1;
+    uint64_t lastUsed = 0;
+    // 播放器正在读或正在下载时不淘汰
+    int pins = 0;
+
+private:
+    std::map<int64_t, std::vector<uint8_t>> ranges_;
+    int64_t bytes_ = 0;
+};
+
+/**
+ * 进程内共享的预加载调度：在播放器 prepareAsync 之前，按优先级把即将播放的 URL 开头下载到内存，
+ * 总量受预算限制，超出时按优先级和最近使用淘汰。read_thread 打开已预加载的 URL 时，
+ * 命中部分直接从内存读，其余回源，首帧不再等网络。
+ */
+class SkyPreloadManager {
+public:
+    static SkyPreloadManager& instance();
+
+    void setBudget(int64_t bytes);
+    // 同一 URL 重复调用时更新优先级和上限
+    void preload(const SkyPreloadRequest &request);
+    // 取消下载，已下载的数据保留到被淘汰；url 为空时取消全部
+    void cancel(const std::string &url);
+
+    // 已预加载的字节数，没有时返回 0
+    int64_t preloadedBytes(const std::string &url);
+
+    // read_thread 调用：有预加载数据时停止该 URL 的下载，返回从缓存读、未命中回源的 AVIOContext，否则返回 nullptr
+    AVIOContext *openIo(const char *url, const AVIOInterruptCB *interrupt);
+
+private:
+    struct Task {
+        SkyPreloadRequest request;
+        std::shared_ptr<SkyPreloadEntry> entry;
+        bool running = false;
+        // 中断回调在下载线程里读取
+        std::atomic<bool> cancelled{false};
+    };
+
+    class Source;
+    class Tee;
+
+    SkyPreloadManager();
+    ~SkyPreloadManager();
+
+    void run();
+    void execute(Task *task);
+    void fetchBytes(Task *task, AVIOContext *upstream);
+    void fetchDuration(Task *task, AVIOContext *upstream);
+    static int interruptCallback(void *opaque);
+    void release(SkyPreloadEntry *entry);
+    size_t readCached(SkyPreloadEntry *entry, int64_t pos, uint8_t *dst, size_t size, int64_t *nextStart);
+
+    // 以下在持有 mutex_ 时调用
+    std::shared_ptr<SkyPreloadEntry> entryLocked(const std::string &url);
+    void cancelLocked(Task *task);
+    // 写入下载的数据，超出预算又无可淘汰时返回 false
+    bool storeLocked(SkyPreloadEntry *entry, int64_t pos, const uint8_t *data, size_t size);
+    bool evictOneLocked(const SkyPreloadEntry *keep);
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool abort_ = false;
+    int64_t budget_ = PRELOAD_DEFAULT_BUDGET;
+    int64_t used_ = 0;
+    uint64_t clock_ = 0;
+    std::unordered_map<std::string, std::shared_ptr<SkyPreloadEntry>> entries_;
+    std::list<std::unique_ptr<Task>> tasks_;
+    std::vector<std::thread> workers_;
+};
+
+#endif // SKY_PRELOAD_H
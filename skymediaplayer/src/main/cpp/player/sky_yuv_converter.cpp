@@ -0,0 +1,348 @@
+#include "sky_yuv_converter.h"
+#include <cstddef>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SKY_YUV_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define SKY_YUV_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SKY_YUV_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+using OutputFormat = SkyYuvConverter::OutputFormat;
+
+namespace {
+    // 6 bit 定点系数：1.164, 1.596, 0.392, 0.813, 2.017
+    constexpr int kYScale = 74;
+    constexpr int kRV = 102;
+    constexpr int kGU = 25;
+    constexpr int kGV = 52;
+    constexpr int kBU = 129;
+
+    // 处理若干个完整的 16 像素块，返回已处理的像素数，剩余部分由标量实现补齐
+    using RowFunc = int (*)(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                            uint8_t* dst, int width, OutputFormat format);
+
+    inline uint8_t clampByte(int value) {
+        return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+    void convertRowScalar(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                          uint8_t* dst, int start, int width, OutputFormat format) {
+        for (int x = start; x < width; ++x) {
+            int c = kYScale * (y[x] - 16);
+            int d = u[x / 2] - 128;
+            int e = v[x / 2] - 128;
+            uint8_t r = clampByte((c + kRV * e + 32) >> 6);
+            uint8_t g = clampByte((c - kGU * d - kGV * e + 32) >> 6);
+            uint8_t b = clampByte((c + kBU * d + 32) >> 6);
+            if (format == OutputFormat::RGB565) {
+                auto* out = reinterpret_cast<uint16_t*>(dst) + x;
+                *out = static_cast<uint16_t>(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+            } else {
+                uint8_t* out = dst + x * 4;
+                out[0] = r;
+                out[1] = g;
+                out[2] = b;
+                out[3] = 0xFF;
+            }
+        }
+    }
+
+    void deinterleaveRowScalar(const uint8_t* src, uint8_t* first, uint8_t* second, int start, int count) {
+        for (int i = start; i < count; ++i) {
+            first[i] = src[i * 2];
+            second[i] = src[i * 2 + 1];
+        }
+    }
+
+#if SKY_YUV_NEON
+    int convertRowNeon(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                       uint8_t* dst, int width, OutputFormat format) {
+        const int16x8_t bias16 = vdupq_n_s16(16);
+        const int16x8_t bias128 = vdupq_n_s16(128);
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            uint8x16_t y8 = vld1q_u8(y + x);
+            int16x8_t u16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + x / 2))), bias128);
+            int16x8_t v16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + x / 2))), bias128);
+            int16x8x2_t uu = vzipq_s16(u16, u16);
+            int16x8x2_t vv = vzipq_s16(v16, v16);
+
+            int16x8_t c[2] = {
+                    vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y8))), bias16), kYScale),
+                    vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y8))), bias16), kYScale),
+            };
+            uint8x8_t r[2], g[2], b[2];
+            for (int i = 0; i < 2; ++i) {
+                // B 可能超出 int16，使用饱和加法，结果本来就会被钳到 255
+                r[i] = vqrshrun_n_s16(vqaddq_s16(c[i], vmulq_n_s16(vv.val[i], kRV)), 6);
+                g[i] = vqrshrun_n_s16(vqaddq_s16(c[i], vaddq_s16(vmulq_n_s16(uu.val[i], -kGU),
+                                                                 vmulq_n_s16(vv.val[i], -kGV))), 6);
+                b[i] = vqrshrun_n_s16(vqaddq_s16(c[i], vmulq_n_s16(uu.val[i], kBU)), 6);
+            }
+
+            if (format == OutputFormat::RGB565) {
+                auto* out = reinterpret_cast<uint16_t*>(dst) + x;
+                for (int i = 0; i < 2; ++i) {
+                    uint16x8_t pixel = vshll_n_u8(r[i], 8);
+                    pixel = vsriq_n_u16(pixel, vshll_n_u8(g[i], 8), 5);
+                    pixel = vsriq_n_u16(pixel, vshll_n_u8(b[i], 8), 11);
+                    vst1q_u16(out + i * 8, pixel);
+                }
+            } else {
+                uint8x16x4_t pixel;
+                pixel.val[0] = vcombine_u8(r[0], r[1]);
+                pixel.val[1] = vcombine_u8(g[0], g[1]);
+                pixel.val[2] = vcombine_u8(b[0], b[1]);
+                pixel.val[3] = vdupq_n_u8(0xFF);
+                vst4q_u8(dst + x * 4, pixel);
+            }
+        }
+        return x;
+    }
+
+    int deinterleaveRowNeon(const uint8_t* src, uint8_t* first, uint8_t* second, int count) {
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x2_t pair = vld2q_u8(src + i * 2);
+            vst1q_u8(first + i, pair.val[0]);
+            vst1q_u8(second + i, pair.val[1]);
+        }
+        return i;
+    }
+#endif
+
+#if SKY_YUV_SSE2
+    inline __m128i sseChannel(__m128i c, __m128i product) {
+        const __m128i round = _mm_set1_epi16(32);
+        return _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(c, product), round), 6);
+    }
+
+    inline __m128i sseRgb565(__m128i r8, __m128i g8, __m128i b8, bool high) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i r = high ? _mm_unpackhi_epi8(r8, zero) : _mm_unpacklo_epi8(r8, zero);
+        __m128i g = high ? _mm_unpackhi_epi8(g8, zero) : _mm_unpacklo_epi8(g8, zero);
+        __m128i b = high ? _mm_unpackhi_epi8(b8, zero) : _mm_unpacklo_epi8(b8, zero);
+        return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(r, _mm_set1_epi16(0xF8)), 8),
+                                         _mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(0xFC)), 3)),
+                            _mm_srli_epi16(b, 3));
+    }
+
+    int convertRowSse2(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                       uint8_t* dst, int width, OutputFormat format) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias16 = _mm_set1_epi16(16);
+        const __m128i bias128 = _mm_set1_epi16(128);
+        const __m128i yScale = _mm_set1_epi16(kYScale);
+        const __m128i rv = _mm_set1_epi16(kRV);
+        const __m128i gu = _mm_set1_epi16(-kGU);
+        const __m128i gv = _mm_set1_epi16(-kGV);
+        const __m128i bu = _mm_set1_epi16(kBU);
+        const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+            __m128i u16 = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2)), zero), bias128);
+            __m128i v16 = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2)), zero), bias128);
+            __m128i uu[2] = {_mm_unpacklo_epi16(u16, u16), _mm_unpackhi_epi16(u16, u16)};
+            __m128i vv[2] = {_mm_unpacklo_epi16(v16, v16), _mm_unpackhi_epi16(v16, v16)};
+            __m128i c[2] = {
+                    _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), bias16), yScale),
+                    _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y8, zero), bias16), yScale),
+            };
+            __m128i r[2], g[2], b[2];
+            for (int i = 0; i < 2; ++i) {
+                r[i] = sseChannel(c[i], _mm_mullo_epi16(vv[i], rv));
+                g[i] = sseChannel(c[i], _mm_add_epi16(_mm_mullo_epi16(uu[i], gu), _mm_mullo_epi16(vv[i], gv)));
+                b[i] = sseChannel(c[i], _mm_mullo_epi16(uu[i], bu));
+            }
+            __m128i r8 = _mm_packus_epi16(r[0], r[1]);
+            __m128i g8 = _mm_packus_epi16(g[0], g[1]);
+            __m128i b8 = _mm_packus_epi16(b[0], b[1]);
+
+            if (format == OutputFormat::RGB565) {
+                auto* out = reinterpret_cast<__m128i*>(dst + x * 2);
+                _mm_storeu_si128(out, sseRgb565(r8, g8, b8, false));
+                _mm_storeu_si128(out + 1, sseRgb565(r8, g8, b8, true));
+            } else {
+                __m128i rg0 = _mm_unpacklo_epi8(r8, g8);
+                __m128i rg1 = _mm_unpackhi_epi8(r8, g8);
+                __m128i ba0 = _mm_unpacklo_epi8(b8, alpha);
+                __m128i ba1 = _mm_unpackhi_epi8(b8, alpha);
+                auto* out = reinterpret_cast<__m128i*>(dst + x * 4);
+                _mm_storeu_si128(out, _mm_unpacklo_epi16(rg0, ba0));
+                _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rg0, ba0));
+                _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rg1, ba1));
+                _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rg1, ba1));
+            }
+        }
+        return x;
+    }
+
+    int deinterleaveRowSse2(const uint8_t* src, uint8_t* first, uint8_t* second, int count) {
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2 + 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(first + i),
+                             _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(second + i),
+                             _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+        }
+        return i;
+    }
+#endif
+
+#if SKY_YUV_AVX2
+    __attribute__((target("avx2")))
+    inline __m256i avx2Chroma(const uint8_t* src) {
+        __m128i c16 = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src))),
+                                    _mm_set1_epi16(128));
+        // 每个色度样本对应两个像素
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(c16, c16)),
+                                       _mm_unpackhi_epi16(c16, c16), 1);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i avx2Channel(__m256i c, __m256i product) {
+        __m256i value = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(c, product), _mm256_set1_epi16(32)), 6);
+        return _mm256_min_epi16(_mm256_max_epi16(value, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i avx2Rgba(__m128i r, __m128i g, __m128i b) {
+        return _mm256_or_si256(_mm256_or_si256(_mm256_cvtepu16_epi32(r),
+                                               _mm256_slli_epi32(_mm256_cvtepu16_epi32(g), 8)),
+                               _mm256_or_si256(_mm256_slli_epi32(_mm256_cvtepu16_epi32(b), 16),
+                                               _mm256_set1_epi32(static_cast<int>(0xFF000000u))));
+    }
+
+    __attribute__((target("avx2")))
+    int convertRowAvx2(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                       uint8_t* dst, int width, OutputFormat format) {
+        const __m256i bias16 = _mm256_set1_epi16(16);
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m256i c = _mm256_mullo_epi16(
+                    _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x))), bias16),
+                    _mm256_set1_epi16(kYScale));
+            __m256i uu = avx2Chroma(u + x / 2);
+            __m256i vv = avx2Chroma(v + x / 2);
+
+            __m256i r = avx2Channel(c, _mm256_mullo_epi16(vv, _mm256_set1_epi16(kRV)));
+            __m256i g = avx2Channel(c, _mm256_add_epi16(_mm256_mullo_epi16(uu, _mm256_set1_epi16(-kGU)),
+                                                        _mm256_mullo_epi16(vv, _mm256_set1_epi16(-kGV))));
+            __m256i b = avx2Channel(c, _mm256_mullo_epi16(uu, _mm256_set1_epi16(kBU)));
+
+            if (format == OutputFormat::RGB565) {
+                __m256i pixel = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(r, _mm256_set1_epi16(0xF8)), 8),
+                                        _mm256_slli_epi16(_mm256_and_si256(g, _mm256_set1_epi16(0xFC)), 3)),
+                        _mm256_srli_epi16(b, 3));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 2), pixel);
+            } else {
+                auto* out = reinterpret_cast<__m256i*>(dst + x * 4);
+                _mm256_storeu_si256(out, avx2Rgba(_mm256_castsi256_si128(r), _mm256_castsi256_si128(g),
+                                                  _mm256_castsi256_si128(b)));
+                _mm256_storeu_si256(out + 1, avx2Rgba(_mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1),
+                                                      _mm256_extracti128_si256(b, 1)));
+            }
+        }
+        return x;
+    }
+#endif
+
+    RowFunc selectRowFunc() {
+#if SKY_YUV_NEON
+        return convertRowNeon;
+#elif SKY_YUV_SSE2
+#if SKY_YUV_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+            return convertRowAvx2;
+        }
+#endif
+        return convertRowSse2;
+#else
+        return nullptr;
+#endif
+    }
+
+    RowFunc rowFunc() {
+        static const RowFunc func = selectRowFunc();
+        return func;
+    }
+
+    void deinterleaveRow(const uint8_t* src, uint8_t* first, uint8_t* second, int count) {
+        int done = 0;
+#if SKY_YUV_NEON
+        done = deinterleaveRowNeon(src, first, second, count);
+#elif SKY_YUV_SSE2
+        done = deinterleaveRowSse2(src, first, second, count);
+#endif
+        deinterleaveRowScalar(src, first, second, done, count);
+    }
+}
+
+bool SkyYuvConverter::convert(Layout layout, const uint8_t *const planes[3], const int strides[3],
+                              int width, int height,
+                              uint8_t *dst, int dstStride, OutputFormat format) {
+    if (nullptr == planes || nullptr == strides || nullptr == dst || width <= 0 || height <= 0) {
+        return false;
+    }
+    if (nullptr == planes[0] || nullptr == planes[1] || (layout == Layout::I420 && nullptr == planes[2])) {
+        return false;
+    }
+
+    const int chromaWidth = (width + 1) / 2;
+    // NV12/NV21 的色度行先拆成 U/V 两行，之后与 I420 共用同一个行内核
+    std::vector<uint8_t> chroma(layout == Layout::I420 ? 0 : chromaWidth * 2);
+    uint8_t* chromaU = chroma.data();
+    uint8_t* chromaV = chroma.data() + chromaWidth;
+    int lastChromaRow = -1;
+    const RowFunc func = rowFunc();
+
+    for (int row = 0; row < height; ++row) {
+        const int chromaRow = row / 2;
+        const uint8_t* y = planes[0] + static_cast<size_t>(row) * strides[0];
+        const uint8_t* u;
+        const uint8_t* v;
+        if (layout == Layout::I420) {
+            u = planes[1] + static_cast<size_t>(chromaRow) * strides[1];
+            v = planes[2] + static_cast<size_t>(chromaRow) * strides[2];
+        } else {
+            if (chromaRow != lastChromaRow) {
+                const uint8_t* src = planes[1] + static_cast<size_t>(chromaRow) * strides[1];
+                if (layout == Layout::NV12) {
+                    deinterleaveRow(src, chromaU, chromaV, chromaWidth);
+                } else {
+                    deinterleaveRow(src, chromaV, chromaU, chromaWidth);
+                }
+                lastChromaRow = chromaRow;
+            }
+            u = chromaU;
+            v = chromaV;
+        }
+
+        uint8_t* out = dst + static_cast<size_t>(row) * dstStride;
+        int done = func ? func(y, u, v, out, width, format) : 0;
+        convertRowScalar(y, u, v, out, done, width, format);
+    }
+    return true;
+}
+
+const char* SkyYuvConverter::implementationName() {
+#if SKY_YUV_NEON
+    return "neon";
+#elif SKY_YUV_SSE2
+    return rowFunc() == convertRowSse2 ? "sse2" : "avx2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,42 @@
+#ifndef SKY_YUV_CONVERTER_H
+#define SKY_YUV_CONVERTER_H
+
+#include <cstdint>
+
+/**
+ * YUV -> RGB 转换核心（BT.601 limited range，系数与 GLES shader 一致）。
+ * 只操作普通内存，不依赖 Android/FFmpeg，可以直接在 Linux 上做单测和 benchmark。
+ * 根据 CPU 选择 NEON / AVX2 / SSE2 实现，其余平台走标量实现，各实现输出逐字节一致。
+ */
+class SkyYuvConverter {
+public:
+    enum class Layout {
+        I420,   // Y + U + V 三个 plane
+        NV12,   // Y + UV 交错
+        NV21,   // Y + VU 交错
+    };
+
+    enum class OutputFormat {
+        RGBA8888,
+        RGB565,
+    };
+
+    /**
+     * @param planes    各 plane 起始地址，NV12/NV21 只使用前两个
+     * @param strides   各 plane 的行字节数
+     * @param dst       输出起始地址
+     * @param dstStride 输出行字节数
+     */
+    static bool convert(Layout layout, const uint8_t* const planes[3], const int strides[3],
+                        int width, int height,
+                        uint8_t* dst, int dstStride, OutputFormat format);
+
+    static int bytesPerPixel(OutputFormat format) {
+        return format == OutputFormat::RGB565 ? 2 : 4;
+    }
+
+    // 当前使用的实现，便于日志和 benchmark
+    static const char* implementationName();
+};
+
+#endif // SKY_YUV_CONVERTER_H
@@ -2,11 +2,297 @@
 #include <sched.h>
 #include <thread>
 #include <chrono>
+#include <cstring>
+#include <ctime>
+#include <cmath>
+#include <algorithm>
 
 #include "skyaudio.h"
 
 static const char *TAG = "SkySLGESAudioOut";
 
+// 设备位置与外推值相差超过该值时不再平滑，直接对齐
+#define AUDIO_CLOCK_MAX_ERROR_MS 20.0
+
+static int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SkyAudioClock::reset(int sampleRate) {
+    sampleRate_ = sampleRate;
+    valid_ = false;
+    anchorFrames_ = 0;
+    anchorUs_ = 0;
+    averageErrorMs_ = 0;
+}
+
+void SkyAudioClock::update(int64_t devicePlayedFrames, int64_t nowUs) {
+    if (devicePlayedFrames < 0 || sampleRate_ <= 0) {
+        valid_ = false;
+        return;
+    }
+    if (!valid_) {
+        anchorFrames_ = static_cast<double>(devicePlayedFrames);
+        anchorUs_ = nowUs;
+        valid_ = true;
+        return;
+    }
+
+    double predicted = anchorFrames_ + static_cast<double>(nowUs - anchorUs_) * sampleRate_ / 1000000.0;
+    double error = static_cast<double>(devicePlayedFrames) - predicted;
+    double errorMs = error * 1000.0 / sampleRate_;
+    if (std::fabs(errorMs) > AUDIO_CLOCK_MAX_ERROR_MS) {
+        anchorFrames_ = static_cast<double>(devicePlayedFrames);
+    } else {
+        anchorFrames_ = predicted + error / 8;
+        averageErrorMs_ += (std::fabs(errorMs) - averageErrorMs_) / 16;
+    }
+    anchorUs_ = nowUs;
+}
+
+int64_t SkyAudioClock::playedFrames(int64_t nowUs) const {
+    if (!valid_) {
+        return -1;
+    }
+    return static_cast<int64_t>(anchorFrames_ + static_cast<double>(nowUs - anchorUs_) * sampleRate_ / 1000000.0);
+}
+
+static double threadCpuMs() {
+    struct timespec cpu{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    return cpu.tv_sec * 1000.0 + cpu.tv_nsec / 1000000.0;
+}
+
+void SkyThreadPowerStats::begin(bool deep) {
+    mode_ = deep ? 1 : 0;
+    lastCpuMs_ = threadCpuMs();
+    lastWallUs_ = nowUs();
+}
+
+void SkyThreadPowerStats::setMode(bool deep) {
+    int mode = deep ? 1 : 0;
+    if (mode != mode_) {
+        settle();
+        mode_ = mode;
+    }
+}
+
+void SkyThreadPowerStats::settle() {
+    double cpu = threadCpuMs();
+    int64_t now = nowUs();
+    cpuMs_[mode_] += cpu - lastCpuMs_;
+    wallMs_[mode_] += (now - lastWallUs_) / 1000.0;
+    lastCpuMs_ = cpu;
+    lastWallUs_ = now;
+}
+
+void SkyThreadPowerStats::log(const char *tag, const char *name) {
+    static const char *modeNames[2] = {"low-latency", "deep-buffer"};
+    settle();
+    for (int i = 0; i < 2; ++i) {
+        if (wallMs_[i] < 1000.0) {
+            continue;
+        }
+        ALOG_I(tag, "[%s] %s %.1f s: %.1f wakeups/s, cpu %.1f ms per minute", name, modeNames[i],
+               wallMs_[i] / 1000.0, wakeups_[i] * 1000.0 / wallMs_[i], cpuMs_[i] * 60000.0 / wallMs_[i]);
+    }
+}
+
+double SkyAudioOut::getLatencySeconds() {
+    double ringSeconds = 0.0;
+    if (producerBytesPerFrame_ > 0 && sampleRate_ > 0) {
+        ringSeconds = (double) ring_.availableToRead() / producerBytesPerFrame_ / sampleRate_;
+    }
+    if (sampleRate_ <= 0) {
+        return minimalLatencySeconds + ringSeconds;
+    }
+
+    int64_t played = getPlayedFrames();
+    if (played < 0) {
+        deviceQueuedFrames_.store(std::llround(minimalLatencySeconds * sampleRate_), std::memory_order_relaxed);
+        return minimalLatencySeconds + ringSeconds;
+    }
+    int64_t written = framesWritten_.load(std::memory_order_relaxed);
+    int64_t queued = std::clamp<int64_t>(written - played, 0, written);
+    deviceQueuedFrames_.store(queued, std::memory_order_relaxed);
+    return static_cast<double>(queued) / sampleRate_ + ringSeconds;
+}
+
+int64_t SkyAudioOut::getPlayedFrames() {
+    if (sampleRate_ <= 0) {
+        return -1;
+    }
+    int64_t now = nowUs();
+    clock_.update(getDevicePlayedFrames(), now);
+    clockErrorMs_.store(clock_.averageErrorMs(), std::memory_order_relaxed);
+    return clock_.playedFrames(now);
+}
+
+int64_t SkyAudioOut::getWriteFramePosition(int pendingBytes) const {
+    int64_t written = framesWritten_.load(std::memory_order_relaxed);
+    if (producerBytesPerFrame_ <= 0) {
+        return written;
+    }
+    return written + static_cast<int64_t>(ring_.availableToRead() + pendingBytes) / producerBytesPerFrame_;
+}
+
+void SkyAudioOut::resetPosition(int sampleRate) {
+    sampleRate_ = sampleRate;
+    framesWritten_.store(0, std::memory_order_relaxed);
+    deviceQueuedFrames_.store(0, std::memory_order_relaxed);
+    clock_.reset(sampleRate);
+    clockErrorMs_.store(0, std::memory_order_relaxed);
+}
+
+void SkyAudioOut::discardQueuedFrames() {
+    int64_t played = getDevicePlayedFrames();
+    if (played >= 0 && played < framesWritten_.load(std::memory_order_relaxed)) {
+        framesWritten_.store(played, std::memory_order_relaxed);
+    }
+}
+
+void SkyAudioOut::setDeepBuffer(bool enabled) {
+    deepBufferRequested_.store(enabled, std::memory_order_relaxed);
+    producerCond_.notify_one();
+}
+
+bool SkyAudioOut::deepBufferActive() const {
+    return deepBufferRequested_.load(std::memory_order_relaxed)
+           && nowUs() - lastFlushUs_.load(std::memory_order_relaxed) > AUDIO_DEEP_HOLDOFF_MS * 1000LL;
+}
+
+void SkyAudioOut::startProducer(const SkyAudioSpec &spec, int bytesPerFrame, int chunkBytes) {
+    producerCallback_ = spec.callback;
+    producerUserdata_ = spec.userdata;
+    producerBytesPerFrame_ = bytesPerFrame;
+    producerChunkBytes_ = chunkBytes;
+    producerFormat_.sampleRate = spec.sdl_audioSpec.freq;
+    producerFormat_.channels = spec.sdl_audioSpec.channels;
+    producerFormat_.format = spec.sdl_audioSpec.format;
+
+    // 容量取 chunk 的整数倍，每次写入一个完整 chunk 时不会绕回；按深缓冲分配，低延迟时只用前一部分
+    int chunks = std::max(2, (AUDIO_RING_MS + OPENSLES_BUFLEN - 1) / OPENSLES_BUFLEN);
+    int deepChunks = std::max(chunks, AUDIO_DEEP_RING_MS / OPENSLES_BUFLEN);
+    ring_.init(static_cast<size_t>(deepChunks) * chunkBytes);
+    lowLatencyRingBytes_ = static_cast<size_t>(chunks) * chunkBytes;
+    // 启动时先按低延迟运行，尽快出声
+    lastFlushUs_.store(nowUs(), std::memory_order_relaxed);
+    ringPrimed_ = false;
+    underruns_.store(0, std::memory_order_relaxed);
+    ringFlushPending_.store(false, std::memory_order_relaxed);
+    producerPaused_.store(true, std::memory_order_relaxed);
+    producerStop_.store(false, std::memory_order_relaxed);
+    producerThread_ = std::thread([this]() {
+        this->producerThread();
+    });
+}
+
+void SkyAudioOut::stopProducer() {
+    producerStop_.store(true, std::memory_order_relaxed);
+    producerCond_.notify_all();
+    if (producerThread_.joinable()) {
+        producerThread_.join();
+    }
+    if (producerChunkBytes_ > 0) {
+        ALOG_I(TAG, "audio producer stopped, underruns: %llu",
+               (unsigned long long) underruns_.load(std::memory_order_relaxed));
+    }
+}
+
+void SkyAudioOut::setProducerPaused(bool paused) {
+    producerPaused_.store(paused, std::memory_order_relaxed);
+    producerCond_.notify_one();
+}
+
+void SkyAudioOut::requestRingFlush() {
+    ringFlushPending_.store(true, std::memory_order_relaxed);
+    lastFlushUs_.store(nowUs(), std::memory_order_relaxed);
+}
+
+void SkyAudioOut::producerThread() {
+    ALOG_I(TAG, "[PRODUCER] started, ring %zu bytes, chunk %d bytes", ring_.capacity(), producerChunkBytes_);
+    const auto chunkDuration = std::chrono::milliseconds(OPENSLES_BUFLEN);
+    const double bytesPerMs = (double) producerBytesPerFrame_ * sampleRate_ / 1000.0;
+    SkyThreadPowerStats stats;
+    stats.begin(deepBufferActive());
+
+    while (!producerStop_.load(std::memory_order_relaxed)) {
+        if (producerPaused_.load(std::memory_order_relaxed)) {
+            std::unique_lock<std::mutex> lock(producerMutex_);
+            producerCond_.wait(lock, [this] {
+                return !producerPaused_.load(std::memory_order_relaxed) || producerStop_.load(std::memory_order_relaxed);
+            });
+            stats.wakeup();
+            continue;
+        }
+
+        const bool deep = deepBufferActive();
+        stats.setMode(deep);
+
+        size_t contiguous = 0;
+        uint8_t *chunk = ring_.beginWrite(&contiguous);
+        size_t readable = ring_.availableToRead();
+        size_t target = deep ? ring_.capacity() : lowLatencyRingBytes_;
+        if (nullptr == chunk || contiguous < static_cast<size_t>(producerChunkBytes_)
+            || readable + producerChunkBytes_ > target) {
+            // 低延迟：等输出线程读走一个 chunk；深缓冲：休眠到 ring 降到一半，再一次解码到满
+            std::unique_lock<std::mutex> lock(producerMutex_);
+            if (deep && bytesPerMs > 0) {
+                size_t half = ring_.capacity() / 2;
+                auto waitMs = static_cast<int64_t>(readable > half ? (readable - half) / bytesPerMs : 0);
+                producerCond_.wait_for(lock, std::chrono::milliseconds(std::max<int64_t>(OPENSLES_BUFLEN, waitMs)));
+            } else {
+                producerCond_.wait_for(lock, chunkDuration);
+            }
+            stats.wakeup();
+            continue;
+        }
+
+        if (producerCallback_) {
+            producerCallback_(producerUserdata_, chunk, producerChunkBytes_);
+        }
+        ring_.commitWrite(producerChunkBytes_);
+
+        // 回调中请求的 flush，作废的数据包括刚写入的这个 chunk
+        if (ringFlushPending_.exchange(false, std::memory_order_relaxed)) {
+            ring_.markFlush();
+        }
+    }
+    // 解码 + 重采样 + 音量的唤醒次数和 CPU 开销，按模式分别统计
+    stats.log(TAG, "PRODUCER");
+}
+
+size_t SkyAudioOut::peekRecentPcm(uint8_t *dst, size_t bytes, SkyPcmFormat *format, uint64_t *endIndex) const {
+    *format = producerFormat_;
+    if (producerBytesPerFrame_ <= 0) {
+        *endIndex = 0;
+        return 0;
+    }
+    const auto lag = static_cast<size_t>(std::max<int64_t>(deviceQueuedFrames_.load(std::memory_order_relaxed), 0))
+                     * producerBytesPerFrame_;
+    return ring_.peekRecent(dst, bytes, lag, endIndex);
+}
+
+void SkyAudioOut::readPcm(uint8_t *dst, int bytes, uint8_t silence) {
+    size_t got = ring_.read(dst, static_cast<size_t>(bytes));
+    if (got < static_cast<size_t>(bytes)) {
+        memset(dst + got, silence, bytes - got);
+        // 从有数据到读空算一次 underrun，启动和 flush 后还没有数据时不计
+        if (ringPrimed_) {
+            uint64_t count = underruns_.fetch_add(1, std::memory_order_relaxed) + 1;
+            ALOG_W(TAG, "audio ring underrun, got %zu/%d bytes, total %llu", got, bytes, (unsigned long long) count);
+        }
+        ringPrimed_ = false;
+    } else {
+        ringPrimed_ = true;
+    }
+    // 深缓冲时只在 ring 降到一半后唤醒生产线程，让它批量解码
+    if (!deepBufferActive() || ring_.availableToRead() <= ring_.capacity() / 2) {
+        producerCond_.notify_one();
+    }
+}
+
 bool SkySLESAudioOut::prepareAudio() {
     wakeup_cond_ = std::make_unique<std::condition_variable>();
     if (!wakeup_cond_) {
@@ -66,17 +352,28 @@ bool SkySLESAudioOut::prepareAudio() {
 bool SkySLESAudioOut::openAudio(const SkyAudioSpec *desired, SkyAudioSpec *obtained) {
     if (!prepareAudio()) {
         ALOG_E(TAG, "prepareAudio failed");
+        closeAudio();
         return false;
     }
 
+    // 设备只按单声道/立体声打开，多声道由上层 downmix，协商后的参数通过 obtained 返回
+    SkyAudioSpec negotiated = *desired;
+    if (negotiated.sdl_audioSpec.channels > 2) {
+        ALOG_I(TAG, "OpenSL-ES: %d channels negotiated to stereo", negotiated.sdl_audioSpec.channels);
+        negotiated.sdl_audioSpec.channels = 2;
+    }
+    desired = &negotiated;
+
     SLDataLocator_AndroidSimpleBufferQueue loc_bufq =
             {SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, OPENSLES_BUFFERS};
 
-    format_pcm_.formatType = SL_DATAFORMAT_PCM;
+    const bool isFloat = desired->sdl_audioSpec.format == SDL_AUDIO_F32;
+    format_pcm_.formatType = SL_ANDROID_DATAFORMAT_PCM_EX;
     format_pcm_.numChannels = desired->sdl_audioSpec.channels;
-    format_pcm_.samplesPerSec = desired->sdl_audioSpec.freq * 1000; // milli Hz
-    format_pcm_.bitsPerSample = SL_PCMSAMPLEFORMAT_FIXED_16;
-    format_pcm_.containerSize = SL_PCMSAMPLEFORMAT_FIXED_16;
+    format_pcm_.sampleRate = desired->sdl_audioSpec.freq * 1000; // milli Hz
+    format_pcm_.bitsPerSample = isFloat ? SL_PCMSAMPLEFORMAT_FIXED_32 : SL_PCMSAMPLEFORMAT_FIXED_16;
+    format_pcm_.containerSize = format_pcm_.bitsPerSample;
+    format_pcm_.representation = isFloat ? SL_ANDROID_PCM_REPRESENTATION_FLOAT : SL_ANDROID_PCM_REPRESENTATION_SIGNED_INT;
     switch (desired->sdl_audioSpec.channels) {
         case 2:
             format_pcm_.channelMask = SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT;
@@ -155,31 +452,44 @@ bool SkySLESAudioOut::openAudio(const SkyAudioSpec *desired, SkyAudioSpec *obtai
 
     bytes_per_frame_ = format_pcm_.numChannels * format_pcm_.bitsPerSample / 8;
     milli_per_buffer_ = OPENSLES_BUFLEN;
-    // samplesPerSec 在上面转化成了ms，这里是微秒
-    frames_per_buffer_ = milli_per_buffer_ * format_pcm_.samplesPerSec / 1000000;
+    // sampleRate 在上面转化成了 milli Hz，这里是微秒
+    frames_per_buffer_ = milli_per_buffer_ * format_pcm_.sampleRate / 1000000;
     bytes_per_buffer_ = bytes_per_frame_ * frames_per_buffer_;
+    deep_frames_per_buffer_ = OPENSLES_DEEP_BUFLEN * format_pcm_.sampleRate / 1000000;
+    deep_bytes_per_buffer_ = bytes_per_frame_ * deep_frames_per_buffer_;
     buffer_capacity_ = OPENSLES_BUFFERS * bytes_per_buffer_;
     ALOG_I(TAG, "OpenSL-ES: bytes_per_frame  = %d bytes\n", bytes_per_frame_);
     ALOG_I(TAG, "OpenSL-ES: milli_per_buffer = %d ms\n", milli_per_buffer_);
     ALOG_I(TAG, "OpenSL-ES: frame_per_buffer = %d frames\n", frames_per_buffer_);
     ALOG_I(TAG, "OpenSL-ES: bytes_per_buffer = %d bytes\n", bytes_per_buffer_);
     ALOG_I(TAG, "OpenSL-ES: buffer_capacity  = %zu bytes\n", buffer_capacity_);
-    buffer_.resize(buffer_capacity_, 0);
+    // 每个 buffer 按深缓冲的大小分配，两种模式可以逐个 buffer 切换
+    buffer_.resize(static_cast<size_t>(OPENSLES_BUFFERS) * deep_bytes_per_buffer_, 0);
+
+    resetPosition(desired->sdl_audioSpec.freq);
+    minimalLatencySeconds = (double) buffer_capacity_ / (bytes_per_frame_ * desired->sdl_audioSpec.freq);
 
     for (int i = 0; i < OPENSLES_BUFFERS; ++i) {
         result = (*slBufferQueueItf_)->Enqueue(slBufferQueueItf_,
-                                               buffer_.data() + i * bytes_per_buffer_,
+                                               buffer_.data() + i * deep_bytes_per_buffer_,
                                                bytes_per_buffer_);
         if (result != SL_RESULT_SUCCESS) {
             ALOG_E(TAG, "Failed to enqueue buffer");
             closeAudio();
             return false;
         }
+        onFramesWritten(frames_per_buffer_);
     }
 
     pause_on_.store(true, std::memory_order_relaxed);
     abort_request_.store(false, std::memory_order_relaxed);
 
+    spec_ = *desired;
+    // 没有回调时由 fillBuffer 的子类直接提供数据，不需要生产线程
+    if (spec_.callback) {
+        startProducer(spec_, bytes_per_frame_, bytes_per_buffer_);
+    }
+
     // 创建读取buffer线程，与 bufferQueueCallback 配合
     stop_thread_flag_.store(false, std::memory_order_relaxed);
     audio_thread_ = std::thread([this]() {
@@ -190,7 +500,6 @@ bool SkySLESAudioOut::openAudio(const SkyAudioSpec *desired, SkyAudioSpec *obtai
         *obtained = *desired;  // 返回更新后的 spec_，包含正确的 size
         obtained->size = buffer_capacity_;
     }
-    spec_ = *desired;
 
     ALOG_I(TAG, "OpenSL-ES: Audio spec configured - callback: %p, userdata: %p, freq: %d, channels: %d, format: %d, silence: %d",
            spec_.callback, spec_.userdata, spec_.sdl_audioSpec.freq, spec_.sdl_audioSpec.channels,
@@ -233,6 +542,8 @@ void SkySLESAudioOut::audioOutputThread() {
 
     // 初始化下一个缓冲区索引（局部变量）
     int next_buffer_index = 0;
+    SkyThreadPowerStats stats;
+    stats.begin(useDeepBuffer());
 
     if (!abort_request_.load(std::memory_order_relaxed)
         && !pause_on_.load(std::memory_order_relaxed)) {
@@ -267,6 +578,9 @@ void SkySLESAudioOut::audioOutputThread() {
             (*slBufferQueueItf_)->Clear(slBufferQueueItf_);
             ALOG_I(TAG, "[AUDIO_THREAD] Buffer queue cleared without stopping playback");
 
+            // 队列中的数据不会再播放
+            discardQueuedFrames();
+
             // 重置缓冲区索引
             next_buffer_index = 0;
             ALOG_I(TAG, "[AUDIO_THREAD] Reset buffer index to 0");
@@ -305,6 +619,7 @@ void SkySLESAudioOut::audioOutputThread() {
                            stop_thread_flag_.load(std::memory_order_relaxed) ||
                            abort_request_.load(std::memory_order_relaxed);
                 });
+                stats.wakeup();
             }
 
             // 只有在明确取消暂停时才恢复播放
@@ -338,52 +653,43 @@ void SkySLESAudioOut::audioOutputThread() {
         }
 
         if (slState.count < OPENSLES_BUFFERS) {
-            // 使用局部变量管理缓冲区索引
-            uint8_t* current_buffer = buffer_.data() + next_buffer_index * bytes_per_buffer_;
-
-            // 调用音频回调函数获取音频数据
-            if (spec_.callback && spec_.userdata) {
-                // 检查是否有 flush 请求，如果有则跳过本次回调
-                if (need_flush_.load(std::memory_order_relaxed)) {
-                    ALOG_I(TAG, "[AUDIO_THREAD] Flush requested, skipping callback and will process flush");
-                    continue;  // 跳过回调，回到循环开始处理 flush
-                }
-
-                // 先用静音填充缓冲区
-                memset(current_buffer, spec_.silence, bytes_per_buffer_);
-
-                // 调用回调函数获取音频数据
-                spec_.callback(spec_.userdata, current_buffer, bytes_per_buffer_);
-
-                // 将缓冲区入队到 OpenSL ES
-                slRet = (*slBufferQueueItf_)->Enqueue(slBufferQueueItf_,
-                                                     current_buffer,
-                                                     bytes_per_buffer_);
-                if (slRet == SL_RESULT_SUCCESS) {
-                    // 更新下一个缓冲区索引
-                    next_buffer_index = (next_buffer_index + 1) % OPENSLES_BUFFERS;
-                } else {
-                    ALOG_E(TAG, "Failed to enqueue audio buffer, error: %d", slRet);
-                }
+            // 使用局部变量管理缓冲区索引，深缓冲时一个 buffer 对应 OPENSLES_DEEP_BUFLEN
+            uint8_t* current_buffer = buffer_.data() + next_buffer_index * deep_bytes_per_buffer_;
+            const bool deep = useDeepBuffer();
+            const int bytes = deep ? deep_bytes_per_buffer_ : bytes_per_buffer_;
+            stats.setMode(deep);
+
+            // 检查是否有 flush 请求，如果有则先处理 flush
+            if (need_flush_.load(std::memory_order_relaxed)) {
+                ALOG_I(TAG, "[AUDIO_THREAD] Flush requested, skipping fill and will process flush");
+                continue;
+            }
+
+            // 只从 ring 拷贝，解码和重采样在生产线程完成
+            fillBuffer(current_buffer, bytes);
+
+            // 将缓冲区入队到 OpenSL ES
+            slRet = (*slBufferQueueItf_)->Enqueue(slBufferQueueItf_,
+                                                 current_buffer,
+                                                 bytes);
+            if (slRet == SL_RESULT_SUCCESS) {
+                onFramesWritten(bytes / bytes_per_frame_);
+                // 更新下一个缓冲区索引
+                next_buffer_index = (next_buffer_index + 1) % OPENSLES_BUFFERS;
             } else {
-                // 没有回调函数，填充静音
-                memset(current_buffer, spec_.silence, bytes_per_buffer_);
-                slRet = (*slBufferQueueItf_)->Enqueue(slBufferQueueItf_,
-                                                     current_buffer,
-                                                     bytes_per_buffer_);
-                if (slRet == SL_RESULT_SUCCESS) {
-                    next_buffer_index = (next_buffer_index + 1) % OPENSLES_BUFFERS;
-                }
+                ALOG_E(TAG, "Failed to enqueue audio buffer, error: %d", slRet);
             }
         } else {
             // 所有缓冲区都在使用中，等待回调唤醒
             // 简单等待，让 OpenSL ES 缓冲区回调能够唤醒线程
             wakeup_cond_->wait_for(lock, std::chrono::milliseconds(1000));
+            stats.wakeup();
         }
     }
 
     // 线程退出前的清理
-    ALOG_I(TAG, "[AUDIO_THREAD] Audio thread stopping, cleaning up...");
+    ALOG_I(TAG, "[AUDIO_THREAD] Audio thread stopping, clock average error %.2f ms", clock_.averageErrorMs());
+    stats.log(TAG, "AUDIO_THREAD");
     (*slPlayItf_)->SetPlayState(slPlayItf_, SL_PLAYSTATE_STOPPED);
     (*slBufferQueueItf_)->Clear(slBufferQueueItf_);
 
@@ -391,10 +697,29 @@ void SkySLESAudioOut::audioOutputThread() {
     ALOG_I(TAG, "Audio output thread exited");
 }
 
+void SkySLESAudioOut::fillBuffer(uint8_t *dst, int bytes) {
+    readPcm(dst, bytes, spec_.silence);
+}
+
+int64_t SkySLESAudioOut::getDevicePlayedFrames() {
+    if (!slPlayItf_ || sampleRate_ <= 0) {
+        return -1;
+    }
+    // 播放位置在 PAUSED 时保持，只有 STOPPED 才会归零
+    SLmillisecond position = 0;
+    if ((*slPlayItf_)->GetPosition(slPlayItf_, &position) != SL_RESULT_SUCCESS) {
+        return -1;
+    }
+    return static_cast<int64_t>(position) * sampleRate_ / 1000;
+}
+
 void SkySLESAudioOut::closeAudio() {
     ALOG_I(TAG, "Closing audio device");
     SkyAudioOut::closeAudio();
 
+    // 先停生产线程，它可能正在回调中解码
+    stopProducer();
+
     // 请求线程停止
     stop_thread_flag_.store(true, std::memory_order_relaxed);
 
@@ -407,11 +732,30 @@ void SkySLESAudioOut::closeAudio() {
     if (audio_thread_.joinable()) {
         audio_thread_.join(); // 或 detach，但推荐 join 以确保同步
     }
+
+    // 按 player -> output mix -> engine 的顺序销毁，进程内同时只能有一个引擎，不销毁会导致下次打开失败
+    slPlayItf_ = nullptr;
+    slVolumeItf_ = nullptr;
+    slBufferQueueItf_ = nullptr;
+    if (slPlayerObject_) {
+        (*slPlayerObject_)->Destroy(slPlayerObject_);
+        slPlayerObject_ = nullptr;
+    }
+    if (slOutputMixObject_) {
+        (*slOutputMixObject_)->Destroy(slOutputMixObject_);
+        slOutputMixObject_ = nullptr;
+    }
+    slEngine_ = nullptr;
+    if (slObject_) {
+        (*slObject_)->Destroy(slObject_);
+        slObject_ = nullptr;
+    }
 }
 
 void SkySLESAudioOut::pauseAudio(int pauseOn) {
     // 设置暂停状态
     pause_on_.store(pauseOn != 0, std::memory_order_relaxed);
+    setProducerPaused(pauseOn != 0);
 
     // 唤醒音频线程，让它检查新的暂停状态
     if (wakeup_cond_) {
@@ -419,6 +763,15 @@ void SkySLESAudioOut::pauseAudio(int pauseOn) {
     }
 }
 
+void SkySLESAudioOut::setVolume(float left, float right) {
+    left_volume.store(left, std::memory_order_relaxed);
+    right_volume.store(right, std::memory_order_relaxed);
+    need_set_volume.store(true, std::memory_order_relaxed);
+    if (wakeup_cond_) {
+        wakeup_cond_->notify_one();
+    }
+}
+
 void SkySLESAudioOut::flushAudio() {
     ALOG_I(TAG, "Flushing audio buffers");
 
@@ -427,11 +780,111 @@ void SkySLESAudioOut::flushAudio() {
            is_running_.load(std::memory_order_relaxed) ? "true" : "false",
            stop_thread_flag_.load(std::memory_order_relaxed) ? "true" : "false");
 
-    // 设置刷新标志
+    // 设置刷新标志，ring 和设备队列中的旧数据都要丢弃
+    requestRingFlush();
     need_flush_.store(true, std::memory_order_relaxed);
 
     // 唤醒音频线程，让它处理刷新请求
     if (wakeup_cond_) {
         wakeup_cond_->notify_one();
     }
-}
\ No newline at end of file
+}
+
+// ============================================================================
+// SkyNullAudioOut
+// ============================================================================
+
+bool SkyNullAudioOut::openAudio(const SkyAudioSpec *desired, SkyAudioSpec *obtained) {
+    if (desired->sdl_audioSpec.freq <= 0 || desired->sdl_audioSpec.channels <= 0) {
+        return false;
+    }
+
+    spec_ = *desired;
+    bytes_per_frame_ = desired->sdl_audioSpec.channels * SDL_AUDIO_BYTESIZE(desired->sdl_audioSpec.format);
+    frames_per_buffer_ = desired->sdl_audioSpec.freq * OPENSLES_BUFLEN / 1000;
+    buffer_.assign(static_cast<size_t>(bytes_per_frame_) * frames_per_buffer_, 0);
+
+    resetPosition(desired->sdl_audioSpec.freq);
+    minimalLatencySeconds = (double) OPENSLES_BUFFERS * OPENSLES_BUFLEN / 1000;
+    playedFrames_.store(0, std::memory_order_relaxed);
+    playedFramesExact_ = 0;
+
+    if (obtained) {
+        *obtained = *desired;
+        obtained->size = OPENSLES_BUFFERS * buffer_.size();
+    }
+
+    startProducer(spec_, bytes_per_frame_, static_cast<int>(buffer_.size()));
+
+    stop_.store(false, std::memory_order_relaxed);
+    pause_on_.store(true, std::memory_order_relaxed);
+    thread_ = std::thread([this]() {
+        this->outputThread();
+    });
+    ALOG_I(TAG, "null audio out opened: %d channels, %d Hz", desired->sdl_audioSpec.channels, desired->sdl_audioSpec.freq);
+    return true;
+}
+
+void SkyNullAudioOut::outputThread() {
+    const int64_t maxQueuedFrames = static_cast<int64_t>(OPENSLES_BUFFERS) * frames_per_buffer_;
+    lastTickUs_ = nowUs();
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(wakeup_mutex_);
+        if (pause_on_.load(std::memory_order_relaxed)) {
+            wakeup_cond_.wait(lock, [this] {
+                return !pause_on_.load(std::memory_order_relaxed) || stop_.load(std::memory_order_relaxed);
+            });
+            // 暂停期间设备不消耗数据
+            lastTickUs_ = nowUs();
+            continue;
+        }
+        if (need_flush_.exchange(false)) {
+            discardQueuedFrames();
+            continue;
+        }
+
+        // 按系统时间模拟设备消耗
+        int64_t now = nowUs();
+        int64_t written = framesWritten_.load(std::memory_order_relaxed);
+        playedFramesExact_ = std::min(static_cast<double>(written),
+                                      playedFramesExact_ + static_cast<double>(now - lastTickUs_) * sampleRate_ / 1000000.0);
+        lastTickUs_ = now;
+        auto played = static_cast<int64_t>(playedFramesExact_);
+        playedFrames_.store(played, std::memory_order_relaxed);
+
+        if (written - played < maxQueuedFrames) {
+            lock.unlock();
+            readPcm(buffer_.data(), static_cast<int>(buffer_.size()), spec_.silence);
+            onFramesWritten(frames_per_buffer_);
+        } else {
+            wakeup_cond_.wait_for(lock, std::chrono::milliseconds(OPENSLES_BUFLEN));
+        }
+    }
+    ALOG_I(TAG, "null audio out exit, clock average error %.2f ms", clock_.averageErrorMs());
+}
+
+int64_t SkyNullAudioOut::getDevicePlayedFrames() {
+    return playedFrames_.load(std::memory_order_relaxed);
+}
+
+void SkyNullAudioOut::pauseAudio(int pauseOn) {
+    pause_on_.store(pauseOn != 0, std::memory_order_relaxed);
+    setProducerPaused(pauseOn != 0);
+    wakeup_cond_.notify_one();
+}
+
+void SkyNullAudioOut::flushAudio() {
+    requestRingFlush();
+    need_flush_.store(true, std::memory_order_relaxed);
+    wakeup_cond_.notify_one();
+}
+
+void SkyNullAudioOut::closeAudio() {
+    stopProducer();
+    stop_.store(true, std::memory_order_relaxed);
+    wakeup_cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
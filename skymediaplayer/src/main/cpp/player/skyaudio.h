@@ -1,6 +1,8 @@
 #ifndef MY_PLAYER_SKYAUDIO_H
 #define MY_PLAYER_SKYAUDIO_H
 
+#include <atomic>
+#include <condition_variable>
 #include <thread>
 #include <mutex>
 #include <vector>
@@ -10,9 +12,17 @@
 #include "logger.h"
 #include "SDL3/SDL_audio.h"
 #include "ffplay.h"
+#include "sky_pcm_ring.h"
 
 #define OPENSLES_BUFFERS 4 /* 减少缓冲区数量以降低延迟 */
 #define OPENSLES_BUFLEN  10 /* ms */
+#define AUDIO_RING_MS    80 /* 生产线程提前解码的时长 */
+
+/* 深缓冲（省电）模式：设备 buffer 加大，生产线程在 ring 降到一半时集中解码到满 */
+#define OPENSLES_DEEP_BUFLEN    100  /* ms */
+#define AUDIO_DEEP_RING_MS      1000
+/* flush（seek）之后保持低延迟的时长，连续 seek 时不反复切换 */
+#define AUDIO_DEEP_HOLDOFF_MS   2000
 
 #define CHECK_OPENSL_ERROR(ret__, ...) \
     do { \
@@ -23,8 +33,63 @@
     	} \
     } while (0)
 
+/**
+ * 设备播放位置 -> 平滑后的已播放帧数。
+ * 设备位置按 burst 跳变且有读数抖动，这里用系统时间外推，再以 1/8 的比例向设备位置收敛，
+ * 误差过大（暂停、flush、设备重启）时直接对齐设备位置。
+ */
+class SkyAudioClock {
+public:
+    void reset(int sampleRate);
+    // devicePlayedFrames 为设备报告的已播放帧数，nowUs 为读取时刻
+    void update(int64_t devicePlayedFrames, int64_t nowUs);
+    // 外推到 nowUs 时刻的已播放帧数，没有设备位置时返回 -1
+    int64_t playedFrames(int64_t nowUs) const;
+    // 设备位置与外推值的平均偏差（ms），用于观察 A/V drift
+    double averageErrorMs() const { return averageErrorMs_; }
+
+private:
+    int sampleRate_ = 0;
+    bool valid_ = false;
+    double anchorFrames_ = 0;
+    int64_t anchorUs_ = 0;
+    double averageErrorMs_ = 0;
+};
+
+/**
+ * 按功耗模式统计线程的唤醒次数和 CPU 时间，模式切换和线程退出时结算，退出时输出日志。
+ * 只在所属线程内使用。
+ */
+class SkyThreadPowerStats {
+public:
+    void begin(bool deep);
+    void wakeup() { ++wakeups_[mode_]; }
+    void setMode(bool deep);
+    void log(const char *tag, const char *name);
+
+private:
+    void settle();
+
+private:
+    int mode_ = 0;
+    uint64_t wakeups_[2] = {0, 0};
+    double cpuMs_[2] = {0, 0};
+    double wallMs_[2] = {0, 0};
+    double lastCpuMs_ = 0;
+    int64_t lastWallUs_ = 0;
+};
+
+// ring 中 PCM 的格式，即交给设备（或混音器）的格式
+struct SkyPcmFormat {
+    int sampleRate = 0;
+    int channels = 0;
+    SDL_AudioFormat format = SDL_AUDIO_UNKNOWN;
+};
+
 class SkyAudioOut {
 public:
+    virtual ~SkyAudioOut() = default;
+
     virtual void free() {}
     virtual bool openAudio(const SkyAudioSpec *desired, SkyAudioSpec *obtained) {
         return 0;
@@ -32,16 +97,113 @@ public:
     virtual void pauseAudio(int pauseOn) {}
     virtual void flushAudio() {}
     virtual void setVolume(float left, float right) {}
+    // 声像 -1（左）~ 1（右），只有混音器输入支持
+    virtual void setPan(float pan) {}
     virtual void closeAudio() {}
 
-    virtual double getLatencySeconds() {
-        return 0.0;
+    /**
+     * 已解码但还没有播放的时长：ring 中的数据 + 设备队列中的数据，设备部分由播放位置计算。
+     * 只在生产线程（即音频回调中）调用。
+     */
+    virtual double getLatencySeconds();
+    /**
+     * 生产线程：按交给设备的帧数计的播放位置和写入位置。播放位置由设备位置外推，未知时返回 -1；
+     * 写入位置包括 ring 中的数据，再加上当前 chunk 已写的 pendingBytes
+     */
+    int64_t getPlayedFrames();
+    int64_t getWriteFramePosition(int pendingBytes) const;
+    virtual void setDefaultLatencySeconds(double latency) {
+        minimalLatencySeconds = latency;
+    }
+
+    // 设备位置与外推时钟的平均偏差（ms），任意线程可读，用于测量 A/V drift
+    double getClockErrorMs() const {
+        return clockErrorMs_.load(std::memory_order_relaxed);
+    }
+
+    // ring 读空的次数，连续读空只计一次
+    uint64_t getUnderrunCount() const {
+        return underruns_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 请求深缓冲模式：大设备 buffer + 批量解码，线程大部分时间休眠。
+     * 最近 AUDIO_DEEP_HOLDOFF_MS 内有 flush 时仍按低延迟运行，见 deepBufferActive
+     */
+    void setDeepBuffer(bool enabled);
+    bool deepBufferActive() const;
+
+    /**
+     * 分析线程：拷贝设备正在播放的 bytes 字节，不影响输出线程，取不到返回 0。
+     * 输出线程读走的数据还要经过设备队列才播放，窗口按 getLatencySeconds 算出的设备队列长度往前移。
+     * 混音器输入的数据还没有乘音量/声像。endIndex 与上次相同说明没有新数据（暂停）
+     */
+    size_t peekRecentPcm(uint8_t *dst, size_t bytes, SkyPcmFormat *format, uint64_t *endIndex) const;
+
+protected:
+    // 设备实际播放到的帧数，子类从设备读取，未知时返回 -1
+    virtual int64_t getDevicePlayedFrames() { return -1; }
+
+    void resetPosition(int sampleRate);
+    void onFramesWritten(int frames) {
+        framesWritten_.fetch_add(frames, std::memory_order_relaxed);
     }
-    virtual void setDefaultLatencySeconds(double latency) {}
+    // flush 丢掉了设备队列中的数据，写入位置回退到设备播放位置
+    void discardQueuedFrames();
+
+    /**
+     * 生产线程：提前调用 spec.callback 解码/重采样，按 chunkBytes 写入 ring，
+     * 输出线程只从 ring 拷贝，不会因为解码或内存分配阻塞
+     */
+    void startProducer(const SkyAudioSpec &spec, int bytesPerFrame, int chunkBytes);
+    void stopProducer();
+    void setProducerPaused(bool paused);
+    // ring 中已有的数据作废，在生产线程写完当前 chunk 后生效
+    void requestRingFlush();
+
+    // 输出线程：从 ring 读取，不足部分填静音
+    void readPcm(uint8_t *dst, int bytes, uint8_t silence);
+
+private:
+    void producerThread();
 
 public:
     std::mutex mtx;
-    double minimalLatencySeconds;
+    // 设备位置不可用时的兜底延迟
+    double minimalLatencySeconds = 0.0;
+
+protected:
+    int sampleRate_ = 0;
+    std::atomic<int64_t> framesWritten_{0};
+    // 设备队列中还没播放的帧数，生产线程在 getLatencySeconds 中更新，供分析线程对齐 peek 窗口
+    std::atomic<int64_t> deviceQueuedFrames_{0};
+    SkyAudioClock clock_;
+    // clock_ 只在生产线程访问，偏差经这里发布给其他线程
+    std::atomic<double> clockErrorMs_{0};
+
+private:
+    SkyPcmRing ring_;
+    Sky_AudioCallback producerCallback_ = nullptr;
+    void *producerUserdata_ = nullptr;
+    int producerBytesPerFrame_ = 0;
+    int producerChunkBytes_ = 0;
+    SkyPcmFormat producerFormat_;
+
+    std::thread producerThread_;
+    std::mutex producerMutex_;
+    std::condition_variable producerCond_;
+    std::atomic<bool> producerStop_{false};
+    std::atomic<bool> producerPaused_{true};
+    std::atomic<bool> ringFlushPending_{false};
+    // 低延迟模式下 ring 只填到这里，深缓冲模式填满整个 ring
+    size_t lowLatencyRingBytes_ = 0;
+
+    std::atomic<bool> deepBufferRequested_{false};
+    std::atomic<int64_t> lastFlushUs_{0};
+
+    // 只在输出线程访问
+    bool ringPrimed_ = false;
+    std::atomic<uint64_t> underruns_{0};
 };
 
 class SkySLESAudioOut : public SkyAudioOut {
@@ -54,10 +216,21 @@ public:
 
     void flushAudio() override;
 
+    void setVolume(float left, float right) override;
+
     void audioOutputThread();
 
     void closeAudio() override;
 
+protected:
+    int64_t getDevicePlayedFrames() override;
+
+    // 输出线程填充一个设备 buffer，默认从 ring 读取；混音器在这里直接混合各路输入
+    virtual void fillBuffer(uint8_t *dst, int bytes);
+    // 输出线程每次入队前查询，深缓冲时按 OPENSLES_DEEP_BUFLEN 入队
+    virtual bool useDeepBuffer() { return deepBufferActive(); }
+
+public:
     // 静态回调函数声明
     static void bufferQueueCallback(SLAndroidSimpleBufferQueueItf bufferQueueItf, void *context);
 
@@ -68,11 +241,14 @@ private:
     std::atomic<bool> stop_thread_flag_{false}; // 控制线程退出的标志
 
     SkyAudioSpec spec_;
-    SLDataFormat_PCM format_pcm_;
+    // PCM_EX 兼容 SLDataFormat_PCM 的字段，额外支持 float 表示
+    SLAndroidDataFormat_PCM_EX format_pcm_;
     int bytes_per_frame_ = 0;
     int milli_per_buffer_ = 0;
     int frames_per_buffer_ = 0;
     int bytes_per_buffer_ = 0;
+    int deep_frames_per_buffer_ = 0;
+    int deep_bytes_per_buffer_ = 0;
 
     SLObjectItf slObject_ = nullptr;
     SLEngineItf slEngine_ = nullptr;
@@ -95,4 +271,40 @@ private:
     size_t buffer_capacity_ = 0;
 };
 
+/**
+ * 不出声的输出：按系统时间模拟设备消耗数据，用于没有音频设备的环境和 A/V 同步测量
+ */
+class SkyNullAudioOut : public SkyAudioOut {
+public:
+    bool openAudio(const SkyAudioSpec *desired, SkyAudioSpec *obtained) override;
+    void pauseAudio(int pauseOn) override;
+    void flushAudio() override;
+    void closeAudio() override;
+
+protected:
+    int64_t getDevicePlayedFrames() override;
+
+private:
+    void outputThread();
+
+private:
+    SkyAudioSpec spec_{};
+    int bytes_per_frame_ = 0;
+    int frames_per_buffer_ = 0;
+    std::vector<uint8_t> buffer_;
+
+    std::thread thread_;
+    std::mutex wakeup_mutex_;
+    std::condition_variable wakeup_cond_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> pause_on_{true};
+    std::atomic<bool> need_flush_{false};
+
+    // 输出线程写，生产线程经 getDevicePlayedFrames 读；小数部分留在输出线程的 playedFramesExact_ 中
+    std::atomic<int64_t> playedFrames_{0};
+    // 只在输出线程访问
+    double playedFramesExact_ = 0;
+    int64_t lastTickUs_ = 0;
+};
+
 #endif //MY_PLAYER_SKYAUDIO_H
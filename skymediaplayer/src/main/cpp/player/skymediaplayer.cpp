@@ -1,14 +1,25 @@
 extern "C" {
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/log.h"
 }
 
+#include <algorithm>
+#include <cstring>
 #include "logger.h"
 #include "skymediaplayer.h"
+#include "sky_anativewindow_renderer.h"
+#include "sky_audio_mixer.h"
+#include "sky_disk_cache.h"
+#include "sky_mmap_io.h"
+#include "sky_parallel_io.h"
+#include "sky_preload.h"
 #include "ffplay.h"
 #include "skymediaplayer_interface.h"
 
 extern bool postEventToJava(SkyPlayer* player, int what, int arg1, int arg2, jobject obj);
+extern bool postStringEventToJava(SkyPlayer* player, int what, int arg1, int arg2, const char* str);
 
 namespace {
     std::once_flag ffmpegLogInitFlag;
@@ -35,7 +46,7 @@ void setSkyPlayerWeakJavaPlayer(SkyPlayer *player, void *weakJavaPlayer) {
     player->setWeakJavaPlayerPtr(weakJavaPlayer);
 }
 
-bool sky_display_image(void *player, AVFrame *frame) {
+bool sky_display_image(void *player, AVFrame *frame, int rotation, int flip) {
     if (nullptr == player) {
         ALOG_E(TAG, "sky_display_image() player == null");
         return false;
@@ -43,7 +54,7 @@ bool sky_display_image(void *player, AVFrame *frame) {
 
     auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
 
-    bool ret = skyPlayer->getSkyVideoOutHandler().displayImage(frame);
+    bool ret = skyPlayer->getSkyVideoOutHandler().displayImage(frame, rotation, flip);
     if (!ret) {
         ALOG_E(TAG, "=== displayImage FAILED === for frame %dx%d format=%s",
                frame->width, frame->height,
@@ -56,6 +67,84 @@ bool sky_display_image(void *player, AVFrame *frame) {
     return ret;
 }
 
+void sky_set_video_eq(void *player, const SkyVideoEq *eq) {
+    if (nullptr == player || nullptr == eq) {
+        ALOG_E(TAG, "sky_set_video_eq() null ptr");
+        return;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    skyPlayer->getSkyVideoOutHandler().setVideoEq(*eq);
+}
+
+void sky_get_video_target_size(void *player, int *width, int *height) {
+    *width = 0;
+    *height = 0;
+    if (nullptr == player) {
+        return;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    skyPlayer->getSkyVideoOutHandler().getSurfaceSize(width, height);
+}
+
+void sky_set_subtitle(void *player, const AVSubtitle *sub, int width, int height) {
+    if (nullptr == player) {
+        ALOG_E(TAG, "sky_set_subtitle() player == null");
+        return;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    skyPlayer->getSkyVideoOutHandler().setSubtitle(sub, width, height);
+}
+
+bool sky_capture_pending(void *player) {
+    if (nullptr == player) {
+        return false;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    return skyPlayer->getFrameCapturer().isPending();
+}
+
+void sky_capture_frame(void *player, const AVFrame *frame, double pts, int rotation, int flip) {
+    if (nullptr == player) {
+        ALOG_E(TAG, "sky_capture_frame() player == null");
+        return;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    skyPlayer->getFrameCapturer().submit(frame, pts, rotation, flip);
+}
+
+bool sky_frame_tap_active(void *player) {
+    if (nullptr == player) {
+        return false;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    return skyPlayer->getFrameTap().isActive();
+}
+
+void sky_frame_tap_submit(void *player, const AVFrame *frame, double pts) {
+    if (nullptr == player) {
+        ALOG_E(TAG, "sky_frame_tap_submit() player == null");
+        return;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    skyPlayer->getFrameTap().submit(frame, pts);
+}
+
+void sky_pcm_tap_write(void *player, const uint8_t *data, int bytes, int format, int channels, int sample_rate) {
+    if (nullptr == player || bytes <= 0) {
+        return;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    skyPlayer->getPcmTap().write(data, static_cast<size_t>(bytes), format, channels, sample_rate);
+}
+
 bool sky_open_audio(void *player, SkyAudioSpec *desired, SkyAudioSpec *obtained) {
     if (nullptr == player) {
         ALOG_E(TAG, "sky_open_audio() player == null");
@@ -73,10 +162,16 @@ bool sky_open_audio(void *player, SkyAudioSpec *desired, SkyAudioSpec *obtained)
     ALOG_I(TAG, "sky_open_audio() attempting to open: %d channels, %d Hz",
            desired->sdl_audioSpec.channels, desired->sdl_audioSpec.freq);
 
-    if (skyAudioOutHandler.openAudio(AudioOutType::OPENSL_ES, desired, obtained)) {
+    // 回调经播放器转发，播放列表在回调里把下一项接在当前项的最后一个采样之后
+    skyPlayer->setAudioSource(static_cast<VideoState*>(desired->userdata));
+    desired->callback = SkyPlayer::audioCallback;
+    desired->userdata = skyPlayer;
+
+    if (skyAudioOutHandler.openAudio(skyPlayer->audioOutType.load(), desired, obtained)) {
         ALOG_I(TAG, "sky_open_audio() openAudio success: %d channels, %d Hz",
                obtained ? obtained->sdl_audioSpec.channels : desired->sdl_audioSpec.channels,
                obtained ? obtained->sdl_audioSpec.freq : desired->sdl_audioSpec.freq);
+        skyPlayer->setAudioSpec(obtained ? *obtained : *desired);
         return true;
     }
 
@@ -99,6 +194,15 @@ void sky_pause_audio(void *player, bool pause) {
     ALOG_I(TAG, "sky_pause_audio() %s", pause ? "paused" : "resumed");
 }
 
+double sky_get_audio_latency(void *player) {
+    if (nullptr == player) {
+        return 0.0;
+    }
+
+    auto* skyPlayer = reinterpret_cast<SkyPlayer*>(player);
+    return skyPlayer->getSkyAudioOutHandler().getLatencySeconds();
+}
+
 void sky_flush_audio(void *player) {
     if (nullptr == player) {
         ALOG_E(TAG, "sky_flush_audio() player == null");
@@ -113,13 +217,37 @@ void sky_flush_audio(void *player) {
     ALOG_I(TAG, "sky_flush_audio() audio buffers flushed");
 }
 
+const char *sky_io_filename(const char *url) {
+    return SkyDiskCache::unwrapUrl(url);
+}
+
+AVIOContext *sky_io_open(const char *url, const AVIOInterruptCB *interrupt) {
+    if (nullptr == url) {
+        return nullptr;
+    }
+    if (SkyDiskCache::isCacheUrl(url)) {
+        return SkyDiskCache::instance().openIo(url, interrupt);
+    }
+    if (SkyParallelIo::isParallelUrl(url)) {
+        return SkyParallelIo::open(url, interrupt);
+    }
+    if (SkyMmapIo::isLocalFile(url)) {
+        return SkyMmapIo::open(url);
+    }
+    return SkyPreloadManager::instance().openIo(url, interrupt);
+}
+
+void sky_io_close(AVIOContext **pb) {
+    SkyIo::close(pb);
+}
+
 // ============================================================================
 // Message Sending Interface Implementation
 // ============================================================================
 
 bool sky_post_message(void *player, int what, int arg1, int arg2, void *obj) {
     if (nullptr == player) {
-        ALOG_E(TAG, "sky_post_message() player == null");
+        // 预加载的播放列表项还没有交给播放器，消息直接丢弃
         return false;
     }
 
@@ -133,7 +261,7 @@ bool sky_post_message(void *player, int what, int arg1, int arg2, void *obj) {
 
 bool sky_post_simple_message(void *player, int what) {
     if (nullptr == player) {
-        ALOG_E(TAG, "sky_post_simple_message() player == null");
+        // 预加载的播放列表项还没有交给播放器，消息直接丢弃
         return false;
     }
 
@@ -146,7 +274,7 @@ bool sky_post_simple_message(void *player, int what) {
 
 bool sky_post_message_ii(void *player, int what, int arg1, int arg2) {
     if (nullptr == player) {
-        ALOG_E(TAG, "sky_post_message_ii() player == null");
+        // 预加载的播放列表项还没有交给播放器，消息直接丢弃
         return false;
     }
 
@@ -164,21 +292,25 @@ bool sky_post_message_ii(void *player, int what, int arg1, int arg2) {
 
 void SkyVideoOutHandler::setWindow(EGLNativeWindowType window) {
     FUNC_TRACE()
+    std::lock_guard<std::mutex> lock(mtx);
     if (window_ == window) {
         ALOG_W(TAG, "duplicate set window");
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mtx);
-
-    // release old resources
+    // release old window, keep EGL context
     if (nullptr != window_) {
-        releaseResources();
+        releaseWindow();
     }
 
     if (nullptr != window) {
         ANativeWindow_acquire(window);
         window_ = window;
+        hasWindow_.store(true);
+        // 上层未告知显示尺寸时，以 window 当前尺寸作为近似
+        if (0 == surfaceWidth_.load() || 0 == surfaceHeight_.load()) {
+            setSurfaceSize(ANativeWindow_getWidth(window), ANativeWindow_getHeight(window));
+        }
 
         // 重新创建渲染器，确保Surface重建后能正常渲染
         if (!renderer_) {
@@ -192,29 +324,169 @@ void SkyVideoOutHandler::setWindow(EGLNativeWindowType window) {
     }
 }
 
+bool SkyVideoOutHandler::addWindow(EGLNativeWindowType window, const SkyRenderOutput &output) {
+    FUNC_TRACE()
+    std::lock_guard<std::mutex> lock(mtx);
+    if (nullptr == window || window == window_) {
+        ALOG_E(TAG, "addWindow invalid window %p", window);
+        return false;
+    }
+    if (!renderer_ || !renderer_->setOutput(window, output)) {
+        ALOG_W(TAG, "renderer does not support multiple outputs");
+        return false;
+    }
+    if (std::find(extraWindows_.begin(), extraWindows_.end(), window) == extraWindows_.end()) {
+        ANativeWindow_acquire(window);
+        extraWindows_.push_back(window);
+    }
+    return true;
+}
+
+void SkyVideoOutHandler::removeWindow(EGLNativeWindowType window) {
+    FUNC_TRACE()
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = std::find(extraWindows_.begin(), extraWindows_.end(), window);
+    if (it == extraWindows_.end()) {
+        return;
+    }
+    if (renderer_) {
+        renderer_->removeOutput(window);
+    }
+    ANativeWindow_release(window);
+    extraWindows_.erase(it);
+}
+
+void SkyVideoOutHandler::setSurfaceSize(int width, int height) {
+    if (width == surfaceWidth_.load() && height == surfaceHeight_.load()) {
+        return;
+    }
+    ALOG_I(TAG, "surface size %dx%d", width, height);
+    surfaceWidth_.store(width > 0 ? width : 0);
+    surfaceHeight_.store(height > 0 ? height : 0);
+}
+
+void SkyVideoOutHandler::getSurfaceSize(int *width, int *height) const {
+    *width = surfaceWidth_.load();
+    *height = surfaceHeight_.load();
+}
+
+void SkyVideoOutHandler::releaseWindow() {
+    // 注意：这里不需要加锁，因为调用方已经加锁了
+
+    // 只销毁与当前 Surface 绑定的 EGLSurface，display/context/program 保留
+    if (renderer_) {
+        renderer_->releaseSurface();
+    }
+
+    if (window_) {
+        ANativeWindow_release(window_);
+        window_ = nullptr;
+        hasWindow_.store(false);
+        ALOG_I(TAG, "Released ANativeWindow");
+    }
+}
+
 void SkyVideoOutHandler::releaseResources() {
     // 注意：这里不需要加锁，因为调用方已经加锁了
 
     ALOG_I(TAG, "SkyVideoOutHandler releasing resources");
 
-    // 只释放与当前Surface相关的渲染资源，但保留渲染器实例
+    // 播放器销毁时才整体释放 EGL 资源，但保留渲染器实例
     if (renderer_) {
-        ALOG_I(TAG, "Terminating renderer for current surface");
+        ALOG_I(TAG, "Terminating renderer");
         renderer_->terminate();
         // 注意：不要reset渲染器，保留实例以便重用
     }
 
-    // 释放 window 资源
-    if (window_) {
-        ANativeWindow_release(window_);
-        window_ = nullptr;
-        ALOG_I(TAG, "Released ANativeWindow");
+    releaseWindow();
+
+    for (auto window : extraWindows_) {
+        if (renderer_) {
+            renderer_->removeOutput(window);
+        }
+        ANativeWindow_release(window);
     }
+    extraWindows_.clear();
 
     ALOG_I(TAG, "SkyVideoOutHandler resources released (renderer preserved)");
 }
 
-bool SkyVideoOutHandler::displayImage(AVFrame *frame) {
+void SkyVideoOutHandler::setVideoEq(const SkyVideoEq &eq) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (renderer_) {
+        renderer_->setEq(eq);
+    }
+}
+
+void SkyVideoOutHandler::setWatermark(std::shared_ptr<const SkyWatermark> watermark) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (renderer_) {
+        renderer_->setWatermark(std::move(watermark));
+    }
+}
+
+void SkyVideoOutHandler::setSubtitle(const AVSubtitle *sub, int width, int height) {
+    std::shared_ptr<SkyWatermark> image;
+    if (nullptr != sub && width > 0 && height > 0) {
+        // 所有位图 rect 的包围盒，合成到一张纹理里
+        int left = width, top = height, right = 0, bottom = 0;
+        for (unsigned i = 0; i < sub->num_rects; ++i) {
+            const AVSubtitleRect* rect = sub->rects[i];
+            if (rect->type != SUBTITLE_BITMAP || rect->w <= 0 || rect->h <= 0) {
+                continue;
+            }
+            left = std::min(left, std::max(rect->x, 0));
+            top = std::min(top, std::max(rect->y, 0));
+            right = std::max(right, std::min(rect->x + rect->w, width));
+            bottom = std::max(bottom, std::min(rect->y + rect->h, height));
+        }
+
+        if (right > left && bottom > top) {
+            image = std::make_shared<SkyWatermark>();
+            image->width = right - left;
+            image->height = bottom - top;
+            image->pixels.assign(static_cast<size_t>(image->width) * image->height * 4, 0);
+            image->left = static_cast<float>(left) / width;
+            image->top = static_cast<float>(top) / height;
+            image->right = static_cast<float>(right) / width;
+            image->bottom = static_cast<float>(bottom) / height;
+
+            for (unsigned i = 0; i < sub->num_rects; ++i) {
+                const AVSubtitleRect* rect = sub->rects[i];
+                if (rect->type != SUBTITLE_BITMAP || rect->w <= 0 || rect->h <= 0) {
+                    continue;
+                }
+                // 调色板为 native endian 的 0xAARRGGBB，先转成 premultiplied RGBA 查找表
+                uint8_t lut[256][4];
+                const auto* palette = reinterpret_cast<const uint32_t*>(rect->data[1]);
+                for (int c = 0; c < 256; ++c) {
+                    uint32_t argb = c < rect->nb_colors ? palette[c] : 0;
+                    uint32_t a = argb >> 24;
+                    lut[c][0] = static_cast<uint8_t>(((argb >> 16) & 0xFF) * a / 255);
+                    lut[c][1] = static_cast<uint8_t>(((argb >> 8) & 0xFF) * a / 255);
+                    lut[c][2] = static_cast<uint8_t>((argb & 0xFF) * a / 255);
+                    lut[c][3] = static_cast<uint8_t>(a);
+                }
+                int x0 = std::max(rect->x, left), x1 = std::min(rect->x + rect->w, right);
+                int y0 = std::max(rect->y, top), y1 = std::min(rect->y + rect->h, bottom);
+                for (int y = y0; y < y1; ++y) {
+                    const uint8_t* src = rect->data[0] + static_cast<ptrdiff_t>(y - rect->y) * rect->linesize[0] + (x0 - rect->x);
+                    uint8_t* dst = image->pixels.data() + (static_cast<size_t>(y - top) * image->width + (x0 - left)) * 4;
+                    for (int x = x0; x < x1; ++x, dst += 4) {
+                        memcpy(dst, lut[*src++], 4);
+                    }
+                }
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (renderer_) {
+        renderer_->setSubtitle(std::move(image));
+    }
+}
+
+bool SkyVideoOutHandler::displayImage(AVFrame *frame, int rotation, int flip) {
     std::lock_guard<std::mutex> lock(mtx);
 
     // 检查渲染器是否存在
@@ -230,7 +502,20 @@ bool SkyVideoOutHandler::displayImage(AVFrame *frame) {
     }
 
     // 尝试渲染
+    renderer_->setOrientation(rotation, flip);
     bool result = renderer_->displayImage(window_, frame);
+    if (!result && renderer_->isUnavailable()) {
+        // EGL 在部分模拟器/低端机上无法初始化，切换到 CPU 渲染，之后一直使用
+        ALOG_W(TAG, "renderer unavailable, fallback to ANativeWindow renderer");
+        renderer_->terminate();
+        renderer_ = std::make_unique<SkyANativeWindowRenderer>();
+        if (!extraWindows_.empty()) {
+            ALOG_W(TAG, "fallback renderer only draws the main window, %zu extra outputs not drawn",
+                   extraWindows_.size());
+        }
+        renderer_->setOrientation(rotation, flip);
+        result = renderer_->displayImage(window_, frame);
+    }
     if (!result) {
         ALOG_W(TAG, "displayImage() failed for frame %dx%d format=%s",
                frame->width, frame->height,
@@ -253,6 +538,12 @@ std::unique_ptr<SkyAudioOut> SkyAudioOutHandler::createAudioOutInstance(AudioOut
         case AudioOutType::OPENSL_ES:
             audioOut = std::make_unique<SkySLESAudioOut>();
             break;
+        case AudioOutType::NULL_SINK:
+            audioOut = std::make_unique<SkyNullAudioOut>();
+            break;
+        case AudioOutType::SHARED_MIXER:
+            audioOut = std::make_unique<SkyMixerAudioOut>();
+            break;
         default:
             ALOG_E(TAG, "unknown audio out type");
             audioOut = nullptr;
@@ -264,19 +555,61 @@ std::unique_ptr<SkyAudioOut> SkyAudioOutHandler::createAudioOutInstance(AudioOut
 
 bool SkyAudioOutHandler::openAudio(const AudioOutType audioOutType, SkyAudioSpec *desired,
                                    SkyAudioSpec *obtained) {
-    if (skyAudioOut_) {
-        skyAudioOut_->closeAudio();
+    std::unique_ptr<SkyAudioOut> oldAudioOut;
+    {
+        // 分析线程在锁内访问 skyAudioOut_，换下的对象在锁外关闭
+        std::lock_guard<std::mutex> lock(mtx);
+        oldAudioOut = std::move(skyAudioOut_);
+    }
+    if (oldAudioOut) {
         ALOG_E(TAG, "openAudio() skyAudioOut_ != null");
-        skyAudioOut_ = nullptr;
+        oldAudioOut->closeAudio();
+        oldAudioOut.reset();
     }
 
-    skyAudioOut_ = createAudioOutInstance(audioOutType);
-    if (nullptr == skyAudioOut_) {
+    auto audioOut = createAudioOutInstance(audioOutType);
+    if (nullptr == audioOut) {
         ALOG_E(TAG, "createAudioOutInstance failed");
         return false;
     }
 
-    return skyAudioOut_->openAudio(desired, obtained);
+    SkyAudioOut* out = audioOut.get();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        audioOut->setVolume(leftVolume_, rightVolume_);
+        audioOut->setPan(pan_);
+        audioOut->setDeepBuffer(deepBuffer_);
+        skyAudioOut_ = std::move(audioOut);
+    }
+    return out->openAudio(desired, obtained);
+}
+
+void SkyAudioOutHandler::setVolume(float left, float right) {
+    std::lock_guard<std::mutex> lock(mtx);
+    leftVolume_ = left;
+    rightVolume_ = right;
+    if (skyAudioOut_) {
+        skyAudioOut_->setVolume(left, right);
+    }
+}
+
+void SkyAudioOutHandler::setDeepBuffer(bool enabled) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (deepBuffer_ != enabled) {
+        ALOG_I(TAG, "audio deep buffer %s", enabled ? "on" : "off");
+    }
+    deepBuffer_ = enabled;
+    if (skyAudioOut_) {
+        skyAudioOut_->setDeepBuffer(enabled);
+    }
+}
+
+void SkyAudioOutHandler::setPan(float pan) {
+    std::lock_guard<std::mutex> lock(mtx);
+    pan_ = pan;
+    if (skyAudioOut_) {
+        skyAudioOut_->setPan(pan);
+    }
 }
 
 void SkyAudioOutHandler::pauseAudio(bool pause) {
@@ -293,12 +626,44 @@ void SkyAudioOutHandler::flushAudio() {
     }
 }
 
-void SkyAudioOutHandler::cleanup() {
+size_t SkyAudioOutHandler::peekRecentPcm(uint8_t *dst, size_t bytes, SkyPcmFormat *format, uint64_t *endIndex) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!skyAudioOut_) {
+        *format = SkyPcmFormat();
+        *endIndex = 0;
+        return 0;
+    }
+    return skyAudioOut_->peekRecentPcm(dst, bytes, format, endIndex);
+}
+
+double SkyAudioOutHandler::getClockErrorMs() {
     std::lock_guard<std::mutex> lock(mtx);
+    return skyAudioOut_ ? skyAudioOut_->getClockErrorMs() : 0.0;
+}
+
+double SkyAudioOutHandler::getLatencySeconds() {
+    // 不加锁：在音频回调中调用，SkyAudioOut 对象在音频线程退出后才会被释放
+    return skyAudioOut_ ? skyAudioOut_->getLatencySeconds() : 0.0;
+}
+
+int64_t SkyAudioOutHandler::getPlayedFrames() {
+    return skyAudioOut_ ? skyAudioOut_->getPlayedFrames() : -1;
+}
+
+int64_t SkyAudioOutHandler::getWriteFramePosition(int pendingBytes) {
+    return skyAudioOut_ ? skyAudioOut_->getWriteFramePosition(pendingBytes) : 0;
+}
+
+void SkyAudioOutHandler::cleanup() {
     ALOG_I(TAG, "SkyAudioOutHandler cleanup starting");
-    if (skyAudioOut_) {
-        skyAudioOut_->closeAudio();
-        skyAudioOut_.reset();
+    std::unique_ptr<SkyAudioOut> audioOut;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        audioOut = std::move(skyAudioOut_);
+    }
+    // 在锁外 join 音频线程：回调里的 sky_flush_audio 也要拿这把锁
+    if (audioOut) {
+        audioOut->closeAudio();
     }
     ALOG_I(TAG, "SkyAudioOutHandler cleanup completed");
 }
@@ -312,6 +677,12 @@ SkyPlayer::SkyPlayer()
     , is(nullptr)
     , weakJavaPlayer(nullptr)
     , playerState(STATE_IDLE)
+    , frameCapturer_([this](int positionMs, int result, const std::string &path) {
+        char* name = av_strdup(path.c_str());
+        if (!postMessage(SKY_MSG_GET_IMG_STATE, positionMs, result, name)) {
+            av_free(name);
+        }
+    })
     , isDestroyed_(false) {
 }
 
@@ -326,11 +697,32 @@ void SkyPlayer::cleanup() {
 
     ALOG_I(TAG, "SkyPlayer cleanup starting");
 
-    // 1. 停止消息队列
+    // 1. 停止截图线程、旁路线程、分析线程和消息队列，截图回调会往队列里发消息
+    frameCapturer_.stop();
+    frameTap_.unsubscribe();
+    setAudioAnalysisEnabled(false, 0);
+    setLoudnessMeterEnabled(false);
     messageQueue_.abort();
     messageQueue_.destroy();
 
-    // 2. 停止播放并清理 ffplay 资源
+    // 2. 停止播放并清理 ffplay 资源，包括预加载和正在接续的播放列表项
+    VideoState* preloaded;
+    VideoState* handoff;
+    {
+        std::lock_guard<std::mutex> lock(playlistMutex_);
+        preloaded = preloaded_;
+        handoff = handoff_;
+        preloaded_ = handoff_ = handoffFrom_ = nullptr;
+        playlist_.clear();
+        playlistPending_.store(false);
+    }
+    audioState_.store(nullptr);
+    if (preloaded) {
+        stream_close(preloaded);
+    }
+    if (handoff) {
+        stream_close(handoff);
+    }
     if (is) {
         stream_close(is);
         is = nullptr;
@@ -411,6 +803,10 @@ void SkyPlayer::prepareAsync() {
         is = stream_open(data_source_, nullptr);
         if (is) {
             is->skyPlayer = this;  // 关键：建立C到C++的连接
+            is->audio_tap_enabled = pcmTapEnabled_.load() ? 1 : 0;
+            if (!videoFilters_.empty()) {
+                set_video_filters(is, videoFilters_.c_str());
+            }
             setPlayerState(STATE_PREPARED);
 
             // 启动消息队列
@@ -425,6 +821,291 @@ void SkyPlayer::prepareAsync() {
     }
 }
 
+void SkyPlayer::setVideoFilters(const char *filters) {
+    std::lock_guard<std::mutex> lock(mtx);
+    videoFilters_ = filters ? filters : "";
+    ALOG_I(TAG, "setVideoFilters %s", videoFilters_.c_str());
+    if (is) {
+        set_video_filters(is, videoFilters_.empty() ? nullptr : videoFilters_.c_str());
+    }
+    std::lock_guard<std::mutex> playlistLock(playlistMutex_);
+    if (preloaded_) {
+        set_video_filters(preloaded_, videoFilters_.empty() ? nullptr : videoFilters_.c_str());
+    }
+}
+
+void SkyPlayer::appendPlaylistItem(const char* path) {
+    if (nullptr == path) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(playlistMutex_);
+        playlist_.emplace_back(path);
+        playlistPending_.store(true);
+    }
+    ALOG_I(TAG, "appendPlaylistItem %s", path);
+    // 在消息线程打开，当前项已打开音频设备时马上开始预加载
+    postMessage(SKY_MSG_PLAYLIST_PRELOAD);
+}
+
+void SkyPlayer::clearPlaylist() {
+    VideoState* preloaded;
+    bool handoff;
+    {
+        std::lock_guard<std::mutex> lock(playlistMutex_);
+        playlist_.clear();
+        playlistGeneration_++;
+        preloaded = preloaded_;
+        preloaded_ = nullptr;
+        handoff = handoff_ != nullptr;
+        advanceRequested_ = false;
+        // 已接续的项还要等切换
+        playlistPending_.store(handoff);
+    }
+    ALOG_I(TAG, "clearPlaylist");
+    if (preloaded) {
+        stream_close(preloaded);
+    }
+
+    // 当前项读到文件尾时还有下一项，COMPLETED 被忽略了，这里补发
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!handoff && is && is->eof) {
+        postMessage(SKY_MSG_COMPLETED);
+    }
+}
+
+void SkyPlayer::audioCallback(void *userdata, Uint8 *stream, int len) {
+    static_cast<SkyPlayer*>(userdata)->fillAudio(stream, len);
+}
+
+void SkyPlayer::setAudioSource(VideoState *state) {
+    audioState_.store(state);
+}
+
+void SkyPlayer::setAudioSpec(const SkyAudioSpec &spec) {
+    std::lock_guard<std::mutex> lock(playlistMutex_);
+    audioSpec_ = spec;
+}
+
+void SkyPlayer::fillAudio(uint8_t *stream, int len) {
+    VideoState* current = audioState_.load();
+    if (nullptr == current) {
+        memset(stream, 0, len);
+        return;
+    }
+    if (!playlistPending_.load()) {
+        stream_audio_fill(current, stream, len, 0, 0);
+        return;
+    }
+
+    int filled = stream_audio_fill(current, stream, len, 0, 1);
+    VideoState* next = nullptr;
+    if (handoffWaiting_) {
+        std::lock_guard<std::mutex> lock(playlistMutex_);
+        if (nullptr == handoffFrom_) {
+            // cleanup 已经取走
+            handoffWaiting_ = false;
+        } else {
+            // 设备播到接续点之前听到的还是上一项，上一项的视频也要显示完
+            int64_t played = skyAudioOutHandler_.getPlayedFrames();
+            if ((played < 0 || played >= handoffFrame_) && stream_video_ended(handoffFrom_)) {
+                handoffFrom_ = nullptr;
+                handoffWaiting_ = false;
+                postMessage(SKY_MSG_PLAYLIST_ADVANCE);
+            }
+        }
+    } else if (filled < len) {
+        std::lock_guard<std::mutex> lock(playlistMutex_);
+        if (preloaded_ && preloaded_->read_status > 0 && !handoff_) {
+            // 当前项的音频已全部交出，下一项从这个 buffer 的同一位置接着写，
+            // 两者的时钟都按同一个设备延迟计算，中间没有静音。
+            // 视频要等设备播到接续点才切换，在这之前上一项继续显示，下一项的帧留在队列中
+            next = preloaded_;
+            preloaded_ = nullptr;
+            handoff_ = next;
+            handoffFrom_ = current;
+            handoffFrame_ = skyAudioOutHandler_.getWriteFramePosition(filled);
+            handoffWaiting_ = true;
+            next->video_hold = 1;
+            stream_activate(next, this);
+            audioState_.store(next);
+        } else if (!handoff_ && !advanceRequested_ && (!preloaded_ || preloaded_->read_status < 0)) {
+            // 下一项打开失败或还没开始预加载，交给消息线程，这期间输出静音
+            advanceRequested_ = true;
+            postMessage(SKY_MSG_PLAYLIST_ADVANCE);
+        }
+    }
+    if (next) {
+        filled = stream_audio_fill(next, stream, len, filled, 1);
+    }
+    if (filled < len) {
+        memset(stream + filled, 0, len - filled);
+    }
+}
+
+void SkyPlayer::startPreload() {
+    std::string filters;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!is) {
+            return;
+        }
+        filters = videoFilters_;
+    }
+
+    for (;;) {
+        std::string path;
+        SkyAudioSpec spec;
+        int generation;
+        {
+            std::lock_guard<std::mutex> lock(playlistMutex_);
+            // 设备还没打开（当前项没有音频）时无法预加载，由 openNextItem 处理
+            if (preloaded_ || handoff_ || playlist_.empty() || audioSpec_.sdl_audioSpec.freq <= 0) {
+                return;
+            }
+            path = playlist_.front();
+            playlist_.pop_front();
+            queuedIndex_++;
+            spec = audioSpec_;
+            generation = playlistGeneration_;
+        }
+
+        VideoState* next = stream_open_preload(path.c_str(), nullptr, &spec);
+        if (next && !filters.empty()) {
+            set_video_filters(next, filters.c_str());
+        }
+
+        std::unique_lock<std::mutex> lock(playlistMutex_);
+        if (generation != playlistGeneration_) {
+            lock.unlock();
+            if (next) {
+                stream_close(next);
+            }
+            return;
+        }
+        if (next) {
+            ALOG_I(TAG, "playlist item %d preloading %s", queuedIndex_, path.c_str());
+            preloaded_ = next;
+            playlistPending_.store(true);
+            return;
+        }
+        ALOG_E(TAG, "playlist item %d open failed, skipped: %s", queuedIndex_, path.c_str());
+        playlistPending_.store(!playlist_.empty());
+    }
+}
+
+void SkyPlayer::onPlaylistAdvance() {
+    VideoState* next = nullptr;
+    VideoState* failed = nullptr;
+    int index;
+    {
+        std::lock_guard<std::mutex> lock(playlistMutex_);
+        advanceRequested_ = false;
+        // handoffFrom_ 不为空说明音频回调还在等接续点
+        if (handoff_ && !handoffFrom_) {
+            next = handoff_;
+            handoff_ = nullptr;
+            playlistPending_.store(!playlist_.empty());
+        }
+        if (!handoff_ && preloaded_ && preloaded_->read_status < 0) {
+            failed = preloaded_;
+            preloaded_ = nullptr;
+            playlistPending_.store(!playlist_.empty());
+        }
+        index = queuedIndex_;
+    }
+
+    if (failed) {
+        ALOG_E(TAG, "playlist item %d failed (%d), skipped", index, failed->read_status);
+        stream_close(failed);
+    }
+    if (next) {
+        switchToItem(next, index);
+    }
+    startPreload();
+
+    if (!playlistPending_.load()) {
+        // 列表已到最后一项，它在预加载时读到文件尾的 COMPLETED 被丢弃了
+        std::lock_guard<std::mutex> lock(mtx);
+        if (is && is->eof) {
+            postMessage(SKY_MSG_COMPLETED);
+        }
+    }
+}
+
+void SkyPlayer::openNextItem() {
+    std::string filters;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        filters = videoFilters_;
+    }
+
+    for (;;) {
+        std::string path;
+        int index;
+        {
+            std::lock_guard<std::mutex> lock(playlistMutex_);
+            if (playlist_.empty()) {
+                playlistPending_.store(false);
+                break;
+            }
+            path = playlist_.front();
+            playlist_.pop_front();
+            index = ++queuedIndex_;
+            playlistPending_.store(!playlist_.empty());
+        }
+
+        VideoState* next = stream_open(path.c_str(), nullptr);
+        if (nullptr == next) {
+            ALOG_E(TAG, "playlist item %d open failed, skipped: %s", index, path.c_str());
+            continue;
+        }
+        next->skyPlayer = this;
+        if (!filters.empty()) {
+            set_video_filters(next, filters.c_str());
+        }
+        switchToItem(next, index);
+        return;
+    }
+    postMessage(SKY_MSG_COMPLETED);
+}
+
+void SkyPlayer::switchToItem(VideoState *next, int index) {
+    VideoState* old;
+    int width = 0;
+    int height = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        old = is;
+        stream_deactivate(old);
+        is = next;
+        next->video_hold = 0;
+        playlistIndex_ = index;
+        firstVideoFrameRendered = false;
+        next->audio_tap_enabled = pcmTapEnabled_.load() ? 1 : 0;
+        hasVideoStream_.store(next->video_stream >= 0);
+        updateVideoSuspendedLocked();
+        // 暂停状态以播放器为准：回调接续的项已经在播放，直接打开的项还是暂停的
+        if (next->paused != (playerState == STATE_STARTED ? 0 : 1)) {
+            toggle_pause(next);
+        }
+        if (next->video_st) {
+            width = next->video_st->codecpar->width;
+            height = next->video_st->codecpar->height;
+        }
+    }
+
+    // 旧项已不在音频回调和 is 中，在锁外关闭
+    stream_close(old);
+    updateAudioPowerMode();
+
+    ALOG_I(TAG, "playlist item %d started", index);
+    postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_INFO, static_cast<int>(MEDIA_INFO_TYPE::MEDIA_INFO_PLAYLIST_ITEM_CHANGED), index);
+    if (width > 0 && height > 0) {
+        postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_SET_VIDEO_SIZE, width, height);
+    }
+}
+
 bool SkyPlayer::postMessage(const SkyMessage& message) {
     return messageQueue_.put(message);
 }
@@ -467,6 +1148,10 @@ bool SkyPlayer::postEventToJava(int what, int arg1, int arg2, void* obj) {
     return ::postEventToJava(this, what, arg1, arg2, static_cast<jobject>(obj));
 }
 
+bool SkyPlayer::postMediaStringEventToJava(MEDIA_EVENT_TYPE eventType, int arg1, int arg2, const char* str) {
+    return ::postStringEventToJava(this, static_cast<int>(eventType), arg1, arg2, str);
+}
+
 void SkyPlayer::handleMessage(const SkyMessage& message) {
 
     switch (message.what) {
@@ -474,21 +1159,62 @@ void SkyPlayer::handleMessage(const SkyMessage& message) {
             ALOG_I(TAG, "handleMessage() SKY_MSG_PREPARED");
             {
                 std::lock_guard<std::mutex> lock(mtx);
-                setPlayerState(STATE_PREPARED);
+                // 播放列表中直接打开的项不改变播放器状态
+                if (playlistIndex_ == 0) {
+                    setPlayerState(STATE_PREPARED);
+                }
+                hasVideoStream_.store(is && is->video_stream >= 0);
+                updateVideoSuspendedLocked();
+            }
+            updateAudioPowerMode();
+            if (playlistIndex_ == 0) {
+                postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_PREPARED);
             }
-            postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_PREPARED);
+            startPreload();
             break;
 
         case SKY_MSG_COMPLETED:
             ALOG_I(TAG, "handleMessage() SKY_MSG_COMPLETED");
+            if (playlistPending_.load()) {
+                // 播放列表还有下一项，读到文件尾不是播放结束
+                break;
+            }
             {
                 std::lock_guard<std::mutex> lock(mtx);
+                // 播放列表切换时可能补发过
+                if (playerState == STATE_COMPLETED) {
+                    break;
+                }
                 restart = true;
                 setPlayerState(STATE_COMPLETED);
             }
             postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_PLAYBACK_COMPLETE);
             break;
 
+        case SKY_MSG_PLAYBACK_END:
+            ALOG_I(TAG, "handleMessage() SKY_MSG_PLAYBACK_END");
+            if (playlistPending_.load()) {
+                bool audioOpened;
+                {
+                    std::lock_guard<std::mutex> lock(playlistMutex_);
+                    audioOpened = audioSpec_.sdl_audioSpec.freq > 0;
+                }
+                // 音频设备打开时由音频回调接续
+                if (!audioOpened) {
+                    openNextItem();
+                }
+            }
+            break;
+
+        case SKY_MSG_PLAYLIST_ADVANCE:
+            ALOG_I(TAG, "handleMessage() SKY_MSG_PLAYLIST_ADVANCE");
+            onPlaylistAdvance();
+            break;
+
+        case SKY_MSG_PLAYLIST_PRELOAD:
+            startPreload();
+            break;
+
         case SKY_MSG_SEEK_COMPLETE:
             ALOG_I(TAG, "handleMessage() SKY_MSG_SEEK_COMPLETE");
             {
@@ -511,6 +1237,11 @@ void SkyPlayer::handleMessage(const SkyMessage& message) {
             postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_SET_VIDEO_SAR, message.arg1, message.arg2);
             break;
 
+        case SKY_MSG_VIDEO_ROTATION_CHANGED:
+            ALOG_I(TAG, "handleMessage() SKY_MSG_VIDEO_ROTATION_CHANGED degree=%d", message.arg1);
+            postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_INFO, static_cast<int>(MEDIA_INFO_TYPE::MEDIA_INFO_VIDEO_ROTATION_CHANGED), message.arg1);
+            break;
+
         case SKY_MSG_VIDEO_RENDERING_START:
             ALOG_I(TAG, "handleMessage() SKY_MSG_VIDEO_DECODED_START");
             postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_INFO, static_cast<int>(MEDIA_INFO_TYPE::MEDIA_INFO_VIDEO_SEEK_RENDERING_START));
@@ -541,6 +1272,20 @@ void SkyPlayer::handleMessage(const SkyMessage& message) {
             postMediaEventToJava(MEDIA_EVENT_TYPE::MEDIA_ERROR, static_cast<int>(MEDIA_INFO_TYPE::MEDIA_INFO_COMPONENT_OPEN_ERR));
             break;
 
+        case SKY_MSG_TIMED_TEXT:
+            // obj 为 ffplay 中 av_malloc 的字符串，这里负责释放
+            postMediaStringEventToJava(MEDIA_EVENT_TYPE::MEDIA_TIMED_TEXT, message.arg1, message.arg2,
+                                       static_cast<const char*>(message.obj));
+            av_free(message.obj);
+            break;
+
+        case SKY_MSG_GET_IMG_STATE:
+            // obj 为截图线程 av_strdup 的文件名
+            postMediaStringEventToJava(MEDIA_EVENT_TYPE::MEDIA_GET_IMG_STATE, message.arg1, message.arg2,
+                                       static_cast<const char*>(message.obj));
+            av_free(message.obj);
+            break;
+
         case SKY_MSG_ERROR:
             ALOG_E(TAG, "handleMessage() SKY_MSG_ERROR arg1=%d, arg2=%d", message.arg1, message.arg2);
             {
@@ -596,6 +1341,115 @@ int64_t SkyPlayer::getDuration() {
     return duration_us / 1000;
 }
 
+void SkyPlayer::captureFrame(SkyCaptureRequest request) {
+    std::string path = request.path;
+    int ret;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        // 纯音频或视频挂起时刷新线程不会取帧，直接失败，不占排队名额
+        ret = is ? video_frame_available(is) : AVERROR(EAGAIN);
+        if (ret >= 0) {
+            ret = frameCapturer_.request(std::move(request)) ? 0 : AVERROR(EAGAIN);
+        }
+        if (ret >= 0) {
+            request_video_refresh(is);
+            return;
+        }
+    }
+
+    ALOG_E(TAG, "captureFrame() rejected: %s, %d", path.c_str(), ret);
+    char* name = av_strdup(path.c_str());
+    if (!postMessage(SKY_MSG_GET_IMG_STATE, 0, ret, name)) {
+        av_free(name);
+    }
+}
+
+void SkyPlayer::setAudioPowerMode(AudioPowerMode mode) {
+    audioPowerMode_.store(mode);
+    updateAudioPowerMode();
+}
+
+void SkyPlayer::setAudioOutType(AudioOutType type) {
+    if (type != AudioOutType::OPENSL_ES && type != AudioOutType::NULL_SINK && type != AudioOutType::SHARED_MIXER) {
+        ALOG_W(TAG, "unsupported audio out type %d", static_cast<int>(type));
+        return;
+    }
+    audioOutType.store(type);
+}
+
+double SkyPlayer::getAudioClockErrorMs() {
+    return skyAudioOutHandler_.getClockErrorMs();
+}
+
+void SkyPlayer::updateAudioPowerMode() {
+    bool deep;
+    switch (audioPowerMode_.load()) {
+        case AudioPowerMode::LOW_LATENCY:
+            deep = false;
+            break;
+        case AudioPowerMode::DEEP_BUFFER:
+            deep = true;
+            break;
+        default:
+            // 有视频且正在显示时需要低延迟的 A/V 同步；两个条件都是原子标志，消息线程调用时不需要视频输出的锁
+            deep = !hasVideoStream_.load() || !skyVideoOutHandler_.hasWindow();
+            break;
+    }
+    skyAudioOutHandler_.setDeepBuffer(deep);
+}
+
+void SkyPlayer::setAudioAnalysisEnabled(bool enabled, int bands) {
+    std::unique_ptr<SkyAudioAnalyzer> old;
+    {
+        std::lock_guard<std::mutex> lock(analyzerMutex_);
+        old = std::move(audioAnalyzer_);
+        if (enabled) {
+            audioAnalyzer_ = std::make_unique<SkyAudioAnalyzer>(
+                    [this](uint8_t *dst, size_t bytes, SkyPcmFormat *format, uint64_t *endIndex) {
+                        return skyAudioOutHandler_.peekRecentPcm(dst, bytes, format, endIndex);
+                    }, bands);
+        }
+    }
+    // 在锁外 join 分析线程，getAudioLevels 不会被阻塞
+    old.reset();
+}
+
+bool SkyPlayer::getAudioLevels(SkyAudioLevels *levels) {
+    std::lock_guard<std::mutex> lock(analyzerMutex_);
+    return audioAnalyzer_ && audioAnalyzer_->getLevels(levels);
+}
+
+void SkyPlayer::setLoudnessMeterEnabled(bool enabled) {
+    std::unique_ptr<SkyLoudnessMeter> old;
+    {
+        std::lock_guard<std::mutex> lock(loudnessMutex_);
+        old = std::move(loudnessMeter_);
+        if (enabled) {
+            loudnessMeter_ = std::make_unique<SkyLoudnessMeter>(pcmTap_);
+        }
+        pcmTapEnabled_.store(enabled);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (is) {
+            is->audio_tap_enabled = enabled ? 1 : 0;
+        }
+    }
+    // 析构时先从旁路摘除 ring 再 join 计量线程，都在锁外完成
+    old.reset();
+}
+
+bool SkyPlayer::getLoudness(SkyLoudness *loudness) {
+    std::lock_guard<std::mutex> lock(loudnessMutex_);
+    return loudnessMeter_ && loudnessMeter_->getLoudness(loudness);
+}
+
+void SkyPlayer::updateVideoSuspendedLocked() {
+    if (is) {
+        set_video_suspended(is, skyVideoOutHandler_.hasWindow() ? 0 : 1);
+    }
+}
+
 void SkyPlayer::stop() {
 
 }
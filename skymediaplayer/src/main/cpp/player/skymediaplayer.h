@@ -1,14 +1,21 @@
 #ifndef MY_PLAYER_SKYMEDIAPLAYER_H
 #define MY_PLAYER_SKYMEDIAPLAYER_H
 
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <condition_variable>
 #include <atomic>
 #include <jni.h>
 #include "skyrenderer.h"
 #include "skyaudio.h"
 #include "sky_msg_queue.h"
+#include "sky_frame_capture.h"
+#include "sky_audio_analyzer.h"
+#include "sky_loudness_meter.h"
+#include "sky_pcm_tap.h"
+#include "sky_frame_tap.h"
 
 #define TAG "SkyPlayer"
 
@@ -84,7 +91,29 @@ public:
 
     void setWindow(EGLNativeWindowType window);
 
-    bool displayImage(AVFrame *frame);
+    bool displayImage(AVFrame *frame, int rotation = 0, int flip = 0);
+
+    // GPU 后处理参数，下一帧生效
+    void setVideoEq(const SkyVideoEq &eq);
+    void setWatermark(std::shared_ptr<const SkyWatermark> watermark);
+    // 位图字幕合成为一张 premultiplied RGBA 交给 renderer 叠加，只在字幕切换时调用，nullptr 为清除
+    void setSubtitle(const AVSubtitle *sub, int width, int height);
+
+    // 附加输出：同一帧再绘制到其他 window（画中画/预览），handler 持有 window 引用
+    bool addWindow(EGLNativeWindowType window, const SkyRenderOutput &output);
+    void removeWindow(EGLNativeWindowType window);
+
+    // 显示区域尺寸（像素），解码线程据此决定缩小倍数，0 表示未知
+    void setSurfaceSize(int width, int height);
+    void getSurfaceSize(int *width, int *height) const;
+
+    // Surface 切换时只释放 window 相关资源，EGL context/program 保留
+    void releaseWindow();
+
+    // 不加锁，消息线程和 ffplay 线程都会查询
+    bool hasWindow() const {
+        return hasWindow_.load();
+    }
 
     void releaseResources();
 
@@ -93,13 +122,28 @@ public:
 
 private:
     EGLNativeWindowType window_;
+    // 与 window_ 同步更新，window_ 只能在持有 mtx 时访问
+    std::atomic<bool> hasWindow_{false};
     std::unique_ptr<SkyRenderer> renderer_;
     std::unique_ptr<SkyVideoOutHandler> skyVideoOutHandler_;
+    std::vector<EGLNativeWindowType> extraWindows_;
+    std::atomic<int> surfaceWidth_{0};
+    std::atomic<int> surfaceHeight_{0};
 };
 
+// 与 SkyMediaPlayer.AUDIO_OUT_* 对应
 enum class AudioOutType {
-    ANDROID_AUDIO_TRACK,
-    OPENSL_ES
+    ANDROID_AUDIO_TRACK = 0,    // 未实现
+    OPENSL_ES = 1,      // 独占一路 OpenSL ES 输出
+    NULL_SINK = 2,      // 不出声，按系统时间消耗数据
+    SHARED_MIXER = 3    // 进程内共享的混音器，多个播放器共用一路设备输出
+};
+
+// 音频功耗模式，与 SkyMediaPlayer.AUDIO_POWER_MODE_* 对应
+enum class AudioPowerMode {
+    AUTO = 0,           // 没有视频显示（纯音频或无 Surface）时用深缓冲
+    LOW_LATENCY = 1,
+    DEEP_BUFFER = 2
 };
 
 class SkyAudioOutHandler {
@@ -119,11 +163,32 @@ public:
     // 添加清理方法
     void cleanup();
 
+    // 见 SkyAudioOut::getClockErrorMs，没有打开音频时返回 0
+    double getClockErrorMs();
+
+    // 已写给设备还没播放的时长，只在音频回调中调用
+    double getLatencySeconds();
+    // 播放位置和写入位置，见 SkyAudioOut::getPlayedFrames，只在音频回调中调用
+    int64_t getPlayedFrames();
+    int64_t getWriteFramePosition(int pendingBytes);
+
+    // 音量、声像和深缓冲在打开音频之前设置也会生效
+    void setVolume(float left, float right);
+    void setPan(float pan);
+    void setDeepBuffer(bool enabled);
+
+    // 分析线程取设备正在播放的 PCM，见 SkyAudioOut::peekRecentPcm
+    size_t peekRecentPcm(uint8_t *dst, size_t bytes, SkyPcmFormat *format, uint64_t *endIndex);
+
 public:
     std::mutex mtx;
 
 private:
     std::unique_ptr<SkyAudioOut> skyAudioOut_;
+    float leftVolume_ = 1.0f;
+    float rightVolume_ = 1.0f;
+    float pan_ = 0.0f;
+    bool deepBuffer_ = false;
 };
 
 // ============================================================================
@@ -137,7 +202,7 @@ enum class MEDIA_EVENT_TYPE {
     MEDIA_SEEK_COMPLETE     = 4,
     MEDIA_SET_VIDEO_SIZE    = 5,        // arg1 = width, arg2 = height
     MEDIA_GET_IMG_STATE     = 6,        // arg1 = timestamp, arg2 = result code, obj = file name
-    MEDIA_TIMED_TEXT        = 99,       // not supported yet
+    MEDIA_TIMED_TEXT        = 99,       // obj = 文本字幕（String），null 为清除
     MEDIA_ERROR             = 100,      // arg1, arg2
     MEDIA_INFO              = 200,      // arg1, arg2
     MEDIA_SET_VIDEO_SAR     = 10001,    // arg1 = sar.num, arg2 = sar.den
@@ -174,6 +239,7 @@ enum class MEDIA_INFO_TYPE {
     MEDIA_INFO_COMPONENT_OPEN_ERR     = 10008,
     MEDIA_INFO_VIDEO_SEEK_RENDERING_START = 10009,
     MEDIA_INFO_AUDIO_SEEK_RENDERING_START = 100010,
+    MEDIA_INFO_PLAYLIST_ITEM_CHANGED  = 10011,   // extra = 播放列表下标，data source 为 0
 
     MEDIA_INFO_MEDIA_ACCURATE_SEEK_COMPLETE = 10100
 };
@@ -223,6 +289,55 @@ public:
     const char *getDataSource() const;
     void prepareAsync();
 
+    // 视频滤镜，crop/eq 由 GPU 完成，其余交给 libavfilter；播放中设置会在下一帧重建
+    void setVideoFilters(const char* filters);
+
+    // 播放列表：data source 之后依次播放。当前项播放时下一项已打开并缓冲好，
+    // 音频在设备回调里接在当前项最后一个采样之后，复用同一个音频输出和渲染器
+    void appendPlaylistItem(const char* path);
+    // 清空还没播放的项，当前项播完后结束
+    void clearPlaylist();
+
+    // 音频设备的回调经播放器转发，见 sky_open_audio
+    static void audioCallback(void *userdata, Uint8 *stream, int len);
+    void setAudioSource(VideoState *state);
+    void setAudioSpec(const SkyAudioSpec &spec);
+
+    // 异步截图，结果通过 MEDIA_GET_IMG_STATE 回调
+    void captureFrame(SkyCaptureRequest request);
+
+    void setAudioPowerMode(AudioPowerMode mode);
+    // 音频输出类型，下次打开音频（prepare）时生效；NULL_SINK 不出声，用于没有音频设备的环境和 A/V drift 测量
+    void setAudioOutType(AudioOutType type);
+    // 音频时钟相对设备位置的平均偏差（ms）
+    double getAudioClockErrorMs();
+    // 视频流或 Surface 变化后重新决定是否使用深缓冲，可在消息线程和 JNI 线程调用
+    void updateAudioPowerMode();
+    // 没有 Surface 时挂起视频解码和刷新，只保留音频。读写 is，调用方须持有 mtx
+    void updateVideoSuspendedLocked();
+
+    // 音频电平/频谱分析，开启时才创建分析线程，关闭后释放；bands 为频带数
+    void setAudioAnalysisEnabled(bool enabled, int bands);
+    // 拉取最近一次分析结果，未开启或还没有结果时返回 false
+    bool getAudioLevels(SkyAudioLevels *levels);
+
+    // EBU R128 响度计量，开启时挂上解码 PCM 旁路，关闭后 ffplay 不再写旁路；重新开启时整体响度从头统计
+    void setLoudnessMeterEnabled(bool enabled);
+    bool getLoudness(SkyLoudness *loudness);
+
+    SkyPcmTap& getPcmTap() {
+        return pcmTap_;
+    }
+
+    SkyFrameCapturer& getFrameCapturer() {
+        return frameCapturer_;
+    }
+
+    // 解码帧旁路，订阅方在旁路线程收到帧
+    SkyFrameTap& getFrameTap() {
+        return frameTap_;
+    }
+
     // 状态控制回调
     void onPlaybackStateChanged(int state);
 
@@ -241,6 +356,8 @@ public:
     bool postMediaEventToJava(MEDIA_EVENT_TYPE eventType, int arg1 = 0, int arg2 = 0, void* obj = nullptr) {
         return postEventToJava(static_cast<int>(eventType), arg1, arg2, obj);
     }
+    // obj 为 UTF-8 字符串，在 JNI 层转成 java String
+    bool postMediaStringEventToJava(MEDIA_EVENT_TYPE eventType, int arg1, int arg2, const char* str);
 
 public:
     std::mutex mtx;
@@ -252,7 +369,7 @@ public:
     bool autoStartOnPrepare = true;
     bool firstVideoFrameRendered = false;
 
-    AudioOutType audioOutType = AudioOutType::OPENSL_ES;
+    std::atomic<AudioOutType> audioOutType{AudioOutType::SHARED_MIXER};
 
     // 添加状态管理
     enum PlayerState {
@@ -270,6 +387,7 @@ public:
 
 private:
     char *data_source_;
+    std::string videoFilters_;
 
     SkyVideoOutHandler skyVideoOutHandler_;
     SkyAudioOutHandler skyAudioOutHandler_;
@@ -283,6 +401,55 @@ private:
 
     // 消息队列
     SkyMessageQueue messageQueue_;
+    // 截图线程，只在截到帧后才启动
+    SkyFrameCapturer frameCapturer_;
+    SkyFrameTap frameTap_;
+    // 音频分析，从 skyAudioOutHandler_ 取数据，必须在它之前析构
+    std::mutex analyzerMutex_;
+    std::unique_ptr<SkyAudioAnalyzer> audioAnalyzer_;
+    // 解码 PCM 旁路，生命周期与播放器相同，stream_close 之后才析构
+    SkyPcmTap pcmTap_;
+    std::mutex loudnessMutex_;
+    std::unique_ptr<SkyLoudnessMeter> loudnessMeter_;
+    std::atomic<bool> pcmTapEnabled_{false};
+
+    std::atomic<AudioPowerMode> audioPowerMode_{AudioPowerMode::AUTO};
+    std::atomic<bool> hasVideoStream_{false};
+
+    // 播放列表，playlistMutex_ 保护；音频回调只在当前项的音频交完、等待切换时才拿这把锁
+    std::mutex playlistMutex_;
+    std::deque<std::string> playlist_;
+    // 已打开、暂停着缓冲的下一项
+    VideoState* preloaded_ = nullptr;
+    // 音频回调已经接续、等消息线程完成切换的项
+    VideoState* handoff_ = nullptr;
+    // 被接续的项和接续点（设备帧序号）。设备播到接续点、它的视频也播完后音频回调置为 nullptr，
+    // 消息线程再切换，之前它仍是 is，继续显示
+    VideoState* handoffFrom_ = nullptr;
+    int64_t handoffFrame_ = 0;
+    // 音频回调在等接续点，只在音频回调中访问
+    bool handoffWaiting_ = false;
+    bool advanceRequested_ = false;
+    // 已从 playlist_ 取出的项数，clearPlaylist 后 generation 变化，正在打开的项作废
+    int queuedIndex_ = 0;
+    int playlistGeneration_ = 0;
+    // 已打开的音频设备参数，freq 为 0 表示还没有打开
+    SkyAudioSpec audioSpec_{};
+    std::atomic<bool> playlistPending_{false};
+    // 音频回调正在取数据的项，接续后是下一项，消息线程切换 is 之前两者不同
+    // 接续后到切换前 playlistPending_ 保持为 true
+    std::atomic<VideoState*> audioState_{nullptr};
+    // 当前项在播放列表中的下标，只在消息线程访问
+    int playlistIndex_ = 0;
+
+    void fillAudio(uint8_t *stream, int len);
+    // 以下在消息线程调用
+    void startPreload();
+    void onPlaylistAdvance();
+    // 没有打开音频设备时（纯视频）无法在回调里接续，当前项播完后直接打开下一项
+    void openNextItem();
+    void switchToItem(VideoState *next, int index);
+
     // 消息处理回调
     void handleMessage(const SkyMessage& message);
 
@@ -1,14 +1,23 @@
+#include <algorithm>
 #include <cassert>
 #include "logger.h"
 #include "skyrenderer.h"
+#include "sky_egl2_program_cache.h"
+#include "sky_egl2_post_processor.h"
 #include "sky_egl2_renderer_yuv420p.h"
 #include "sky_egl2_renderer_nv12.h"
 #include "sky_egl2_renderer_nv21.h"
 #include "sky_egl2_renderer_rgba.h"
 #include "sky_egl2_renderer_yuv422p.h"
+#include "ffplay.h"
 
 inline static const char *TAG = "SkyEGL2Renderer";
 
+constexpr int MAX_SURFACE_SETUP_FAILURES = 3;
+
+SkyEGL2Renderer::SkyEGL2Renderer() : postProcessor_(std::make_unique<SkyEGL2PostProcessor>()) {
+}
+
 SkyEGL2Renderer::~SkyEGL2Renderer() noexcept {
     // 释放资源
 }
@@ -29,12 +38,27 @@ bool SkyEGL2Renderer::displayImage(EGLNativeWindowType window, AVFrame *frame) {
         return false;
     }
 
+    // 后处理 pass 切换过 program，主画面绘制前恢复 Imp 的状态
+    if (postProcessed_) {
+        rendererImp_->rebind();
+    }
+    postProcessed_ = postProcessor_->isActive();
+    if (postProcessed_) {
+        postProcessor_->begin(surfaceWidth_, surfaceHeight_);
+    }
+
     EGLBoolean ret = rendererImp_->renderImage(frame);
     if (!ret) {
         ALOG_E(TAG, "displayImage() renderImage fail");
         return false;
     }
+    if (postProcessed_) {
+        postProcessor_->end(surfaceWidth_, surfaceHeight_);
+    }
     eglSwapBuffers(display_, surface_);
+    if (!outputs_.empty()) {
+        drawOutputs(frame);
+    }
     eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     eglReleaseThread();
 
@@ -42,44 +66,182 @@ bool SkyEGL2Renderer::displayImage(EGLNativeWindowType window, AVFrame *frame) {
 }
 
 
+void SkyEGL2Renderer::setOrientation(int rotation, int flip) {
+    rotation_ = rotation;
+    flip_ = flip;
+}
+
+void SkyEGL2Renderer::setEq(const SkyVideoEq &eq) {
+    postProcessor_->setEq(eq);
+}
+
+void SkyEGL2Renderer::setWatermark(std::shared_ptr<const SkyWatermark> watermark) {
+    postProcessor_->setWatermark(std::move(watermark));
+}
+
+void SkyEGL2Renderer::setSubtitle(std::shared_ptr<const SkyWatermark> subtitle) {
+    postProcessor_->setSubtitle(std::move(subtitle));
+}
+
+bool SkyEGL2Renderer::setOutput(EGLNativeWindowType window, const SkyRenderOutput &output) {
+    auto it = std::find_if(outputs_.begin(), outputs_.end(),
+                           [window](const Output& o) { return o.window == window; });
+    if (it != outputs_.end()) {
+        it->config = output;
+        return true;
+    }
+    // EGLSurface 在渲染线程下一帧创建
+    Output newOutput;
+    newOutput.window = window;
+    newOutput.config = output;
+    outputs_.push_back(newOutput);
+    ALOG_I(TAG, "add output %p, total %zu", window, outputs_.size());
+    return true;
+}
+
+void SkyEGL2Renderer::removeOutput(EGLNativeWindowType window) {
+    auto it = std::find_if(outputs_.begin(), outputs_.end(),
+                           [window](const Output& o) { return o.window == window; });
+    if (it == outputs_.end()) {
+        return;
+    }
+    if (EGL_NO_SURFACE != it->surface && EGL_NO_DISPLAY != display_) {
+        eglDestroySurface(display_, it->surface);
+    }
+    outputs_.erase(it);
+    ALOG_I(TAG, "remove output %p, total %zu", window, outputs_.size());
+}
+
+void SkyEGL2Renderer::drawOutputs(AVFrame *frame) {
+    // 主画面后处理切换过 program，这里恢复后下一帧无需再 rebind
+    if (postProcessed_) {
+        rendererImp_->rebind();
+        postProcessed_ = false;
+    }
+
+    const int visibleWidth = static_cast<int>(frame->width - frame->crop_left - frame->crop_right);
+    const int visibleHeight = static_cast<int>(frame->height - frame->crop_top - frame->crop_bottom);
+    for (auto& output : outputs_) {
+        const SkyRenderOutput& config = output.config;
+        bool swapSize = config.rotation == 90 || config.rotation == 270;
+        float width = visibleWidth * (config.cropRight - config.cropLeft);
+        float height = visibleHeight * (config.cropBottom - config.cropTop);
+        if (swapSize) {
+            std::swap(width, height);
+        }
+        float scale = 1.0f;
+        if (config.maxWidth > 0) {
+            scale = std::min(scale, config.maxWidth / width);
+        }
+        if (config.maxHeight > 0) {
+            scale = std::min(scale, config.maxHeight / height);
+        }
+        int bufferWidth = std::max(1, static_cast<int>(width * scale));
+        int bufferHeight = std::max(1, static_cast<int>(height * scale));
+
+        if (EGL_NO_SURFACE == output.surface) {
+            ANativeWindow_setBuffersGeometry(output.window, bufferWidth, bufferHeight, nativeVisualId_);
+            output.surface = eglCreateWindowSurface(display_, config_, output.window, nullptr);
+            if (EGL_NO_SURFACE == output.surface) {
+                ALOG_E(TAG, "[EGL] eglCreateWindowSurface failed for output %p", output.window);
+                continue;
+            }
+            if (eglMakeCurrent(display_, output.surface, output.surface, context_)) {
+                // 附加输出不再等待 vsync，避免多个 surface 的 swap 串行阻塞
+                eglSwapInterval(display_, 0);
+            }
+        } else if (!eglMakeCurrent(display_, output.surface, output.surface, context_)) {
+            ALOG_E(TAG, "[EGL] eglMakeCurrent failed for output %p", output.window);
+            continue;
+        }
+
+        EGLint surfaceWidth = 0;
+        EGLint surfaceHeight = 0;
+        if (!resizeBuffers(output.window, output.surface, bufferWidth, bufferHeight, &surfaceWidth, &surfaceHeight)) {
+            continue;
+        }
+        glViewport(0, 0, surfaceWidth, surfaceHeight);  skyElg2CheckError("glViewport");
+        rendererImp_->setOrientation(config.rotation, config.flip);
+        rendererImp_->setViewRegion(config.cropLeft, config.cropTop, config.cropRight, config.cropBottom);
+        rendererImp_->drawImage();
+        eglSwapBuffers(display_, output.surface);
+    }
+    // 主画面的方向在下一帧 prepareRenderer 中恢复
+    rendererImp_->setViewRegion(0.0f, 0.0f, 1.0f, 1.0f);
+}
+
+void SkyEGL2Renderer::destroyOutputSurfaces() {
+    for (auto& output : outputs_) {
+        if (EGL_NO_SURFACE != output.surface) {
+            eglDestroySurface(display_, output.surface);
+            output.surface = EGL_NO_SURFACE;
+        }
+    }
+}
+
+void SkyEGL2Renderer::releaseSurface() {
+    if (EGL_NO_DISPLAY == display_) {
+        return;
+    }
+    FUNC_TRACE()
+
+    // 只销毁 window surface，display/context 以及各格式的 program 保留复用
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (EGL_NO_SURFACE != surface_) {
+        eglDestroySurface(display_, surface_);
+        surface_ = EGL_NO_SURFACE;
+    }
+    eglReleaseThread();
+
+    window_ = nullptr;
+}
+
 void SkyEGL2Renderer::terminate() {
-    if (!isValid()) {
+    if (EGL_NO_DISPLAY == display_) {
         return;
     }
     FUNC_TRACE()
 
+    // program/texture 属于 context，先尝试 make current 再删除（无 surface 时依赖 surfaceless context），
+    // 失败也没关系，eglDestroyContext 会一并回收
+    if (EGL_NO_CONTEXT != context_ && eglMakeCurrent(display_, surface_, surface_, context_)) {
+        for (auto& entry : rendererImps_) {
+            entry.second->reset();
+        }
+        postProcessor_->reset();
+    }
+    rendererImps_.clear();
+    rendererImp_ = nullptr;
+    rendererFormat_ = AV_PIX_FMT_NONE;
+    postProcessed_ = false;
+
     eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-    eglDestroyContext(display_, context_);
-    eglDestroySurface(display_, surface_);
+    destroyOutputSurfaces();
+    if (EGL_NO_CONTEXT != context_) {
+        eglDestroyContext(display_, context_);
+    }
+    if (EGL_NO_SURFACE != surface_) {
+        eglDestroySurface(display_, surface_);
+    }
     eglTerminate(display_);
     eglReleaseThread();
 
+    window_ = nullptr;
     context_ = EGL_NO_CONTEXT;
     surface_ = EGL_NO_SURFACE;
     display_ = EGL_NO_DISPLAY;
-
-    if (nullptr != rendererImp_) {
-        rendererImp_->reset();
-    }
+    config_ = nullptr;
 }
 
 bool SkyEGL2Renderer::isValid() {
     return window_ && display_ && surface_ && context_;
 }
 
-EGLBoolean SkyEGL2Renderer::makeCurrent(EGLNativeWindowType window) {
-    if (window == window_ && isValid()) {
-        if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-            ALOG_E(TAG, "%s error", __func__);
-            return EGL_FALSE;
-        }
-
-        return EGL_TRUE;
-    }
-
-    // 如果需要释放旧资源
-    terminate();
+bool SkyEGL2Renderer::isUnavailable() {
+    return contextUnavailable_ || surfaceSetupFailures_ >= MAX_SURFACE_SETUP_FAILURES;
+}
 
+EGLBoolean SkyEGL2Renderer::initContext() {
     EGLDisplay  display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
     if (display == EGL_NO_DISPLAY) {
         ALOG_E(TAG, "[EGL] no display");
@@ -122,48 +284,80 @@ EGLBoolean SkyEGL2Renderer::makeCurrent(EGLNativeWindowType window) {
         return EGL_FALSE;
     }
 
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        ALOG_E(TAG, "[EGL] eglCreateContext failed\n");
+        eglTerminate(display);
+        return EGL_FALSE;
+    }
+
+    display_ = display;
+    config_ = config;
+    context_ = context;
+    nativeVisualId_ = native_visual_id;
+    ALOG_I(TAG, "initContext success");
+
+    return EGL_TRUE;
+}
+
+EGLBoolean SkyEGL2Renderer::createSurface(EGLNativeWindowType window) {
     int32_t width  = ANativeWindow_getWidth(window);
     int32_t height = ANativeWindow_getHeight(window);
-    ALOG_I(TAG, "[EGL] ANativeWindow_setBuffersGeometry(f=%d);", native_visual_id);
-    int ret = ANativeWindow_setBuffersGeometry(window, width, height, native_visual_id);
+    ALOG_I(TAG, "[EGL] ANativeWindow_setBuffersGeometry(f=%d);", nativeVisualId_);
+    int ret = ANativeWindow_setBuffersGeometry(window, width, height, nativeVisualId_);
     if (ret) {
         ALOG_E(TAG, "[EGL] ANativeWindow_setBuffersGeometry(format) returned error %d", ret);
-        eglTerminate(display);
         return EGL_FALSE;
     }
 
-    EGLSurface surface = eglCreateWindowSurface(display, config, window, nullptr);
+    EGLSurface surface = eglCreateWindowSurface(display_, config_, window, nullptr);
     if (surface == EGL_NO_SURFACE) {
         ALOG_E(TAG, "[EGL] eglCreateWindowSurface failed\n");
-        eglTerminate(display);
         return EGL_FALSE;
     }
 
-    EGLSurface context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
-    if (context == EGL_NO_CONTEXT) {
-        ALOG_E(TAG, "[EGL] eglCreateContext failed\n");
-        eglDestroySurface(display, surface);
-        eglTerminate(display);
+    window_ = window;
+    surface_ = surface;
+
+    return EGL_TRUE;
+}
+
+EGLBoolean SkyEGL2Renderer::makeCurrent(EGLNativeWindowType window) {
+    if (window == window_ && isValid()) {
+        if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+            ALOG_E(TAG, "%s error", __func__);
+            return EGL_FALSE;
+        }
+
+        return EGL_TRUE;
+    }
+
+    // display/context 只创建一次，之后 Surface 变化只重建 window surface
+    if (EGL_NO_CONTEXT == context_ && !initContext()) {
+        contextUnavailable_ = true;
         return EGL_FALSE;
     }
 
-    if (!eglMakeCurrent(display, surface, surface, context)) {
+    releaseSurface();
+    if (!createSurface(window)) {
+        surfaceSetupFailures_++;
+        return EGL_FALSE;
+    }
+
+    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
         ALOG_E(TAG, "[EGL] elgMakeCurrent() failed (new)\n");
-        eglDestroyContext(display, context);
-        eglDestroySurface(display, surface);
-        eglTerminate(display);
+        releaseSurface();
+        surfaceSetupFailures_++;
         return EGL_FALSE;
     }
 
-    window_ = window;
-    context_ = context;
-    surface_ = surface;
-    display_ = display;
     if (EGL_FALSE == setup()) {
         ALOG_E(TAG, "setup() fail");
-        terminate();
+        releaseSurface();
+        surfaceSetupFailures_++;
         return EGL_FALSE;
     }
+    surfaceSetupFailures_ = 0;
     ALOG_I(TAG, "makeCurrent success");
 
     return EGL_TRUE;
@@ -184,29 +378,40 @@ EGLBoolean SkyEGL2Renderer::setup() {
 }
 
 EGLBoolean SkyEGL2Renderer::prepareRenderer(AVFrame *avFrame) {
-    if (nullptr == rendererImp_ || !rendererImp_->isValid() || rendererImp_->avPixFormat != avFrame->format) {
-        if (nullptr != rendererImp_) {
-            rendererImp_.reset();
-        }
-
-        rendererImp_ = createRenderImpFactory(static_cast<AVPixelFormat>(avFrame->format));
-        if (nullptr == rendererImp_) {
-            ALOG_E(TAG, "[EGL] createRenderImpFactory fail.");
-            return EGL_FALSE;
+    if (nullptr == rendererImp_ || rendererFormat_ != avFrame->format) {
+        // 同一 context 内每种格式的 program 只 compile/link 一次
+        auto& imp = rendererImps_[avFrame->format];
+        if (nullptr == imp || !imp->isValid()) {
+            imp = createRenderImpFactory(static_cast<AVPixelFormat>(avFrame->format));
+            if (nullptr == imp) {
+                ALOG_E(TAG, "[EGL] createRenderImpFactory fail.");
+                rendererImps_.erase(avFrame->format);
+                return EGL_FALSE;
+            }
+            imp->init();
+            if (!imp->isValid()) {
+                ALOG_E(TAG, "[EGL] renderImp init fail!");
+                rendererImps_.erase(avFrame->format);
+                return GL_FALSE;
+            }
         }
-        rendererImp_->init();
-        if (!rendererImp_->isValid()) {
-            ALOG_E(TAG, "[EGL] renderImp init fail!");
-            return GL_FALSE;
-        }
-        if (!rendererImp_->use()) {
+        if (!imp->use()) {
             ALOG_E(TAG, "renderImp use() fail.");
             return GL_FALSE;
         }
-    }
-
-    // todo 这里根据帧宽高设置 surface 的大小，那 顶点坐标 剪切的处理怎么影响这里的大小？
-    if (!setSurfaceSize(avFrame->width, avFrame->height)) {
+        rendererImp_ = imp.get();
+        rendererFormat_ = avFrame->format;
+        postProcessed_ = false;
+    }
+    rendererImp_->setOrientation(rotation_, flip_);
+    rendererImp_->setCropBounds(avFrame);
+
+    // surface 大小跟随裁剪后的可见区域，旋转 90/270 度时宽高互换
+    int visibleWidth = static_cast<int>(avFrame->width - avFrame->crop_left - avFrame->crop_right);
+    int visibleHeight = static_cast<int>(avFrame->height - avFrame->crop_top - avFrame->crop_bottom);
+    bool swapSize = rotation_ == 90 || rotation_ == 270;
+    if (!setSurfaceSize(swapSize ? visibleHeight : visibleWidth,
+                        swapSize ? visibleWidth : visibleHeight)) {
         ALOG_E(TAG, "[EGL] setSurfaceSize() error");
         return GL_FALSE;
     }
@@ -221,29 +426,34 @@ EGLBoolean SkyEGL2Renderer::setSurfaceSize(int frameWidth, int frameHeight) {
         return GL_FALSE;
     }
 
-    surfaceWidth_ = querySurfaceSurfaceWidth();
-    surfaceHeight_ = querySurfaceSurfaceHeight();
-    if (surfaceWidth_ != frameWidth || surfaceHeight_ != frameHeight) {
-        int format = ANativeWindow_getFormat(window_);
+    return resizeBuffers(window_, surface_, frameWidth, frameHeight, &surfaceWidth_, &surfaceHeight_);
+}
+
+EGLBoolean SkyEGL2Renderer::resizeBuffers(EGLNativeWindowType window, EGLSurface surface, int width, int height,
+                                          EGLint *surfaceWidth, EGLint *surfaceHeight) {
+    *surfaceWidth = querySurfaceSurfaceWidth(surface);
+    *surfaceHeight = querySurfaceSurfaceHeight(surface);
+    if (*surfaceWidth != width || *surfaceHeight != height) {
+        int format = ANativeWindow_getFormat(window);
         ALOG_I(TAG, "ANativeWindow_setBuffersGeometry(w=%d,h=%d) -> (w=%d,h=%d);",
-               surfaceWidth_, surfaceHeight_,
-               frameWidth, frameHeight);
-        int ret = ANativeWindow_setBuffersGeometry(window_, frameWidth, frameHeight, format);
+               *surfaceWidth, *surfaceHeight,
+               width, height);
+        int ret = ANativeWindow_setBuffersGeometry(window, width, height, format);
         if (ret) {
             ALOG_E(TAG, "[EGL] ANativeWindow_setBuffersGeometry() returned error %d", ret);
             return EGL_FALSE;
         }
 
-        surfaceWidth_ = querySurfaceSurfaceWidth();
-        surfaceHeight_ = querySurfaceSurfaceHeight();
-        return (surfaceWidth_ && surfaceHeight_) ? EGL_TRUE : EGL_FALSE;
+        *surfaceWidth = querySurfaceSurfaceWidth(surface);
+        *surfaceHeight = querySurfaceSurfaceHeight(surface);
+        return (*surfaceWidth && *surfaceHeight) ? EGL_TRUE : EGL_FALSE;
     }
     return GL_TRUE;
 }
 
-int SkyEGL2Renderer::querySurfaceSurfaceWidth() {
+int SkyEGL2Renderer::querySurfaceSurfaceWidth(EGLSurface surface) {
     EGLint width = 0;
-    if (!eglQuerySurface(display_, surface_, EGL_WIDTH, &width)) {
+    if (!eglQuerySurface(display_, surface, EGL_WIDTH, &width)) {
         ALOG_E(TAG, "[EGL] eglQuerySurface(EGL_WIDTH) returned error %d", eglGetError());
         return 0;
     }
@@ -251,9 +461,9 @@ int SkyEGL2Renderer::querySurfaceSurfaceWidth() {
     return width;
 }
 
-int SkyEGL2Renderer::querySurfaceSurfaceHeight() {
+int SkyEGL2Renderer::querySurfaceSurfaceHeight(EGLSurface surface) {
     EGLint height = 0;
-    if (!eglQuerySurface(display_, surface_, EGL_HEIGHT, &height)) {
+    if (!eglQuerySurface(display_, surface, EGL_HEIGHT, &height)) {
         ALOG_E(TAG, "[EGL] eglQuerySurface(EGL_HEIGHT) returned error %d", eglGetError());
         return 0;
     }
@@ -361,38 +571,55 @@ void SkyEGL2RendererImp::printProgramInfo(GLuint program) {
 }
 
 void SkyEGL2RendererImp::init() {
+    const char* fragmentSource = getFragmentShaderSource();
+
+    // 优先使用上次启动缓存的 program binary，省去 compile/link
+    program = SkyEGL2ProgramCache::loadProgram(YUV_VERTEX_SHADER_DEFAULT, fragmentSource);
+    if (!program) {
+        program = buildProgram(fragmentSource);
+        if (!program) {
+            return;
+        }
+        SkyEGL2ProgramCache::saveProgram(program, YUV_VERTEX_SHADER_DEFAULT, fragmentSource);
+    }
+
+    av4_position = glGetAttribLocation(program, "av4_Position");     skyElg2CheckError("glGetAttribLocation(av4_Position)");
+    av2_texcoord = glGetAttribLocation(program, "av2_Texcoord");     skyElg2CheckError("glGetAttribLocation(av2_Texcoord)");
+    um4_mvp = glGetUniformLocation(program, "um4_ModelViewProjection");     skyElg2CheckError("glGetUniformLocation(um4_ModelViewProjection)");
+}
+
+GLuint SkyEGL2RendererImp::buildProgram(const char *fragmentSource) {
+    GLuint prog = INVALID_PROGRAM;
+    GLint linkStatus = 0;
+
     vertexShader = compileShader(GL_VERTEX_SHADER, YUV_VERTEX_SHADER_DEFAULT);
     if (!vertexShader) {
         goto fail;
     }
-    fragmentShader = compileShader(GL_FRAGMENT_SHADER, getFragmentShaderSource());
+    fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
     if (!fragmentShader) {
         goto fail;
     }
-    program = glCreateProgram();        skyElg2CheckError("glCreateProgram");
-    if (!program) {
+    prog = glCreateProgram();        skyElg2CheckError("glCreateProgram");
+    if (!prog) {
         goto fail;
     }
-    glAttachShader(program, vertexShader);      skyElg2CheckError("glAttachShader");
-    glAttachShader(program, fragmentShader);    skyElg2CheckError("glAttachShader");
-    glLinkProgram(program);
-    GLint linkStatus;
-    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    glAttachShader(prog, vertexShader);      skyElg2CheckError("glAttachShader");
+    glAttachShader(prog, fragmentShader);    skyElg2CheckError("glAttachShader");
+    glLinkProgram(prog);
+    glGetProgramiv(prog, GL_LINK_STATUS, &linkStatus);
     if (!linkStatus) {
         goto fail;
     }
-    av4_position = glGetAttribLocation(program, "av4_Position");     skyElg2CheckError("glGetAttribLocation(av4_Position)");
-    av2_texcoord = glGetAttribLocation(program, "av2_Texcoord");     skyElg2CheckError("glGetAttribLocation(av2_Texcoord)");
-    um4_mvp = glGetUniformLocation(program, "um4_ModelViewProjection");     skyElg2CheckError("glGetUniformLocation(um4_ModelViewProjection)");
 
-    return;
+    return prog;
 
 fail:
-    if (program) {
-        printProgramInfo(program);
-        glDeleteProgram(program);
-        program = INVALID_PROGRAM;
+    if (prog) {
+        printProgramInfo(prog);
+        glDeleteProgram(prog);
     }
+    return INVALID_PROGRAM;
 }
 
 void
@@ -427,14 +654,91 @@ SkyEGL2RendererImp::buildOrthoMatrix(Matrix4x4Std &matrix, GLfloat left, GLfloat
 }
 
 void SkyEGL2RendererImp::resetTextureCoordinatesToCover() {
-    texcoords[0] = 0.0f;
-    texcoords[1] = 1.0f; // left-top
-    texcoords[2] = 1.0f;
-    texcoords[3] = 1.0f; // right-top
-    texcoords[4] = 0.0f;
-    texcoords[5] = 0.0f; // left-bottom
-    texcoords[6] = 1.0f;
-    texcoords[7] = 0.0f; // right-bottom
+    // 屏幕四个角（与 vertices 顺序一致，y 向下）：left-bottom, right-bottom, left-top, right-top
+    static const GLfloat corners[4][2] = {{0.0f, 1.0f}, {1.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f}};
+
+    for (int i = 0; i < 4; ++i) {
+        GLfloat x = corners[i][0];
+        GLfloat y = corners[i][1];
+        // 镜像在旋转之后，所以先撤销镜像，再做逆旋转，得到该屏幕角对应的图像坐标
+        if (flip & SKY_VIDEO_FLIP_H) {
+            x = 1.0f - x;
+        }
+        if (flip & SKY_VIDEO_FLIP_V) {
+            y = 1.0f - y;
+        }
+        GLfloat u, v;
+        switch (rotation) {
+            case 90:
+                u = y;
+                v = 1.0f - x;
+                break;
+            case 180:
+                u = 1.0f - x;
+                v = 1.0f - y;
+                break;
+            case 270:
+                u = 1.0f - y;
+                v = x;
+                break;
+            default:
+                u = x;
+                v = y;
+                break;
+        }
+        // 先映射到当前输出的显示范围，再映射到纹理中的可见区域
+        u = viewLeft + u * (viewRight - viewLeft);
+        v = viewTop + v * (viewBottom - viewTop);
+        texcoords[i * 2] = texLeft + u * (texRight - texLeft);
+        texcoords[i * 2 + 1] = texTop + v * (texBottom - texTop);
+    }
+}
+
+void SkyEGL2RendererImp::setOrientation(int newRotation, int newFlip) {
+    if (rotation == newRotation && flip == newFlip) {
+        return;
+    }
+    ALOG_I(TAG, "setOrientation rotation=%d flip=%d", newRotation, newFlip);
+    rotation = newRotation;
+    flip = newFlip;
+
+    resetTextureCoordinatesToCover();
+    buildAndEnableTextureCoordinatesAttributes();
+}
+
+void SkyEGL2RendererImp::setCropBounds(AVFrame *avFrame) {
+    // 纹理按 getBufferWidth 上传，右侧可能带有 linesize 对齐的填充
+    GLsizei bufferWidth = getBufferWidth(avFrame);
+    if (bufferWidth <= 0 || avFrame->height <= 0) {
+        return;
+    }
+    GLfloat left = static_cast<GLfloat>(avFrame->crop_left) / bufferWidth;
+    GLfloat right = static_cast<GLfloat>(avFrame->width - avFrame->crop_right) / bufferWidth;
+    GLfloat top = static_cast<GLfloat>(avFrame->crop_top) / avFrame->height;
+    GLfloat bottom = static_cast<GLfloat>(avFrame->height - avFrame->crop_bottom) / avFrame->height;
+    if (left == texLeft && right == texRight && top == texTop && bottom == texBottom) {
+        return;
+    }
+    texLeft = left;
+    texRight = right;
+    texTop = top;
+    texBottom = bottom;
+
+    resetTextureCoordinatesToCover();
+    buildAndEnableTextureCoordinatesAttributes();
+}
+
+void SkyEGL2RendererImp::setViewRegion(GLfloat left, GLfloat top, GLfloat right, GLfloat bottom) {
+    if (left == viewLeft && top == viewTop && right == viewRight && bottom == viewBottom) {
+        return;
+    }
+    viewLeft = left;
+    viewTop = top;
+    viewRight = right;
+    viewBottom = bottom;
+
+    resetTextureCoordinatesToCover();
+    buildAndEnableTextureCoordinatesAttributes();
 }
 
 void SkyEGL2RendererImp::buildAndEnableTextureCoordinatesAttributes() {
@@ -488,6 +792,17 @@ EGLBoolean SkyEGL2RendererImp::renderImage(AVFrame *avFrame) {
     return GL_TRUE;
 }
 
+void SkyEGL2RendererImp::drawImage() {
+    glClear(GL_COLOR_BUFFER_BIT);               skyElg2CheckError("glClear");
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);      skyElg2CheckError("glDrawArrays");
+}
+
+void SkyEGL2RendererImp::rebind() {
+    glUseProgram(program);      skyElg2CheckError("glUseProgram");
+    buildAndEnableTextureCoordinatesAttributes();
+    buildAndEnableVerticesAttributes();
+}
+
 inline std::unique_ptr<SkyEGL2RendererImp> createRenderImpFactory(AVPixelFormat format) {
     ALOG_I("SkyEGL2Renderer", "createRenderImpFactory format=%d", format);
     switch (format) {
@@ -2,6 +2,9 @@
 #define MY_PLAYER_SKYRENDERER_H
 
 #include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 #include <android/native_window.h>
@@ -9,6 +12,7 @@
 #include "libavutil/frame.h"
 #include "logger.h"
 #include "libavutil/pixdesc.h"
+#include "ffplay.h"
 
 using Matrix4x4Std = std::array<float, 16>;
 
@@ -53,11 +57,20 @@ public:
 
     void resetTextureCoordinatesToCover();
     void buildAndEnableTextureCoordinatesAttributes();
+    void setOrientation(int rotation, int flip);
+    void setCropBounds(AVFrame *avFrame);
     void resetVerticesToNDC();
     void buildAndEnableVerticesAttributes();
     EGLBoolean renderImage(AVFrame *avFrame);
+    // 只用已上传的纹理重新绘制，多个输出共享一次上传
+    void drawImage();
+    // 输出只显示可见区域中的一部分（旋转前的归一化坐标）
+    void setViewRegion(GLfloat left, GLfloat top, GLfloat right, GLfloat bottom);
+    // 后处理 pass 会切换 program 和顶点属性，主画面绘制前恢复
+    void rebind();
 
     static GLuint compileShader(GLenum type, const char* source);
+    GLuint buildProgram(const char* fragmentSource);
     static void printShaderInfo(GLuint shader);
     static void printProgramInfo(GLuint program);
     static void buildOrthoMatrix(Matrix4x4Std &matrix, GLfloat left, GLfloat right,
@@ -85,6 +98,22 @@ protected:
     std::array<GLfloat, 8> vertices{};
     bool verticesChanged = 0;
 
+    // 显示方向：顺时针旋转角度 + 旋转后的镜像（SKY_VIDEO_FLIP_*），作用在纹理坐标上
+    int rotation = 0;
+    int flip = 0;
+
+    // 可见区域（AVFrame crop_* 与 linesize 对齐填充）在纹理中的归一化范围
+    GLfloat texLeft = 0.0f;
+    GLfloat texTop = 0.0f;
+    GLfloat texRight = 1.0f;
+    GLfloat texBottom = 1.0f;
+
+    // 当前输出在可见区域中的显示范围
+    GLfloat viewLeft = 0.0f;
+    GLfloat viewTop = 0.0f;
+    GLfloat viewRight = 1.0f;
+    GLfloat viewBottom = 1.0f;
+
     // 上一帧的宽高数据
     GLsizei frameWidth;
     GLsizei frameHeight;
@@ -93,42 +122,121 @@ protected:
     GLsizei lastBufferWidth;
 };
 
+// 水印/字幕位图，pixels 为 premultiplied RGBA，位置为相对 surface 的归一化坐标（左上角为原点）
+struct SkyWatermark {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+    float left = 0.0f;
+    float top = 0.0f;
+    float right = 0.0f;
+    float bottom = 0.0f;
+    float alpha = 1.0f;
+};
+
+// 附加输出（画中画、预览等）的显示参数，crop 为相对可见画面（旋转前）的归一化坐标
+struct SkyRenderOutput {
+    int rotation = 0;
+    int flip = 0;
+    float cropLeft = 0.0f;
+    float cropTop = 0.0f;
+    float cropRight = 1.0f;
+    float cropBottom = 1.0f;
+    // buffer 尺寸上限，保持宽高比缩小，0 表示不限制
+    int maxWidth = 0;
+    int maxHeight = 0;
+};
+
+class SkyEGL2PostProcessor;
+
 class SkyRenderer {
 public:
     virtual ~SkyRenderer(){}
     virtual bool displayImage(EGLNativeWindowType window, AVFrame *frame) = 0;
+    // 设置后续帧的显示方向，rotation 为顺时针角度，flip 为 SKY_VIDEO_FLIP_* 组合
+    virtual void setOrientation(int rotation, int flip) = 0;
+    // GPU 后处理，不支持的 renderer 忽略
+    virtual void setEq(const SkyVideoEq &eq) {}
+    virtual void setWatermark(std::shared_ptr<const SkyWatermark> watermark) {}
+    virtual void setSubtitle(std::shared_ptr<const SkyWatermark> subtitle) {}
+    // 同一帧额外绘制到其他 window，不支持的 renderer 返回 false
+    virtual bool setOutput(EGLNativeWindowType window, const SkyRenderOutput &output) { return false; }
+    virtual void removeOutput(EGLNativeWindowType window) {}
     virtual bool isValid() = 0;
+    // 渲染后端在当前设备上不可用（如 EGL 初始化失败），需要切换到兜底渲染
+    virtual bool isUnavailable() { return false; }
+    // 只释放与 window 绑定的资源，Surface 切换时调用
+    virtual void releaseSurface() = 0;
     virtual void terminate() = 0;
 };
 
 class SkyEGL2Renderer : public SkyRenderer {
 public:
+    SkyEGL2Renderer();
     ~SkyEGL2Renderer();
 
     bool displayImage(EGLNativeWindowType window, AVFrame *frame) override;
+    void setOrientation(int rotation, int flip) override;
+    void setEq(const SkyVideoEq &eq) override;
+    void setWatermark(std::shared_ptr<const SkyWatermark> watermark) override;
+    void setSubtitle(std::shared_ptr<const SkyWatermark> subtitle) override;
+    bool setOutput(EGLNativeWindowType window, const SkyRenderOutput &output) override;
+    void removeOutput(EGLNativeWindowType window) override;
     bool isValid() override;
+    bool isUnavailable() override;
+    void releaseSurface() override;
     void terminate() override;
 
 private:
     EGLBoolean setup();
+    EGLBoolean initContext();
+    EGLBoolean createSurface(EGLNativeWindowType window);
     EGLBoolean makeCurrent(EGLNativeWindowType window);
     EGLBoolean prepareRenderer(AVFrame *avFrame);
     EGLBoolean setSurfaceSize(int frameWidth, int frameHeight);
+    EGLBoolean resizeBuffers(EGLNativeWindowType window, EGLSurface surface, int width, int height,
+                             EGLint *surfaceWidth, EGLint *surfaceHeight);
+    void drawOutputs(AVFrame *avFrame);
+    void destroyOutputSurfaces();
 
-    int querySurfaceSurfaceWidth();
-    int querySurfaceSurfaceHeight();
+    int querySurfaceSurfaceWidth(EGLSurface surface);
+    int querySurfaceSurfaceHeight(EGLSurface surface);
 
 private:
-    std::unique_ptr<SkyEGL2RendererImp> rendererImp_;
+    // 每种像素格式一个 Imp，program/texture 跟随 context 存活，Surface 切换不重建
+    std::unordered_map<int, std::unique_ptr<SkyEGL2RendererImp>> rendererImps_;
+    SkyEGL2RendererImp* rendererImp_ = nullptr;
+    int rendererFormat_ = AV_PIX_FMT_NONE;
+
+    EGLNativeWindowType window_ = nullptr;
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    EGLSurface surface_ = EGL_NO_SURFACE;
+    EGLContext context_ = EGL_NO_CONTEXT;
+    EGLConfig config_ = nullptr;
+    EGLint nativeVisualId_ = 0;
+
+    // initContext 失败或连续多次无法为新 Surface 建立 EGL 环境时认为 EGL 不可用
+    bool contextUnavailable_ = false;
+    int surfaceSetupFailures_ = 0;
+
+    int rotation_ = 0;
+    int flip_ = 0;
 
-    EGLNativeWindowType window_;
-    EGLDisplay display_;
-    EGLSurface surface_;
-    EGLContext context_;
+    std::unique_ptr<SkyEGL2PostProcessor> postProcessor_;
+    // 上一帧走过后处理，主 program 的 GL 状态需要恢复
+    bool postProcessed_ = false;
 
     // surface 宽高
-    EGLint surfaceWidth_;
-    EGLint surfaceHeight_;
+    EGLint surfaceWidth_ = 0;
+    EGLint surfaceHeight_ = 0;
+
+    // 附加输出与主 window 共用 context，纹理每帧只上传一次
+    struct Output {
+        EGLNativeWindowType window = nullptr;
+        EGLSurface surface = EGL_NO_SURFACE;
+        SkyRenderOutput config;
+    };
+    std::vector<Output> outputs_;
 };
 
 std::unique_ptr<SkyEGL2RendererImp> createRenderImpFactory(AVPixelFormat format);
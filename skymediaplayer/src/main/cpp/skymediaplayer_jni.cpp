@@ -1,9 +1,16 @@
 #include <jni.h>
 #include <string>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <algorithm>
 #include <pthread.h>
 #include <android/log.h>
 
 #include "player/skymediaplayer.h"
+#include "player/sky_egl2_program_cache.h"
+#include "player/sky_disk_cache.h"
+#include "player/sky_preload.h"
 #include "logger.h"
 
 extern "C" {
@@ -139,6 +146,24 @@ bool postEventToJava(SkyPlayer* player, int what, int arg1, int arg2, jobject ob
     return success;
 }
 
+bool postStringEventToJava(SkyPlayer* player, int what, int arg1, int arg2, const char* str) {
+    if (nullptr == str) {
+        return postEventToJava(player, what, arg1, arg2, nullptr);
+    }
+
+    JNIEnv* env = getJNIEnv();
+    if (!env) {
+        ALOG_E(TAG, "postStringEventToJava: Failed to get JNIEnv");
+        return false;
+    }
+    jstring jstr = env->NewStringUTF(str);
+    bool success = postEventToJava(player, what, arg1, arg2, jstr);
+    if (jstr) {
+        env->DeleteLocalRef(jstr);
+    }
+    return success;
+}
+
 void sky_mediaPlayer_native_setup(JNIEnv *env, jobject thiz) {
     FUNC_TRACE()
     auto* player = createSkyPlayer();
@@ -239,6 +264,31 @@ void sky_mediaPlayer_setDataSource(JNIEnv *env, jobject thiz, jstring path) {
     ALOG_I(TAG, "path=%s", player->getDataSource());
 }
 
+void sky_mediaPlayer_appendPlaylistItem(JNIEnv *env, jobject thiz, jstring path) {
+    FUNC_TRACE()
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player || nullptr == path) {
+        return;
+    }
+
+    const char* nativeString = env->GetStringUTFChars(path, nullptr);
+    if (nullptr == nativeString) {
+        ALOG_E(TAG, "nativeString == nullptr");
+        return;
+    }
+    player->appendPlaylistItem(nativeString);
+    env->ReleaseStringUTFChars(path, nativeString);
+}
+
+void sky_mediaPlayer_clearPlaylist(JNIEnv *env, jobject thiz) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    player->clearPlaylist();
+}
+
 void sky_mediaPlayer_prepare(JNIEnv *env, jobject thiz) {
 
 }
@@ -262,12 +312,384 @@ void sky_mediaPlayer_setVideoSurface(JNIEnv *env, jobject thiz, jobject jsurface
         return;
     }
 
+    // 与 prepare/release 和播放列表切换互斥，下面的 updateVideoSuspendedLocked 依赖这把锁
     std::lock_guard<std::mutex> lock(player->mtx);
 
+    // surface 为 null 表示 Surface 已销毁，只释放 window surface，保留 EGL context
+    if (nullptr == jsurface) {
+        player->getSkyVideoOutHandler().setWindow(nullptr);
+        // 退到后台，视频停在 demuxer，音频可以切到深缓冲
+        player->updateVideoSuspendedLocked();
+        player->updateAudioPowerMode();
+        return;
+    }
+
     EGLNativeWindowType window = ANativeWindow_fromSurface(env, jsurface);
     if (nullptr != window) {
         player->getSkyVideoOutHandler().setWindow(window);
+        // ANativeWindow_fromSurface 已经 acquire 过一次，setWindow 内部会再 acquire
+        ANativeWindow_release(window);
+    }
+    player->updateVideoSuspendedLocked();
+    player->updateAudioPowerMode();
+}
+
+void sky_mediaPlayer_addVideoSurface(JNIEnv *env, jobject thiz, jobject jsurface, jint rotation, jint flip,
+                                     jfloat cropLeft, jfloat cropTop, jfloat cropRight, jfloat cropBottom,
+                                     jint maxWidth, jint maxHeight) {
+    FUNC_TRACE()
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player || nullptr == jsurface) {
+        return;
+    }
+
+    EGLNativeWindowType window = ANativeWindow_fromSurface(env, jsurface);
+    if (nullptr == window) {
+        return;
+    }
+    SkyRenderOutput output;
+    output.rotation = rotation;
+    output.flip = flip;
+    output.cropLeft = cropLeft;
+    output.cropTop = cropTop;
+    output.cropRight = cropRight;
+    output.cropBottom = cropBottom;
+    output.maxWidth = maxWidth;
+    output.maxHeight = maxHeight;
+    player->getSkyVideoOutHandler().addWindow(window, output);
+    // addWindow 内部会再 acquire
+    ANativeWindow_release(window);
+}
+
+void sky_mediaPlayer_removeVideoSurface(JNIEnv *env, jobject thiz, jobject jsurface) {
+    FUNC_TRACE()
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player || nullptr == jsurface) {
+        return;
+    }
+
+    // 同一个 Surface 得到的是同一个 ANativeWindow
+    EGLNativeWindowType window = ANativeWindow_fromSurface(env, jsurface);
+    if (nullptr == window) {
+        return;
+    }
+    player->getSkyVideoOutHandler().removeWindow(window);
+    ANativeWindow_release(window);
+}
+
+void sky_mediaPlayer_setCacheDir(JNIEnv *env, jobject thiz, jstring dir) {
+    FUNC_TRACE()
+
+    if (nullptr == dir) {
+        return;
+    }
+
+    const char* nativeString = env->GetStringUTFChars(dir, nullptr);
+    if (nullptr == nativeString) {
+        ALOG_E(TAG, "nativeString == nullptr");
+        return;
+    }
+
+    SkyEGL2ProgramCache::setCacheDir(nativeString);
+    SkyDiskCache::instance().setDir(std::string(nativeString) + "/skycache");
+    env->ReleaseStringUTFChars(dir, nativeString);
+}
+
+void sky_mediaPlayer_preload(JNIEnv *env, jclass clazz, jstring url, jint priority, jlong maxBytes, jint durationMs) {
+    if (nullptr == url) {
+        return;
+    }
+
+    const char* nativeString = env->GetStringUTFChars(url, nullptr);
+    if (nullptr == nativeString) {
+        ALOG_E(TAG, "nativeString == nullptr");
+        return;
+    }
+
+    SkyPreloadRequest request;
+    request.url = nativeString;
+    request.priority = priority;
+    if (maxBytes > 0) {
+        request.maxBytes = maxBytes;
+    }
+    request.durationMs = durationMs;
+    env->ReleaseStringUTFChars(url, nativeString);
+    SkyPreloadManager::instance().preload(request);
+}
+
+void sky_mediaPlayer_cancelPreload(JNIEnv *env, jclass clazz, jstring url) {
+    std::string nativeUrl;
+    if (nullptr != url) {
+        const char* nativeString = env->GetStringUTFChars(url, nullptr);
+        if (nullptr == nativeString) {
+            ALOG_E(TAG, "nativeString == nullptr");
+            return;
+        }
+        nativeUrl = nativeString;
+        env->ReleaseStringUTFChars(url, nativeString);
+    }
+    SkyPreloadManager::instance().cancel(nativeUrl);
+}
+
+void sky_mediaPlayer_setPreloadBudget(JNIEnv *env, jclass clazz, jlong bytes) {
+    SkyPreloadManager::instance().setBudget(bytes);
+}
+
+void sky_mediaPlayer_setDiskCacheBudget(JNIEnv *env, jclass clazz, jlong bytes) {
+    SkyDiskCache::instance().setBudget(bytes);
+}
+
+void sky_mediaPlayer_setVideoFilters(JNIEnv *env, jobject thiz, jstring filters) {
+    FUNC_TRACE()
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    if (nullptr == filters) {
+        player->setVideoFilters(nullptr);
+        return;
+    }
+
+    const char* nativeString = env->GetStringUTFChars(filters, nullptr);
+    if (nullptr == nativeString) {
+        ALOG_E(TAG, "nativeString == nullptr");
+        return;
+    }
+
+    player->setVideoFilters(nativeString);
+    env->ReleaseStringUTFChars(filters, nativeString);
+}
+
+void sky_mediaPlayer_setVideoSurfaceSize(JNIEnv *env, jobject thiz, jint width, jint height) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    player->getSkyVideoOutHandler().setSurfaceSize(width, height);
+}
+
+void sky_mediaPlayer_setVolume(JNIEnv *env, jobject thiz, jfloat left, jfloat right) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    player->getSkyAudioOutHandler().setVolume(left, right);
+}
+
+void sky_mediaPlayer_setPan(JNIEnv *env, jobject thiz, jfloat pan) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    player->getSkyAudioOutHandler().setPan(pan);
+}
+
+void sky_mediaPlayer_setAudioPowerMode(JNIEnv *env, jobject thiz, jint mode) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    player->setAudioPowerMode(static_cast<AudioPowerMode>(mode));
+}
+
+void sky_mediaPlayer_setAudioOutType(JNIEnv *env, jobject thiz, jint type) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    player->setAudioOutType(static_cast<AudioOutType>(type));
+}
+
+jfloat sky_mediaPlayer_getAudioClockErrorMs(JNIEnv *env, jobject thiz) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return 0;
+    }
+
+    return static_cast<jfloat>(player->getAudioClockErrorMs());
+}
+
+void sky_mediaPlayer_setAudioAnalysisEnabled(JNIEnv *env, jobject thiz, jboolean enabled, jint bands) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    player->setAudioAnalysisEnabled(enabled, bands);
+}
+
+jboolean sky_mediaPlayer_getAudioLevels(JNIEnv *env, jobject thiz, jfloatArray out) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player || nullptr == out) {
+        return JNI_FALSE;
+    }
+
+    SkyAudioLevels levels;
+    if (!player->getAudioLevels(&levels)) {
+        return JNI_FALSE;
+    }
+
+    // rmsL, rmsR, peakL, peakR, bands...，单声道时左右相同
+    int right = levels.channels > 1 ? 1 : 0;
+    std::vector<jfloat> values = {levels.rms[0], levels.rms[right], levels.peak[0], levels.peak[right]};
+    values.insert(values.end(), levels.bands.begin(), levels.bands.end());
+    jsize count = std::min(env->GetArrayLength(out), static_cast<jsize>(values.size()));
+    env->SetFloatArrayRegion(out, 0, count, values.data());
+    return JNI_TRUE;
+}
+
+void sky_mediaPlayer_setLoudnessMeterEnabled(JNIEnv *env, jobject thiz, jboolean enabled) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    player->setLoudnessMeterEnabled(enabled);
+}
+
+jboolean sky_mediaPlayer_getLoudness(JNIEnv *env, jobject thiz, jfloatArray out) {
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player || nullptr == out) {
+        return JNI_FALSE;
+    }
+
+    SkyLoudness loudness;
+    if (!player->getLoudness(&loudness)) {
+        return JNI_FALSE;
+    }
+
+    // momentary, shortTerm, integrated
+    const jfloat values[] = {loudness.momentary, loudness.shortTerm, loudness.integrated};
+    jsize count = std::min(env->GetArrayLength(out), static_cast<jsize>(3));
+    env->SetFloatArrayRegion(out, 0, count, values);
+    return JNI_TRUE;
+}
+
+void sky_mediaPlayer_setFrameTap(JNIEnv *env, jobject thiz, jobject listener, jfloat maxFps,
+                                 jint maxWidth, jint maxHeight, jint format) {
+    FUNC_TRACE()
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    if (nullptr == listener) {
+        player->getFrameTap().unsubscribe();
+        return;
+    }
+
+    jclass clazz = env->GetObjectClass(listener);
+    jmethodID onFrame = env->GetMethodID(clazz, "onFrame", "(Ljava/nio/ByteBuffer;IIIIJ)V");
+    env->DeleteLocalRef(clazz);
+    if (nullptr == onFrame) {
+        env->ExceptionClear();
+        ALOG_E(TAG, "setFrameTap: onFrame not found");
+        return;
+    }
+
+    // 全局引用随回调一起释放，释放时所在线程可能是旁路线程
+    std::shared_ptr<_jobject> globalListener(env->NewGlobalRef(listener), [](jobject ref) {
+        JNIEnv *threadEnv = getJNIEnv();
+        if (threadEnv && ref) {
+            threadEnv->DeleteGlobalRef(ref);
+        }
+    });
+
+    SkyFrameTapConfig config;
+    config.maxFps = maxFps;
+    config.maxWidth = maxWidth;
+    config.maxHeight = maxHeight;
+    // Java 层需要像素，不支持只交引用
+    config.format = format == SKY_FRAME_TAP_FORMAT_NV12 ? SKY_FRAME_TAP_FORMAT_NV12 : SKY_FRAME_TAP_FORMAT_RGBA;
+    player->getFrameTap().subscribe(config, [globalListener, onFrame](const SkyTapFrame &frame) {
+        if (nullptr == frame.data) {
+            return;
+        }
+        JNIEnv *threadEnv = getJNIEnv();
+        if (nullptr == threadEnv) {
+            return;
+        }
+        // buffer 直接指向 pool 中的像素，只在回调期间有效
+        jobject buffer = threadEnv->NewDirectByteBuffer(const_cast<uint8_t *>(frame.data),
+                                                        static_cast<jlong>(frame.size));
+        if (nullptr == buffer) {
+            threadEnv->ExceptionClear();
+            return;
+        }
+        jlong ptsMs = std::isnan(frame.pts) ? -1 : static_cast<jlong>(frame.pts * 1000);
+        threadEnv->CallVoidMethod(globalListener.get(), onFrame, buffer, frame.width, frame.height,
+                                  frame.stride, frame.format, ptsMs);
+        if (threadEnv->ExceptionCheck()) {
+            ALOG_E(TAG, "setFrameTap: exception in onFrame");
+            threadEnv->ExceptionDescribe();
+            threadEnv->ExceptionClear();
+        }
+        threadEnv->DeleteLocalRef(buffer);
+    });
+}
+
+void sky_mediaPlayer_captureFrame(JNIEnv *env, jobject thiz, jstring path, jint format, jint quality,
+                                  jint maxWidth, jint maxHeight) {
+    FUNC_TRACE()
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player || nullptr == path) {
+        return;
+    }
+
+    const char* nativeString = env->GetStringUTFChars(path, nullptr);
+    if (nullptr == nativeString) {
+        ALOG_E(TAG, "nativeString == nullptr");
+        return;
     }
+
+    SkyCaptureRequest request;
+    request.path = nativeString;
+    request.format = format;
+    request.quality = quality;
+    request.maxWidth = maxWidth;
+    request.maxHeight = maxHeight;
+    env->ReleaseStringUTFChars(path, nativeString);
+    player->captureFrame(std::move(request));
+}
+
+void sky_mediaPlayer_setWatermark(JNIEnv *env, jobject thiz, jbyteArray pixels, jint width, jint height,
+                                  jfloat left, jfloat top, jfloat right, jfloat bottom, jfloat alpha) {
+    FUNC_TRACE()
+    auto* player = asSkyPlayer(env, thiz);
+    if (nullptr == player) {
+        return;
+    }
+
+    if (nullptr == pixels || width <= 0 || height <= 0) {
+        player->getSkyVideoOutHandler().setWatermark(nullptr);
+        return;
+    }
+
+    jsize length = env->GetArrayLength(pixels);
+    if (length < width * height * 4) {
+        ALOG_E(TAG, "watermark pixels too short %d < %dx%dx4", length, width, height);
+        return;
+    }
+
+    // Bitmap ARGB_8888 在内存中为 premultiplied RGBA，可直接作为纹理上传
+    auto watermark = std::make_shared<SkyWatermark>();
+    watermark->pixels.resize(static_cast<size_t>(width) * height * 4);
+    env->GetByteArrayRegion(pixels, 0, static_cast<jsize>(watermark->pixels.size()),
+                            reinterpret_cast<jbyte*>(watermark->pixels.data()));
+    watermark->width = width;
+    watermark->height = height;
+    watermark->left = left;
+    watermark->top = top;
+    watermark->right = right;
+    watermark->bottom = bottom;
+    watermark->alpha = alpha;
+    player->getSkyVideoOutHandler().setWatermark(std::move(watermark));
 }
 
 void sky_mediaPlayer_start(JNIEnv *env, jobject thiz) {
@@ -318,9 +740,32 @@ jboolean sky_mediaPlayer_isPlaying(JNIEnv *env, jobject thiz) {
 static JNINativeMethod methods[] = {
         {"_native_setup", "()V", (void *) (sky_mediaPlayer_native_setup)},
         {"_setDataSource", "(Ljava/lang/String;)V", (void *) sky_mediaPlayer_setDataSource},
+        {"_appendPlaylistItem", "(Ljava/lang/String;)V", (void *) sky_mediaPlayer_appendPlaylistItem},
+        {"_clearPlaylist", "()V", (void *) sky_mediaPlayer_clearPlaylist},
         {"_prepare", "()V", (void *) sky_mediaPlayer_prepare},
         {"_prepareAsync", "()V", (void *) sky_mediaPlayer_prepareAsync},
         {"_setVideoSurface", "(Landroid/view/Surface;)V", (void *) sky_mediaPlayer_setVideoSurface},
+        {"_addVideoSurface", "(Landroid/view/Surface;IIFFFFII)V", (void *) sky_mediaPlayer_addVideoSurface},
+        {"_removeVideoSurface", "(Landroid/view/Surface;)V", (void *) sky_mediaPlayer_removeVideoSurface},
+        {"_setCacheDir", "(Ljava/lang/String;)V", (void *) sky_mediaPlayer_setCacheDir},
+        {"_preload", "(Ljava/lang/String;IJI)V", (void *) sky_mediaPlayer_preload},
+        {"_cancelPreload", "(Ljava/lang/String;)V", (void *) sky_mediaPlayer_cancelPreload},
+        {"_setPreloadBudget", "(J)V", (void *) sky_mediaPlayer_setPreloadBudget},
+        {"_setDiskCacheBudget", "(J)V", (void *) sky_mediaPlayer_setDiskCacheBudget},
+        {"_setVideoFilters", "(Ljava/lang/String;)V", (void *) sky_mediaPlayer_setVideoFilters},
+        {"_setVideoSurfaceSize", "(II)V", (void *) sky_mediaPlayer_setVideoSurfaceSize},
+        {"_setVolume", "(FF)V", (void *) sky_mediaPlayer_setVolume},
+        {"_setPan", "(F)V", (void *) sky_mediaPlayer_setPan},
+        {"_setAudioPowerMode", "(I)V", (void *) sky_mediaPlayer_setAudioPowerMode},
+        {"_setAudioOutType", "(I)V", (void *) sky_mediaPlayer_setAudioOutType},
+        {"_getAudioClockErrorMs", "()F", (void *) sky_mediaPlayer_getAudioClockErrorMs},
+        {"_setAudioAnalysisEnabled", "(ZI)V", (void *) sky_mediaPlayer_setAudioAnalysisEnabled},
+        {"_getAudioLevels", "([F)Z", (void *) sky_mediaPlayer_getAudioLevels},
+        {"_setLoudnessMeterEnabled", "(Z)V", (void *) sky_mediaPlayer_setLoudnessMeterEnabled},
+        {"_getLoudness", "([F)Z", (void *) sky_mediaPlayer_getLoudness},
+        {"_setFrameTap", "(Limt/zw/skymediaplayer/player/SkyMediaPlayer$FrameTapListener;FIII)V", (void *) sky_mediaPlayer_setFrameTap},
+        {"_captureFrame", "(Ljava/lang/String;IIII)V", (void *) sky_mediaPlayer_captureFrame},
+        {"_setWatermark", "([BIIFFFFF)V", (void *) sky_mediaPlayer_setWatermark},
         {"_start", "()V", (void *) sky_mediaPlayer_start},
         {"_pause", "()V", (void *) sky_mediaPlayer_pause},
         {"_seekTo", "(J)V", (void *) sky_mediaPlayer_seekTo},
@@ -6,6 +6,12 @@ import android.view.Surface
 import android.view.SurfaceHolder
 
 interface IMediaPlayer {
+    companion object {
+        // MEDIA_INFO 类型，与 native MEDIA_INFO_TYPE 保持一致
+        const val MEDIA_INFO_VIDEO_ROTATION_CHANGED = 10001   // extra = 顺时针旋转角度
+        const val MEDIA_INFO_PLAYLIST_ITEM_CHANGED = 10011    // extra = 播放列表下标，data source 为 0
+    }
+
     fun setDisplay(sh: SurfaceHolder?)
     fun setDataSource(context: Context, localVideoPath: String)
     fun setDataSource(context: Context, uri: Uri)
@@ -54,6 +60,16 @@ interface IMediaPlayer {
         fun onInfo(mp: IMediaPlayer, what: Int, extra: Int): Boolean
     }
 
+    // 文本字幕，text 为 null 表示清除；位图字幕由 renderer 直接叠加，不经过这里
+    interface OnTimedTextListener {
+        fun onTimedText(mp: IMediaPlayer, text: String?)
+    }
+
+    // 截图结果，result 为 0 成功，<0 为错误码；positionMs 为截到帧的显示时间
+    interface OnFrameCapturedListener {
+        fun onFrameCaptured(mp: IMediaPlayer, path: String, positionMs: Int, result: Int)
+    }
+
     fun setOnPreparedListener(listener: OnPrepareListener) {
     }
 
@@ -74,7 +90,19 @@ interface IMediaPlayer {
 
     fun setOnInfoListener(listener: OnInfoListener) {
     }
+
+    fun setOnTimedTextListener(listener: OnTimedTextListener) {
+    }
+
+    fun setOnFrameCapturedListener(listener: OnFrameCapturedListener) {
+    }
     //
 
     fun setSurface(surface: Surface)
+
+    /**
+     * 显示区域尺寸，播放器据此在解码阶段缩小远大于显示区域的视频
+     */
+    fun setSurfaceSize(width: Int, height: Int) {
+    }
 }
\ No newline at end of file
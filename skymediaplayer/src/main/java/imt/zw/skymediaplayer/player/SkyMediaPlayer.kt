@@ -1,6 +1,8 @@
 package imt.zw.skymediaplayer.player
 
 import android.content.Context
+import android.graphics.Bitmap
+import android.graphics.RectF
 import android.net.Uri
 import android.os.Handler
 import android.os.Looper
@@ -9,6 +11,7 @@ import android.util.Log
 import android.view.Surface
 import android.view.SurfaceHolder
 import java.lang.ref.WeakReference
+import java.nio.ByteBuffer
 import androidx.annotation.Keep
 import imt.zw.skymediaplayer.utils.Utils
 
@@ -26,11 +29,42 @@ class SkyMediaPlayer() : IMediaPlayer {
         private const val MEDIA_BUFFERING_UPDATE = 3
         private const val MEDIA_SEEK_COMPLETE = 4
         private const val MEDIA_SET_VIDEO_SIZE = 5
+        private const val MEDIA_GET_IMG_STATE = 6
         private const val MEDIA_TIMED_TEXT = 99
         private const val MEDIA_ERROR = 100
         private const val MEDIA_INFO = 200
         private const val MEDIA_SET_VIDEO_SAR = 10001
 
+        // addSurface 的 flip 参数
+        const val FLIP_HORIZONTAL = 1
+        const val FLIP_VERTICAL = 2
+
+        // captureFrame 的 format 参数
+        const val CAPTURE_FORMAT_JPEG = 0
+        const val CAPTURE_FORMAT_PNG = 1
+
+        // setAudioPowerMode 的 mode 参数
+        const val AUDIO_POWER_MODE_AUTO = 0
+        const val AUDIO_POWER_MODE_LOW_LATENCY = 1
+        const val AUDIO_POWER_MODE_DEEP_BUFFER = 2
+
+        // setAudioOutType 的 type 参数
+        const val AUDIO_OUT_OPENSL_ES = 1
+        const val AUDIO_OUT_NULL = 2
+        const val AUDIO_OUT_SHARED_MIXER = 3
+
+        // getAudioLevels 结果中频带能量的起始下标
+        const val AUDIO_LEVELS_BANDS_OFFSET = 4
+
+        // getLoudness 结果的下标，单位 LUFS，没有数据时为 -70
+        const val LOUDNESS_MOMENTARY = 0
+        const val LOUDNESS_SHORT_TERM = 1
+        const val LOUDNESS_INTEGRATED = 2
+
+        // setFrameTapListener 的 format 参数
+        const val FRAME_TAP_FORMAT_RGBA = 1
+        const val FRAME_TAP_FORMAT_NV12 = 2
+
         init {
             try {
                 // 按依赖顺序加载库：先加载依赖库，再加载主库
@@ -53,6 +87,57 @@ class SkyMediaPlayer() : IMediaPlayer {
             }
         }
 
+        /**
+         * 在 prepareAsync 之前把即将播放的 http(s) URL 开头下载到内存，打开时命中部分不再等网络。
+         * 所有播放器共享，重复调用同一 URL 时更新优先级
+         * @param priority 数值大的先下载，超出预算时先淘汰数值小的
+         * @param maxBytes 最多下载的字节数，<= 0 时使用默认的 4MB
+         * @param durationMs 大于 0 时按容器解析，下载够这么长的开头（含头部）即停止
+         */
+        @JvmStatic
+        fun preload(url: String, priority: Int = 0, maxBytes: Long = 0, durationMs: Int = 0) {
+            _preload(url, priority, maxBytes, durationMs)
+        }
+
+        /**
+         * 取消预加载，已下载的数据保留到被淘汰；url 为 null 时取消全部
+         */
+        @JvmStatic
+        fun cancelPreload(url: String?) {
+            _cancelPreload(url)
+        }
+
+        /**
+         * 所有预加载数据共用的内存上限，默认 64MB
+         */
+        @JvmStatic
+        fun setPreloadBudget(bytes: Long) {
+            _setPreloadBudget(bytes)
+        }
+
+        /**
+         * data source 写成 "skycache:" + http(s) URL 时，下载过的区间缓存在 cacheDir/skycache 下，
+         * 重播和回退 seek 直接读磁盘，进程重启后仍有效；每次打开先用 ETag/Last-Modified 确认源文件没变。
+         * HLS/DASH（.m3u8/.mpd）不缓存，去掉前缀直接播放。这里设置所有缓存文件共用的上限，默认 512MB，超出时淘汰最久没播放的
+         */
+        @JvmStatic
+        fun setDiskCacheBudget(bytes: Long) {
+            _setDiskCacheBudget(bytes)
+        }
+
+        @Keep
+        @JvmStatic
+        private external fun _preload(url: String, priority: Int, maxBytes: Long, durationMs: Int)
+        @Keep
+        @JvmStatic
+        private external fun _cancelPreload(url: String?)
+        @Keep
+        @JvmStatic
+        private external fun _setPreloadBudget(bytes: Long)
+        @Keep
+        @JvmStatic
+        private external fun _setDiskCacheBudget(bytes: Long)
+
         // 供native层调用的静态事件发送方法
         @Keep
         @JvmStatic
@@ -133,15 +218,20 @@ class SkyMediaPlayer() : IMediaPlayer {
                     player._onVideoSizeChangedListener?.onVideoSizeChanged(
                         player, player._videoWidth, player._videoHeight, player._videoSarNum, player._videoSarDen)
                 }
+                MEDIA_GET_IMG_STATE -> {
+                    Log.i(TAG, "handleEventFromNative MEDIA_GET_IMG_STATE arg1:${msg.arg1} arg2:${msg.arg2}")
+                    player._onFrameCapturedListener?.onFrameCaptured(player, msg.obj as String? ?: "", msg.arg1, msg.arg2)
+                }
                 MEDIA_TIMED_TEXT -> {
-                    // TODO: 处理MEDIA_TIMED_TEXT事件
+                    player._onTimedTextListener?.onTimedText(player, msg.obj as String?)
                 }
                 MEDIA_ERROR -> {
                     Log.e(TAG, "handleEventFromNative MEDIA_ERROR arg1:${msg.arg1} arg2:${msg.arg2}")
                     player._onErrorListener?.onError(player, msg.arg1, msg.arg2)
                 }
                 MEDIA_INFO -> {
-                    // TODO: 处理MEDIA_INFO事件
+                    // arg1: info 类型，arg2: 附加参数
+                    player._onInfoListener?.onInfo(player, msg.arg1, msg.arg2)
                 }
                 else -> {
                     // TODO: 处理未知事件
@@ -157,6 +247,8 @@ class SkyMediaPlayer() : IMediaPlayer {
     private var _onVideoSizeChangedListener: IMediaPlayer.OnVideoSizeChangedListener ?= null
     private var _onErrorListener: IMediaPlayer.OnErrorListener ?= null
     private var _onInfoListener: IMediaPlayer.OnInfoListener ?= null
+    private var _onTimedTextListener: IMediaPlayer.OnTimedTextListener ?= null
+    private var _onFrameCapturedListener: IMediaPlayer.OnFrameCapturedListener ?= null
 
     private var _surfaceHolder:SurfaceHolder ?= null
     private var _nativeMediaPlayer: Long = 0
@@ -169,11 +261,52 @@ class SkyMediaPlayer() : IMediaPlayer {
     @Keep
     private external fun _setDataSource(path: String)
     @Keep
+    private external fun _appendPlaylistItem(path: String)
+    @Keep
+    private external fun _clearPlaylist()
+    @Keep
     private external fun _prepare()
     @Keep
     private external fun _prepareAsync()
     @Keep
-    private external fun _setVideoSurface(surface: Surface)
+    private external fun _setVideoSurface(surface: Surface?)
+    @Keep
+    private external fun _addVideoSurface(surface: Surface, rotation: Int, flip: Int,
+                                          cropLeft: Float, cropTop: Float, cropRight: Float, cropBottom: Float,
+                                          maxWidth: Int, maxHeight: Int)
+    @Keep
+    private external fun _removeVideoSurface(surface: Surface)
+    @Keep
+    private external fun _setCacheDir(dir: String)
+    @Keep
+    private external fun _setVideoFilters(filters: String?)
+    @Keep
+    private external fun _setVideoSurfaceSize(width: Int, height: Int)
+    @Keep
+    private external fun _setVolume(leftVolume: Float, rightVolume: Float)
+    @Keep
+    private external fun _setPan(pan: Float)
+    @Keep
+    private external fun _setAudioPowerMode(mode: Int)
+    @Keep
+    private external fun _setAudioOutType(type: Int)
+    @Keep
+    private external fun _getAudioClockErrorMs(): Float
+    @Keep
+    private external fun _setAudioAnalysisEnabled(enabled: Boolean, bands: Int)
+    @Keep
+    private external fun _getAudioLevels(out: FloatArray): Boolean
+    @Keep
+    private external fun _setLoudnessMeterEnabled(enabled: Boolean)
+    @Keep
+    private external fun _getLoudness(out: FloatArray): Boolean
+    @Keep
+    private external fun _setFrameTap(listener: FrameTapListener?, maxFps: Float, maxWidth: Int, maxHeight: Int, format: Int)
+    @Keep
+    private external fun _captureFrame(path: String, format: Int, quality: Int, maxWidth: Int, maxHeight: Int)
+    @Keep
+    private external fun _setWatermark(pixels: ByteArray?, width: Int, height: Int,
+                                       left: Float, top: Float, right: Float, bottom: Float, alpha: Float)
     @Keep
     private external fun _start()
     @Keep
@@ -189,7 +322,6 @@ class SkyMediaPlayer() : IMediaPlayer {
     @Keep
     private external fun _isPlaying(): Boolean
     // private external fun _reset()
-    // private external fun _setVolume(leftVolume: Float, rightVolume: Float)
     // private external fun _getAudioSessionId(): Int
 
     init {
@@ -200,17 +332,17 @@ class SkyMediaPlayer() : IMediaPlayer {
 
     override fun setDisplay(sh: SurfaceHolder ?) {
         _surfaceHolder = sh;
-        val surface = sh?.surface
-        if (null != surface) {
-            _setVideoSurface(surface)
-        }
+        // sh 为 null 时通知 native 释放 window surface（EGL context 保留）
+        _setVideoSurface(sh?.surface)
     }
 
     override fun setDataSource(context: Context, localVideoPath: String) {
+        _setCacheDir(context.cacheDir.absolutePath)
         _setDataSource(localVideoPath)
     }
 
     override fun setDataSource(context: Context, uri: Uri) {
+        _setCacheDir(context.cacheDir.absolutePath)
         try {
             // 使用ContentResolver打开Uri并获取文件描述符
             context.contentResolver.openFileDescriptor(uri, "r")?.use { pfd ->
@@ -240,6 +372,43 @@ class SkyMediaPlayer() : IMediaPlayer {
         }
     }
 
+    /**
+     * 追加到播放列表，data source 播完后依次无缝播放；下一项在当前项播放时就已打开并缓冲，
+     * 切换时回调 MEDIA_INFO_PLAYLIST_ITEM_CHANGED，只有最后一项播完才回调 onCompletion
+     */
+    fun appendToPlaylist(path: String) {
+        _appendPlaylistItem(path)
+    }
+
+    /**
+     * 清空还没播放的项，当前项播完后结束
+     */
+    fun clearPlaylist() {
+        _clearPlaylist()
+    }
+
+    /**
+     * 设置 ffmpeg 格式的视频滤镜，尾部的 crop/eq 由 GPU 完成，其余仍交给 libavfilter
+     */
+    fun setVideoFilters(filters: String?) {
+        _setVideoFilters(filters)
+    }
+
+    /**
+     * 设置水印，位置为相对画面的归一化坐标（左上角为原点），bitmap 为 null 时移除
+     */
+    fun setWatermark(bitmap: Bitmap?, left: Float, top: Float, right: Float, bottom: Float, alpha: Float = 1.0f) {
+        if (bitmap == null) {
+            _setWatermark(null, 0, 0, 0f, 0f, 0f, 0f, 0f)
+            return
+        }
+        val argb = if (bitmap.config == Bitmap.Config.ARGB_8888) bitmap else bitmap.copy(Bitmap.Config.ARGB_8888, false)
+        // ARGB_8888 在内存中为 premultiplied RGBA
+        val buffer = ByteBuffer.allocate(argb.byteCount)
+        argb.copyPixelsToBuffer(buffer)
+        _setWatermark(buffer.array(), argb.width, argb.height, left, top, right, bottom, alpha)
+    }
+
     override fun prepareAsync() {
         _prepareAsync()
     }
@@ -289,6 +458,7 @@ class SkyMediaPlayer() : IMediaPlayer {
         _onVideoSizeChangedListener = null
         _onErrorListener = null
         _onInfoListener = null
+        _onTimedTextListener = null
 
         // 3. 清理 Surface 引用
         _surfaceHolder = null
@@ -307,8 +477,101 @@ class SkyMediaPlayer() : IMediaPlayer {
     }
 
     override fun setVolume(leftVolume: Float, rightVolume: Float) {
-        // TODO: 实现 JNI 方法后替换为 _setVolume(leftVolume, rightVolume)
-        Log.d(TAG, "setVolume: left=$leftVolume, right=$rightVolume")
+        _setVolume(leftVolume, rightVolume)
+    }
+
+    /**
+     * 声像，-1 为左、0 居中、1 为右，只在共享混音器输出下生效
+     */
+    fun setPan(pan: Float) {
+        _setPan(pan)
+    }
+
+    /**
+     * 音频功耗模式。深缓冲使用几百毫秒的设备 buffer 并批量解码，适合纯音频和后台播放；
+     * AUTO 在没有视频显示时使用深缓冲，Surface 恢复或 seek 后回到低延迟
+     * @param mode AUDIO_POWER_MODE_AUTO/AUDIO_POWER_MODE_LOW_LATENCY/AUDIO_POWER_MODE_DEEP_BUFFER
+     */
+    fun setAudioPowerMode(mode: Int) {
+        _setAudioPowerMode(mode)
+    }
+
+    /**
+     * 音频输出类型，下次 prepare 时生效，默认共享混音器。
+     * AUDIO_OUT_NULL 不出声、按系统时间消耗数据，用于没有音频设备的环境和 A/V drift 测量
+     * @param type AUDIO_OUT_OPENSL_ES/AUDIO_OUT_NULL/AUDIO_OUT_SHARED_MIXER
+     */
+    fun setAudioOutType(type: Int) {
+        _setAudioOutType(type)
+    }
+
+    /**
+     * 音频时钟与设备播放位置的平均偏差（ms），没有打开音频时为 0
+     */
+    fun getAudioClockErrorMs(): Float {
+        return _getAudioClockErrorMs()
+    }
+
+    /**
+     * 解码帧旁路的回调，在播放器的旁路线程调用
+     */
+    @Keep
+    interface FrameTapListener {
+        /**
+         * @param buffer 转换后的像素，只在回调期间有效，需要保留时自行拷贝；NV12 的 UV 紧跟在 Y 之后
+         * @param format FRAME_TAP_FORMAT_RGBA/FRAME_TAP_FORMAT_NV12
+         * @param ptsMs 帧的显示时间，未知时为 -1
+         */
+        fun onFrame(buffer: ByteBuffer, width: Int, height: Int, stride: Int, format: Int, ptsMs: Long)
+    }
+
+    /**
+     * 订阅正在播放的解码帧，用于应用内分析（场景检测、审核等），不需要从 Surface 回读。
+     * 解码线程只对帧加引用，缩小和格式转换在旁路线程完成；回调处理不过来时丢弃最旧的帧，不影响播放。
+     * 硬件解码直接输出到 Surface 时没有像素，不会回调
+     * @param listener null 为取消订阅
+     * @param maxFps 最高帧率，0 表示不限制
+     * @param maxWidth 按比例缩小到不超过 maxWidth x maxHeight，0 表示不限制
+     * @param format FRAME_TAP_FORMAT_RGBA/FRAME_TAP_FORMAT_NV12
+     */
+    fun setFrameTapListener(listener: FrameTapListener?, maxFps: Float = 0f, maxWidth: Int = 0, maxHeight: Int = 0,
+                            format: Int = FRAME_TAP_FORMAT_RGBA) {
+        _setFrameTap(listener, maxFps, maxWidth, maxHeight, format)
+    }
+
+    /**
+     * 音频电平/频谱分析，在低优先级线程上计算，不开启时没有内存和 CPU 开销
+     * @param bands 频带数（1~64），从 40Hz 到 20kHz 按对数划分
+     */
+    fun setAudioAnalysisEnabled(enabled: Boolean, bands: Int = 32) {
+        _setAudioAnalysisEnabled(enabled, bands)
+    }
+
+    /**
+     * 拉取最近一次分析结果，可以在每个 UI 帧调用
+     * @param out 依次为 rmsL、rmsR、peakL、peakR（线性值，满幅为 1），
+     *            从 AUDIO_LEVELS_BANDS_OFFSET 开始为各频带能量（dBFS），长度不足时截断
+     * @return 未开启或还没有结果时返回 false
+     */
+    fun getAudioLevels(out: FloatArray): Boolean {
+        return _getAudioLevels(out)
+    }
+
+    /**
+     * EBU R128 响度计量，统计解码后、音量调节前的音频；不开启时音频线程只多一次判断
+     * 重新开启时整体响度从头统计
+     */
+    fun setLoudnessMeterEnabled(enabled: Boolean) {
+        _setLoudnessMeterEnabled(enabled)
+    }
+
+    /**
+     * 拉取最近一次计量结果，每 100ms 更新一次
+     * @param out 按 LOUDNESS_MOMENTARY、LOUDNESS_SHORT_TERM、LOUDNESS_INTEGRATED 下标填入，长度不足时截断
+     * @return 未开启或还没有结果时返回 false
+     */
+    fun getLoudness(out: FloatArray): Boolean {
+        return _getLoudness(out)
     }
 
     override fun isPlaying(): Boolean {
@@ -324,6 +587,38 @@ class SkyMediaPlayer() : IMediaPlayer {
         _setVideoSurface(surface)
     }
 
+    override fun setSurfaceSize(width: Int, height: Int) {
+        _setVideoSurfaceSize(width, height)
+    }
+
+    /**
+     * 附加输出（画中画、预览等），与主 Surface 共用同一路解码，纹理每帧只上传一次
+     * @param rotation 顺时针旋转角度 (0/90/180/270)
+     * @param flip FLIP_HORIZONTAL/FLIP_VERTICAL 组合，在旋转之后应用
+     * @param crop 相对画面的归一化裁剪区域，null 为整个画面
+     * @param maxWidth buffer 宽度上限，保持宽高比缩小，0 表示不限制
+     */
+    fun addSurface(surface: Surface, rotation: Int = 0, flip: Int = 0, crop: RectF? = null,
+                   maxWidth: Int = 0, maxHeight: Int = 0) {
+        val region = crop ?: RectF(0f, 0f, 1f, 1f)
+        _addVideoSurface(surface, rotation, flip, region.left, region.top, region.right, region.bottom,
+            maxWidth, maxHeight)
+    }
+
+    fun removeSurface(surface: Surface) {
+        _removeVideoSurface(surface)
+    }
+
+    /**
+     * 异步截取当前显示的画面（旋转/镜像后），结果通过 OnFrameCapturedListener 返回
+     * @param format CAPTURE_FORMAT_JPEG/CAPTURE_FORMAT_PNG
+     * @param maxWidth 保持宽高比缩小，0 表示不限制
+     */
+    fun captureFrame(path: String, format: Int = CAPTURE_FORMAT_JPEG, quality: Int = 90,
+                     maxWidth: Int = 0, maxHeight: Int = 0) {
+        _captureFrame(path, format, quality, maxWidth, maxHeight)
+    }
+
     override fun setOnPreparedListener(listener: IMediaPlayer.OnPrepareListener) {
         _onPreparedListener = listener
     }
@@ -351,4 +646,12 @@ class SkyMediaPlayer() : IMediaPlayer {
     override fun setOnInfoListener(listener: IMediaPlayer.OnInfoListener) {
         _onInfoListener = listener
     }
+
+    override fun setOnTimedTextListener(listener: IMediaPlayer.OnTimedTextListener) {
+        _onTimedTextListener = listener
+    }
+
+    override fun setOnFrameCapturedListener(listener: IMediaPlayer.OnFrameCapturedListener) {
+        _onFrameCapturedListener = listener
+    }
 }
\ No newline at end of file
@@ -69,6 +69,7 @@ class SkyVideoView(context: Context,
                 height: Int
             ) {
                 Log.d(TAG, "surfaceChanged format:$format, width:$width, height:$height")
+                _mediaPlayer?.setSurfaceSize(width, height)
             }
 
             override fun surfaceDestroyed(holder: SurfaceHolder) {
@@ -462,6 +463,11 @@ class SkyVideoView(context: Context,
     private val _onInfoListener : IMediaPlayer.OnInfoListener = object : IMediaPlayer.OnInfoListener {
         override fun onInfo(mp: IMediaPlayer, what: Int, extra: Int): Boolean {
             Log.i(TAG, "onInfo what:$what, extra:$extra")
+            if (what == IMediaPlayer.MEDIA_INFO_VIDEO_ROTATION_CHANGED) {
+                // 旋转由 native 渲染完成，这里只需要按旋转后的宽高比布局
+                _surfaceRenderView?.setVideoRotation(extra)
+                return true
+            }
             return false
         }
     }
@@ -28,6 +28,7 @@ class SurfaceRenderView(
 
     // 视频尺寸相关属性
     private var _videoSize: VideoSizeCalculator.VideoSize? = null
+    private var _videoRotation: Int = 0
     private var _scaleType: VideoSizeCalculator.ScaleType = VideoSizeCalculator.ScaleType.AR_ASPECT_FIT_CENTER
 
     // 视频尺寸计算器
@@ -101,6 +102,17 @@ class SurfaceRenderView(
         requestLayout()
     }
 
+    /**
+     * 设置视频旋转角度（顺时针），90/270 度时按宽高互换后的比例布局
+     */
+    fun setVideoRotation(degree: Int) {
+        Log.i(TAG, "setVideoRotation degree:$degree")
+        if (_videoRotation != degree) {
+            _videoRotation = degree
+            requestLayout()
+        }
+    }
+
     /**
      * 设置缩放模式
      */
@@ -116,7 +128,15 @@ class SurfaceRenderView(
      * 重写 onMeasure 实现宽高比保持
      */
     override fun onMeasure(widthMeasureSpec: Int, heightMeasureSpec: Int) {
-        val videoSize = _videoSize
+        var videoSize = _videoSize
+        if (videoSize != null && (_videoRotation == 90 || _videoRotation == 270)) {
+            videoSize = VideoSizeCalculator.VideoSize(
+                width = videoSize.height,
+                height = videoSize.width,
+                sarNum = videoSize.sarDen,
+                sarDen = videoSize.sarNum
+            )
+        }
         if (videoSize == null || !videoSize.isValid()) {
             // 没有有效的视频尺寸信息时，使用默认测量
             Log.d(TAG, "No valid video size available, using default measure")
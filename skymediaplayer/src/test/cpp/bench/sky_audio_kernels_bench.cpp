@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "sky_bench.h"
+#include "sky_audio_kernels.h"
+
+// 每个内核处理一个 10 ms 设备 buffer（48 kHz）时分派实现与标量实现的耗时
+int main() {
+    constexpr int kFrames = 480;
+    constexpr int kChannels = 6;
+    constexpr int kIterations = 20000;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    std::vector<float> f32(kFrames * kChannels);
+    std::vector<float> f32Dst(kFrames * kChannels);
+    std::vector<int16_t> s16(kFrames * kChannels);
+    std::vector<int16_t> s16Dst(kFrames * kChannels);
+    for (auto &v : f32) v = dist(rng);
+    for (auto &v : s16) v = static_cast<int16_t>(rng());
+    std::vector<std::vector<float>> planeData(kChannels, std::vector<float>(kFrames));
+    const float *planes[kChannels];
+    for (int c = 0; c < kChannels; ++c) {
+        for (auto &v : planeData[c]) v = dist(rng);
+        planes[c] = planeData[c].data();
+    }
+    const float left[kChannels] = {0.7f, 0.0f, 0.5f, 0.0f, 0.6f, 0.0f};
+    const float right[kChannels] = {0.0f, 0.7f, 0.5f, 0.0f, 0.0f, 0.6f};
+    const float coeffs[10] = {1.5351249f, -2.6916962f, 1.1983928f, -1.6906593f, 0.7324808f,
+                              1.0f, -2.0f, 1.0f, -1.9900475f, 0.9900723f};
+    float state[8] = {};
+    float sumSq[2] = {};
+
+    struct Case {
+        const char *name;
+        std::function<void()> fn;
+    };
+    const Case cases[] = {
+            {"gain_s16 (stereo)", [&] { sky_audio_gain_s16(s16Dst.data(), s16.data(), kFrames * 2, 0.8f); }},
+            {"gain_f32 (stereo)", [&] { sky_audio_gain_f32(f32Dst.data(), f32.data(), kFrames * 2, 0.8f); }},
+            {"mix_s16 (stereo)", [&] { sky_audio_mix_s16(s16Dst.data(), s16.data(), kFrames * 2, 0.1f); }},
+            {"mix_f32 (stereo)", [&] { sky_audio_mix_f32(f32Dst.data(), f32.data(), kFrames * 2, 0.1f); }},
+            {"mix_stereo_f32", [&] { sky_audio_mix_stereo_f32(f32Dst.data(), f32.data(), kFrames, 0.1f, 0.05f); }},
+            {"ramp_s16 (stereo)", [&] { sky_audio_ramp_s16(s16Dst.data(), s16.data(), kFrames, 2, 0.0f, 1.0f); }},
+            {"ramp_f32 (stereo)", [&] { sky_audio_ramp_f32(f32Dst.data(), f32.data(), kFrames, 2, 0.0f, 1.0f); }},
+            {"downmix_f32 (5.1)", [&] {
+                sky_audio_downmix_stereo_f32(f32Dst.data(), planes, kFrames, kChannels, left, right); }},
+            {"downmix_s16 (5.1)", [&] {
+                sky_audio_downmix_stereo_s16(s16Dst.data(), planes, kFrames, kChannels, left, right); }},
+            {"kweight_f32 (stereo)", [&] { sky_audio_kweight_f32(f32.data(), kFrames, 2, coeffs, state, sumSq); }},
+    };
+
+    printf("implementation: %s, %d frames per call\n", sky_audio_kernels_impl(), kFrames);
+    printf("%-22s %10s %12s %8s\n", "kernel", "simd(ns)", "scalar(ns)", "speedup");
+    for (const auto &c : cases) {
+        sky_audio_kernels_force_scalar(0);
+        const double simd = sky_bench::measureUs(c.fn, kIterations) * 1000.0;
+        sky_audio_kernels_force_scalar(1);
+        const double scalar = sky_bench::measureUs(c.fn, kIterations) * 1000.0;
+        sky_bench::keep(f32Dst.data());
+        sky_bench::keep(s16Dst.data());
+        sky_bench::keep(sumSq);
+        printf("%-22s %10.0f %12.0f %7.2fx\n", c.name, simd, scalar, scalar / simd);
+    }
+    sky_audio_kernels_force_scalar(0);
+    return 0;
+}
@@ -0,0 +1,150 @@
+extern "C" {
+#include "libavformat/avio.h"
+}
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sky_bench.h"
+#include "sky_mmap_io.h"
+
+/*
+ * 同一个本地文件分别经 SkyMmapIo 和 FFmpeg 的 file 协议读取的耗时，不需要界面和解码：
+ * 按 demux 常见的读取大小顺序读完整个文件，以及随机 seek 后读一块（mov 的交错、用户拖动）。
+ * cold 在每轮之前用 posix_fadvise 把文件移出页缓存，warm 直接读页缓存。
+ *
+ * 主机：cmake 找到 libavformat 时构建到 bench/ 下
+ * 设备：主工程 cmake 加 -DSKY_BUILD_BENCH=ON，adb push 后
+ *       adb shell "cd /data/local/tmp && LD_LIBRARY_PATH=. ./sky_mmap_io_bench [目录] [MB]"
+ */
+namespace {
+    constexpr int kRandomReads = 2000;
+    constexpr int kRandomReadSize = 64 * 1024;
+
+    std::string makeFile(const std::string &dir, int64_t size) {
+        std::string path = dir + "/sky_mmap_io_bench.bin";
+        FILE *fp = fopen(path.c_str(), "wb");
+        if (nullptr == fp) {
+            return "";
+        }
+        std::vector<uint8_t> block(1024 * 1024);
+        std::mt19937 rng(1);
+        for (auto &b : block) {
+            b = static_cast<uint8_t>(rng());
+        }
+        for (int64_t written = 0; written < size; written += static_cast<int64_t>(block.size())) {
+            fwrite(block.data(), 1, block.size(), fp);
+        }
+        fclose(fp);
+        // SkyMmapIo 跳过刚修改过的文件，把修改时间设到一小时前
+        struct timespec times[2];
+        clock_gettime(CLOCK_REALTIME, &times[0]);
+        times[0].tv_sec -= 3600;
+        times[1] = times[0];
+        utimensat(AT_FDCWD, path.c_str(), times, 0);
+        return path;
+    }
+
+    void dropPageCache(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+
+    AVIOContext *openIo(const std::string &path, bool mmap) {
+        if (mmap) {
+            return SkyMmapIo::open(path.c_str());
+        }
+        AVIOContext *pb = nullptr;
+        return avio_open2(&pb, ("file:" + path).c_str(), AVIO_FLAG_READ, nullptr, nullptr) < 0 ? nullptr : pb;
+    }
+
+    void closeIo(AVIOContext **pb, bool mmap) {
+        if (mmap) {
+            SkyIo::close(pb);
+        } else {
+            avio_closep(pb);
+        }
+    }
+
+    uint64_t readSequential(AVIOContext *pb, std::vector<uint8_t> &buf) {
+        uint64_t sum = 0;
+        int n;
+        while ((n = avio_read(pb, buf.data(), static_cast<int>(buf.size()))) > 0) {
+            sum += buf[0] + buf[n - 1];
+        }
+        return sum;
+    }
+
+    uint64_t readRandom(AVIOContext *pb, std::vector<uint8_t> &buf, int64_t size) {
+        std::mt19937_64 rng(2);
+        uint64_t sum = 0;
+        for (int i = 0; i < kRandomReads; ++i) {
+            avio_seek(pb, static_cast<int64_t>(rng() % static_cast<uint64_t>(size - kRandomReadSize)), SEEK_SET);
+            int n = avio_read(pb, buf.data(), kRandomReadSize);
+            sum += n > 0 ? buf[0] : 0;
+        }
+        return sum;
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::string dir = argc > 1 ? argv[1] : "/tmp";
+    const int64_t size = (argc > 2 ? std::max(16, atoi(argv[2])) : 256) * 1024LL * 1024;
+    const std::string path = makeFile(dir, size);
+    if (path.empty()) {
+        fprintf(stderr, "can not create test file in %s\n", dir.c_str());
+        return 1;
+    }
+
+    printf("file %s, %lld MB\n", path.c_str(), (long long) (size >> 20));
+    printf("%-22s %-6s %12s %12s %8s\n", "case", "cache", "file(MB/s)", "mmap(MB/s)", "speedup");
+    struct Case {
+        const char *name;
+        int readSize;
+        bool random;
+    };
+    const Case cases[] = {
+            {"sequential 4 KB", 4 * 1024, false},
+            {"sequential 64 KB", 64 * 1024, false},
+            {"sequential 1 MB", 1024 * 1024, false},
+            {"random seek + 64 KB", kRandomReadSize, true},
+    };
+    for (const auto &c : cases) {
+        const double megabytes = (c.random ? static_cast<double>(kRandomReads) * kRandomReadSize : size) / (1 << 20);
+        for (bool cold : {false, true}) {
+            double us[2];
+            for (bool mmap : {false, true}) {
+                std::vector<uint8_t> buf(static_cast<size_t>(c.readSize));
+                us[mmap] = sky_bench::measureUs([&] {
+                    if (cold) {
+                        dropPageCache(path);
+                    }
+                    AVIOContext *pb = openIo(path, mmap);
+                    if (nullptr == pb) {
+                        fprintf(stderr, "open %s failed\n", mmap ? "mmap" : "file");
+                        exit(1);
+                    }
+                    uint64_t sum = c.random ? readRandom(pb, buf, size) : readSequential(pb, buf);
+                    sky_bench::keep(&sum);
+                    closeIo(&pb, mmap);
+                }, 1, 3);
+            }
+            printf("%-22s %-6s %12.0f %12.0f %7.2fx\n", c.name, cold ? "cold" : "warm",
+                   megabytes / (us[0] / 1e6), megabytes / (us[1] / 1e6), us[0] / us[1]);
+        }
+    }
+    unlink(path.c_str());
+    return 0;
+}
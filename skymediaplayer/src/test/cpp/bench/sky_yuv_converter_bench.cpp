@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "sky_bench.h"
+#include "sky_yuv_converter.h"
+#include "sky_yuv_reference.h"
+
+using Layout = SkyYuvConverter::Layout;
+using OutputFormat = SkyYuvConverter::OutputFormat;
+
+// 常见分辨率下 SIMD 转换与逐像素参考实现的单帧耗时
+int main() {
+    const int sizes[][2] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+    std::mt19937 rng(1);
+    printf("implementation: %s\n", SkyYuvConverter::implementationName());
+    printf("%-6s %-7s %-10s %12s %12s %8s\n", "layout", "format", "size", "simd(us)", "scalar(us)", "speedup");
+
+    for (const auto &size : sizes) {
+        const int width = size[0];
+        const int height = size[1];
+        std::vector<uint8_t> y(static_cast<size_t>(width) * height);
+        std::vector<uint8_t> chroma(static_cast<size_t>(width) * height / 2);
+        for (auto &b : y) b = static_cast<uint8_t>(rng());
+        for (auto &b : chroma) b = static_cast<uint8_t>(rng());
+
+        for (Layout layout : {Layout::I420, Layout::NV12}) {
+            const uint8_t *planes[3];
+            int strides[3];
+            planes[0] = y.data();
+            strides[0] = width;
+            if (layout == Layout::I420) {
+                planes[1] = chroma.data();
+                planes[2] = chroma.data() + chroma.size() / 2;
+                strides[1] = strides[2] = width / 2;
+            } else {
+                planes[1] = chroma.data();
+                planes[2] = nullptr;
+                strides[1] = width;
+                strides[2] = 0;
+            }
+
+            for (OutputFormat format : {OutputFormat::RGBA8888, OutputFormat::RGB565}) {
+                const int dstStride = width * SkyYuvConverter::bytesPerPixel(format);
+                std::vector<uint8_t> dst(static_cast<size_t>(dstStride) * height);
+                const int iterations = width * height > 4000000 ? 5 : 20;
+                double simd = sky_bench::measureUs([&]() {
+                    SkyYuvConverter::convert(layout, planes, strides, width, height, dst.data(), dstStride, format);
+                    sky_bench::keep(dst.data());
+                }, iterations);
+                double scalar = sky_bench::measureUs([&]() {
+                    sky_yuv_reference::convert(layout, planes, strides, width, height, dst.data(), dstStride, format);
+                    sky_bench::keep(dst.data());
+                }, iterations);
+                printf("%-6s %-7s %4dx%-5d %12.1f %12.1f %7.2fx\n",
+                       layout == Layout::I420 ? "I420" : "NV12",
+                       format == OutputFormat::RGB565 ? "RGB565" : "RGBA",
+                       width, height, simd, scalar, scalar / simd);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+//
+// 音频线程 CPU 时间和唤醒次数的设备端 benchmark：不解码文件，回调里模拟 ffplay 的输出路径
+// （planar float 解码结果 -> 交错 s16/f32 -> 音量），按 s16/f32 × 低延迟/深缓冲逐项运行。
+//
+// 构建：主工程 cmake 加 -DSKY_BUILD_BENCH=ON（gradle 的 externalNativeBuild.cmake.arguments）
+// 运行：adb push sky_audio_power_bench libskymediaplayer.so libSDL3.so libskyffmpeg.so /data/local/tmp/
+//       adb shell "cd /data/local/tmp && LD_LIBRARY_PATH=. ./sky_audio_power_bench [null|opensl] [秒数]"
+// null 输出不占用设备，结果只取决于线程调度；opensl 按真实设备的回调节奏运行。
+// 每个线程的分项统计同时由 SkyThreadPowerStats 写入 logcat。
+//
+
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "skyaudio.h"
+#include "sky_audio_kernels.h"
+
+namespace {
+    constexpr int kSampleRate = 48000;
+    constexpr int kChannels = 2;
+    // AAC 一帧的样本数，解码结果按帧交给回调
+    constexpr int kFrameSamples = 1024;
+
+    struct Source {
+        bool isFloat = true;
+        float gain = 0.8f;
+        std::vector<float> planes[kChannels];
+        std::vector<uint8_t> packed;
+        int offset = 0;
+        int available = 0;
+    };
+
+    // 模拟 audio_decode_frame：f32 只做 planar -> packed，s16 还要转换格式（swr 的工作）
+    void decodeFrame(Source *source) {
+        const int sampleSize = source->isFloat ? 4 : 2;
+        source->packed.resize(static_cast<size_t>(kFrameSamples) * kChannels * sampleSize);
+        for (int i = 0; i < kFrameSamples; ++i) {
+            for (int c = 0; c < kChannels; ++c) {
+                float v = source->planes[c][i];
+                if (source->isFloat) {
+                    reinterpret_cast<float *>(source->packed.data())[i * kChannels + c] = v;
+                } else {
+                    reinterpret_cast<int16_t *>(source->packed.data())[i * kChannels + c] =
+                            static_cast<int16_t>(std::lrintf(v * 32767.0f));
+                }
+            }
+        }
+        source->offset = 0;
+        source->available = static_cast<int>(source->packed.size());
+    }
+
+    // 模拟 stream_audio_fill：按帧取数据并乘音量
+    void audioCallback(void *userdata, Uint8 *stream, int len) {
+        auto *source = static_cast<Source *>(userdata);
+        while (len > 0) {
+            if (source->available == 0) {
+                decodeFrame(source);
+            }
+            int n = std::min(len, source->available);
+            const uint8_t *src = source->packed.data() + source->offset;
+            if (source->isFloat) {
+                sky_audio_gain_f32(reinterpret_cast<float *>(stream), reinterpret_cast<const float *>(src),
+                                   n / 4, source->gain);
+            } else {
+                sky_audio_gain_s16(reinterpret_cast<int16_t *>(stream), reinterpret_cast<const int16_t *>(src),
+                                   n / 2, source->gain);
+            }
+            stream += n;
+            len -= n;
+            source->offset += n;
+            source->available -= n;
+        }
+    }
+
+    struct Usage {
+        double cpuMs;
+        long switches;
+    };
+
+    Usage processUsage() {
+        struct rusage ru{};
+        getrusage(RUSAGE_SELF, &ru);
+        double cpuMs = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000.0
+                       + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000.0;
+        return {cpuMs, ru.ru_nvcsw + ru.ru_nivcsw};
+    }
+
+    bool runCase(bool useOpenSL, bool isFloat, bool deep, int seconds) {
+        Source source;
+        source.isFloat = isFloat;
+        for (auto &plane : source.planes) {
+            plane.resize(kFrameSamples);
+        }
+        for (int i = 0; i < kFrameSamples; ++i) {
+            float v = 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 440.0f * i / kSampleRate);
+            source.planes[0][i] = v;
+            source.planes[1][i] = -v;
+        }
+
+        std::unique_ptr<SkyAudioOut> out;
+        if (useOpenSL) {
+            out = std::make_unique<SkySLESAudioOut>();
+        } else {
+            out = std::make_unique<SkyNullAudioOut>();
+        }
+        SkyAudioSpec desired{};
+        desired.sdl_audioSpec.format = isFloat ? SDL_AUDIO_F32 : SDL_AUDIO_S16;
+        desired.sdl_audioSpec.channels = kChannels;
+        desired.sdl_audioSpec.freq = kSampleRate;
+        desired.samples = 1024;
+        desired.callback = audioCallback;
+        desired.userdata = &source;
+        SkyAudioSpec obtained{};
+        out->setDeepBuffer(deep);
+        if (!out->openAudio(&desired, &obtained)) {
+            fprintf(stderr, "openAudio failed (%s)\n", isFloat ? "f32" : "s16");
+            return false;
+        }
+
+        // 跳过启动阶段的预填充；启动后 AUDIO_DEEP_HOLDOFF_MS 内仍按低延迟运行，深缓冲要等它过去
+        out->pauseAudio(0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(AUDIO_DEEP_HOLDOFF_MS + 1000));
+        Usage begin = processUsage();
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        Usage end = processUsage();
+        out->closeAudio();
+
+        double minutes = seconds / 60.0;
+        printf("%-4s %-11s %10.1f %14.1f %10llu\n", isFloat ? "f32" : "s16", deep ? "deep-buffer" : "low-latency",
+               (end.cpuMs - begin.cpuMs) / minutes, (end.switches - begin.switches) / static_cast<double>(seconds),
+               static_cast<unsigned long long>(out->getUnderrunCount()));
+        return true;
+    }
+}
+
+int main(int argc, char **argv) {
+    const bool useOpenSL = argc > 1 && strcmp(argv[1], "opensl") == 0;
+    const int seconds = argc > 2 ? std::max(1, atoi(argv[2])) : 20;
+
+    printf("output: %s, %d s per case, kernels: %s\n", useOpenSL ? "opensl" : "null", seconds, sky_audio_kernels_impl());
+    printf("%-4s %-11s %10s %14s %10s\n", "fmt", "mode", "cpu ms/min", "ctx switch/s", "underruns");
+    for (bool isFloat : {false, true}) {
+        for (bool deep : {false, true}) {
+            if (!runCase(useOpenSL, isFloat, deep, seconds)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
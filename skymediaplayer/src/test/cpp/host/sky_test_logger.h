@@ -0,0 +1,21 @@
+#ifndef SKY_TEST_LOGGER_H
+#define SKY_TEST_LOGGER_H
+
+/*
+ * 主机编译时代替 include/logger.h（通过 -include 强制包含，占用它的 include guard），
+ * 日志输出到 stderr，不依赖 android/log.h。
+ */
+#define MY_PLAYER_LOGGER_H
+
+#include <stdio.h>
+
+#define SKY_TEST_LOG(LEVEL, TAG, ...) (fprintf(stderr, "%s/%s: ", LEVEL, TAG), fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+
+#define ALOG_I(TAG, ...) SKY_TEST_LOG("I", TAG, __VA_ARGS__)
+#define ALOG_D(TAG, ...) SKY_TEST_LOG("D", TAG, __VA_ARGS__)
+#define ALOG_W(TAG, ...) SKY_TEST_LOG("W", TAG, __VA_ARGS__)
+#define ALOG_E(TAG, ...) SKY_TEST_LOG("E", TAG, __VA_ARGS__)
+
+#define FUNC_TRACE() ALOG_I("sky_trace", "Func:%s, line:%d", __func__, __LINE__);
+
+#endif // SKY_TEST_LOGGER_H
@@ -0,0 +1,176 @@
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sky_test.h"
+#include "sky_audio_kernels.h"
+
+/*
+ * 当前平台分派到的 SIMD 实现与标量实现逐位比较。长度覆盖 0、小于一个向量以及不是 4/8/16 倍数的尾部，
+ * 起始地址错开一个样本，检查非对齐访问和尾部交接。
+ */
+namespace {
+    const int kCounts[] = {0, 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 23, 31, 32, 33, 63, 64, 65, 127, 1000, 1023, 1029};
+    const float kGains[] = {0.37f, 0.8f, 1.9f, -0.6f};
+
+    std::vector<int16_t> randomS16(size_t n, std::mt19937 &rng) {
+        std::vector<int16_t> v(n);
+        for (auto &s : v) {
+            s = static_cast<int16_t>(rng());
+        }
+        return v;
+    }
+
+    std::vector<float> randomF32(size_t n, std::mt19937 &rng) {
+        std::uniform_real_distribution<float> dist(-1.5f, 1.5f);
+        std::vector<float> v(n);
+        for (auto &s : v) {
+            s = dist(rng);
+        }
+        return v;
+    }
+
+    // 对同一份输入分别用标量和分派后的实现运行 fn，逐位比较 dst
+    template <typename T, typename Fn>
+    bool sameAsScalar(const std::vector<T> &init, Fn &&fn) {
+        std::vector<T> scalar = init;
+        std::vector<T> simd = init;
+        sky_audio_kernels_force_scalar(1);
+        fn(scalar.data());
+        sky_audio_kernels_force_scalar(0);
+        fn(simd.data());
+        return memcmp(scalar.data(), simd.data(), sizeof(T) * init.size()) == 0;
+    }
+
+    std::string describe(const char *kernel, int count, float gain) {
+        return std::string(kernel) + " count=" + std::to_string(count) + " gain=" + std::to_string(gain);
+    }
+
+    void expectSame(bool same, const std::string &what) {
+        if (!same) {
+            sky_test::fail(__FILE__, __LINE__, std::string("differs from scalar: ") + what + " impl="
+                                               + sky_audio_kernels_impl());
+        }
+    }
+}
+
+TEST(AudioKernelsGainMatchesScalar) {
+    std::mt19937 rng(1);
+    for (int count : kCounts) {
+        for (float gain : kGains) {
+            auto s16 = randomS16(count + 1, rng);
+            auto dstS16 = randomS16(count + 1, rng);
+            expectSame(sameAsScalar(dstS16, [&](int16_t *dst) {
+                sky_audio_gain_s16(dst + 1, s16.data() + 1, count, gain);
+            }), describe("gain_s16", count, gain));
+
+            auto f32 = randomF32(count + 1, rng);
+            auto dstF32 = randomF32(count + 1, rng);
+            expectSame(sameAsScalar(dstF32, [&](float *dst) {
+                sky_audio_gain_f32(dst + 1, f32.data() + 1, count, gain);
+            }), describe("gain_f32", count, gain));
+
+            // 原地处理
+            expectSame(sameAsScalar(s16, [&](int16_t *dst) {
+                sky_audio_gain_s16(dst, dst, count, gain);
+            }), describe("gain_s16 in place", count, gain));
+        }
+    }
+}
+
+TEST(AudioKernelsMixMatchesScalar) {
+    std::mt19937 rng(2);
+    for (int count : kCounts) {
+        for (float gain : kGains) {
+            auto s16 = randomS16(count + 1, rng);
+            expectSame(sameAsScalar(randomS16(count + 1, rng), [&](int16_t *dst) {
+                sky_audio_mix_s16(dst + 1, s16.data() + 1, count, gain);
+            }), describe("mix_s16", count, gain));
+
+            auto f32 = randomF32(count + 1, rng);
+            expectSame(sameAsScalar(randomF32(count + 1, rng), [&](float *dst) {
+                sky_audio_mix_f32(dst + 1, f32.data() + 1, count, gain);
+            }), describe("mix_f32", count, gain));
+        }
+    }
+}
+
+TEST(AudioKernelsMixStereoMatchesScalar) {
+    std::mt19937 rng(3);
+    for (int frames : kCounts) {
+        auto src = randomF32(frames * 2 + 1, rng);
+        expectSame(sameAsScalar(randomF32(frames * 2 + 1, rng), [&](float *dst) {
+            sky_audio_mix_stereo_f32(dst + 1, src.data() + 1, frames, 0.9f, 0.35f);
+        }), describe("mix_stereo_f32", frames, 0.9f));
+    }
+}
+
+TEST(AudioKernelsRampMatchesScalar) {
+    std::mt19937 rng(4);
+    for (int frames : kCounts) {
+        for (int channels : {1, 2, 6}) {
+            const int count = frames * channels;
+            auto s16 = randomS16(count + 1, rng);
+            expectSame(sameAsScalar(randomS16(count + 1, rng), [&](int16_t *dst) {
+                sky_audio_ramp_s16(dst + 1, s16.data() + 1, frames, channels, 0.0f, 1.7f);
+            }), describe(("ramp_s16 ch=" + std::to_string(channels)).c_str(), frames, 1.7f));
+
+            auto f32 = randomF32(count + 1, rng);
+            expectSame(sameAsScalar(randomF32(count + 1, rng), [&](float *dst) {
+                sky_audio_ramp_f32(dst + 1, f32.data() + 1, frames, channels, 1.0f, 0.0f);
+            }), describe(("ramp_f32 ch=" + std::to_string(channels)).c_str(), frames, 0.0f));
+        }
+    }
+}
+
+TEST(AudioKernelsDownmixMatchesScalar) {
+    std::mt19937 rng(5);
+    const float left[SKY_AUDIO_DOWNMIX_MAX_CHANNELS] = {0.7f, 0.0f, 0.5f, 0.3f, 0.6f, 0.0f, 0.4f, 0.2f};
+    const float right[SKY_AUDIO_DOWNMIX_MAX_CHANNELS] = {0.0f, 0.7f, 0.5f, 0.3f, 0.0f, 0.6f, 0.2f, 0.4f};
+    for (int frames : kCounts) {
+        for (int channels = 1; channels <= SKY_AUDIO_DOWNMIX_MAX_CHANNELS; ++channels) {
+            std::vector<std::vector<float>> data(channels);
+            const float *planes[SKY_AUDIO_DOWNMIX_MAX_CHANNELS];
+            for (int c = 0; c < channels; ++c) {
+                data[c] = randomF32(frames + 1, rng);
+                planes[c] = data[c].data() + 1;
+            }
+            const std::string name = "downmix ch=" + std::to_string(channels);
+            expectSame(sameAsScalar(randomF32(frames * 2, rng), [&](float *dst) {
+                sky_audio_downmix_stereo_f32(dst, planes, frames, channels, left, right);
+            }), describe((name + " f32").c_str(), frames, 0));
+            expectSame(sameAsScalar(randomS16(frames * 2, rng), [&](int16_t *dst) {
+                sky_audio_downmix_stereo_s16(dst, planes, frames, channels, left, right);
+            }), describe((name + " s16").c_str(), frames, 0));
+        }
+    }
+}
+
+TEST(AudioKernelsKWeightMatchesScalar) {
+    // 48 kHz 的 BS.1770 K 加权系数（高架 + 高通）
+    const float coeffs[10] = {1.53512485958697f, -2.69169618940638f, 1.19839281085285f,
+                              -1.69065929318241f, 0.73248077421585f,
+                              1.0f, -2.0f, 1.0f, -1.99004745483398f, 0.99007225036621f};
+    std::mt19937 rng(6);
+    for (int frames : kCounts) {
+        for (int channels : {1, 2, 6}) {
+            auto src = randomF32(frames * channels, rng);
+            float stateScalar[SKY_AUDIO_KWEIGHT_MAX_CHANNELS * 4] = {};
+            float stateSimd[SKY_AUDIO_KWEIGHT_MAX_CHANNELS * 4] = {};
+            float sumScalar[SKY_AUDIO_KWEIGHT_MAX_CHANNELS] = {};
+            float sumSimd[SKY_AUDIO_KWEIGHT_MAX_CHANNELS] = {};
+            // 连续处理两块，检查跨调用保存的滤波状态
+            for (int block = 0; block < 2; ++block) {
+                sky_audio_kernels_force_scalar(1);
+                sky_audio_kweight_f32(src.data(), frames, channels, coeffs, stateScalar, sumScalar);
+                sky_audio_kernels_force_scalar(0);
+                sky_audio_kweight_f32(src.data(), frames, channels, coeffs, stateSimd, sumSimd);
+                const std::string what = "kweight ch=" + std::to_string(channels) + " frames="
+                                         + std::to_string(frames) + " block=" + std::to_string(block);
+                expectSame(memcmp(stateScalar, stateSimd, sizeof(stateScalar)) == 0, what + " state");
+                expectSame(memcmp(sumScalar, sumSimd, sizeof(sumScalar)) == 0, what + " sumSq");
+            }
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef SKY_BENCH_H
+#define SKY_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+/**
+ * benchmark 小工具：预热一次后重复运行 repeat 轮，每轮 iterations 次，取最快一轮的单次耗时（微秒），
+ * 减少调度和频率变化的干扰。
+ */
+namespace sky_bench {
+    template <typename Fn>
+    double measureUs(Fn &&fn, int iterations, int repeat = 5) {
+        fn();
+        double best = 0;
+        for (int r = 0; r < repeat; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                fn();
+            }
+            const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count()
+                              / iterations;
+            best = r == 0 ? us : std::min(best, us);
+        }
+        return best;
+    }
+
+    // 防止编译器把只写不读的结果优化掉
+    inline void keep(const void *p) {
+        asm volatile("" : : "r"(p) : "memory");
+    }
+}
+
+#endif // SKY_BENCH_H
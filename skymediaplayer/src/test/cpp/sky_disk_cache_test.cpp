@@ -0,0 +1,222 @@
+extern "C" {
+#include "libavformat/avio.h"
+}
+
+#include <dirent.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "sky_test.h"
+#include "sky_http_test_server.h"
+#include "sky_disk_cache.h"
+
+/*
+ * 本地 HTTP 服务上按 read_thread 的方式读 skycache: 地址：下载中断后续传只请求缺失部分，
+ * 超出预算按最近使用淘汰，源站 ETag/Last-Modified 变化时丢弃旧数据，HLS/DASH 不进缓存。
+ */
+namespace {
+    sky_test::HttpServer &server() {
+        static sky_test::HttpServer instance;
+        static bool started = instance.start();
+        (void) started;
+        return instance;
+    }
+
+    // 每个进程只能设置一次缓存目录，所有用例共用一个临时目录
+    const std::string &cacheDir() {
+        static std::string dir = [] {
+            char tmpl[] = "/tmp/sky_disk_cache_test.XXXXXX";
+            const char *path = mkdtemp(tmpl);
+            std::string result = path ? std::string(path) + "/skycache" : std::string();
+            SkyDiskCache::instance().setDir(result);
+            return result;
+        }();
+        return dir;
+    }
+
+    std::string cacheUrl(const std::string &path) {
+        cacheDir();
+        return DISK_CACHE_SCHEME + server().url(path);
+    }
+
+    std::vector<uint8_t> serve(const std::string &path, size_t size, uint32_t seed,
+                               const std::string &etag = "", const std::string &lastModified = "") {
+        auto data = sky_test::HttpServer::makeData(size, seed);
+        server().setResource(path, {data, etag, lastModified});
+        return data;
+    }
+
+    // 最多读 limit 字节后关闭，limit 小于 0 时读到结束
+    std::vector<uint8_t> readUrl(const std::string &url, int64_t limit = -1) {
+        std::vector<uint8_t> out;
+        AVIOContext *pb = SkyDiskCache::instance().openIo(url.c_str(), nullptr);
+        if (nullptr == pb) {
+            return out;
+        }
+        uint8_t buf[16 * 1024];
+        while (limit < 0 || static_cast<int64_t>(out.size()) < limit) {
+            int size = sizeof(buf);
+            if (limit >= 0) {
+                size = static_cast<int>(std::min<int64_t>(size, limit - static_cast<int64_t>(out.size())));
+            }
+            int n = avio_read(pb, buf, size);
+            if (n <= 0) {
+                break;
+            }
+            out.insert(out.end(), buf, buf + n);
+        }
+        SkyIo::close(&pb);
+        return out;
+    }
+
+    // from 之后对 path 的 GET 请求
+    std::vector<sky_test::HttpServer::Request> getsSince(size_t from, const std::string &path) {
+        std::vector<sky_test::HttpServer::Request> result;
+        auto all = server().requests();
+        for (size_t i = from; i < all.size(); ++i) {
+            if (all[i].method == "GET" && all[i].path == path) {
+                result.push_back(all[i]);
+            }
+        }
+        return result;
+    }
+
+    int countFiles(const std::string &dir) {
+        int count = 0;
+        DIR *d = opendir(dir.c_str());
+        if (nullptr == d) {
+            return -1;
+        }
+        while (struct dirent *ent = readdir(d)) {
+            count += ent->d_name[0] != '.' ? 1 : 0;
+        }
+        closedir(d);
+        return count;
+    }
+}
+
+TEST(DiskCacheResumesInterruptedDownload) {
+    const std::string path = "/resume.bin";
+    const std::string url = cacheUrl(path);
+    const std::string upstream = server().url(path);
+    auto data = serve(path, 600 * 1024, 1, "\"r1\"");
+
+    // 播放到一半退出：已下载的部分留在缓存里
+    auto head = readUrl(url, 150 * 1024);
+    ASSERT_TRUE(head.size() == 150 * 1024);
+    EXPECT_TRUE(memcmp(head.data(), data.data(), head.size()) == 0);
+    const int64_t cached = SkyDiskCache::instance().cachedBytes(upstream);
+    EXPECT_TRUE(cached >= 150 * 1024);
+    EXPECT_TRUE(cached < static_cast<int64_t>(data.size()));
+
+    // 再次打开：开头读磁盘，从缓存结束的位置续传
+    size_t mark = server().requests().size();
+    EXPECT_TRUE(readUrl(url) == data);
+    bool resumed = false;
+    for (const auto &request : getsSince(mark, path)) {
+        resumed = resumed || request.rangeStart == cached;
+    }
+    EXPECT_TRUE(resumed);
+    EXPECT_EQ(SkyDiskCache::instance().cachedBytes(upstream), static_cast<int64_t>(data.size()));
+
+    // 全部缓存后只剩校验用的 HEAD
+    mark = server().requests().size();
+    EXPECT_TRUE(readUrl(url) == data);
+    EXPECT_EQ(getsSince(mark, path).size(), static_cast<size_t>(0));
+    EXPECT_TRUE(server().requests().size() > mark);
+}
+
+TEST(DiskCacheSurvivesDroppedConnection) {
+    const std::string path = "/dropped.bin";
+    const std::string url = cacheUrl(path);
+    auto data = serve(path, 500 * 1024, 2);
+
+    // 第一个 GET 发 200 KB 后断开，FFmpeg 重连后接着下载，缓存内容不能错位
+    std::atomic<int> drops{0};
+    server().setFault([&drops, path](const sky_test::HttpServer::Request &request, int) {
+        sky_test::HttpServer::Fault fault;
+        if (request.path == path && request.method == "GET" && drops++ == 0) {
+            fault.dropAfter = 200 * 1024;
+        }
+        return fault;
+    });
+    EXPECT_TRUE(readUrl(url) == data);
+    server().setFault(nullptr);
+    EXPECT_TRUE(drops.load() >= 2);
+    EXPECT_EQ(SkyDiskCache::instance().cachedBytes(server().url(path)), static_cast<int64_t>(data.size()));
+
+    const size_t mark = server().requests().size();
+    EXPECT_TRUE(readUrl(url) == data);
+    EXPECT_EQ(getsSince(mark, path).size(), static_cast<size_t>(0));
+}
+
+TEST(DiskCacheEvictsLeastRecentlyUsed) {
+    const std::string a = "/evict_a.bin";
+    const std::string b = "/evict_b.bin";
+    const std::string c = "/evict_c.bin";
+    auto dataA = serve(a, 300 * 1024, 3);
+    auto dataB = serve(b, 300 * 1024, 4);
+    auto dataC = serve(c, 300 * 1024, 5);
+
+    // 前面用例留下的缓存先被淘汰掉
+    SkyDiskCache::instance().setBudget(700 * 1024);
+    const int before = countFiles(cacheDir());
+    EXPECT_TRUE(readUrl(cacheUrl(a)) == dataA);
+    EXPECT_TRUE(readUrl(cacheUrl(b)) == dataB);
+    // 重播 a，b 成为最久没用的
+    EXPECT_TRUE(readUrl(cacheUrl(a)) == dataA);
+    EXPECT_TRUE(readUrl(cacheUrl(c)) == dataC);
+
+    EXPECT_EQ(SkyDiskCache::instance().cachedBytes(server().url(a)), static_cast<int64_t>(dataA.size()));
+    EXPECT_EQ(SkyDiskCache::instance().cachedBytes(server().url(b)), 0);
+    EXPECT_EQ(SkyDiskCache::instance().cachedBytes(server().url(c)), static_cast<int64_t>(dataC.size()));
+    // b 的索引和数据文件都已删除
+    EXPECT_EQ(countFiles(cacheDir()), before + 4);
+
+    // 被淘汰后重新回源，内容不受影响
+    const size_t mark = server().requests().size();
+    EXPECT_TRUE(readUrl(cacheUrl(b)) == dataB);
+    EXPECT_TRUE(!getsSince(mark, b).empty());
+    SkyDiskCache::instance().setBudget(DISK_CACHE_DEFAULT_BUDGET);
+}
+
+TEST(DiskCacheDropsChangedContent) {
+    // ETag 变化，大小不变
+    const std::string path = "/etag.bin";
+    const std::string url = cacheUrl(path);
+    auto v1 = serve(path, 200 * 1024, 6, "\"v1\"");
+    EXPECT_TRUE(readUrl(url) == v1);
+    size_t mark = server().requests().size();
+    EXPECT_TRUE(readUrl(url) == v1);
+    EXPECT_EQ(getsSince(mark, path).size(), static_cast<size_t>(0));
+
+    auto v2 = serve(path, 200 * 1024, 7, "\"v2\"");
+    mark = server().requests().size();
+    EXPECT_TRUE(readUrl(url) == v2);
+    EXPECT_TRUE(!getsSince(mark, path).empty());
+
+    // 只有 Last-Modified 的源站
+    const std::string lmPath = "/last_modified.bin";
+    const std::string lmUrl = cacheUrl(lmPath);
+    auto old = serve(lmPath, 100 * 1024, 8, "", "Mon, 05 Oct 2026 08:00:00 GMT");
+    EXPECT_TRUE(readUrl(lmUrl) == old);
+    auto updated = serve(lmPath, 100 * 1024, 9, "", "Tue, 06 Oct 2026 08:00:00 GMT");
+    EXPECT_TRUE(readUrl(lmUrl) == updated);
+}
+
+TEST(DiskCacheRejectsSegmentedStreams) {
+    const std::string playlist = cacheUrl("/live/index.m3u8");
+    EXPECT_TRUE(SkyDiskCache::instance().openIo(playlist.c_str(), nullptr) == nullptr);
+    EXPECT_TRUE(strcmp(SkyDiskCache::unwrapUrl(playlist.c_str()), server().url("/live/index.m3u8").c_str()) == 0);
+    EXPECT_TRUE(SkyDiskCache::isSegmentedUrl("https://cdn.example.com/a/manifest.MPD?token=1"));
+    EXPECT_TRUE(SkyDiskCache::isSegmentedUrl("https://cdn.example.com/a/master.m3u8#t=10"));
+    EXPECT_TRUE(!SkyDiskCache::isSegmentedUrl("https://cdn.example.com/a/video.mp4?list=a.m3u8"));
+
+    const std::string progressive = cacheUrl("/video.mp4");
+    EXPECT_TRUE(SkyDiskCache::unwrapUrl(progressive.c_str()) == progressive.c_str());
+    EXPECT_EQ(server().requestCount("/live/index.m3u8"), 0);
+}
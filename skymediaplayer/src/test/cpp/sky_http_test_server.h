@@ -0,0 +1,350 @@
+#ifndef SKY_HTTP_TEST_SERVER_H
+#define SKY_HTTP_TEST_SERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * IO 单测用的本地 HTTP/1.1 服务：只监听 127.0.0.1，每个连接一个线程、处理一个请求后关闭。
+ * 支持 GET/HEAD、Range（206）、ETag/Last-Modified，并能按请求注入延迟、限速、中途断开和错误状态码，
+ * 用来模拟慢速、乱序和不稳定的网络。
+ */
+namespace sky_test {
+    class HttpServer {
+    public:
+        struct Resource {
+            std::vector<uint8_t> data;
+            std::string etag;
+            std::string lastModified;
+        };
+
+        struct Request {
+            std::string method;
+            std::string path;
+            // 没有 Range 时为 -1；rangeEnd 为闭区间终点，"bytes=a-" 时为 -1
+            int64_t rangeStart = -1;
+            int64_t rangeEnd = -1;
+            std::map<std::string, std::string> headers;
+            // 收到请求时距服务启动的毫秒数
+            int64_t timeMs = 0;
+        };
+
+        // 对单个请求注入的故障，index 是该请求在所有请求中的序号（从 0 开始）
+        struct Fault {
+            // 发送响应头之前等待
+            int delayMs = 0;
+            // 大于 0 时按这个速度发送 body
+            int bytesPerSecond = 0;
+            // 大于等于 0 时发送这么多字节的 body 后直接断开
+            int64_t dropAfter = -1;
+            // 非 0 时直接返回这个状态码
+            int status = 0;
+        };
+        using FaultFn = std::function<Fault(const Request &request, int index)>;
+
+        HttpServer() = default;
+
+        ~HttpServer() {
+            stop();
+        }
+
+        bool start() {
+            listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+            if (listenFd_ < 0) {
+                return false;
+            }
+            int on = 1;
+            setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            socklen_t len = sizeof(addr);
+            if (bind(listenFd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0
+                || listen(listenFd_, 64) < 0
+                || getsockname(listenFd_, reinterpret_cast<sockaddr *>(&addr), &len) < 0) {
+                close(listenFd_);
+                listenFd_ = -1;
+                return false;
+            }
+            port_ = ntohs(addr.sin_port);
+            startTime_ = std::chrono::steady_clock::now();
+            acceptThread_ = std::thread([this]() {
+                acceptLoop();
+            });
+            return true;
+        }
+
+        void stop() {
+            if (listenFd_ < 0) {
+                return;
+            }
+            stopping_.store(true);
+            shutdown(listenFd_, SHUT_RDWR);
+            close(listenFd_);
+            listenFd_ = -1;
+            if (acceptThread_.joinable()) {
+                acceptThread_.join();
+            }
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                threads.swap(connections_);
+            }
+            for (auto &t : threads) {
+                t.join();
+            }
+        }
+
+        std::string url(const std::string &path) const {
+            return "http://127.0.0.1:" + std::to_string(port_) + path;
+        }
+
+        void setResource(const std::string &path, Resource resource) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            resources_[path] = std::move(resource);
+        }
+
+        void setFault(FaultFn fault) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fault_ = std::move(fault);
+        }
+
+        std::vector<Request> requests() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return requests_;
+        }
+
+        int requestCount(const std::string &path) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return static_cast<int>(std::count_if(requests_.begin(), requests_.end(), [&](const Request &r) {
+                return r.path == path;
+            }));
+        }
+
+        // 已发送的 body 总字节数
+        int64_t bodyBytesSent() const {
+            return bodyBytesSent_.load();
+        }
+
+        // 生成确定的伪随机内容，便于逐字节校验
+        static std::vector<uint8_t> makeData(size_t size, uint32_t seed) {
+            std::vector<uint8_t> data(size);
+            uint32_t x = seed * 2654435761u + 1;
+            for (auto &b : data) {
+                x = x * 1664525u + 1013904223u;
+                b = static_cast<uint8_t>(x >> 24);
+            }
+            return data;
+        }
+
+    private:
+        void acceptLoop() {
+            while (!stopping_.load()) {
+                int fd = accept(listenFd_, nullptr, nullptr);
+                if (fd < 0) {
+                    if (stopping_.load()) {
+                        return;
+                    }
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                connections_.emplace_back([this, fd]() {
+                    serve(fd);
+                    close(fd);
+                });
+            }
+        }
+
+        static std::string lower(std::string s) {
+            for (auto &c : s) {
+                c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            }
+            return s;
+        }
+
+        static bool parseRequest(const std::string &head, Request *request) {
+            size_t lineEnd = head.find("\r\n");
+            std::string line = head.substr(0, lineEnd);
+            size_t sp1 = line.find(' ');
+            size_t sp2 = line.find(' ', sp1 + 1);
+            if (sp1 == std::string::npos || sp2 == std::string::npos) {
+                return false;
+            }
+            request->method = line.substr(0, sp1);
+            request->path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+            size_t pos = lineEnd + 2;
+            while (pos < head.size()) {
+                size_t end = head.find("\r\n", pos);
+                if (end == std::string::npos || end == pos) {
+                    break;
+                }
+                std::string header = head.substr(pos, end - pos);
+                size_t colon = header.find(':');
+                if (colon != std::string::npos) {
+                    std::string value = header.substr(colon + 1);
+                    value.erase(0, value.find_first_not_of(' '));
+                    request->headers[lower(header.substr(0, colon))] = value;
+                }
+                pos = end + 2;
+            }
+            auto range = request->headers.find("range");
+            if (range != request->headers.end() && range->second.compare(0, 6, "bytes=") == 0) {
+                const char *spec = range->second.c_str() + 6;
+                char *end = nullptr;
+                request->rangeStart = strtoll(spec, &end, 10);
+                if (end && *end == '-' && isdigit(static_cast<unsigned char>(end[1]))) {
+                    request->rangeEnd = strtoll(end + 1, nullptr, 10);
+                }
+            }
+            return true;
+        }
+
+        bool sendAll(int fd, const void *data, size_t size) {
+            const auto *p = static_cast<const uint8_t *>(data);
+            while (size > 0) {
+                ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    return false;
+                }
+                p += n;
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        void serve(int fd) {
+            std::string head;
+            char buf[4096];
+            while (head.find("\r\n\r\n") == std::string::npos) {
+                ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0) {
+                    return;
+                }
+                head.append(buf, static_cast<size_t>(n));
+            }
+
+            Request request;
+            if (!parseRequest(head, &request)) {
+                return;
+            }
+            request.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - startTime_).count();
+            Resource resource;
+            bool found;
+            FaultFn faultFn;
+            int index;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                index = static_cast<int>(requests_.size());
+                requests_.push_back(request);
+                auto it = resources_.find(request.path);
+                found = it != resources_.end();
+                if (found) {
+                    resource = it->second;
+                }
+                faultFn = fault_;
+            }
+            Fault fault = faultFn ? faultFn(request, index) : Fault{};
+            if (fault.delayMs > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(fault.delayMs));
+            }
+
+            const int64_t total = static_cast<int64_t>(resource.data.size());
+            int status = 200;
+            int64_t start = 0;
+            int64_t end = total - 1;
+            if (fault.status) {
+                status = fault.status;
+            } else if (!found) {
+                status = 404;
+            } else if (request.rangeStart >= 0) {
+                if (request.rangeStart >= total) {
+                    status = 416;
+                } else {
+                    status = 206;
+                    start = request.rangeStart;
+                    if (request.rangeEnd >= 0) {
+                        end = std::min(request.rangeEnd, total - 1);
+                    }
+                }
+            }
+
+            std::string response = "HTTP/1.1 " + std::to_string(status) + (status < 300 ? " OK" : " Error") + "\r\n";
+            int64_t length = 0;
+            if (status == 200 || status == 206) {
+                length = end - start + 1;
+                response += "Accept-Ranges: bytes\r\n";
+                if (status == 206) {
+                    response += "Content-Range: bytes " + std::to_string(start) + "-" + std::to_string(end) + "/"
+                                + std::to_string(total) + "\r\n";
+                }
+                if (!resource.etag.empty()) {
+                    response += "ETag: " + resource.etag + "\r\n";
+                }
+                if (!resource.lastModified.empty()) {
+                    response += "Last-Modified: " + resource.lastModified + "\r\n";
+                }
+            } else if (status == 416) {
+                response += "Content-Range: bytes */" + std::to_string(total) + "\r\n";
+            }
+            response += "Content-Length: " + std::to_string(length) + "\r\n";
+            response += "Connection: close\r\n\r\n";
+            if (!sendAll(fd, response.data(), response.size()) || request.method == "HEAD" || length == 0) {
+                return;
+            }
+
+            int64_t limit = fault.dropAfter >= 0 ? std::min(fault.dropAfter, length) : length;
+            // 限速时每 10 ms 发一小块
+            const int64_t step = fault.bytesPerSecond > 0 ? std::max<int64_t>(1, fault.bytesPerSecond / 100) : 64 * 1024;
+            int64_t sent = 0;
+            while (sent < limit && !stopping_.load()) {
+                int64_t n = std::min(step, limit - sent);
+                if (!sendAll(fd, resource.data.data() + start + sent, static_cast<size_t>(n))) {
+                    return;
+                }
+                sent += n;
+                bodyBytesSent_.fetch_add(n);
+                if (fault.bytesPerSecond > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+            }
+            if (sent < length) {
+                // 模拟连接中途断开：不等对方读完直接复位
+                struct linger lin{1, 0};
+                setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+            }
+        }
+
+    private:
+        int listenFd_ = -1;
+        int port_ = 0;
+        std::atomic<bool> stopping_{false};
+        std::atomic<int64_t> bodyBytesSent_{0};
+        std::chrono::steady_clock::time_point startTime_;
+        std::thread acceptThread_;
+        mutable std::mutex mutex_;
+        std::map<std::string, Resource> resources_;
+        FaultFn fault_;
+        std::vector<Request> requests_;
+        std::vector<std::thread> connections_;
+    };
+}
+
+#endif // SKY_HTTP_TEST_SERVER_H
@@ -0,0 +1,125 @@
+extern "C" {
+#include "libavformat/avio.h"
+}
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sky_test.h"
+#include "sky_mmap_io.h"
+
+/*
+ * mmap 数据源读到的内容与文件一致；播放中文件被截短时改用 pread，读到新的文件尾结束而不是 SIGBUS。
+ */
+namespace {
+    std::vector<uint8_t> makeData(size_t size, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<uint8_t> data(size);
+        for (auto &b : data) {
+            b = static_cast<uint8_t>(rng());
+        }
+        return data;
+    }
+
+    std::string writeFile(const char *name, const std::vector<uint8_t> &data, bool stable = true) {
+        static const std::string dir = [] {
+            char tmpl[] = "/tmp/sky_mmap_io_test.XXXXXX";
+            const char *path = mkdtemp(tmpl);
+            return std::string(path ? path : "/tmp");
+        }();
+        const std::string path = dir + "/" + name;
+        FILE *fp = fopen(path.c_str(), "wb");
+        if (nullptr == fp) {
+            return "";
+        }
+        fwrite(data.data(), 1, data.size(), fp);
+        fclose(fp);
+        if (stable) {
+            // 刚写完的文件不会被 mmap，把修改时间设到一小时前
+            struct timespec times[2];
+            clock_gettime(CLOCK_REALTIME, &times[0]);
+            times[0].tv_sec -= 3600;
+            times[1] = times[0];
+            utimensat(AT_FDCWD, path.c_str(), times, 0);
+        }
+        return path;
+    }
+
+    std::vector<uint8_t> readAll(AVIOContext *pb, int chunk) {
+        std::vector<uint8_t> out;
+        std::vector<uint8_t> buf(static_cast<size_t>(chunk));
+        int n;
+        while ((n = avio_read(pb, buf.data(), chunk)) > 0) {
+            out.insert(out.end(), buf.begin(), buf.begin() + n);
+        }
+        return out;
+    }
+}
+
+TEST(MmapIoReadsWholeFile) {
+    auto data = makeData(3 * 1024 * 1024 + 123, 1);
+    const std::string path = writeFile("whole.bin", data);
+    AVIOContext *pb = SkyMmapIo::open(path.c_str());
+    ASSERT_TRUE(pb != nullptr);
+    EXPECT_EQ(avio_size(pb), static_cast<int64_t>(data.size()));
+    EXPECT_TRUE(readAll(pb, 4096) == data);
+    EXPECT_EQ(avio_seek(pb, 1000, SEEK_SET), 1000);
+    auto rest = readAll(pb, 1024 * 1024);
+    EXPECT_TRUE(rest.size() == data.size() - 1000);
+    EXPECT_TRUE(std::equal(rest.begin(), rest.end(), data.begin() + 1000));
+    SkyIo::close(&pb);
+
+    // file: URL 同样接管
+    pb = SkyMmapIo::open(("file:" + path).c_str());
+    EXPECT_TRUE(pb != nullptr);
+    SkyIo::close(&pb);
+}
+
+TEST(MmapIoSkipsFileBeingWritten) {
+    const std::string path = writeFile("recent.bin", makeData(4096, 2), false);
+    EXPECT_TRUE(SkyMmapIo::open(path.c_str()) == nullptr);
+}
+
+TEST(MmapIoReadsTruncatedTailWithPread) {
+    auto data = makeData(2 * 1024 * 1024, 3);
+    const std::string path = writeFile("tail.bin", data);
+    AVIOContext *pb = SkyMmapIo::open(path.c_str());
+    ASSERT_TRUE(pb != nullptr);
+
+    uint8_t buf[64 * 1024];
+    ASSERT_TRUE(avio_read(pb, buf, sizeof(buf)) == static_cast<int>(sizeof(buf)));
+    // 截掉后半个文件：顺序读到尾部附近时发现，截掉的部分不再访问映射
+    ASSERT_TRUE(truncate(path.c_str(), 1024 * 1024) == 0);
+    auto rest = readAll(pb, 256 * 1024);
+    EXPECT_EQ(rest.size() + sizeof(buf), static_cast<size_t>(1024 * 1024));
+    EXPECT_TRUE(std::equal(rest.begin(), rest.end(), data.begin() + sizeof(buf)));
+    SkyIo::close(&pb);
+}
+
+TEST(MmapIoReadsAfterSeekIntoTruncatedRange) {
+    auto data = makeData(16 * 1024 * 1024, 4);
+    const std::string path = writeFile("seek.bin", data);
+    AVIOContext *pb = SkyMmapIo::open(path.c_str());
+    ASSERT_TRUE(pb != nullptr);
+
+    uint8_t buf[64 * 1024];
+    ASSERT_TRUE(avio_read(pb, buf, sizeof(buf)) == static_cast<int>(sizeof(buf)));
+    ASSERT_TRUE(truncate(path.c_str(), 3 * 1024 * 1024) == 0);
+    // 跳到截掉的范围里：seek 之后的第一次读取先确认文件，返回结束而不是访问已失效的页
+    EXPECT_EQ(avio_seek(pb, 8 * 1024 * 1024, SEEK_SET), 8 * 1024 * 1024);
+    EXPECT_TRUE(avio_read(pb, buf, sizeof(buf)) <= 0);
+    // 截短后的范围内仍能读到原来的数据
+    EXPECT_EQ(avio_seek(pb, 2 * 1024 * 1024, SEEK_SET), 2 * 1024 * 1024);
+    auto rest = readAll(pb, 64 * 1024);
+    EXPECT_EQ(rest.size(), static_cast<size_t>(1024 * 1024));
+    EXPECT_TRUE(std::equal(rest.begin(), rest.end(), data.begin() + 2 * 1024 * 1024));
+    EXPECT_EQ(avio_size(pb), 3 * 1024 * 1024);
+    SkyIo::close(&pb);
+}
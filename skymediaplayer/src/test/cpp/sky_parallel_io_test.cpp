@@ -0,0 +1,159 @@
+extern "C" {
+#include "libavformat/avio.h"
+#include "libavutil/error.h"
+}
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "sky_test.h"
+#include "sky_http_test_server.h"
+#include "sky_parallel_io.h"
+
+/*
+ * 本地 HTTP 服务上注入限速、延迟、断连和错误状态码：块乱序完成时仍按偏移拼出原文件，
+ * 失败的块从断点重试且间隔翻倍，重试用完后读取返回错误。
+ */
+namespace {
+    constexpr int64_t kChunk = PARALLEL_IO_CHUNK_SIZE;
+
+    sky_test::HttpServer &server() {
+        static sky_test::HttpServer instance;
+        static bool started = instance.start();
+        (void) started;
+        return instance;
+    }
+
+    std::vector<uint8_t> serve(const std::string &path, size_t size, uint32_t seed) {
+        auto data = sky_test::HttpServer::makeData(size, seed);
+        server().setResource(path, {data, "", ""});
+        return data;
+    }
+
+    std::vector<uint8_t> readAll(const std::string &path, int *error = nullptr) {
+        std::vector<uint8_t> out;
+        const std::string url = PARALLEL_IO_SCHEME + server().url(path);
+        AVIOContext *pb = SkyParallelIo::open(url.c_str(), nullptr);
+        if (nullptr == pb) {
+            return out;
+        }
+        uint8_t buf[32 * 1024];
+        int n;
+        while ((n = avio_read(pb, buf, sizeof(buf))) > 0) {
+            out.insert(out.end(), buf, buf + n);
+        }
+        if (error) {
+            *error = n;
+        }
+        SkyIo::close(&pb);
+        return out;
+    }
+
+    // 起点落在 [start, start + kChunk) 内的 GET 请求，按到达顺序
+    std::vector<sky_test::HttpServer::Request> chunkRequests(const std::string &path, int64_t start) {
+        std::vector<sky_test::HttpServer::Request> result;
+        for (const auto &request : server().requests()) {
+            if (request.path == path && request.method == "GET" && request.rangeStart >= start
+                && request.rangeStart < start + kChunk) {
+                result.push_back(request);
+            }
+        }
+        return result;
+    }
+}
+
+TEST(ParallelIoReassemblesOutOfOrderChunks) {
+    const std::string path = "/out_of_order.bin";
+    auto data = serve(path, 6 * kChunk, 1);
+
+    // 第 2 块限速、第 4 块迟迟不响应，后面的块先下载完
+    server().setFault([path](const sky_test::HttpServer::Request &request, int) {
+        sky_test::HttpServer::Fault fault;
+        if (request.path == path && request.rangeStart == kChunk) {
+            fault.bytesPerSecond = 2 * 1024 * 1024;
+        } else if (request.path == path && request.rangeStart == 3 * kChunk) {
+            fault.delayMs = 300;
+        }
+        return fault;
+    });
+    EXPECT_TRUE(readAll(path) == data);
+    server().setFault(nullptr);
+
+    for (int64_t i = 0; i < 6; ++i) {
+        EXPECT_EQ(chunkRequests(path, i * kChunk).size(), static_cast<size_t>(1));
+    }
+    // 第 2 块传完至少要 500 ms，最后一块在那之前就已开始下载
+    const auto slow = chunkRequests(path, kChunk);
+    const auto last = chunkRequests(path, 5 * kChunk);
+    ASSERT_TRUE(!slow.empty() && !last.empty());
+    EXPECT_TRUE(last[0].timeMs < slow[0].timeMs + 400);
+}
+
+TEST(ParallelIoRetriesFailedChunkWithBackoff) {
+    const std::string path = "/flaky.bin";
+    auto data = serve(path, 5 * kChunk, 2);
+
+    // 第 3 块前两次连接失败
+    std::atomic<int> failures{0};
+    server().setFault([path, &failures](const sky_test::HttpServer::Request &request, int) {
+        sky_test::HttpServer::Fault fault;
+        if (request.path == path && request.rangeStart == 2 * kChunk && failures++ < 2) {
+            fault.status = 503;
+        }
+        return fault;
+    });
+    EXPECT_TRUE(readAll(path) == data);
+    server().setFault(nullptr);
+
+    const auto attempts = chunkRequests(path, 2 * kChunk);
+    ASSERT_TRUE(attempts.size() == 3);
+    // 间隔按 PARALLEL_IO_RETRY_DELAY_MS 翻倍，留 20 ms 计时误差
+    EXPECT_TRUE(attempts[1].timeMs - attempts[0].timeMs >= PARALLEL_IO_RETRY_DELAY_MS - 20);
+    EXPECT_TRUE(attempts[2].timeMs - attempts[1].timeMs >= 2 * PARALLEL_IO_RETRY_DELAY_MS - 20);
+}
+
+TEST(ParallelIoResumesDroppedConnectionMidWindow) {
+    const std::string path = "/dropped.bin";
+    auto data = serve(path, 6 * kChunk, 3);
+
+    // 第 4 块的连接传了 300 KB 后被断开，其余块照常下载
+    std::atomic<int> drops{0};
+    server().setFault([path, &drops](const sky_test::HttpServer::Request &request, int) {
+        sky_test::HttpServer::Fault fault;
+        if (request.path == path && request.rangeStart == 3 * kChunk && drops++ == 0) {
+            fault.dropAfter = 300 * 1024;
+        }
+        return fault;
+    });
+    EXPECT_TRUE(readAll(path) == data);
+    server().setFault(nullptr);
+
+    // 从断点续传，而不是重新请求整块
+    const auto attempts = chunkRequests(path, 3 * kChunk);
+    ASSERT_TRUE(attempts.size() >= 2);
+    EXPECT_TRUE(attempts.back().rangeStart > 3 * kChunk);
+}
+
+TEST(ParallelIoFailsAfterRetries) {
+    const std::string path = "/broken.bin";
+    auto data = serve(path, 4 * kChunk, 4);
+
+    server().setFault([path](const sky_test::HttpServer::Request &request, int) {
+        sky_test::HttpServer::Fault fault;
+        if (request.path == path && request.rangeStart == 2 * kChunk) {
+            fault.status = 503;
+        }
+        return fault;
+    });
+    int error = 0;
+    auto head = readAll(path, &error);
+    server().setFault(nullptr);
+
+    // 出错块之前的数据完整交出，之后返回错误
+    EXPECT_EQ(head.size(), static_cast<size_t>(2 * kChunk));
+    EXPECT_TRUE(std::equal(head.begin(), head.end(), data.begin()));
+    EXPECT_TRUE(error < 0 && error != AVERROR_EOF);
+    EXPECT_EQ(chunkRequests(path, 2 * kChunk).size(), static_cast<size_t>(1 + PARALLEL_IO_RETRIES));
+}
@@ -0,0 +1,184 @@
+extern "C" {
+#include "libavformat/avformat.h"
+}
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sky_test.h"
+#include "sky_http_test_server.h"
+#include "sky_preload.h"
+
+/*
+ * 本地 HTTP 服务上先预加载再按 read_thread 的方式打开：全部命中时不再请求网络，
+ * 没有预加载时交回 FFmpeg 自己打开，部分命中时其余字节回源且内容一致。
+ */
+namespace {
+    sky_test::HttpServer &server() {
+        static sky_test::HttpServer instance;
+        static bool started = instance.start();
+        (void) started;
+        return instance;
+    }
+
+    std::vector<uint8_t> serve(const std::string &path, size_t size, uint32_t seed) {
+        auto data = sky_test::HttpServer::makeData(size, seed);
+        server().setResource(path, {data, "", ""});
+        return data;
+    }
+
+    // 等预加载写够 bytes 字节，超时返回 false
+    bool waitPreloaded(const std::string &url, int64_t bytes) {
+        for (int i = 0; i < 500; ++i) {
+            if (SkyPreloadManager::instance().preloadedBytes(url) >= bytes) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    std::vector<uint8_t> readAll(AVIOContext *pb) {
+        std::vector<uint8_t> out;
+        uint8_t buf[16 * 1024];
+        int n;
+        while ((n = avio_read(pb, buf, sizeof(buf))) > 0) {
+            out.insert(out.end(), buf, buf + n);
+        }
+        return out;
+    }
+
+    // 8 kHz 单声道 s16 的 WAV，时长 seconds 秒
+    std::vector<uint8_t> makeWav(int seconds) {
+        const uint32_t dataSize = 8000 * 2 * seconds;
+        std::vector<uint8_t> wav(44 + dataSize);
+        auto put32 = [&](size_t pos, uint32_t v) {
+            for (int i = 0; i < 4; ++i) wav[pos + i] = static_cast<uint8_t>(v >> (8 * i));
+        };
+        auto put16 = [&](size_t pos, uint16_t v) {
+            wav[pos] = static_cast<uint8_t>(v);
+            wav[pos + 1] = static_cast<uint8_t>(v >> 8);
+        };
+        memcpy(&wav[0], "RIFF", 4);
+        put32(4, 36 + dataSize);
+        memcpy(&wav[8], "WAVEfmt ", 8);
+        put32(16, 16);
+        put16(20, 1);
+        put16(22, 1);
+        put32(24, 8000);
+        put32(28, 8000 * 2);
+        put16(32, 2);
+        put16(34, 16);
+        memcpy(&wav[36], "data", 4);
+        put32(40, dataSize);
+        auto pcm = sky_test::HttpServer::makeData(dataSize, 7);
+        memcpy(&wav[44], pcm.data(), dataSize);
+        return wav;
+    }
+}
+
+TEST(PreloadHitReadsFromMemory) {
+    const std::string path = "/hit.bin";
+    const std::string url = server().url(path);
+    auto data = serve(path, 300 * 1024, 1);
+
+    SkyPreloadManager::instance().preload({url});
+    ASSERT_TRUE(waitPreloaded(url, static_cast<int64_t>(data.size())));
+    const int requests = server().requestCount(path);
+
+    AVIOContext *pb = SkyPreloadManager::instance().openIo(url.c_str(), nullptr);
+    ASSERT_TRUE(pb != nullptr);
+    EXPECT_EQ(avio_size(pb), static_cast<int64_t>(data.size()));
+    EXPECT_TRUE(readAll(pb) == data);
+    // 回到开头再读一次，仍然不回源
+    EXPECT_EQ(avio_seek(pb, 0, SEEK_SET), 0);
+    EXPECT_TRUE(readAll(pb) == data);
+    EXPECT_EQ(server().requestCount(path), requests);
+    SkyIo::close(&pb);
+}
+
+TEST(PreloadMissLeavesOpenToFfmpeg) {
+    const std::string path = "/miss.bin";
+    serve(path, 64 * 1024, 2);
+
+    // 没有预加载过的 URL 和非 http 地址都不接管
+    EXPECT_TRUE(SkyPreloadManager::instance().openIo(server().url(path).c_str(), nullptr) == nullptr);
+    EXPECT_TRUE(SkyPreloadManager::instance().openIo("file:///sdcard/a.mp4", nullptr) == nullptr);
+    EXPECT_EQ(server().requestCount(path), 0);
+}
+
+TEST(PreloadPartialHitFallsBackToNetwork) {
+    const std::string path = "/partial.bin";
+    const std::string url = server().url(path);
+    auto data = serve(path, 300 * 1024, 3);
+    const int64_t preloaded = 100 * 1024;
+
+    SkyPreloadRequest request;
+    request.url = url;
+    request.maxBytes = preloaded;
+    SkyPreloadManager::instance().preload(request);
+    ASSERT_TRUE(waitPreloaded(url, preloaded));
+    EXPECT_EQ(SkyPreloadManager::instance().preloadedBytes(url), preloaded);
+    const int requests = server().requestCount(path);
+
+    AVIOContext *pb = SkyPreloadManager::instance().openIo(url.c_str(), nullptr);
+    ASSERT_TRUE(pb != nullptr);
+    EXPECT_TRUE(readAll(pb) == data);
+    EXPECT_TRUE(server().requestCount(path) > requests);
+
+    // 已缓存的开头仍从内存读
+    const int afterMiss = server().requestCount(path);
+    EXPECT_EQ(avio_seek(pb, 1000, SEEK_SET), 1000);
+    uint8_t buf[4096];
+    EXPECT_EQ(avio_read(pb, buf, sizeof(buf)), static_cast<int>(sizeof(buf)));
+    EXPECT_TRUE(memcmp(buf, data.data() + 1000, sizeof(buf)) == 0);
+    EXPECT_EQ(server().requestCount(path), afterMiss);
+    SkyIo::close(&pb);
+}
+
+TEST(PreloadedIoOpensWithoutProtocolOptions) {
+    const std::string path = "/tone.wav";
+    const std::string url = server().url(path);
+    auto wav = makeWav(2);
+    server().setResource(path, {wav, "", ""});
+
+    SkyPreloadManager::instance().preload({url});
+    ASSERT_TRUE(waitPreloaded(url, static_cast<int64_t>(wav.size())));
+
+    // 与 read_thread 相同：自定义 IO 时不设置 http 协议选项，avformat_open_input 后不应剩余未识别的选项
+    AVFormatContext *ic = avformat_alloc_context();
+    ASSERT_TRUE(ic != nullptr);
+    ic->pb = SkyPreloadManager::instance().openIo(url.c_str(), &ic->interrupt_callback);
+    ASSERT_TRUE(ic->pb != nullptr);
+    ic->flags |= AVFMT_FLAG_CUSTOM_IO;
+    AVIOContext *pb = ic->pb;
+    AVDictionary *opts = nullptr;
+    av_dict_set(&opts, "max_delay", "500000", 0);
+    int ret = avformat_open_input(&ic, url.c_str(), nullptr, &opts);
+    EXPECT_TRUE(ret >= 0);
+    EXPECT_TRUE(av_dict_get(opts, "", nullptr, AV_DICT_IGNORE_SUFFIX) == nullptr);
+    if (ret >= 0) {
+        EXPECT_EQ(static_cast<int>(ic->nb_streams), 1);
+        EXPECT_EQ(ic->streams[0]->codecpar->sample_rate, 8000);
+        avformat_close_input(&ic);
+    }
+    av_dict_free(&opts);
+
+    // 协议选项传给自定义 IO 时无人消费，正是 read_thread 之前报 AVERROR_OPTION_NOT_FOUND 的原因
+    SkyIo::close(&pb);
+    ic = avformat_alloc_context();
+    ASSERT_TRUE(ic != nullptr);
+    ic->pb = SkyPreloadManager::instance().openIo(url.c_str(), nullptr);
+    ic->flags |= AVFMT_FLAG_CUSTOM_IO;
+    pb = ic->pb;
+    av_dict_set(&opts, "rw_timeout", "10000000", 0);
+    ret = avformat_open_input(&ic, url.c_str(), nullptr, &opts);
+    EXPECT_TRUE(ret >= 0);
+    EXPECT_TRUE(av_dict_get(opts, "rw_timeout", nullptr, 0) != nullptr);
+    avformat_close_input(&ic);
+    av_dict_free(&opts);
+    SkyIo::close(&pb);
+}
@@ -0,0 +1,88 @@
+#ifndef SKY_TEST_H
+#define SKY_TEST_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * 主机端单测的最小框架：TEST 注册用例，EXPECT_* 失败时记录并继续，ASSERT_* 失败时结束当前用例。
+ * 不依赖 gtest，NDK 和主机上都能直接编译。
+ */
+namespace sky_test {
+    struct Case {
+        const char *name;
+        std::function<void()> body;
+    };
+
+    inline std::vector<Case> &cases() {
+        static std::vector<Case> all;
+        return all;
+    }
+
+    inline int &failures() {
+        static int count = 0;
+        return count;
+    }
+
+    struct Registrar {
+        Registrar(const char *name, std::function<void()> body) {
+            cases().push_back({name, std::move(body)});
+        }
+    };
+
+    inline void fail(const char *file, int line, const std::string &message) {
+        fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+        failures()++;
+    }
+
+    // 依次运行名字包含 filter 的用例，返回进程退出码
+    inline int runAll(const char *filter) {
+        int failedCases = 0;
+        for (const auto &c : cases()) {
+            if (filter && std::string(c.name).find(filter) == std::string::npos) {
+                continue;
+            }
+            const int before = failures();
+            printf("[ RUN  ] %s\n", c.name);
+            c.body();
+            const bool ok = failures() == before;
+            printf("[ %s ] %s\n", ok ? " OK " : "FAIL", c.name);
+            failedCases += ok ? 0 : 1;
+        }
+        printf("%d case(s) failed\n", failedCases);
+        return failedCases == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
+
+#define SKY_TEST_CONCAT_(a, b) a##b
+#define SKY_TEST_CONCAT(a, b) SKY_TEST_CONCAT_(a, b)
+
+#define TEST(name) \
+    static void name(); \
+    static sky_test::Registrar SKY_TEST_CONCAT(name, _registrar)(#name, name); \
+    static void name()
+
+#define EXPECT_TRUE(cond) \
+    do { if (!(cond)) sky_test::fail(__FILE__, __LINE__, "expected: " #cond); } while (0)
+
+#define EXPECT_EQ(a, b) \
+    do { \
+        const auto &va_ = (a); const auto &vb_ = (b); \
+        if (!(va_ == vb_)) sky_test::fail(__FILE__, __LINE__, "expected " #a " == " #b \
+            " (" + std::to_string(va_) + " vs " + std::to_string(vb_) + ")"); \
+    } while (0)
+
+#define EXPECT_NEAR(a, b, tol) \
+    do { \
+        const double va_ = (a); const double vb_ = (b); \
+        if (!(va_ - vb_ <= (tol) && vb_ - va_ <= (tol))) sky_test::fail(__FILE__, __LINE__, "expected " #a " ~= " #b \
+            " (" + std::to_string(va_) + " vs " + std::to_string(vb_) + ")"); \
+    } while (0)
+
+#define ASSERT_TRUE(cond) \
+    do { if (!(cond)) { sky_test::fail(__FILE__, __LINE__, "required: " #cond); return; } } while (0)
+
+#endif // SKY_TEST_H
@@ -0,0 +1,6 @@
+#include "sky_test.h"
+
+// 用法：<test> [用例名的一部分]
+int main(int argc, char **argv) {
+    return sky_test::runAll(argc > 1 ? argv[1] : nullptr);
+}
@@ -0,0 +1,131 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "sky_test.h"
+#include "sky_yuv_converter.h"
+#include "sky_yuv_reference.h"
+
+using Layout = SkyYuvConverter::Layout;
+using OutputFormat = SkyYuvConverter::OutputFormat;
+
+namespace {
+    constexpr uint8_t kGuard = 0xA5;
+
+    // 按给定的行跨度准备一帧随机 YUV，跨度之外的填充字节也是随机值，越界读取会让结果不一致
+    struct Frame {
+        std::vector<uint8_t> data[3];
+        const uint8_t *planes[3] = {nullptr, nullptr, nullptr};
+        int strides[3] = {0, 0, 0};
+
+        Frame(Layout layout, int width, int height, int padding, std::mt19937 &rng) {
+            const int chromaWidth = (width + 1) / 2;
+            const int chromaHeight = (height + 1) / 2;
+            strides[0] = width + padding;
+            if (layout == Layout::I420) {
+                strides[1] = strides[2] = chromaWidth + padding;
+            } else {
+                strides[1] = chromaWidth * 2 + padding;
+            }
+            const int rows[3] = {height, chromaHeight, layout == Layout::I420 ? chromaHeight : 0};
+            for (int i = 0; i < 3; ++i) {
+                data[i].resize(static_cast<size_t>(strides[i]) * rows[i]);
+                for (auto &b : data[i]) {
+                    b = static_cast<uint8_t>(rng());
+                }
+                planes[i] = data[i].empty() ? nullptr : data[i].data();
+            }
+        }
+    };
+
+    const char *layoutName(Layout layout) {
+        return layout == Layout::I420 ? "I420" : (layout == Layout::NV12 ? "NV12" : "NV21");
+    }
+
+    // 与参考实现逐字节比较，并检查输出行尾的填充没有被写
+    void checkCase(Layout layout, OutputFormat format, int width, int height, int srcPadding, int dstPadding,
+                   std::mt19937 &rng) {
+        Frame frame(layout, width, height, srcPadding, rng);
+        const int bpp = SkyYuvConverter::bytesPerPixel(format);
+        const int dstStride = width * bpp + dstPadding;
+        std::vector<uint8_t> actual(static_cast<size_t>(dstStride) * height, kGuard);
+        std::vector<uint8_t> expected(actual.size(), kGuard);
+
+        ASSERT_TRUE(SkyYuvConverter::convert(layout, frame.planes, frame.strides, width, height,
+                                             actual.data(), dstStride, format));
+        sky_yuv_reference::convert(layout, frame.planes, frame.strides, width, height,
+                                   expected.data(), dstStride, format);
+
+        for (size_t i = 0; i < actual.size(); ++i) {
+            if (actual[i] != expected[i]) {
+                const int row = static_cast<int>(i / dstStride);
+                const int col = static_cast<int>(i % dstStride);
+                sky_test::fail(__FILE__, __LINE__, std::string(layoutName(layout))
+                        + (format == OutputFormat::RGB565 ? " RGB565 " : " RGBA ")
+                        + std::to_string(width) + "x" + std::to_string(height)
+                        + " pad " + std::to_string(srcPadding) + "/" + std::to_string(dstPadding)
+                        + ": mismatch at row " + std::to_string(row) + " byte " + std::to_string(col)
+                        + (col >= width * bpp ? " (padding overwritten)" : ""));
+                return;
+            }
+        }
+    }
+}
+
+TEST(YuvConverterMatchesReference) {
+    printf("implementation: %s\n", SkyYuvConverter::implementationName());
+    std::mt19937 rng(20240601);
+    // 覆盖不足一个 SIMD 块、刚好整块、整块加尾巴以及奇数宽高
+    const int sizes[][2] = {{1, 1}, {2, 2}, {3, 5}, {15, 3}, {16, 16}, {17, 9}, {31, 4}, {33, 7},
+                            {64, 2}, {65, 3}, {127, 5}, {640, 3}};
+    const int paddings[][2] = {{0, 0}, {13, 0}, {0, 7}, {32, 12}};
+    for (Layout layout : {Layout::I420, Layout::NV12, Layout::NV21}) {
+        for (OutputFormat format : {OutputFormat::RGBA8888, OutputFormat::RGB565}) {
+            for (const auto &size : sizes) {
+                for (const auto &padding : paddings) {
+                    checkCase(layout, format, size[0], size[1], padding[0], padding[1], rng);
+                }
+            }
+        }
+    }
+}
+
+TEST(YuvConverterCloseToFloatBt601) {
+    // 防止参考实现和被测实现一起写错：6 bit 系数（74/64 对 1.164 等）加上取整，相对浮点 BT.601 最多差约 2.4
+    for (int y = 16; y <= 235; y += 7) {
+        for (int u = 16; u <= 240; u += 14) {
+            for (int v = 16; v <= 240; v += 14) {
+                const uint8_t yPlane[2] = {static_cast<uint8_t>(y), static_cast<uint8_t>(y)};
+                const uint8_t uPlane[1] = {static_cast<uint8_t>(u)};
+                const uint8_t vPlane[1] = {static_cast<uint8_t>(v)};
+                const uint8_t *planes[3] = {yPlane, uPlane, vPlane};
+                const int strides[3] = {2, 1, 1};
+                uint8_t out[8];
+                ASSERT_TRUE(SkyYuvConverter::convert(Layout::I420, planes, strides, 2, 1, out, 8,
+                                                     OutputFormat::RGBA8888));
+
+                const double c = 1.164 * (y - 16);
+                const double r = c + 1.596 * (v - 128);
+                const double g = c - 0.392 * (u - 128) - 0.813 * (v - 128);
+                const double b = c + 2.017 * (u - 128);
+                auto clamp = [](double value) { return std::fmin(255.0, std::fmax(0.0, value)); };
+                EXPECT_NEAR(out[0], clamp(r), 3.0);
+                EXPECT_NEAR(out[1], clamp(g), 3.0);
+                EXPECT_NEAR(out[2], clamp(b), 3.0);
+                EXPECT_EQ(out[3], 0xFF);
+            }
+        }
+    }
+}
+
+TEST(YuvConverterRejectsInvalidArguments) {
+    uint8_t plane[4] = {};
+    const uint8_t *planes[3] = {plane, plane, nullptr};
+    const int strides[3] = {2, 2, 2};
+    uint8_t out[16];
+    EXPECT_TRUE(!SkyYuvConverter::convert(Layout::I420, planes, strides, 2, 2, out, 8, OutputFormat::RGBA8888));
+    EXPECT_TRUE(SkyYuvConverter::convert(Layout::NV12, planes, strides, 2, 2, out, 8, OutputFormat::RGBA8888));
+    EXPECT_TRUE(!SkyYuvConverter::convert(Layout::NV12, planes, strides, 0, 2, out, 8, OutputFormat::RGBA8888));
+    EXPECT_TRUE(!SkyYuvConverter::convert(Layout::NV12, planes, strides, 2, 2, nullptr, 8, OutputFormat::RGBA8888));
+}
@@ -0,0 +1,54 @@
+#ifndef SKY_YUV_REFERENCE_H
+#define SKY_YUV_REFERENCE_H
+
+#include <cstdint>
+
+#include "sky_yuv_converter.h"
+
+/**
+ * 逐像素的参考转换：BT.601 limited range，6 bit 定点系数，与 SkyYuvConverter 和 GLES shader 约定的公式一致。
+ * 只用于单测对比和 benchmark 的基线，不追求速度。
+ */
+namespace sky_yuv_reference {
+    inline uint8_t clamp(int value) {
+        return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+    inline void convert(SkyYuvConverter::Layout layout, const uint8_t *const planes[3], const int strides[3],
+                        int width, int height, uint8_t *dst, int dstStride, SkyYuvConverter::OutputFormat format) {
+        using Layout = SkyYuvConverter::Layout;
+        for (int row = 0; row < height; ++row) {
+            for (int x = 0; x < width; ++x) {
+                const int yv = planes[0][row * strides[0] + x];
+                int u;
+                int v;
+                if (layout == Layout::I420) {
+                    u = planes[1][(row / 2) * strides[1] + x / 2];
+                    v = planes[2][(row / 2) * strides[2] + x / 2];
+                } else {
+                    const uint8_t *pair = planes[1] + (row / 2) * strides[1] + (x / 2) * 2;
+                    u = layout == Layout::NV12 ? pair[0] : pair[1];
+                    v = layout == Layout::NV12 ? pair[1] : pair[0];
+                }
+                const int c = 74 * (yv - 16);
+                const int d = u - 128;
+                const int e = v - 128;
+                const uint8_t r = clamp((c + 102 * e + 32) >> 6);
+                const uint8_t g = clamp((c - 25 * d - 52 * e + 32) >> 6);
+                const uint8_t b = clamp((c + 129 * d + 32) >> 6);
+                uint8_t *out = dst + row * dstStride;
+                if (format == SkyYuvConverter::OutputFormat::RGB565) {
+                    reinterpret_cast<uint16_t *>(out)[x] =
+                            static_cast<uint16_t>(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+                } else {
+                    out[x * 4] = r;
+                    out[x * 4 + 1] = g;
+                    out[x * 4 + 2] = b;
+                    out[x * 4 + 3] = 0xFF;
+                }
+            }
+        }
+    }
+}
+
+#endif // SKY_YUV_REFERENCE_H